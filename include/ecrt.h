@@ -201,6 +201,50 @@
  */
 #define EC_HAVE_SLAVE_CONFIG_EOE
 
+/** Defined if the method ecrt_master_cycle() is available.
+ */
+#define EC_HAVE_MASTER_CYCLE
+
+/** Defined if the methods ecrt_master_cycle_thread_start(),
+ * ecrt_master_cycle_post(), ecrt_master_cycle_wait() and
+ * ecrt_master_cycle_thread_stop() are available.
+ */
+#define EC_HAVE_MASTER_CYCLE_THREAD
+
+/** Defined if the methods ecrt_master_begin_config() and
+ * ecrt_master_commit_config() are available.
+ */
+#define EC_HAVE_CONFIG_TRANSACTION
+
+/** Defined if the methods ecrt_master_completion_fd() and
+ * ecrt_master_read_completions() are available.
+ */
+#define EC_HAVE_REQUEST_COMPLETIONS
+
+/** Defined if the methods ecrt_master_acyclic_setup(),
+ * ecrt_master_acyclic_submit() and ecrt_master_acyclic_reap() are
+ * available.
+ */
+#define EC_HAVE_ACYCLIC_QUEUE
+
+/** Defined if the method ecrt_domain_set_period() and the \a stale_cycles
+ * field of ec_domain_state_t are available.
+ */
+#define EC_HAVE_DOMAIN_PERIOD
+
+/** Defined if the methods ecrt_domain_optimize_layout() and
+ * ecrt_domain_remap_offset() are available.
+ */
+#define EC_HAVE_DOMAIN_LAYOUT
+
+/** Defined if the method ecrt_domain_overlapping_pdos() is available.
+ */
+#define EC_HAVE_DOMAIN_OVERLAPPING_PDOS
+
+/** Defined if the method ecrt_master_share_request_data() is available.
+ */
+#define EC_HAVE_SHARED_REQUEST_DATA
+
 /*****************************************************************************/
 
 /** End of list marker.
@@ -441,10 +485,50 @@ typedef struct {
     unsigned int working_counter; /**< Value of the last working counter. */
     ec_wc_state_t wc_state; /**< Working counter interpretation. */
     unsigned int redundancy_active; /**< Redundant link is in use. */
+    unsigned int stale_cycles; /**< Number of consecutive cycles, in which
+                                 the domain was not exchanged due to its
+                                 period (see ecrt_domain_set_period()). The
+                                 other fields refer to the last exchange.
+                                 Zero, if the data are up to date. */
 } ec_domain_state_t;
 
 /*****************************************************************************/
 
+/** Cyclic operation type.
+ *
+ * This is used in ec_cycle_op_t.
+ */
+typedef enum {
+    EC_CYCLE_RECEIVE, /**< ecrt_master_receive(). */
+    EC_CYCLE_DOMAIN_PROCESS, /**< ecrt_domain_process(). */
+    EC_CYCLE_DOMAIN_STATE, /**< ecrt_domain_state(). */
+    EC_CYCLE_DOMAIN_QUEUE, /**< ecrt_domain_queue(). */
+    EC_CYCLE_APPLICATION_TIME, /**< ecrt_master_application_time(). */
+    EC_CYCLE_SYNC_REFERENCE_CLOCK, /**< ecrt_master_sync_reference_clock().
+                                    */
+    EC_CYCLE_SYNC_REFERENCE_CLOCK_TO, /**<
+                                        ecrt_master_sync_reference_clock_to().
+                                       */
+    EC_CYCLE_SYNC_SLAVE_CLOCKS, /**< ecrt_master_sync_slave_clocks(). */
+    EC_CYCLE_SYNC_MONITOR_QUEUE, /**< ecrt_master_sync_monitor_queue(). */
+    EC_CYCLE_SEND /**< ecrt_master_send(). */
+} ec_cycle_op_type_t;
+
+/** Cyclic operation.
+ *
+ * This is used for the sequence of operations passed to ecrt_master_cycle().
+ */
+typedef struct {
+    ec_cycle_op_type_t type; /**< Operation type. */
+    ec_domain_t *domain; /**< Domain for the domain operations. */
+    uint64_t time; /**< Time for EC_CYCLE_APPLICATION_TIME and
+                     EC_CYCLE_SYNC_REFERENCE_CLOCK_TO. */
+    ec_domain_state_t *state; /**< Structure to store the result of
+                                EC_CYCLE_DOMAIN_STATE. */
+} ec_cycle_op_t;
+
+/*****************************************************************************/
+
 /** Direction type for PDO assignment functions.
  */
 typedef enum {
@@ -557,6 +641,77 @@ typedef enum {
 
 /*****************************************************************************/
 
+/** Request type.
+ *
+ * This is used in ec_request_completion_t to tell the type of the request.
+ */
+typedef enum {
+    EC_REQUEST_TYPE_SDO, /**< SDO request (ec_sdo_request_t). */
+    EC_REQUEST_TYPE_SOE, /**< SoE request (ec_soe_request_t). */
+    EC_REQUEST_TYPE_FOE, /**< FoE request (ec_foe_request_t). */
+    EC_REQUEST_TYPE_REG, /**< Register request (ec_reg_request_t). */
+    EC_REQUEST_TYPE_VOE, /**< VoE handler (ec_voe_handler_t). */
+} ec_request_type_t;
+
+/** Request completion.
+ *
+ * This is used by ecrt_master_read_completions().
+ */
+typedef struct {
+    ec_request_type_t type; /**< Request type. */
+    void *request; /**< Request handle, to be casted according to \a type. */
+    ec_request_state_t state; /**< Final request state. */
+} ec_request_completion_t;
+
+/*****************************************************************************/
+
+/** Acyclic operation type.
+ *
+ * This is used in ec_acyclic_op_t.
+ */
+typedef enum {
+    EC_ACYCLIC_SDO_UPLOAD, /**< Upload an SDO. */
+    EC_ACYCLIC_SDO_DOWNLOAD, /**< Download an SDO. */
+    EC_ACYCLIC_SOE_READ, /**< Read an IDN. */
+    EC_ACYCLIC_SOE_WRITE, /**< Write an IDN. */
+    EC_ACYCLIC_FOE_READ, /**< Read a file via FoE. */
+    EC_ACYCLIC_FOE_WRITE, /**< Write a file via FoE. */
+    EC_ACYCLIC_REG_READ, /**< Read ESC registers. */
+    EC_ACYCLIC_REG_WRITE, /**< Write ESC registers. */
+} ec_acyclic_opcode_t;
+
+/** Acyclic operation.
+ *
+ * This is used as input parameter for ecrt_master_acyclic_submit().
+ */
+typedef struct {
+    ec_acyclic_opcode_t opcode; /**< Operation type. */
+    uint16_t slave_position; /**< Slave position. */
+    uint16_t index; /**< SDO index, IDN or register address. */
+    uint8_t subindex; /**< SDO subindex or SoE drive number. */
+    uint8_t complete_access; /**< Transfer the SDO via CompleteAccess. */
+    const char *file_name; /**< FoE file name. */
+    uint32_t password; /**< FoE password. */
+    uint8_t *data; /**< Data to write, or buffer to receive the data. */
+    size_t size; /**< Number of bytes to write, or size of the receive
+                   buffer. */
+    void *user_data; /**< Returned with the completion. */
+} ec_acyclic_op_t;
+
+/** Acyclic operation completion.
+ *
+ * This is used as output parameter for ecrt_master_acyclic_reap().
+ */
+typedef struct {
+    void *user_data; /**< User data of the operation. */
+    int result; /**< Zero on success, otherwise a negative error code. */
+    size_t size; /**< Number of bytes received. */
+    uint32_t error_code; /**< SDO abort code, SoE error code or FoE result
+                           (#ec_foe_error_t). */
+} ec_acyclic_completion_t;
+
+/*****************************************************************************/
+
 /** FoE error enumeration type.
  */
 typedef enum {
@@ -797,6 +952,51 @@ ec_slave_config_t *ecrt_master_slave_config(
         uint32_t product_code /**< Expected product code. */
         );
 
+#ifndef __KERNEL__
+
+/** Starts recording a configuration transaction.
+ *
+ * Until ecrt_master_commit_config() is called, the calls to
+ * ecrt_master_slave_config(), ecrt_slave_config_sync_manager(),
+ * ecrt_slave_config_watchdog(), ecrt_slave_config_pdo_assign_clear(),
+ * ecrt_slave_config_pdo_assign_add(), ecrt_slave_config_pdo_mapping_clear(),
+ * ecrt_slave_config_pdo_mapping_add(), ecrt_slave_config_pdos(),
+ * ecrt_slave_config_dc(), ecrt_slave_config_sdo() (and its variants),
+ * ecrt_slave_config_complete_sdo() and ecrt_domain_reg_pdo_entry_list() are
+ * only recorded and always succeed. They are applied with a single system
+ * call on commit. The offsets of the PDO entries registered with
+ * ecrt_domain_reg_pdo_entry_list() are stored on commit.
+ *
+ * ecrt_slave_config_reg_pdo_entry() and
+ * ecrt_slave_config_reg_pdo_entry_pos() apply the recorded operations
+ * before registering the entry. Other methods must not be called for slave
+ * configurations created in the transaction before the commit.
+ *
+ * \retval 0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_master_begin_config(
+        ec_master_t *master /**< EtherCAT master. */
+        );
+
+/** Applies a configuration transaction.
+ *
+ * The recorded operations are checked first, so that nothing is applied if
+ * an operation refers to an invalid slave configuration or domain. If an
+ * operation fails afterwards, the operations before it are rolled back, so
+ * that the transaction is applied either completely or not at all.
+ *
+ * ecrt_master_activate() commits an open transaction implicitly.
+ *
+ * \retval 0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_master_commit_config(
+        ec_master_t *master /**< EtherCAT master. */
+        );
+
+#endif // #ifndef __KERNEL__
+
 /** Selects the reference clock for distributed clocks.
  *
  * If this method is not called for a certain master, or if the slave
@@ -1163,6 +1363,201 @@ size_t ecrt_master_send_ext(
         ec_master_t *master /**< EtherCAT master. */
         );
 
+/** Executes a sequence of cyclic operations.
+ *
+ * Performs the operations in \a ops in the given order, as if the
+ * corresponding methods (see ec_cycle_op_type_t) were called one after
+ * another. A typical cycle consists of EC_CYCLE_RECEIVE, an
+ * EC_CYCLE_DOMAIN_PROCESS and EC_CYCLE_DOMAIN_STATE operation per domain,
+ * followed by EC_CYCLE_DOMAIN_QUEUE operations, the distributed clocks
+ * operations and EC_CYCLE_SEND.
+ *
+ * In userspace, the whole sequence is executed with a single system call.
+ *
+ * \retval 0 Success.
+ * \retval -EINVAL A domain operation has no domain.
+ * \retval <0 Error code. The operations before the failing one have been
+ *              executed.
+ */
+int ecrt_master_cycle(
+        ec_master_t *master, /**< EtherCAT master. */
+        const ec_cycle_op_t *ops, /**< Operations to execute. */
+        unsigned int op_count /**< Number of operations. */
+        );
+
+#ifndef __KERNEL__
+
+/** Starts a kernel thread, that executes cycles posted by the application.
+ *
+ * The thread executes the operations in \a ops once for each cycle posted
+ * with ecrt_master_cycle_post(). Cycles are passed via a ring in shared
+ * memory, so that no system calls are necessary in steady state. The
+ * application writes its outputs to the domain memory, posts a cycle and
+ * waits for it with ecrt_master_cycle_wait().
+ *
+ * The \a time of EC_CYCLE_APPLICATION_TIME and
+ * EC_CYCLE_SYNC_REFERENCE_CLOCK_TO operations is replaced by the time posted
+ * with each cycle. EC_CYCLE_DOMAIN_STATE is not allowed; use
+ * ecrt_domain_state() instead, which does not need a system call either.
+ *
+ * The thread busy-waits for cycles, so it is bound to the CPU \a cpu, which
+ * should be isolated from the scheduler. If no cycle is posted for a while,
+ * the thread sleeps for some microseconds between polls, so that other tasks
+ * on the CPU are not starved; the first cycle after such a pause is delayed
+ * accordingly. The thread is stopped with ecrt_master_cycle_thread_stop()
+ * or on deactivation.
+ *
+ * EC_CYCLE_SEND and EC_CYCLE_RECEIVE use the send and receive callbacks of
+ * the master, like ecrt_master_send() and ecrt_master_receive() do via
+ * the ioctl() interface.
+ *
+ * This method has to be called after ecrt_master_activate().
+ *
+ * \retval 0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_master_cycle_thread_start(
+        ec_master_t *master, /**< EtherCAT master. */
+        int cpu, /**< CPU to bind the thread to. */
+        const ec_cycle_op_t *ops, /**< Operations to execute per cycle. */
+        unsigned int op_count /**< Number of operations. */
+        );
+
+/** Posts a cycle to the cycle thread.
+ *
+ * \retval 0 Success.
+ * \retval -EAGAIN All ring slots are in use.
+ * \retval <0 Other error code.
+ */
+int ecrt_master_cycle_post(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint64_t app_time /**< Application time of the cycle. */
+        );
+
+/** Waits for the completion of the oldest posted cycle.
+ *
+ * Busy-waits until the cycle thread has executed the cycle.
+ *
+ * \return Result of the cycle (see ecrt_master_cycle()), or -ESRCH, if the
+ *         cycle thread was stopped before executing the cycle.
+ */
+int ecrt_master_cycle_wait(
+        ec_master_t *master /**< EtherCAT master. */
+        );
+
+/** Stops the cycle thread.
+ *
+ * \retval 0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_master_cycle_thread_stop(
+        ec_master_t *master /**< EtherCAT master. */
+        );
+
+/** Enables the completion channel and returns a file descriptor to wait on.
+ *
+ * After this call, the master records the completion of every SDO, SoE, FoE
+ * and register request and every VoE operation of the application's slave
+ * configurations. The returned file descriptor becomes readable in terms of
+ * poll() or select(), as soon as there are completions to read with
+ * ecrt_master_read_completions(). So a thread can sleep until any of its
+ * requests has finished, instead of polling the request states.
+ *
+ * The file descriptor belongs to the master and must not be closed. The
+ * channel is disabled on ecrt_master_deactivate().
+ *
+ * \return File descriptor on success, otherwise a negative error code.
+ */
+int ecrt_master_completion_fd(
+        ec_master_t *master /**< EtherCAT master. */
+        );
+
+/** Reads the completed requests.
+ *
+ * Dequeues up to \a max_count request completions at once. This method
+ * does not block; use poll() on the descriptor returned by
+ * ecrt_master_completion_fd() to wait for completions.
+ *
+ * \return Number of completions read, or a negative error code.
+ */
+int ecrt_master_read_completions(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_request_completion_t *completions, /**< Completions. */
+        unsigned int max_count /**< Maximum number of completions. */
+        );
+
+/** Shares the data of the SDO and SoE requests and VoE handlers with the
+ * master.
+ *
+ * On ecrt_master_activate(), the data memory of the requests is moved into
+ * the process data area, so that reading and writing does not copy the data
+ * via system calls any more. Data pointers retrieved before, for example
+ * with ecrt_sdo_request_data(), become invalid. Requests without data memory
+ * or in progress during activation are not shared.
+ *
+ * This method has to be called before ecrt_master_activate().
+ *
+ * \retval 0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_master_share_request_data(
+        ec_master_t *master /**< EtherCAT master. */
+        );
+
+/** Sets up the acyclic queue.
+ *
+ * The acyclic queue is a submission and a completion ring in memory shared
+ * with the master. It allows to schedule many SDO, SoE, FoE and register
+ * operations for arbitrary slaves with a single system call. The master
+ * processes the operations of different slaves concurrently.
+ *
+ * The data of each operation is transferred through a data area of \a
+ * data_size bytes, so no operation can transfer more than that.
+ *
+ * \retval 0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_master_acyclic_setup(
+        ec_master_t *master, /**< EtherCAT master. */
+        unsigned int entries, /**< Maximum number of operations in progress.
+                                Has to be a power of two. */
+        size_t data_size /**< Maximum data size per operation. */
+        );
+
+/** Submits acyclic operations.
+ *
+ * The data to write is copied, so the buffers of write operations may be
+ * reused after this call. The receive buffers of read operations have to
+ * stay valid until the completion was reaped.
+ *
+ * Completions are collected with ecrt_master_acyclic_reap(). To sleep
+ * until completions are available, use poll() on the file descriptor
+ * returned by ecrt_master_completion_fd().
+ *
+ * \return Number of submitted operations, which may be less than \a count,
+ * if the queue is full, or a negative error code.
+ */
+int ecrt_master_acyclic_submit(
+        ec_master_t *master, /**< EtherCAT master. */
+        const ec_acyclic_op_t *ops, /**< Operations. */
+        unsigned int count /**< Number of operations. */
+        );
+
+/** Reaps completed acyclic operations.
+ *
+ * The received data of read operations is copied to their receive buffers.
+ * This method does not block.
+ *
+ * \return Number of completions, or a negative error code.
+ */
+int ecrt_master_acyclic_reap(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_acyclic_completion_t *completions, /**< Completions. */
+        unsigned int max_count /**< Maximum number of completions. */
+        );
+
+#endif // #ifndef __KERNEL__
+
 #if !defined(__KERNEL__) && defined(EC_RTDM) && defined(EC_EOE)
 
 /** check if there are any open eoe handlers
@@ -2102,6 +2497,105 @@ void ecrt_domain_external_memory(
 
 #endif /* __KERNEL__ */
 
+/** Sets the exchange period of the domain.
+ *
+ * By default, the domain is exchanged in every application cycle, i. e.
+ * with every call to ecrt_master_send(). With a \a period greater than one,
+ * ecrt_domain_queue() only queues the datagrams in every \a period-th
+ * cycle, namely those where the number of cycles since activation modulo
+ * \a period equals \a phase, and does nothing in the other cycles. This
+ * allows slow I/O to share the master with fast axes without occupying the
+ * wire in every cycle.
+ *
+ * If \a phase is negative, the phase is chosen on activation, so that the
+ * process data of domains with a period are spread evenly across the
+ * cycles.
+ *
+ * ecrt_domain_queue() and ecrt_domain_process() should still be called in
+ * every cycle. In cycles following a skipped one, ecrt_domain_process()
+ * leaves the process data untouched and ecrt_domain_state() reports the
+ * number of skipped cycles in the \a stale_cycles field.
+ *
+ * This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_set_period(
+        ec_domain_t *domain, /**< Domain. */
+        unsigned int period, /**< Exchange period in application cycles
+                               (1 = every cycle). */
+        int phase /**< Cycle within the period, or negative for automatic
+                    selection. */
+        );
+
+/** Lets the master optimize the process data layout of the domain.
+ *
+ * By default, the process data of a domain are laid out in the order of
+ * registration. If the layout optimization is enabled, the master rearranges
+ * the sync manager ranges on activation, so that they fit into as few
+ * datagrams as possible, outputs precede inputs in every datagram and
+ * 16, 32 and 64 bit PDO entries are naturally aligned, relative to the start
+ * of the domain's process data. The registration layout is kept, if it
+ * needs fewer datagrams. Domains with overlapping PDOs are not optimized.
+ *
+ * Offsets stored by ecrt_domain_reg_pdo_entry_list() are updated
+ * automatically. Offsets returned by ecrt_slave_config_reg_pdo_entry() have
+ * to be translated with ecrt_domain_remap_offset() after activation. The
+ * domain size may change as well.
+ *
+ * This method has to be called in non-realtime context before any PDO
+ * entries are registered for the domain.
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_optimize_layout(
+        ec_domain_t *domain /**< Domain. */
+        );
+
+/** Translates a process data offset obtained at registration time.
+ *
+ * After ecrt_master_activate(), this returns the offset of the given
+ * registration offset in the optimized layout (see
+ * ecrt_domain_optimize_layout()). Offsets of domains without layout
+ * optimization are returned unchanged.
+ *
+ * \return Offset in the domain's process data.
+ */
+unsigned int ecrt_domain_remap_offset(
+        const ec_domain_t *domain, /**< Domain. */
+        unsigned int offset /**< Offset returned at registration. */
+        );
+
+/** Configures whether the slaves of the domain share the frame space of
+ * inputs and outputs.
+ *
+ * With overlapping PDOs, the input and output process data of each slave
+ * supporting LRW are placed at the same logical addresses, so that the
+ * datagrams carry only the larger of both instead of their sum. Unlike
+ * ecrt_slave_config_overlapping_pdos(), the process data returned by
+ * ecrt_domain_data() keep the registration layout, with inputs and outputs
+ * side by side: ecrt_domain_queue() copies the outputs into a separate frame
+ * image and ecrt_domain_process() copies the received inputs back. As a
+ * slave, that does not respond, leaves its outputs in the input range, the
+ * inputs of a datagram are only taken over, if its working counter is
+ * complete; otherwise the previous inputs are kept. Offsets and domain size
+ * do not change.
+ *
+ * The layout optimization (see ecrt_domain_optimize_layout()) is not
+ * available for domains with overlapping PDOs.
+ *
+ * This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_overlapping_pdos(
+        ec_domain_t *domain, /**< Domain. */
+        uint8_t overlapping_pdos /**< Share the frame space of inputs and
+                                   outputs. */
+        );
+
 /** Returns the domain's process data.
  *
  * - In kernel context: If external memory was provided with
@@ -2125,6 +2619,11 @@ uint8_t *ecrt_domain_data(
  * statistics, if necessary. This must be called after ecrt_master_receive()
  * is expected to receive the domain datagrams in order to make
  * ecrt_domain_state() return the result of the last process data exchange.
+ *
+ * If the datagrams were not queued in the last cycle due to the domain
+ * period, nothing is evaluated and the domain is reported as stale.
+ *
+ * \see ecrt_domain_set_period()
  */
 void ecrt_domain_process(
         ec_domain_t *domain /**< Domain. */
@@ -2133,7 +2632,9 @@ void ecrt_domain_process(
 /** (Re-)queues all domain datagrams in the master's datagram queue.
  *
  * Call this function to mark the domain's datagrams for exchanging at the
- * next call of ecrt_master_send().
+ * next call of ecrt_master_send(). If the domain has a period (see
+ * ecrt_domain_set_period()), the datagrams are only queued in the cycles of
+ * its phase.
  */
 void ecrt_domain_queue(
         ec_domain_t *domain /**< Domain. */
@@ -2216,6 +2717,10 @@ void ecrt_sdo_request_timeout(
  * the internal SDO data memory could be re-allocated if the read SDO data do
  * not fit inside.
  *
+ * If ecrt_master_share_request_data() was called, the memory is moved into
+ * the process data area on ecrt_master_activate(). The pointer has to be
+ * retrieved again after activation then.
+ *
  * \return Pointer to the internal SDO data memory.
  */
 uint8_t *ecrt_sdo_request_data(
@@ -2322,6 +2827,10 @@ void ecrt_soe_request_idn(
  * the internal SOE data memory could be re-allocated if the read SOE data do
  * not fit inside.
  *
+ * If ecrt_master_share_request_data() was called, the memory is moved into
+ * the process data area on ecrt_master_activate(). The pointer has to be
+ * retrieved again after activation then.
+ *
  * \return Pointer to the internal SOE data memory.
  */
 uint8_t *ecrt_soe_request_data(
@@ -2571,6 +3080,10 @@ void ecrt_voe_handler_received_header(
  * avoided by reserving enough memory via the \a size parameter of
  * ecrt_slave_config_create_voe_handler().
  *
+ * If ecrt_master_share_request_data() was called, the memory is moved into
+ * the process data area on ecrt_master_activate(). The pointer has to be
+ * retrieved again after activation then.
+ *
  * \return Pointer to the internal memory.
  */
 uint8_t *ecrt_voe_handler_data(
@@ -85,6 +85,22 @@ ec_master_t *ecrt_open_master(unsigned int master_index)
     master->process_data_size = 0;
     master->first_domain = NULL;
     master->first_config = NULL;
+    ec_index_table_init(&master->config_table);
+    master->state_page = NULL;
+    master->cycle_ring = NULL;
+    master->cycle_head = 0;
+    master->cycle_tail = 0;
+    master->txn_active = 0;
+    master->txn_error = 0;
+    master->txn_ops = NULL;
+    master->txn_info = NULL;
+    master->txn_count = 0;
+    master->txn_size = 0;
+    master->acyclic_memory = NULL;
+    master->acyclic_free = NULL;
+    master->acyclic_free_count = 0;
+    master->acyclic_targets = NULL;
+    master->share_request_data = 0;
 
     snprintf(path, MAX_PATH_LEN - 1,
 #if defined(USE_RTDM)
@@ -122,6 +138,15 @@ ec_master_t *ecrt_open_master(unsigned int master_index)
         goto out_clear;
     }
 
+#if !defined(USE_RTDM) && !defined(USE_RTDM_XENOMAI_V3)
+    master->state_page = mmap(0, sizeof(ec_ioctl_state_page_t), PROT_READ,
+            MAP_SHARED, master->fd, EC_IOCTL_STATE_PAGE_OFFSET);
+    if (master->state_page == MAP_FAILED) {
+        /* States will be read via ioctl() instead. */
+        master->state_page = NULL;
+    }
+#endif
+
     return master;
 
 out_clear:
@@ -36,6 +36,7 @@
 /*****************************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h> /* ENOENT */
 
@@ -47,7 +48,89 @@
 
 void ec_domain_clear(ec_domain_t *domain)
 {
-    // nothing to do
+    free(domain->offset_refs);
+    free(domain->remap);
+}
+
+/*****************************************************************************/
+
+/** Remembers an offset variable, that is translated after activation.
+ */
+static int ec_domain_add_offset_ref(ec_domain_t *domain, unsigned int *offset)
+{
+    unsigned int **refs;
+
+    refs = realloc(domain->offset_refs,
+            (domain->offset_ref_count + 1) * sizeof(*refs));
+    if (!refs) {
+        EC_PRINT_ERR("Failed to allocate offset reference memory.\n");
+        return -ENOMEM;
+    }
+
+    refs[domain->offset_ref_count++] = offset;
+    domain->offset_refs = refs;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Fetches the remap table of an optimized domain and translates the
+ * offsets stored by ecrt_domain_reg_pdo_entry_list().
+ *
+ * Called once after activation.
+ */
+int ec_domain_apply_layout(ec_domain_t *domain)
+{
+    ec_ioctl_domain_layout_t data;
+    unsigned int i;
+    int ret;
+
+    if (!domain->optimize_layout || domain->remap) {
+        return 0;
+    }
+
+    data.domain_index = domain->index;
+    data.size = 0;
+    data.entries = NULL;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_LAYOUT, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to get domain layout: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    if (!data.count) {
+        return 0;
+    }
+
+    data.size = data.count;
+    data.entries = malloc(data.size * sizeof(*data.entries));
+    if (!data.entries) {
+        EC_PRINT_ERR("Failed to allocate domain layout memory.\n");
+        return -ENOMEM;
+    }
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_LAYOUT, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to get domain layout: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        free(data.entries);
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    domain->remap = data.entries;
+    domain->remap_count = data.count < data.size ? data.count : data.size;
+
+    for (i = 0; i < domain->offset_ref_count; i++) {
+        *domain->offset_refs[i] =
+            ecrt_domain_remap_offset(domain, *domain->offset_refs[i]);
+    }
+    free(domain->offset_refs);
+    domain->offset_refs = NULL;
+    domain->offset_ref_count = 0;
+
+    return 0;
 }
 
 /*****************************************************************************/
@@ -64,11 +147,33 @@ int ecrt_domain_reg_pdo_entry_list(ec_domain_t *domain,
                         reg->position, reg->vendor_id, reg->product_code)))
             return -ENOENT;
 
-        if ((ret = ecrt_slave_config_reg_pdo_entry(sc, reg->index,
-                        reg->subindex, domain, reg->bit_position)) < 0)
-            return ret;
+        if (domain->master->txn_active) {
+            ec_ioctl_txn_op_t *op = ec_master_txn_add(domain->master,
+                    EC_IOCTL_TXN_REG_PDO_ENTRY, sc);
+            ec_txn_info_t *info;
+
+            if (!op)
+                return -ENOMEM;
+            op->u.reg_pdo_entry.entry_index = reg->index;
+            op->u.reg_pdo_entry.entry_subindex = reg->subindex;
+            op->u.reg_pdo_entry.domain_index = domain->index;
+
+            // outputs are stored in ec_master_txn_flush()
+            info = &domain->master->txn_info[domain->master->txn_count - 1];
+            info->sc = sc;
+            info->offset = reg->offset;
+            info->bit_position = reg->bit_position;
+        } else {
+            if ((ret = ecrt_slave_config_reg_pdo_entry(sc, reg->index,
+                            reg->subindex, domain, reg->bit_position)) < 0)
+                return ret;
+
+            *reg->offset = ret;
+        }
 
-        *reg->offset = ret;
+        if (domain->optimize_layout
+                && (ret = ec_domain_add_offset_ref(domain, reg->offset)))
+            return ret;
     }
 
     return 0;
@@ -91,6 +196,89 @@ size_t ecrt_domain_size(const ec_domain_t *domain)
 
 /*****************************************************************************/
 
+int ecrt_domain_set_period(ec_domain_t *domain, unsigned int period,
+        int phase)
+{
+    ec_ioctl_domain_period_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+    data.period = period;
+    data.phase = phase;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_PERIOD, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to set domain period: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_optimize_layout(ec_domain_t *domain)
+{
+    int ret;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_OPTIMIZE, domain->index);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to optimize domain layout: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    domain->optimize_layout = 1;
+    return 0;
+}
+
+/*****************************************************************************/
+
+unsigned int ecrt_domain_remap_offset(const ec_domain_t *domain,
+        unsigned int offset)
+{
+    unsigned int low = 0, high = domain->remap_count, mid;
+    const ec_ioctl_domain_remap_t *remap;
+
+    while (low < high) {
+        mid = (low + high) / 2;
+        remap = &domain->remap[mid];
+        if (offset < remap->old_offset) {
+            high = mid;
+        } else if (offset >= remap->old_offset + remap->size) {
+            low = mid + 1;
+        } else {
+            return remap->new_offset + (offset - remap->old_offset);
+        }
+    }
+
+    return offset;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_overlapping_pdos(ec_domain_t *domain,
+        uint8_t overlapping_pdos)
+{
+    ec_ioctl_domain_overlapping_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+    data.overlapping_pdos = overlapping_pdos;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_OVERLAPPING, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to configure overlapping PDOs: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 uint8_t *ecrt_domain_data(ec_domain_t *domain)
 {
     if (!domain->process_data) {
@@ -140,9 +328,17 @@ void ecrt_domain_queue(ec_domain_t *domain)
 
 void ecrt_domain_state(const ec_domain_t *domain, ec_domain_state_t *state)
 {
+    const ec_ioctl_state_page_t *page = domain->master->state_page;
     ec_ioctl_domain_state_t data;
     int ret;
 
+    if (page && domain->index < EC_IOCTL_STATE_PAGE_DOMAINS
+            && !ec_master_read_state_page(domain->master,
+                &page->domains[domain->index].seq, state,
+                &page->domains[domain->index].state, sizeof(*state))) {
+        return;
+    }
+
     data.domain_index = domain->index;
     data.state = state;
 
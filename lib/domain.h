@@ -29,6 +29,7 @@
  *****************************************************************************/
 
 #include "include/ecrt.h"
+#include "ioctl.h"
 
 /*****************************************************************************/
 
@@ -37,10 +38,16 @@ struct ec_domain {
     unsigned int index;
     ec_master_t *master;
     uint8_t *process_data;
+    int optimize_layout;
+    unsigned int **offset_refs; /* patched after activation */
+    unsigned int offset_ref_count;
+    ec_ioctl_domain_remap_t *remap;
+    unsigned int remap_count;
 };
 
 /*****************************************************************************/
 
 void ec_domain_clear(ec_domain_t *);
+int ec_domain_apply_layout(ec_domain_t *);
 
 /*****************************************************************************/
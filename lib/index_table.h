@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2006-2019  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT master userspace library.
+ *
+ *  The IgH EtherCAT master userspace library is free software; you can
+ *  redistribute it and/or modify it under the terms of the GNU Lesser General
+ *  Public License as published by the Free Software Foundation; version 2.1
+ *  of the License.
+ *
+ *  The IgH EtherCAT master userspace library is distributed in the hope that
+ *  it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the IgH EtherCAT master userspace library. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+#ifndef __EC_LIB_INDEX_TABLE_H__
+#define __EC_LIB_INDEX_TABLE_H__
+
+#include <stdlib.h>
+#include <string.h>
+
+/*****************************************************************************/
+
+/** Table of objects, that are addressed by the index the master assigned.
+ *
+ * Allows looking up an object in constant time, instead of walking its list.
+ * Entries without an object are NULL.
+ */
+typedef struct {
+    void **entries; /**< Table entries. */
+    unsigned int size; /**< Allocated number of entries. */
+} ec_index_table_t;
+
+/*****************************************************************************/
+
+/** Initializes an empty table.
+ */
+static inline void ec_index_table_init(ec_index_table_t *table)
+{
+    table->entries = NULL;
+    table->size = 0;
+}
+
+/*****************************************************************************/
+
+/** Frees the table memory. The objects are not touched.
+ */
+static inline void ec_index_table_clear(ec_index_table_t *table)
+{
+    free(table->entries);
+    ec_index_table_init(table);
+}
+
+/*****************************************************************************/
+
+/** Stores an object under the given index.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static inline int ec_index_table_set(ec_index_table_t *table,
+        unsigned int index, void *entry)
+{
+    if (index >= table->size) {
+        unsigned int size = table->size ? table->size : 8;
+        void **entries;
+
+        while (size <= index) {
+            if (size > ~0U / 2) {
+                return -ENOMEM;
+            }
+            size *= 2;
+        }
+
+        entries = realloc(table->entries, size * sizeof(void *));
+        if (!entries) {
+            return -ENOMEM;
+        }
+
+        memset(entries + table->size, 0,
+                (size - table->size) * sizeof(void *));
+        table->entries = entries;
+        table->size = size;
+    }
+
+    table->entries[index] = entry;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Get an object via its index.
+ *
+ * \return Object, or NULL if there is none with that index.
+ */
+static inline void *ec_index_table_get(const ec_index_table_t *table,
+        unsigned int index)
+{
+    return index < table->size ? table->entries[index] : NULL;
+}
+
+/*****************************************************************************/
+
+#endif
@@ -37,6 +37,11 @@
 #include "master.h"
 #include "domain.h"
 #include "slave_config.h"
+#include "sdo_request.h"
+#include "soe_request.h"
+#include "foe_request.h"
+#include "reg_request.h"
+#include "voe_handler.h"
 
 /****************************************************************************/
 
@@ -53,6 +58,20 @@ int ecrt_master_reserve(ec_master_t *master)
 
 /****************************************************************************/
 
+/** Discards the recorded configuration transaction operations.
+ */
+static void ec_master_txn_clear(ec_master_t *master)
+{
+    unsigned int i;
+
+    for (i = 0; i < master->txn_count; i++) {
+        free(master->txn_info[i].sdo_data);
+    }
+    master->txn_count = 0;
+}
+
+/****************************************************************************/
+
 void ec_master_clear_config(ec_master_t *master)
 {
     ec_domain_t *d, *next_d;
@@ -80,6 +99,7 @@ void ec_master_clear_config(ec_master_t *master)
         c = next_c;
     }
     master->first_config = NULL;
+    ec_index_table_clear(&master->config_table);
 
     if (master->process_data)  {
         munmap(master->process_data, master->process_data_size);
@@ -94,6 +114,35 @@ void ec_master_clear(ec_master_t *master)
 {
     ec_master_clear_config(master);
 
+    ec_master_txn_clear(master);
+    free(master->txn_ops);
+    master->txn_ops = NULL;
+    free(master->txn_info);
+    master->txn_info = NULL;
+    master->txn_size = 0;
+    master->txn_active = 0;
+    master->txn_error = 0;
+
+    if (master->state_page) {
+        munmap((void *) master->state_page, sizeof(ec_ioctl_state_page_t));
+        master->state_page = NULL;
+    }
+
+    if (master->cycle_ring) {
+        munmap(master->cycle_ring, sizeof(ec_ioctl_cycle_ring_t));
+        master->cycle_ring = NULL;
+    }
+
+    if (master->acyclic_memory) {
+        munmap(master->acyclic_memory, master->acyclic_setup.size);
+        master->acyclic_memory = NULL;
+    }
+    free(master->acyclic_free);
+    master->acyclic_free = NULL;
+    master->acyclic_free_count = 0;
+    free(master->acyclic_targets);
+    master->acyclic_targets = NULL;
+
     if (master->fd != -1) {
 #if USE_RTDM
         rt_dev_close(master->fd);
@@ -106,6 +155,215 @@ void ec_master_clear(ec_master_t *master)
 
 /****************************************************************************/
 
+/** Maximum number of attempts to read a consistent state page section.
+ *
+ * The writer may be preempted while holding a section. The reader gives up
+ * after this number of attempts instead of spinning, and the caller falls
+ * back to the ioctl() interface.
+ */
+#define EC_STATE_PAGE_RETRIES 16
+
+/** Reads a section of the state page.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_master_read_state_page(
+        const ec_master_t *master, /**< EtherCAT master. */
+        const uint32_t *seq, /**< Sequence counter of the section. */
+        void *dst, /**< Destination buffer. */
+        const void *src, /**< Section data in the state page. */
+        size_t size /**< Size of the section data. */
+        )
+{
+    const volatile uint32_t *counter = seq;
+    uint32_t start;
+    unsigned int i;
+
+    if (!master->state_page) {
+        return -ENODEV;
+    }
+
+    for (i = 0; i < EC_STATE_PAGE_RETRIES; i++) {
+        start = *counter;
+        if (start & 1) {
+            continue;
+        }
+        __sync_synchronize();
+        memcpy(dst, src, size);
+        __sync_synchronize();
+        if (*counter == start) {
+            return 0;
+        }
+    }
+
+    return -EAGAIN;
+}
+
+/****************************************************************************/
+
+/** Records a configuration transaction operation.
+ *
+ * If the operation can not be recorded, the transaction is marked as
+ * failed, so that ec_master_txn_flush() does not apply the rest of it.
+ *
+ * \return Operation to fill in, or NULL if out of memory.
+ */
+ec_ioctl_txn_op_t *ec_master_txn_add(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint32_t type, /**< Operation type. */
+        const ec_slave_config_t *sc /**< Slave configuration, or NULL. */
+        )
+{
+    ec_ioctl_txn_op_t *op;
+
+    if (master->txn_count == master->txn_size) {
+        unsigned int size = master->txn_size ? master->txn_size * 2 : 64;
+        ec_ioctl_txn_op_t *ops;
+        ec_txn_info_t *info;
+
+        ops = realloc(master->txn_ops, sizeof(ec_ioctl_txn_op_t) * size);
+        info = NULL;
+        if (ops) {
+            master->txn_ops = ops;
+            info = realloc(master->txn_info, sizeof(ec_txn_info_t) * size);
+        }
+        if (!info) {
+            // txn_size stays the capacity of both arrays
+            EC_PRINT_ERR("Failed to allocate memory.\n");
+            master->txn_error = -ENOMEM;
+            return NULL;
+        }
+        master->txn_info = info;
+        master->txn_size = size;
+    }
+
+    op = &master->txn_ops[master->txn_count];
+    memset(op, 0x00, sizeof(*op));
+    op->type = type;
+    op->config_index = sc ? sc->index : 0;
+    memset(&master->txn_info[master->txn_count], 0x00,
+            sizeof(ec_txn_info_t));
+    master->txn_count++;
+    return op;
+}
+
+/****************************************************************************/
+
+/** Submits the recorded configuration transaction operations.
+ *
+ * Slave configurations, whose creation was not applied, get the
+ * configuration index EC_IOCTL_TXN_FAILED, so that any further use fails.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_master_txn_flush(ec_master_t *master)
+{
+    ec_ioctl_transaction_t data;
+    ec_ioctl_txn_op_t *op;
+    ec_txn_info_t *info;
+    ec_slave_config_t *sc;
+    unsigned int i;
+    int ret, err = 0;
+
+    data.op_count = master->txn_count;
+    data.ops = master->txn_ops;
+    data.failed_op = 0;
+
+    if (master->txn_error) {
+        err = master->txn_error;
+        master->txn_error = 0;
+        EC_PRINT_ERR("Discarding incomplete configuration transaction.\n");
+        goto out_failed;
+    }
+
+    if (!master->txn_count) {
+        return 0;
+    }
+
+    ret = ioctl(master->fd, EC_IOCTL_TRANSACTION, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        err = -EC_IOCTL_ERRNO(ret);
+        EC_PRINT_ERR("Failed to apply configuration operation %u of %u:"
+                " %s\n", data.failed_op, master->txn_count,
+                strerror(EC_IOCTL_ERRNO(ret)));
+        // the master rolled back all operations
+        goto out_failed;
+    }
+
+    for (i = 0; i < master->txn_count; i++) {
+        op = &master->txn_ops[i];
+        info = &master->txn_info[i];
+
+        switch (op->type) {
+            case EC_IOCTL_TXN_REG_PDO_ENTRY:
+                if (info->bit_position) {
+                    *info->bit_position = op->u.reg_pdo_entry.bit_position;
+                } else if (op->u.reg_pdo_entry.bit_position) {
+                    EC_PRINT_ERR("PDO entry 0x%04X:%02X does not byte-align"
+                            " in config %u:%u.\n",
+                            op->u.reg_pdo_entry.entry_index,
+                            op->u.reg_pdo_entry.entry_subindex,
+                            info->sc ? info->sc->alias : 0,
+                            info->sc ? info->sc->position : 0);
+                    if (!err) {
+                        err = -EFAULT;
+                    }
+                }
+                if (info->offset) {
+                    *info->offset = op->u.reg_pdo_entry.offset;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+out_failed:
+    // the master only sets the index of the applied configurations
+    for (i = 0; i < master->txn_count; i++) {
+        if (master->txn_ops[i].type != EC_IOCTL_TXN_CONFIG) {
+            continue;
+        }
+        sc = master->txn_info[i].sc;
+        sc->index = master->txn_ops[i].config_index;
+        if (sc->index != EC_IOCTL_TXN_FAILED
+                && ec_index_table_set(&master->config_table, sc->index, sc)
+                && !err) {
+            EC_PRINT_ERR("Failed to allocate memory.\n");
+            err = -ENOMEM;
+        }
+    }
+
+    ec_master_txn_clear(master);
+    return err;
+}
+
+/****************************************************************************/
+
+int ecrt_master_begin_config(ec_master_t *master)
+{
+    if (master->txn_active) {
+        return -EBUSY;
+    }
+
+    master->txn_active = 1;
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_commit_config(ec_master_t *master)
+{
+    if (!master->txn_active) {
+        return -EINVAL;
+    }
+
+    master->txn_active = 0;
+    return ec_master_txn_flush(master);
+}
+
+/****************************************************************************/
+
 void ec_master_add_domain(ec_master_t *master, ec_domain_t *domain)
 {
     if (master->first_domain) {
@@ -144,6 +402,11 @@ ec_domain_t *ecrt_master_create_domain(ec_master_t *master)
     domain->index = (unsigned int) index;
     domain->master = master;
     domain->process_data = NULL;
+    domain->optimize_layout = 0;
+    domain->offset_refs = NULL;
+    domain->offset_ref_count = 0;
+    domain->remap = NULL;
+    domain->remap_count = 0;
 
     ec_master_add_domain(master, domain);
 
@@ -181,6 +444,25 @@ ec_slave_config_t *ecrt_master_slave_config(ec_master_t *master,
         return 0;
     }
 
+    if (master->txn_active) {
+        ec_ioctl_txn_op_t *op =
+            ec_master_txn_add(master, EC_IOCTL_TXN_CONFIG, NULL);
+        if (!op) {
+            free(sc);
+            return 0;
+        }
+        op->config_index = EC_IOCTL_TXN_FAILED;
+        op->u.config.alias = alias;
+        op->u.config.position = position;
+        op->u.config.vendor_id = vendor_id;
+        op->u.config.product_code = product_code;
+        master->txn_info[master->txn_count - 1].sc = sc;
+
+        // resolved in ec_master_txn_flush()
+        data.config_index = EC_IOCTL_TXN_PENDING | (master->txn_count - 1);
+        goto out_init;
+    }
+
     data.alias = alias;
     data.position = position;
     data.vendor_id = vendor_id;
@@ -194,6 +476,7 @@ ec_slave_config_t *ecrt_master_slave_config(ec_master_t *master,
         return 0;
     }
 
+out_init:
     sc->next = NULL;
     sc->master = master;
     sc->index = data.config_index;
@@ -204,6 +487,18 @@ ec_slave_config_t *ecrt_master_slave_config(ec_master_t *master,
     sc->first_reg_request = NULL;
     sc->first_voe_handler = NULL;
     sc->first_soe_request = NULL;
+    ec_index_table_init(&sc->sdo_request_table);
+    ec_index_table_init(&sc->soe_request_table);
+    ec_index_table_init(&sc->foe_request_table);
+    ec_index_table_init(&sc->reg_request_table);
+    ec_index_table_init(&sc->voe_handler_table);
+
+    if (!master->txn_active && ec_index_table_set(&master->config_table,
+                sc->index, sc)) {
+        EC_PRINT_ERR("Failed to allocate memory.\n");
+        free(sc);
+        return 0;
+    }
 
     ec_master_add_slave_config(master, sc);
 
@@ -576,11 +871,166 @@ int ecrt_master_read_idn(ec_master_t *master, uint16_t slave_position,
 
 /****************************************************************************/
 
+/** Moves the data of a request into the memory shared with the master.
+ *
+ * The previous contents are kept. Requests, for which the master did not
+ * reserve shared memory, keep their private memory.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_master_map_request(ec_master_t *master, uint16_t type,
+        unsigned int config_index, unsigned int request_index,
+        uint8_t **data, size_t *mem_size, int *mapped)
+{
+    ec_ioctl_request_memory_t io;
+    uint8_t *mem;
+    int ret;
+
+    io.config_index = config_index;
+    io.request_index = request_index;
+    io.type = type;
+
+    ret = ioctl(master->fd, EC_IOCTL_REQUEST_MEMORY, &io);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        if (EC_IOCTL_ERRNO(ret) == ENOBUFS) {
+            return 0;
+        }
+        EC_PRINT_ERR("Failed to get request memory: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    if (io.offset + io.size > master->process_data_size) {
+        return 0;
+    }
+
+    mem = master->process_data + io.offset;
+    if (*data) {
+        memcpy(mem, *data, *mem_size);
+        if (!*mapped) {
+            free(*data);
+        }
+    }
+
+    *data = mem;
+    *mem_size = io.size;
+    *mapped = 1;
+    return 0;
+}
+
+/****************************************************************************/
+
+/** Moves the data of the SDO and SoE requests and VoE handlers into the
+ * memory shared with the master.
+ *
+ * If the application asked for it with ecrt_master_share_request_data(), the
+ * master places them behind the process data on activation, so that reading
+ * and writing does not need to copy them any more.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_master_map_requests(ec_master_t *master)
+{
+#if defined(USE_RTDM) || defined(USE_RTDM_XENOMAI_V3)
+    return 0;
+#else
+    ec_slave_config_t *sc;
+    ec_sdo_request_t *sdo;
+    ec_soe_request_t *soe;
+    ec_voe_handler_t *voe;
+    int ret;
+
+    if (!master->share_request_data) {
+        return 0;
+    }
+
+    for (sc = master->first_config; sc; sc = sc->next) {
+        for (sdo = sc->first_sdo_request; sdo; sdo = sdo->next) {
+            ret = ec_master_map_request(master, EC_IOCTL_COMPLETION_SDO,
+                    sc->index, sdo->index, &sdo->data, &sdo->mem_size,
+                    &sdo->mapped);
+            if (ret) {
+                return ret;
+            }
+        }
+
+        for (soe = sc->first_soe_request; soe; soe = soe->next) {
+            ret = ec_master_map_request(master, EC_IOCTL_COMPLETION_SOE,
+                    sc->index, soe->index, &soe->data, &soe->mem_size,
+                    &soe->mapped);
+            if (ret) {
+                return ret;
+            }
+        }
+
+        for (voe = sc->first_voe_handler; voe; voe = voe->next) {
+            ret = ec_master_map_request(master, EC_IOCTL_COMPLETION_VOE,
+                    sc->index, voe->index, &voe->data, &voe->mem_size,
+                    &voe->mapped);
+            if (ret) {
+                return ret;
+            }
+        }
+    }
+
+    return 0;
+#endif
+}
+
+/****************************************************************************/
+
+int ecrt_master_share_request_data(ec_master_t *master)
+{
+#if defined(USE_RTDM) || defined(USE_RTDM_XENOMAI_V3)
+    return -EOPNOTSUPP;
+#else
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_SHARE_REQUEST_DATA, NULL);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to share request data: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    master->share_request_data = 1;
+    return 0;
+#endif
+}
+
+/****************************************************************************/
+
+/** Translates the registration offsets of all optimized domains.
+ */
+static int ec_master_apply_domain_layouts(ec_master_t *master)
+{
+    ec_domain_t *domain;
+    int ret;
+
+    for (domain = master->first_domain; domain; domain = domain->next) {
+        ret = ec_domain_apply_layout(domain);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
 int ecrt_master_setup_domain_memory(ec_master_t *master)
 {
     ec_ioctl_master_activate_t io;
     int ret;
 
+    if (master->txn_active) {
+        ret = ecrt_master_commit_config(master);
+        if (ret) {
+            return ret;
+        }
+    }
+
     ret = ioctl(master->fd, EC_IOCTL_SETUP_DOMAIN_MEMORY, &io);
     if (EC_IOCTL_IS_ERROR(ret)) {
         EC_PRINT_ERR("Failed to activate master: %s\n",
@@ -588,6 +1038,11 @@ int ecrt_master_setup_domain_memory(ec_master_t *master)
         return -EC_IOCTL_ERRNO(ret);
     }
 
+    ret = ec_master_apply_domain_layouts(master);
+    if (ret) {
+        return ret;
+    }
+
     // will return 0 process_data_size if domain data has already been set up
     if (io.process_data_size) {
         master->process_data_size = io.process_data_size;
@@ -611,6 +1066,11 @@ int ecrt_master_setup_domain_memory(ec_master_t *master)
 
         // Access the mapped region to cause the initial page fault
         master->process_data[0] = 0x00;
+
+        ret = ec_master_map_requests(master);
+        if (ret) {
+            return ret;
+        }
     }
 
     return 0;
@@ -623,6 +1083,13 @@ int ecrt_master_activate(ec_master_t *master)
     ec_ioctl_master_activate_t io;
     int ret;
 
+    if (master->txn_active) {
+        ret = ecrt_master_commit_config(master);
+        if (ret) {
+            return ret;
+        }
+    }
+
     ret = ioctl(master->fd, EC_IOCTL_ACTIVATE, &io);
     if (EC_IOCTL_IS_ERROR(ret)) {
         EC_PRINT_ERR("Failed to activate master: %s\n",
@@ -630,6 +1097,11 @@ int ecrt_master_activate(ec_master_t *master)
         return -EC_IOCTL_ERRNO(ret);
     }
 
+    ret = ec_master_apply_domain_layouts(master);
+    if (ret) {
+        return ret;
+    }
+
     // will return 0 process_data_size if domain data has already been set up
     if (io.process_data_size) {
         master->process_data_size = io.process_data_size;
@@ -653,6 +1125,11 @@ int ecrt_master_activate(ec_master_t *master)
 
         // Access the mapped region to cause the initial page fault
         master->process_data[0] = 0x00;
+
+        ret = ec_master_map_requests(master);
+        if (ret) {
+            return ret;
+        }
     }
 
     return 0;
@@ -765,6 +1242,505 @@ void ecrt_master_receive(ec_master_t *master)
 
 /****************************************************************************/
 
+/** Number of cyclic operations passed with one ioctl() by
+ * ecrt_master_cycle().
+ */
+#define EC_CYCLE_BATCH 64
+
+/****************************************************************************/
+
+/** Converts a cyclic operation for the master.
+ *
+ * \return Zero on success, otherwise -EINVAL.
+ */
+static int ec_master_cycle_op_convert(ec_ioctl_cycle_op_t *data_op,
+        const ec_cycle_op_t *op)
+{
+    if ((op->type == EC_CYCLE_DOMAIN_PROCESS
+                || op->type == EC_CYCLE_DOMAIN_STATE
+                || op->type == EC_CYCLE_DOMAIN_QUEUE) && !op->domain) {
+        EC_PRINT_ERR("Cyclic operation %u needs a domain.\n", op->type);
+        return -EINVAL;
+    }
+
+    data_op->type = op->type;
+    data_op->domain_index = op->domain ? op->domain->index : 0;
+    data_op->time = op->time;
+    data_op->state = op->state;
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_cycle(ec_master_t *master, const ec_cycle_op_t *ops,
+        unsigned int op_count)
+{
+    ec_ioctl_cycle_op_t data_ops[EC_CYCLE_BATCH];
+    ec_ioctl_cycle_t data;
+    unsigned int done, count, i;
+    int ret;
+
+    for (done = 0; done < op_count; done += count) {
+        count = op_count - done;
+        if (count > EC_CYCLE_BATCH) {
+            count = EC_CYCLE_BATCH;
+        }
+
+        for (i = 0; i < count; i++) {
+            if ((ret = ec_master_cycle_op_convert(&data_ops[i],
+                            &ops[done + i]))) {
+                return ret;
+            }
+        }
+
+        data.op_count = count;
+        data.ops = data_ops;
+
+        ret = ioctl(master->fd, EC_IOCTL_CYCLE, &data);
+        if (EC_IOCTL_IS_ERROR(ret)) {
+            EC_PRINT_ERR("Failed to execute cyclic operations: %s\n",
+                    strerror(EC_IOCTL_ERRNO(ret)));
+            return -EC_IOCTL_ERRNO(ret);
+        }
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_cycle_thread_start(ec_master_t *master, int cpu,
+        const ec_cycle_op_t *ops, unsigned int op_count)
+{
+    ec_ioctl_cycle_op_t *data_ops;
+    ec_ioctl_cycle_thread_t data;
+    unsigned int i;
+    int ret;
+
+#if defined(USE_RTDM) || defined(USE_RTDM_XENOMAI_V3)
+    return -EOPNOTSUPP;
+#endif
+
+    if (!master->cycle_ring) {
+        master->cycle_ring = mmap(0, sizeof(ec_ioctl_cycle_ring_t),
+                PROT_READ | PROT_WRITE, MAP_SHARED, master->fd,
+                EC_IOCTL_CYCLE_RING_OFFSET);
+        if (master->cycle_ring == MAP_FAILED) {
+            EC_PRINT_ERR("Failed to map cycle ring: %s\n", strerror(errno));
+            master->cycle_ring = NULL;
+            return -errno;
+        }
+    }
+
+    data_ops = malloc(sizeof(ec_ioctl_cycle_op_t) * op_count);
+    if (!data_ops) {
+        EC_PRINT_ERR("Failed to allocate memory.\n");
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < op_count; i++) {
+        if ((ret = ec_master_cycle_op_convert(&data_ops[i], &ops[i]))) {
+            free(data_ops);
+            return ret;
+        }
+        data_ops[i].state = NULL;
+    }
+
+    data.cpu = cpu;
+    data.op_count = op_count;
+    data.ops = data_ops;
+
+    ret = ioctl(master->fd, EC_IOCTL_CYCLE_THREAD_START, &data);
+    free(data_ops);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to start cycle thread: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    master->cycle_head = master->cycle_ring->head;
+    master->cycle_tail = master->cycle_head;
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_cycle_post(ec_master_t *master, uint64_t app_time)
+{
+    ec_ioctl_cycle_ring_t *ring = master->cycle_ring;
+
+    if (!ring) {
+        return -EINVAL;
+    }
+
+    if (master->cycle_head - master->cycle_tail >= EC_IOCTL_CYCLE_RING_SIZE) {
+        return -EAGAIN;
+    }
+
+    ring->slots[master->cycle_head % EC_IOCTL_CYCLE_RING_SIZE].app_time =
+        app_time;
+    __sync_synchronize();
+    *(volatile uint32_t *) &ring->head = ++master->cycle_head;
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_cycle_wait(ec_master_t *master)
+{
+    ec_ioctl_cycle_ring_t *ring = master->cycle_ring;
+    int result;
+
+    if (!ring || master->cycle_tail == master->cycle_head) {
+        return -EINVAL;
+    }
+
+    while (*(volatile uint32_t *) &ring->tail == master->cycle_tail) {
+        // busy-wait for the cycle thread, as long as it is running
+        if (!*(volatile uint32_t *) &ring->running) {
+            __sync_synchronize();
+            if (*(volatile uint32_t *) &ring->tail == master->cycle_tail) {
+                return -ESRCH;
+            }
+        }
+    }
+    __sync_synchronize();
+
+    result = ring->slots[master->cycle_tail % EC_IOCTL_CYCLE_RING_SIZE].result;
+    master->cycle_tail++;
+    return result;
+}
+
+/****************************************************************************/
+
+int ecrt_master_cycle_thread_stop(ec_master_t *master)
+{
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_CYCLE_THREAD_STOP, NULL);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to stop cycle thread: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_completion_fd(ec_master_t *master)
+{
+#if defined(USE_RTDM) || defined(USE_RTDM_XENOMAI_V3)
+    return -EOPNOTSUPP;
+#else
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_COMPLETIONS_ENABLE, NULL);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to enable completions: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return master->fd;
+#endif
+}
+
+/****************************************************************************/
+
+/** Looks up the request handle of a completion.
+ *
+ * \return Request handle, or NULL if the request is unknown.
+ */
+static void *ec_master_completion_request(ec_master_t *master,
+        const ec_ioctl_completion_t *completion)
+{
+    ec_slave_config_t *sc =
+        ec_index_table_get(&master->config_table, completion->config_index);
+
+    if (!sc) {
+        return NULL;
+    }
+
+    switch (completion->type) {
+        case EC_IOCTL_COMPLETION_SDO:
+            return ec_index_table_get(&sc->sdo_request_table,
+                    completion->request_index);
+        case EC_IOCTL_COMPLETION_SOE:
+            return ec_index_table_get(&sc->soe_request_table,
+                    completion->request_index);
+        case EC_IOCTL_COMPLETION_FOE:
+            return ec_index_table_get(&sc->foe_request_table,
+                    completion->request_index);
+        case EC_IOCTL_COMPLETION_REG:
+            return ec_index_table_get(&sc->reg_request_table,
+                    completion->request_index);
+        case EC_IOCTL_COMPLETION_VOE:
+            return ec_index_table_get(&sc->voe_handler_table,
+                    completion->request_index);
+    }
+
+    return NULL;
+}
+
+/****************************************************************************/
+
+int ecrt_master_read_completions(ec_master_t *master,
+        ec_request_completion_t *completions, unsigned int max_count)
+{
+    ec_ioctl_completion_t buffer[EC_IOCTL_COMPLETION_QUEUE_SIZE];
+    ec_ioctl_completions_t data;
+    unsigned int i, count = 0;
+    int ret;
+
+    if (!max_count) {
+        return 0;
+    }
+
+    if (max_count > EC_IOCTL_COMPLETION_QUEUE_SIZE) {
+        max_count = EC_IOCTL_COMPLETION_QUEUE_SIZE;
+    }
+
+    data.max_count = max_count;
+    data.completions = buffer;
+
+    ret = ioctl(master->fd, EC_IOCTL_COMPLETIONS_READ, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to read completions: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    for (i = 0; i < data.count; i++) {
+        void *request = ec_master_completion_request(master, &buffer[i]);
+        if (!request) {
+            continue; // configuration was cleared in the meantime
+        }
+
+        completions[count].type = (ec_request_type_t) buffer[i].type;
+        completions[count].request = request;
+        completions[count].state = (ec_request_state_t) buffer[i].state;
+        count++;
+    }
+
+    return count;
+}
+
+/****************************************************************************/
+
+int ecrt_master_acyclic_setup(ec_master_t *master, unsigned int entries,
+        size_t data_size)
+{
+#if defined(USE_RTDM) || defined(USE_RTDM_XENOMAI_V3)
+    return -EOPNOTSUPP;
+#else
+    ec_ioctl_acyclic_setup_t data;
+    unsigned int i;
+    int ret;
+
+    if (master->acyclic_memory) {
+        return -EBUSY;
+    }
+
+    if (!entries || entries > EC_IOCTL_ACYCLIC_MAX_ENTRIES
+            || data_size > EC_IOCTL_ACYCLIC_MAX_DATA_SIZE) {
+        return -EINVAL;
+    }
+
+    data.entries = entries;
+    data.data_size = data_size;
+
+    master->acyclic_free = malloc(sizeof(uint32_t) * entries);
+    master->acyclic_targets = calloc(entries, sizeof(uint8_t *));
+    if (!master->acyclic_free || !master->acyclic_targets) {
+        EC_PRINT_ERR("Failed to allocate memory.\n");
+        ret = -ENOMEM;
+        goto out_free;
+    }
+
+    ret = ioctl(master->fd, EC_IOCTL_ACYCLIC_SETUP, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to set up acyclic queue: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        ret = -EC_IOCTL_ERRNO(ret);
+        goto out_free;
+    }
+
+    master->acyclic_memory = mmap(0, data.size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, master->fd, EC_IOCTL_ACYCLIC_QUEUE_OFFSET);
+    if (master->acyclic_memory == MAP_FAILED) {
+        ret = -errno;
+        EC_PRINT_ERR("Failed to map acyclic queue: %s\n", strerror(-ret));
+        master->acyclic_memory = NULL;
+        goto out_clear;
+    }
+
+    master->acyclic_setup = data;
+    for (i = 0; i < entries; i++) {
+        master->acyclic_free[i] = entries - 1 - i;
+    }
+    master->acyclic_free_count = entries;
+    return 0;
+
+out_clear:
+    ioctl(master->fd, EC_IOCTL_ACYCLIC_CLEAR, NULL);
+out_free:
+    free(master->acyclic_free);
+    master->acyclic_free = NULL;
+    free(master->acyclic_targets);
+    master->acyclic_targets = NULL;
+    return ret;
+#endif
+}
+
+/****************************************************************************/
+
+int ecrt_master_acyclic_submit(ec_master_t *master,
+        const ec_acyclic_op_t *ops, unsigned int count)
+{
+    const ec_ioctl_acyclic_setup_t *setup = &master->acyclic_setup;
+    ec_ioctl_acyclic_rings_t *rings;
+    uint32_t *sq;
+    ec_ioctl_acyclic_sqe_t *sqe;
+    uint32_t head, entry;
+    unsigned int i;
+    int ret;
+
+    if (!master->acyclic_memory) {
+        return -EINVAL;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (ops[i].size > setup->data_size) {
+            return -EOVERFLOW;
+        }
+    }
+
+    rings = (ec_ioctl_acyclic_rings_t *) master->acyclic_memory;
+    sq = (uint32_t *) (master->acyclic_memory + setup->sq_offset);
+    head = rings->sq_head;
+
+    for (i = 0; i < count && master->acyclic_free_count; i++) {
+        const ec_acyclic_op_t *op = &ops[i];
+        uint8_t *data;
+
+        entry = master->acyclic_free[--master->acyclic_free_count];
+        sqe = (ec_ioctl_acyclic_sqe_t *) (master->acyclic_memory
+                + setup->sqe_offset) + entry;
+        data = master->acyclic_memory + setup->data_offset
+            + entry * setup->data_size;
+
+        sqe->user_data = (uintptr_t) op->user_data;
+        sqe->opcode = op->opcode;
+        sqe->slave_position = op->slave_position;
+        sqe->index = op->index;
+        sqe->subindex = op->subindex;
+        sqe->complete_access = op->complete_access;
+        sqe->size = op->size;
+        sqe->password = op->password;
+        if (op->file_name) {
+            strncpy(sqe->file_name, op->file_name,
+                    EC_IOCTL_ACYCLIC_FILE_NAME_SIZE - 1);
+            sqe->file_name[EC_IOCTL_ACYCLIC_FILE_NAME_SIZE - 1] = '\0';
+        } else {
+            sqe->file_name[0] = '\0';
+        }
+
+        switch (op->opcode) {
+            case EC_ACYCLIC_SDO_UPLOAD:
+            case EC_ACYCLIC_SOE_READ:
+            case EC_ACYCLIC_FOE_READ:
+            case EC_ACYCLIC_REG_READ:
+                master->acyclic_targets[entry] = op->data;
+                break;
+            default:
+                if (op->size) {
+                    memcpy(data, op->data, op->size);
+                }
+                master->acyclic_targets[entry] = NULL;
+                break;
+        }
+
+        sq[head & (setup->entries - 1)] = entry;
+        head++;
+    }
+
+    __sync_synchronize();
+    *(volatile uint32_t *) &rings->sq_head = head;
+
+    ret = ioctl(master->fd, EC_IOCTL_ACYCLIC_SUBMIT, NULL);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to submit acyclic operations: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return i;
+}
+
+/****************************************************************************/
+
+int ecrt_master_acyclic_reap(ec_master_t *master,
+        ec_acyclic_completion_t *completions, unsigned int max_count)
+{
+    const ec_ioctl_acyclic_setup_t *setup = &master->acyclic_setup;
+    ec_ioctl_acyclic_rings_t *rings;
+    const ec_ioctl_acyclic_cqe_t *cqe;
+    uint32_t head, tail;
+    unsigned int count = 0;
+    int ret;
+
+    if (!master->acyclic_memory) {
+        return -EINVAL;
+    }
+
+    rings = (ec_ioctl_acyclic_rings_t *) master->acyclic_memory;
+    tail = rings->cq_tail;
+    head = *(volatile uint32_t *) &rings->cq_head;
+    __sync_synchronize();
+
+    while (count < max_count && tail != head) {
+        cqe = (const ec_ioctl_acyclic_cqe_t *) (master->acyclic_memory
+                + setup->cq_offset) + (tail & (setup->entries - 1));
+
+        completions[count].user_data = (void *) (uintptr_t) cqe->user_data;
+        completions[count].result = cqe->result;
+        completions[count].size = cqe->size;
+        completions[count].error_code = cqe->error_code;
+
+        if (cqe->entry < setup->entries) {
+            uint8_t *target = master->acyclic_targets[cqe->entry];
+            if (target && cqe->size) {
+                memcpy(target, master->acyclic_memory + setup->data_offset
+                        + cqe->entry * setup->data_size, cqe->size);
+            }
+            master->acyclic_targets[cqe->entry] = NULL;
+            master->acyclic_free[master->acyclic_free_count++] = cqe->entry;
+        }
+
+        tail++;
+        count++;
+    }
+
+    __sync_synchronize();
+    *(volatile uint32_t *) &rings->cq_tail = tail;
+
+    if (count && rings->sq_tail != rings->sq_head) {
+        // submissions were deferred due to a full completion ring
+        ret = ioctl(master->fd, EC_IOCTL_ACYCLIC_SUBMIT, NULL);
+        if (EC_IOCTL_IS_ERROR(ret)) {
+            EC_PRINT_ERR("Failed to submit acyclic operations: %s\n",
+                    strerror(EC_IOCTL_ERRNO(ret)));
+            return -EC_IOCTL_ERRNO(ret);
+        }
+    }
+
+    return count;
+}
+
+/****************************************************************************/
+
 #if defined(EC_RTDM) && defined(EC_EOE)
 
 size_t ecrt_master_send_ext(ec_master_t *master)
@@ -865,6 +1841,12 @@ void ecrt_master_state(const ec_master_t *master, ec_master_state_t *state)
 {
     int ret;
 
+    if (master->state_page && !ec_master_read_state_page(master,
+                &master->state_page->master_seq, state,
+                &master->state_page->master_state, sizeof(*state))) {
+        return;
+    }
+
     ret = ioctl(master->fd, EC_IOCTL_MASTER_STATE, state);
     if (EC_IOCTL_IS_ERROR(ret)) {
         EC_PRINT_ERR("Failed to get master state: %s\n",
@@ -877,9 +1859,16 @@ void ecrt_master_state(const ec_master_t *master, ec_master_state_t *state)
 int ecrt_master_link_state(const ec_master_t *master, unsigned int dev_idx,
         ec_master_link_state_t *state)
 {
+    const ec_ioctl_state_page_t *page = master->state_page;
     ec_ioctl_link_state_t io;
     int ret;
 
+    if (page && dev_idx < EC_MAX_NUM_DEVICES && dev_idx < page->num_devices
+            && !ec_master_read_state_page(master, &page->master_seq, state,
+                &page->link_states[dev_idx], sizeof(*state))) {
+        return 0;
+    }
+
     io.dev_idx = dev_idx;
     io.state = state;
 
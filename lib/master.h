@@ -29,6 +29,20 @@
  *****************************************************************************/
 
 #include "include/ecrt.h"
+#include "ioctl.h"
+#include "index_table.h"
+
+/*****************************************************************************/
+
+/** Library data of a recorded configuration transaction operation.
+ */
+typedef struct {
+    ec_slave_config_t *sc; /**< Configuration created by the operation. */
+    unsigned int *offset; /**< Offset output of a PDO entry registration. */
+    unsigned int *bit_position; /**< Bit position output of a PDO entry
+                                  registration. */
+    uint8_t *sdo_data; /**< Copy of the SDO data. */
+} ec_txn_info_t;
 
 /*****************************************************************************/
 
@@ -39,10 +53,37 @@ struct ec_master {
 
     ec_domain_t *first_domain;
     ec_slave_config_t *first_config;
+    ec_index_table_t config_table;
+
+    const ec_ioctl_state_page_t *state_page;
+
+    ec_ioctl_cycle_ring_t *cycle_ring;
+    uint32_t cycle_head;
+    uint32_t cycle_tail;
+
+    int txn_active;
+    int txn_error;
+    ec_ioctl_txn_op_t *txn_ops;
+    ec_txn_info_t *txn_info;
+    unsigned int txn_count;
+    unsigned int txn_size;
+
+    uint8_t *acyclic_memory;
+    ec_ioctl_acyclic_setup_t acyclic_setup;
+    uint32_t *acyclic_free;
+    unsigned int acyclic_free_count;
+    uint8_t **acyclic_targets;
+
+    int share_request_data;
 };
 
 /*****************************************************************************/
 
 void ec_master_clear(ec_master_t *);
+ec_ioctl_txn_op_t *ec_master_txn_add(ec_master_t *, uint32_t,
+        const ec_slave_config_t *);
+int ec_master_txn_flush(ec_master_t *);
+int ec_master_read_state_page(const ec_master_t *, const uint32_t *,
+        void *, const void *, size_t);
 
 /*****************************************************************************/
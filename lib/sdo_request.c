@@ -45,7 +45,9 @@
 void ec_sdo_request_clear(ec_sdo_request_t *req)
 {
     if (req->data) {
-        free(req->data);
+        if (!req->mapped) {
+            free(req->data);
+        }
         req->data = NULL;
     }
 }
@@ -142,7 +144,9 @@ ec_request_state_t ecrt_sdo_request_state(ec_sdo_request_t *req)
         return EC_REQUEST_ERROR;
     }
 
-    if (data.size) { // new data waiting to be copied
+    if (data.size && req->mapped) { // data were received in place
+        req->data_size = data.size;
+    } else if (data.size) { // new data waiting to be copied
         if (req->mem_size < data.size) {
             EC_PRINT_ERR("Received %zu bytes do not fit info SDO data"
                     " memory (%zu bytes)!\n", data.size, req->mem_size);
@@ -190,7 +194,7 @@ void ecrt_sdo_request_write(ec_sdo_request_t *req)
 
     data.config_index = req->config->index;
     data.request_index = req->index;
-    data.data = req->data;
+    data.data = req->mapped ? NULL : req->data;
     data.size = req->data_size;
 
     ret = ioctl(req->config->master->fd, EC_IOCTL_SDO_REQUEST_WRITE, &data);
@@ -209,7 +213,7 @@ void ecrt_sdo_request_write_with_size(ec_sdo_request_t *req, size_t size)
 
     data.config_index = req->config->index;
     data.request_index = req->index;
-    data.data = req->data;
+    data.data = req->mapped ? NULL : req->data;
     data.size = size;
 
     ret = ioctl(req->config->master->fd, EC_IOCTL_SDO_REQUEST_WRITE, &data);
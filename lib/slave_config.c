@@ -94,6 +94,11 @@ void ec_slave_config_clear(ec_slave_config_t *sc)
     }
     sc->first_soe_request = NULL;
 
+    ec_index_table_clear(&sc->sdo_request_table);
+    ec_index_table_clear(&sc->soe_request_table);
+    ec_index_table_clear(&sc->foe_request_table);
+    ec_index_table_clear(&sc->reg_request_table);
+    ec_index_table_clear(&sc->voe_handler_table);
 }
 
 /*****************************************************************************/
@@ -107,6 +112,17 @@ int ecrt_slave_config_sync_manager(ec_slave_config_t *sc, uint8_t sync_index,
     if (sync_index >= EC_MAX_SYNC_MANAGERS)
         return -ENOENT;
 
+    if (sc->master->txn_active) {
+        ec_ioctl_txn_op_t *op = ec_master_txn_add(sc->master,
+                EC_IOCTL_TXN_SYNC_MANAGER, sc);
+        if (!op)
+            return -ENOMEM;
+        op->u.sync.sync_index = sync_index;
+        op->u.sync.dir = dir;
+        op->u.sync.watchdog_mode = watchdog_mode;
+        return 0;
+    }
+
     memset(&data, 0x00, sizeof(ec_ioctl_config_t));
     data.config_index = sc->index;
     data.syncs[sync_index].dir = dir;
@@ -131,6 +147,16 @@ void ecrt_slave_config_watchdog(ec_slave_config_t *sc,
     ec_ioctl_config_t data;
     int ret;
 
+    if (sc->master->txn_active) {
+        ec_ioctl_txn_op_t *op = ec_master_txn_add(sc->master,
+                EC_IOCTL_TXN_WATCHDOG, sc);
+        if (op) {
+            op->u.watchdog.divider = divider;
+            op->u.watchdog.intervals = intervals;
+        }
+        return;
+    }
+
     memset(&data, 0x00, sizeof(ec_ioctl_config_t));
     data.config_index = sc->index;
     data.watchdog_divider = divider;
@@ -168,6 +194,16 @@ int ecrt_slave_config_pdo_assign_add(ec_slave_config_t *sc,
     ec_ioctl_config_pdo_t data;
     int ret;
 
+    if (sc->master->txn_active) {
+        ec_ioctl_txn_op_t *op = ec_master_txn_add(sc->master,
+                EC_IOCTL_TXN_PDO_ASSIGN_ADD, sc);
+        if (!op)
+            return -ENOMEM;
+        op->u.pdo_assign.sync_index = sync_index;
+        op->u.pdo_assign.pdo_index = pdo_index;
+        return 0;
+    }
+
     data.config_index = sc->index;
     data.sync_index = sync_index;
     data.index = pdo_index;
@@ -190,6 +226,15 @@ void ecrt_slave_config_pdo_assign_clear(ec_slave_config_t *sc,
     ec_ioctl_config_pdo_t data;
     int ret;
 
+    if (sc->master->txn_active) {
+        ec_ioctl_txn_op_t *op = ec_master_txn_add(sc->master,
+                EC_IOCTL_TXN_PDO_ASSIGN_CLEAR, sc);
+        if (op) {
+            op->u.pdo_assign.sync_index = sync_index;
+        }
+        return;
+    }
+
     data.config_index = sc->index;
     data.sync_index = sync_index;
 
@@ -209,6 +254,18 @@ int ecrt_slave_config_pdo_mapping_add(ec_slave_config_t *sc,
     ec_ioctl_add_pdo_entry_t data;
     int ret;
 
+    if (sc->master->txn_active) {
+        ec_ioctl_txn_op_t *op = ec_master_txn_add(sc->master,
+                EC_IOCTL_TXN_PDO_MAPPING_ADD, sc);
+        if (!op)
+            return -ENOMEM;
+        op->u.pdo_mapping.pdo_index = pdo_index;
+        op->u.pdo_mapping.entry_index = entry_index;
+        op->u.pdo_mapping.entry_subindex = entry_subindex;
+        op->u.pdo_mapping.entry_bit_length = entry_bit_length;
+        return 0;
+    }
+
     data.config_index = sc->index;
     data.pdo_index = pdo_index;
     data.entry_index = entry_index;
@@ -233,6 +290,15 @@ void ecrt_slave_config_pdo_mapping_clear(ec_slave_config_t *sc,
     ec_ioctl_config_pdo_t data;
     int ret;
 
+    if (sc->master->txn_active) {
+        ec_ioctl_txn_op_t *op = ec_master_txn_add(sc->master,
+                EC_IOCTL_TXN_PDO_MAPPING_CLEAR, sc);
+        if (op) {
+            op->u.pdo_mapping.pdo_index = pdo_index;
+        }
+        return;
+    }
+
     data.config_index = sc->index;
     data.index = pdo_index;
 
@@ -320,6 +386,10 @@ int ecrt_slave_config_reg_pdo_entry(
     ec_ioctl_reg_pdo_entry_t data;
     int ret;
 
+    /* the offset is needed at once, so apply the recorded operations */
+    if (sc->master->txn_active && (ret = ec_master_txn_flush(sc->master)))
+        return ret;
+
     data.config_index = sc->index;
     data.entry_index = index;
     data.entry_subindex = subindex;
@@ -360,6 +430,10 @@ int ecrt_slave_config_reg_pdo_entry_pos(
     ec_ioctl_reg_pdo_pos_t io;
     int ret;
 
+    /* the offset is needed at once, so apply the recorded operations */
+    if (sc->master->txn_active && (ret = ec_master_txn_flush(sc->master)))
+        return ret;
+
     io.config_index = sc->index;
     io.sync_index = sync_index;
     io.pdo_pos = pdo_pos;
@@ -396,6 +470,19 @@ void ecrt_slave_config_dc(ec_slave_config_t *sc, uint16_t assign_activate,
     ec_ioctl_config_t data;
     int ret;
 
+    if (sc->master->txn_active) {
+        ec_ioctl_txn_op_t *op = ec_master_txn_add(sc->master,
+                EC_IOCTL_TXN_DC, sc);
+        if (op) {
+            op->u.dc.assign_activate = assign_activate;
+            op->u.dc.sync0_cycle_time = sync0_cycle_time;
+            op->u.dc.sync0_shift_time = sync0_shift_time;
+            op->u.dc.sync1_cycle_time = sync1_cycle_time;
+            op->u.dc.sync1_shift_time = sync1_shift_time;
+        }
+        return;
+    }
+
     data.config_index = sc->index;
     data.dc_assign_activate = assign_activate;
     data.dc_sync[0].cycle_time = sync0_cycle_time;
@@ -412,12 +499,51 @@ void ecrt_slave_config_dc(ec_slave_config_t *sc, uint16_t assign_activate,
 
 /*****************************************************************************/
 
+/** Records an SDO configuration in the configuration transaction.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_slave_config_txn_sdo(ec_slave_config_t *sc, uint16_t index,
+        uint8_t subindex, uint8_t complete_access, const uint8_t *sdo_data,
+        size_t size)
+{
+    ec_ioctl_txn_op_t *op;
+    uint8_t *copy;
+
+    if (!size)
+        return -EINVAL;
+
+    if (!(copy = malloc(size))) {
+        EC_PRINT_ERR("Failed to allocate memory.\n");
+        return -ENOMEM;
+    }
+    memcpy(copy, sdo_data, size);
+
+    if (!(op = ec_master_txn_add(sc->master, EC_IOCTL_TXN_SDO, sc))) {
+        free(copy);
+        return -ENOMEM;
+    }
+    op->u.sdo.index = index;
+    op->u.sdo.subindex = subindex;
+    op->u.sdo.complete_access = complete_access;
+    op->u.sdo.size = size;
+    op->u.sdo.data = copy;
+    sc->master->txn_info[sc->master->txn_count - 1].sdo_data = copy;
+    return 0;
+}
+
+/*****************************************************************************/
+
 int ecrt_slave_config_sdo(ec_slave_config_t *sc, uint16_t index,
         uint8_t subindex, const uint8_t *sdo_data, size_t size)
 {
     ec_ioctl_sc_sdo_t data;
     int ret;
 
+    if (sc->master->txn_active) {
+        return ec_slave_config_txn_sdo(sc, index, subindex, 0, sdo_data, size);
+    }
+
     data.config_index = sc->index;
     data.index = index;
     data.subindex = subindex;
@@ -477,6 +603,10 @@ int ecrt_slave_config_complete_sdo(ec_slave_config_t *sc, uint16_t index,
     ec_ioctl_sc_sdo_t data;
     int ret;
 
+    if (sc->master->txn_active) {
+        return ec_slave_config_txn_sdo(sc, index, 0, 1, sdo_data, size);
+    }
+
     data.config_index = sc->index;
     data.index = index;
     data.subindex = 0;
@@ -609,9 +739,14 @@ int ecrt_slave_config_emerg_overruns(ec_slave_config_t *sc)
 
 /*****************************************************************************/
 
-void ec_slave_config_add_sdo_request(ec_slave_config_t *sc,
+int ec_slave_config_add_sdo_request(ec_slave_config_t *sc,
         ec_sdo_request_t *req)
 {
+    if (ec_index_table_set(&sc->sdo_request_table, req->index, req)) {
+        EC_PRINT_ERR("Failed to allocate memory.\n");
+        return -ENOMEM;
+    }
+
     if (sc->first_sdo_request) {
         ec_sdo_request_t *r = sc->first_sdo_request;
         while (r->next) {
@@ -621,6 +756,8 @@ void ec_slave_config_add_sdo_request(ec_slave_config_t *sc,
     } else {
         sc->first_sdo_request = req;
     }
+
+    return 0;
 }
 
 /*****************************************************************************/
@@ -638,6 +775,8 @@ ec_sdo_request_t *ecrt_slave_config_create_sdo_request(ec_slave_config_t *sc,
         return 0;
     }
 
+    req->mapped = 0;
+
     if (size) {
         req->data = malloc(size);
         if (!req->data) {
@@ -673,16 +812,25 @@ ec_sdo_request_t *ecrt_slave_config_create_sdo_request(ec_slave_config_t *sc,
     req->data_size = size;
     req->mem_size = size;
 
-    ec_slave_config_add_sdo_request(sc, req);
+    if (ec_slave_config_add_sdo_request(sc, req)) {
+        ec_sdo_request_clear(req);
+        free(req);
+        return NULL;
+    }
 
     return req;
 }
 
 /*****************************************************************************/
 
-void ec_slave_config_add_soe_request(ec_slave_config_t *sc,
+int ec_slave_config_add_soe_request(ec_slave_config_t *sc,
         ec_soe_request_t *req)
 {
+    if (ec_index_table_set(&sc->soe_request_table, req->index, req)) {
+        EC_PRINT_ERR("Failed to allocate memory.\n");
+        return -ENOMEM;
+    }
+
     if (sc->first_soe_request) {
         ec_soe_request_t *r = sc->first_soe_request;
         while (r->next) {
@@ -692,6 +840,8 @@ void ec_slave_config_add_soe_request(ec_slave_config_t *sc,
     } else {
         sc->first_soe_request = req;
     }
+
+    return 0;
 }
 
 /*****************************************************************************/
@@ -708,6 +858,8 @@ ec_soe_request_t *ecrt_slave_config_create_soe_request(
         return 0;
     }
 
+    req->mapped = 0;
+
     if (size) {
         req->data = malloc(size);
         if (!req->data) {
@@ -742,7 +894,11 @@ ec_soe_request_t *ecrt_slave_config_create_soe_request(
     req->data_size = size;
     req->mem_size = size;
 
-    ec_slave_config_add_soe_request(sc, req);
+    if (ec_slave_config_add_soe_request(sc, req)) {
+        ec_soe_request_clear(req);
+        free(req);
+        return NULL;
+    }
 
     return req;
 }
@@ -762,6 +918,8 @@ ec_sdo_request_t *ecrt_slave_config_create_sdo_request_complete(ec_slave_config_
         return 0;
     }
 
+    req->mapped = 0;
+
     if (size) {
         req->data = malloc(size);
         if (!req->data) {
@@ -797,16 +955,25 @@ ec_sdo_request_t *ecrt_slave_config_create_sdo_request_complete(ec_slave_config_
     req->data_size = size;
     req->mem_size = size;
 
-    ec_slave_config_add_sdo_request(sc, req);
+    if (ec_slave_config_add_sdo_request(sc, req)) {
+        ec_sdo_request_clear(req);
+        free(req);
+        return NULL;
+    }
 
     return req;
 }
 
 /*****************************************************************************/
 
-void ec_slave_config_add_foe_request(ec_slave_config_t *sc,
+int ec_slave_config_add_foe_request(ec_slave_config_t *sc,
         ec_foe_request_t *req)
 {
+    if (ec_index_table_set(&sc->foe_request_table, req->index, req)) {
+        EC_PRINT_ERR("Failed to allocate memory.\n");
+        return -ENOMEM;
+    }
+
     if (sc->first_foe_request) {
         ec_foe_request_t *r = sc->first_foe_request;
         while (r->next) {
@@ -816,6 +983,8 @@ void ec_slave_config_add_foe_request(ec_slave_config_t *sc,
     } else {
         sc->first_foe_request = req;
     }
+
+    return 0;
 }
 
 /*****************************************************************************/
@@ -863,16 +1032,25 @@ ec_foe_request_t *ecrt_slave_config_create_foe_request(ec_slave_config_t *sc,
     req->data_size = size;
     req->mem_size = size;
 
-    ec_slave_config_add_foe_request(sc, req);
+    if (ec_slave_config_add_foe_request(sc, req)) {
+        ec_foe_request_clear(req);
+        free(req);
+        return NULL;
+    }
 
     return req;
 }
 
 /*****************************************************************************/
 
-void ec_slave_config_add_reg_request(ec_slave_config_t *sc,
+int ec_slave_config_add_reg_request(ec_slave_config_t *sc,
         ec_reg_request_t *reg)
 {
+    if (ec_index_table_set(&sc->reg_request_table, reg->index, reg)) {
+        EC_PRINT_ERR("Failed to allocate memory.\n");
+        return -ENOMEM;
+    }
+
     if (sc->first_reg_request) {
         ec_reg_request_t *r = sc->first_reg_request;
         while (r->next) {
@@ -882,6 +1060,8 @@ void ec_slave_config_add_reg_request(ec_slave_config_t *sc,
     } else {
         sc->first_reg_request = reg;
     }
+
+    return 0;
 }
 
 /*****************************************************************************/
@@ -928,16 +1108,25 @@ ec_reg_request_t *ecrt_slave_config_create_reg_request(ec_slave_config_t *sc,
     reg->index = io.request_index;
     reg->mem_size = size;
 
-    ec_slave_config_add_reg_request(sc, reg);
+    if (ec_slave_config_add_reg_request(sc, reg)) {
+        ec_reg_request_clear(reg);
+        free(reg);
+        return NULL;
+    }
 
     return reg;
 }
 
 /*****************************************************************************/
 
-void ec_slave_config_add_voe_handler(ec_slave_config_t *sc,
+int ec_slave_config_add_voe_handler(ec_slave_config_t *sc,
         ec_voe_handler_t *voe)
 {
+    if (ec_index_table_set(&sc->voe_handler_table, voe->index, voe)) {
+        EC_PRINT_ERR("Failed to allocate memory.\n");
+        return -ENOMEM;
+    }
+
     if (sc->first_voe_handler) {
         ec_voe_handler_t *v = sc->first_voe_handler;
         while (v->next) {
@@ -947,6 +1136,8 @@ void ec_slave_config_add_voe_handler(ec_slave_config_t *sc,
     } else {
         sc->first_voe_handler = voe;
     }
+
+    return 0;
 }
 
 /*****************************************************************************/
@@ -964,6 +1155,8 @@ ec_voe_handler_t *ecrt_slave_config_create_voe_handler(ec_slave_config_t *sc,
         return 0;
     }
 
+    voe->mapped = 0;
+
     if (size) {
         voe->data = malloc(size);
         if (!voe->data) {
@@ -994,7 +1187,11 @@ ec_voe_handler_t *ecrt_slave_config_create_voe_handler(ec_slave_config_t *sc,
     voe->data_size = size;
     voe->mem_size = size;
 
-    ec_slave_config_add_voe_handler(sc, voe);
+    if (ec_slave_config_add_voe_handler(sc, voe)) {
+        ec_voe_handler_clear(voe);
+        free(voe);
+        return NULL;
+    }
 
     return voe;
 }
@@ -29,6 +29,7 @@
  *****************************************************************************/
 
 #include "include/ecrt.h"
+#include "index_table.h"
 
 /*****************************************************************************/
 
@@ -43,6 +44,11 @@ struct ec_slave_config {
     ec_reg_request_t *first_reg_request;
     ec_voe_handler_t *first_voe_handler;
     ec_soe_request_t *first_soe_request;
+    ec_index_table_t sdo_request_table;
+    ec_index_table_t soe_request_table;
+    ec_index_table_t foe_request_table;
+    ec_index_table_t reg_request_table;
+    ec_index_table_t voe_handler_table;
 };
 
 /*****************************************************************************/
@@ -41,6 +41,7 @@ struct ec_soe_request {
     uint8_t *data; /**< Pointer to SOE data. */
     size_t mem_size; /**< Size of SOE data memory. */
     size_t data_size; /**< Size of SOE data. */
+    int mapped; /**< \a data is shared with the master. */
 };
 
 /*****************************************************************************/
@@ -46,7 +46,9 @@
 void ec_voe_handler_clear(ec_voe_handler_t *voe)
 {
     if (voe->data) {
-        free(voe->data);
+        if (!voe->mapped) {
+            free(voe->data);
+        }
         voe->data = NULL;
     }
 }
@@ -149,7 +151,7 @@ void ecrt_voe_handler_write(ec_voe_handler_t *voe, size_t size)
     data.config_index = voe->config->index;
     data.voe_index = voe->index;
     data.size = size;
-    data.data = voe->data;
+    data.data = voe->mapped ? NULL : voe->data;
 
     ret = ioctl(voe->config->master->fd, EC_IOCTL_VOE_WRITE, &data);
     if (EC_IOCTL_IS_ERROR(ret)) {
@@ -175,7 +177,9 @@ ec_request_state_t ecrt_voe_handler_execute(ec_voe_handler_t *voe)
         return EC_REQUEST_ERROR;
     }
 
-    if (data.size) { // new data waiting to be copied
+    if (data.size && voe->mapped) { // data were received in place
+        voe->data_size = data.size;
+    } else if (data.size) { // new data waiting to be copied
         if (voe->mem_size < data.size) {
             EC_PRINT_ERR("Received %zu bytes do not fit info VoE data"
                     " memory (%zu bytes)!\n", data.size, voe->mem_size);
@@ -39,6 +39,7 @@ struct ec_voe_handler {
     size_t data_size;
     size_t mem_size;
     uint8_t *data;
+    int mapped;
 };
 
 /*****************************************************************************/
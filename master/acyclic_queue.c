@@ -0,0 +1,660 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   EtherCAT acyclic submission and completion queue.
+*/
+
+/*****************************************************************************/
+
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+
+#include "master.h"
+#include "slave.h"
+#include "sdo_request.h"
+#include "soe_request.h"
+#include "foe_request.h"
+#include "reg_request.h"
+#include "acyclic_queue.h"
+
+/*****************************************************************************/
+
+/** Acyclic operation in progress.
+ */
+typedef struct {
+    struct list_head list; /**< List item. */
+    uint32_t entry; /**< Index of the submission entry. */
+    uint64_t user_data; /**< User data of the submission entry. */
+    uint16_t opcode; /**< Operation. */
+    uint32_t size; /**< Maximum number of bytes to receive. */
+    union {
+        ec_sdo_request_t sdo; /**< SDO request. */
+        ec_soe_request_t soe; /**< SoE request. */
+        ec_foe_request_t foe; /**< FoE request. */
+        ec_reg_request_t reg; /**< Register request. */
+    } u; /**< Request of the operation. */
+} ec_acyclic_queue_op_t;
+
+/*****************************************************************************/
+
+/** Acyclic queue constructor.
+ */
+void ec_acyclic_queue_init(
+        ec_acyclic_queue_t *queue, /**< Acyclic queue. */
+        ec_master_t *master /**< Parent master. */
+        )
+{
+    queue->master = master;
+    queue->memory = NULL;
+    queue->size = 0;
+    queue->rings = NULL;
+    queue->sq = NULL;
+    queue->sqes = NULL;
+    queue->cq = NULL;
+    queue->data = NULL;
+    queue->entries = 0;
+    queue->data_size = 0;
+    queue->sq_tail = 0;
+    queue->cq_head = 0;
+    INIT_LIST_HEAD(&queue->ops);
+    queue->op_count = 0;
+}
+
+/*****************************************************************************/
+
+/** Returns the request state of an operation.
+ *
+ * \return Request state.
+ */
+static ec_internal_request_state_t ec_acyclic_op_state(
+        const ec_acyclic_queue_op_t *op /**< Acyclic operation. */
+        )
+{
+    switch (op->opcode) {
+        case EC_IOCTL_ACYCLIC_SDO_UPLOAD:
+        case EC_IOCTL_ACYCLIC_SDO_DOWNLOAD:
+            return op->u.sdo.state;
+        case EC_IOCTL_ACYCLIC_SOE_READ:
+        case EC_IOCTL_ACYCLIC_SOE_WRITE:
+            return op->u.soe.state;
+        case EC_IOCTL_ACYCLIC_FOE_READ:
+        case EC_IOCTL_ACYCLIC_FOE_WRITE:
+            return op->u.foe.state;
+        default:
+            return op->u.reg.state;
+    }
+}
+
+/*****************************************************************************/
+
+/** Aborts an operation, that was not picked up by the slave FSM yet.
+ */
+static void ec_acyclic_op_abort(
+        ec_acyclic_queue_op_t *op /**< Acyclic operation. */
+        )
+{
+    switch (op->opcode) {
+        case EC_IOCTL_ACYCLIC_SDO_UPLOAD:
+        case EC_IOCTL_ACYCLIC_SDO_DOWNLOAD:
+            list_del_init(&op->u.sdo.list);
+            op->u.sdo.state = EC_INT_REQUEST_FAILURE;
+            break;
+        case EC_IOCTL_ACYCLIC_SOE_READ:
+        case EC_IOCTL_ACYCLIC_SOE_WRITE:
+            list_del_init(&op->u.soe.list);
+            op->u.soe.state = EC_INT_REQUEST_FAILURE;
+            break;
+        case EC_IOCTL_ACYCLIC_FOE_READ:
+        case EC_IOCTL_ACYCLIC_FOE_WRITE:
+            list_del_init(&op->u.foe.list);
+            op->u.foe.state = EC_INT_REQUEST_FAILURE;
+            break;
+        default:
+            list_del_init(&op->u.reg.list);
+            op->u.reg.state = EC_INT_REQUEST_FAILURE;
+            break;
+    }
+}
+
+/*****************************************************************************/
+
+/** Frees an operation.
+ */
+static void ec_acyclic_op_free(
+        ec_acyclic_queue_op_t *op /**< Acyclic operation. */
+        )
+{
+    switch (op->opcode) {
+        case EC_IOCTL_ACYCLIC_SDO_UPLOAD:
+        case EC_IOCTL_ACYCLIC_SDO_DOWNLOAD:
+            ec_sdo_request_clear(&op->u.sdo);
+            break;
+        case EC_IOCTL_ACYCLIC_SOE_READ:
+        case EC_IOCTL_ACYCLIC_SOE_WRITE:
+            ec_soe_request_clear(&op->u.soe);
+            break;
+        case EC_IOCTL_ACYCLIC_FOE_READ:
+        case EC_IOCTL_ACYCLIC_FOE_WRITE:
+            ec_foe_request_clear(&op->u.foe);
+            break;
+        default:
+            ec_reg_request_clear(&op->u.reg);
+            break;
+    }
+
+    kfree(op);
+}
+
+/*****************************************************************************/
+
+/** Acyclic queue destructor.
+ *
+ * Aborts all queued operations, waits for the ones in progress and frees the
+ * shared memory. This has to be called without the master_sem held.
+ */
+void ec_acyclic_queue_clear(
+        ec_acyclic_queue_t *queue /**< Acyclic queue. */
+        )
+{
+    ec_master_t *master = queue->master;
+    ec_acyclic_queue_op_t *op, *next;
+    uint8_t *memory;
+    LIST_HEAD(ops);
+
+    ec_lock_down(&master->master_sem);
+    list_for_each_entry(op, &queue->ops, list) {
+        if (ec_acyclic_op_state(op) == EC_INT_REQUEST_QUEUED) {
+            ec_acyclic_op_abort(op);
+        }
+    }
+    list_splice_init(&queue->ops, &ops);
+    queue->op_count = 0;
+    ec_lock_up(&master->master_sem);
+
+    list_for_each_entry_safe(op, next, &ops, list) {
+        // requests in progress can not be interrupted
+        wait_event(master->request_queue,
+                ec_acyclic_op_state(op) != EC_INT_REQUEST_BUSY);
+        list_del(&op->list);
+        ec_acyclic_op_free(op);
+    }
+
+    // eccdev_poll() looks at the rings with the master_sem held
+    ec_lock_down(&master->master_sem);
+    memory = queue->memory;
+    ec_acyclic_queue_init(queue, master);
+    ec_lock_up(&master->master_sem);
+
+    if (memory) {
+        vfree(memory);
+    }
+}
+
+/*****************************************************************************/
+
+/** Allocates the shared memory of the queue.
+ *
+ * The number of entries has to be a power of two. The offsets of the rings
+ * and the size of the memory are returned in \a setup.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_acyclic_queue_setup(
+        ec_acyclic_queue_t *queue, /**< Acyclic queue. */
+        ec_ioctl_acyclic_setup_t *setup /**< Setup parameters. */
+        )
+{
+    size_t offset;
+
+    if (queue->memory) {
+        return -EBUSY;
+    }
+
+    if (!setup->entries || setup->entries > EC_IOCTL_ACYCLIC_MAX_ENTRIES
+            || (setup->entries & (setup->entries - 1))) {
+        EC_MASTER_ERR(queue->master, "Invalid number of acyclic queue"
+                " entries: %u\n", setup->entries);
+        return -EINVAL;
+    }
+
+    if (!setup->data_size
+            || setup->data_size > EC_IOCTL_ACYCLIC_MAX_DATA_SIZE) {
+        EC_MASTER_ERR(queue->master, "Invalid acyclic queue data size:"
+                " %u\n", setup->data_size);
+        return -EINVAL;
+    }
+
+    offset = sizeof(ec_ioctl_acyclic_rings_t);
+    setup->sq_offset = offset;
+    offset = ALIGN(offset + setup->entries * sizeof(uint32_t),
+            EC_IOCTL_CACHE_LINE_SIZE);
+    setup->sqe_offset = offset;
+    offset = ALIGN(offset + setup->entries * sizeof(ec_ioctl_acyclic_sqe_t),
+            EC_IOCTL_CACHE_LINE_SIZE);
+    setup->cq_offset = offset;
+    offset = ALIGN(offset + setup->entries * sizeof(ec_ioctl_acyclic_cqe_t),
+            EC_IOCTL_CACHE_LINE_SIZE);
+    setup->data_offset = offset;
+    offset = PAGE_ALIGN(offset + (size_t) setup->entries * setup->data_size);
+    setup->size = offset;
+
+    queue->memory = vmalloc(offset);
+    if (!queue->memory) {
+        EC_MASTER_ERR(queue->master, "Failed to allocate %zu bytes of"
+                " acyclic queue memory.\n", offset);
+        return -ENOMEM;
+    }
+    memset(queue->memory, 0x00, offset);
+
+    queue->size = offset;
+    queue->rings = (ec_ioctl_acyclic_rings_t *) queue->memory;
+    queue->sq = (uint32_t *) (queue->memory + setup->sq_offset);
+    queue->sqes =
+        (ec_ioctl_acyclic_sqe_t *) (queue->memory + setup->sqe_offset);
+    queue->cq = (ec_ioctl_acyclic_cqe_t *) (queue->memory + setup->cq_offset);
+    queue->data = queue->memory + setup->data_offset;
+    queue->entries = setup->entries;
+    queue->data_size = setup->data_size;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Writes a completion to the completion ring.
+ *
+ * The caller has to make sure, that the completion ring is not full.
+ */
+static void ec_acyclic_queue_complete(
+        ec_acyclic_queue_t *queue, /**< Acyclic queue. */
+        uint32_t entry, /**< Index of the submission entry. */
+        uint64_t user_data, /**< User data. */
+        int result, /**< Result of the operation. */
+        size_t size, /**< Number of bytes received. */
+        uint32_t error_code /**< Error code. */
+        )
+{
+    ec_ioctl_acyclic_cqe_t *cqe =
+        &queue->cq[queue->cq_head & (queue->entries - 1)];
+
+    cqe->user_data = user_data;
+    cqe->entry = entry;
+    cqe->result = result;
+    cqe->size = size;
+    cqe->error_code = error_code;
+
+    queue->cq_head++;
+    smp_wmb();
+    WRITE_ONCE(queue->rings->cq_head, queue->cq_head);
+}
+
+/*****************************************************************************/
+
+/** Creates the request for a submission entry and schedules it.
+ *
+ * This has to be called with the master_sem held.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_acyclic_queue_start(
+        ec_acyclic_queue_t *queue, /**< Acyclic queue. */
+        uint32_t entry /**< Index of the submission entry. */
+        )
+{
+    ec_master_t *master = queue->master;
+    ec_ioctl_acyclic_sqe_t sqe;
+    const uint8_t *data;
+    ec_acyclic_queue_op_t *op;
+    ec_slave_t *slave;
+    int ret;
+
+    // the entry may be modified by the application at any time
+    memcpy(&sqe, &queue->sqes[entry], sizeof(sqe));
+    sqe.file_name[EC_IOCTL_ACYCLIC_FILE_NAME_SIZE - 1] = '\0';
+    data = queue->data + entry * queue->data_size;
+
+    if (sqe.opcode >= EC_IOCTL_ACYCLIC_OPCODE_COUNT) {
+        return -EINVAL;
+    }
+
+    if (sqe.size > queue->data_size) {
+        return -EOVERFLOW;
+    }
+
+    switch (sqe.opcode) {
+        case EC_IOCTL_ACYCLIC_SOE_READ:
+        case EC_IOCTL_ACYCLIC_SOE_WRITE:
+            if (sqe.subindex > 7) {
+                return -EINVAL; // invalid drive number
+            }
+            break;
+        case EC_IOCTL_ACYCLIC_SDO_DOWNLOAD:
+        case EC_IOCTL_ACYCLIC_FOE_READ:
+        case EC_IOCTL_ACYCLIC_REG_READ:
+        case EC_IOCTL_ACYCLIC_REG_WRITE:
+            if (!sqe.size) {
+                return -EINVAL;
+            }
+            break;
+    }
+
+    if (!(slave = ec_master_find_slave(master, 0, sqe.slave_position))) {
+        EC_MASTER_DBG(master, 1, "Slave %u does not exist!\n",
+                sqe.slave_position);
+        return -EINVAL;
+    }
+
+    if (!(op = kmalloc(sizeof(ec_acyclic_queue_op_t), GFP_KERNEL))) {
+        return -ENOMEM;
+    }
+
+    op->entry = entry;
+    op->user_data = sqe.user_data;
+    op->opcode = sqe.opcode;
+    op->size = sqe.size;
+
+    switch (sqe.opcode) {
+        case EC_IOCTL_ACYCLIC_SDO_UPLOAD:
+        case EC_IOCTL_ACYCLIC_SDO_DOWNLOAD:
+            ec_sdo_request_init(&op->u.sdo);
+            if (sqe.complete_access) {
+                ecrt_sdo_request_index_complete(&op->u.sdo, sqe.index);
+            } else {
+                ecrt_sdo_request_index(&op->u.sdo, sqe.index, sqe.subindex);
+            }
+            if (sqe.opcode == EC_IOCTL_ACYCLIC_SDO_UPLOAD) {
+                ecrt_sdo_request_read(&op->u.sdo);
+            } else {
+                ret = ec_sdo_request_copy_data(&op->u.sdo, data, sqe.size);
+                if (ret) {
+                    goto out_free;
+                }
+                ecrt_sdo_request_write(&op->u.sdo);
+            }
+            list_add_tail(&op->u.sdo.list, &slave->sdo_requests);
+            break;
+
+        case EC_IOCTL_ACYCLIC_SOE_READ:
+        case EC_IOCTL_ACYCLIC_SOE_WRITE:
+            ec_soe_request_init(&op->u.soe);
+            ec_soe_request_set_drive_no(&op->u.soe, sqe.subindex);
+            ec_soe_request_set_idn(&op->u.soe, sqe.index);
+            if (sqe.opcode == EC_IOCTL_ACYCLIC_SOE_READ) {
+                ec_soe_request_read(&op->u.soe);
+            } else {
+                ret = ec_soe_request_copy_data(&op->u.soe, data, sqe.size);
+                if (ret) {
+                    goto out_free;
+                }
+                ec_soe_request_write(&op->u.soe);
+            }
+            list_add_tail(&op->u.soe.list, &slave->soe_requests);
+            break;
+
+        case EC_IOCTL_ACYCLIC_FOE_READ:
+        case EC_IOCTL_ACYCLIC_FOE_WRITE:
+            ec_foe_request_init(&op->u.foe);
+            ecrt_foe_request_file(&op->u.foe, sqe.file_name, sqe.password);
+            if (sqe.opcode == EC_IOCTL_ACYCLIC_FOE_READ) {
+                ret = ec_foe_request_alloc(&op->u.foe, sqe.size);
+                if (ret) {
+                    goto out_free;
+                }
+                ecrt_foe_request_read(&op->u.foe);
+            } else {
+                ret = ec_foe_request_copy_data(&op->u.foe, data, sqe.size);
+                if (ret) {
+                    goto out_free;
+                }
+                ecrt_foe_request_write(&op->u.foe, sqe.size);
+            }
+            list_add_tail(&op->u.foe.list, &slave->foe_requests);
+            break;
+
+        default:
+            ret = ec_reg_request_init(&op->u.reg, sqe.size);
+            if (ret) {
+                kfree(op);
+                return ret;
+            }
+            if (sqe.opcode == EC_IOCTL_ACYCLIC_REG_READ) {
+                ecrt_reg_request_read(&op->u.reg, sqe.index, sqe.size);
+            } else {
+                memcpy(op->u.reg.data, data, sqe.size);
+                ecrt_reg_request_write(&op->u.reg, sqe.index, sqe.size);
+            }
+            list_add_tail(&op->u.reg.list, &slave->reg_requests);
+            break;
+    }
+
+    list_add_tail(&op->list, &queue->ops);
+    queue->op_count++;
+    return 0;
+
+out_free:
+    ec_acyclic_op_free(op);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Schedules the entries of the submission ring.
+ *
+ * Entries are only consumed, as long as there is space in the completion
+ * ring for all operations in progress. Invalid entries are completed
+ * immediately. This has to be called with the master_sem held.
+ *
+ * \return Number of consumed entries, otherwise a negative error code.
+ */
+int ec_acyclic_queue_submit(
+        ec_acyclic_queue_t *queue /**< Acyclic queue. */
+        )
+{
+    uint32_t head, entry;
+    unsigned int count = 0;
+    int ret;
+
+    if (!queue->memory) {
+        return -ENOMEM;
+    }
+
+    head = READ_ONCE(queue->rings->sq_head);
+    smp_rmb();
+
+    while (queue->sq_tail != head) {
+        if (queue->op_count + (queue->cq_head
+                    - READ_ONCE(queue->rings->cq_tail)) >= queue->entries) {
+            break; // completion ring may overflow
+        }
+
+        entry = READ_ONCE(queue->sq[queue->sq_tail & (queue->entries - 1)]);
+        if (entry >= queue->entries) {
+            ret = -EINVAL;
+        } else {
+            ret = ec_acyclic_queue_start(queue, entry);
+        }
+
+        if (ret) {
+            ec_acyclic_queue_complete(queue, entry,
+                    entry < queue->entries ?
+                    queue->sqes[entry].user_data : 0, ret, 0, 0);
+        }
+
+        queue->sq_tail++;
+        count++;
+    }
+
+    WRITE_ONCE(queue->rings->sq_tail, queue->sq_tail);
+    return count;
+}
+
+/*****************************************************************************/
+
+/** Completes a finished operation.
+ */
+static void ec_acyclic_queue_finish(
+        ec_acyclic_queue_t *queue, /**< Acyclic queue. */
+        ec_acyclic_queue_op_t *op /**< Finished operation. */
+        )
+{
+    uint8_t *data = queue->data + op->entry * queue->data_size;
+    const uint8_t *source = NULL;
+    size_t size = 0;
+    uint32_t error_code = 0;
+    int success, ret;
+
+    switch (op->opcode) {
+        case EC_IOCTL_ACYCLIC_SDO_UPLOAD:
+        case EC_IOCTL_ACYCLIC_SDO_DOWNLOAD:
+            success = op->u.sdo.state == EC_INT_REQUEST_SUCCESS;
+            ret = op->u.sdo.errno ? -op->u.sdo.errno : -EIO;
+            error_code = op->u.sdo.abort_code;
+            if (op->opcode == EC_IOCTL_ACYCLIC_SDO_UPLOAD) {
+                source = op->u.sdo.data;
+                size = op->u.sdo.data_size;
+            }
+            break;
+        case EC_IOCTL_ACYCLIC_SOE_READ:
+        case EC_IOCTL_ACYCLIC_SOE_WRITE:
+            success = op->u.soe.state == EC_INT_REQUEST_SUCCESS;
+            ret = -EIO;
+            error_code = op->u.soe.error_code;
+            if (op->opcode == EC_IOCTL_ACYCLIC_SOE_READ) {
+                source = op->u.soe.data;
+                size = op->u.soe.data_size;
+            }
+            break;
+        case EC_IOCTL_ACYCLIC_FOE_READ:
+        case EC_IOCTL_ACYCLIC_FOE_WRITE:
+            success = op->u.foe.state == EC_INT_REQUEST_SUCCESS;
+            ret = -EIO;
+            error_code = op->u.foe.result;
+            if (op->opcode == EC_IOCTL_ACYCLIC_FOE_READ) {
+                source = op->u.foe.buffer;
+                size = op->u.foe.data_size;
+            }
+            break;
+        default:
+            success = op->u.reg.state == EC_INT_REQUEST_SUCCESS;
+            ret = -EIO;
+            if (op->opcode == EC_IOCTL_ACYCLIC_REG_READ) {
+                source = op->u.reg.data;
+                size = op->u.reg.transfer_size;
+            }
+            break;
+    }
+
+    if (!success) {
+        size = 0;
+    } else if (size > op->size) {
+        ret = -EOVERFLOW;
+        size = 0;
+    } else {
+        if (size) {
+            memcpy(data, source, size);
+        }
+        ret = 0;
+    }
+
+    ec_acyclic_queue_complete(queue, op->entry, op->user_data, ret, size,
+            error_code);
+}
+
+/*****************************************************************************/
+
+/** Completes all finished operations.
+ *
+ * This has to be called with the master_sem held.
+ *
+ * \return Number of completed operations.
+ */
+unsigned int ec_acyclic_queue_reap(
+        ec_acyclic_queue_t *queue /**< Acyclic queue. */
+        )
+{
+    ec_acyclic_queue_op_t *op, *next;
+    ec_internal_request_state_t state;
+    unsigned int count = 0;
+
+    list_for_each_entry_safe(op, next, &queue->ops, list) {
+        state = ec_acyclic_op_state(op);
+        if (state != EC_INT_REQUEST_SUCCESS
+                && state != EC_INT_REQUEST_FAILURE) {
+            continue;
+        }
+
+        ec_acyclic_queue_finish(queue, op);
+        list_del(&op->list);
+        queue->op_count--;
+        ec_acyclic_op_free(op);
+        count++;
+    }
+
+    return count;
+}
+
+/*****************************************************************************/
+
+/** Checks for unread completions.
+ *
+ * \return Non-zero, if the completion ring is not empty.
+ */
+int ec_acyclic_queue_pending(
+        const ec_acyclic_queue_t *queue /**< Acyclic queue. */
+        )
+{
+    if (!queue->memory) {
+        return 0;
+    }
+
+    return READ_ONCE(queue->cq_head)
+        != READ_ONCE(queue->rings->cq_tail);
+}
+
+/*****************************************************************************/
+
+/** Looks up the page to map at a given offset of the shared memory.
+ *
+ * \return Page, or NULL if the offset is invalid.
+ */
+struct page *ec_acyclic_queue_page(
+        const ec_acyclic_queue_t *queue, /**< Acyclic queue. */
+        unsigned long offset /**< Offset in the shared memory. */
+        )
+{
+    if (!queue->memory || offset >= queue->size) {
+        return NULL;
+    }
+
+    return vmalloc_to_page(queue->memory + offset);
+}
+
+/*****************************************************************************/
@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   EtherCAT acyclic submission and completion queue.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_ACYCLIC_QUEUE_H__
+#define __EC_ACYCLIC_QUEUE_H__
+
+#include <linux/list.h>
+#include <linux/mm.h>
+
+#include "globals.h"
+#include "ioctl.h"
+
+/*****************************************************************************/
+
+/** Acyclic queue.
+ *
+ * Shared memory area with a submission and a completion ring, through which
+ * the application schedules SDO, SoE, FoE and register operations for
+ * arbitrary slaves. Each submitted operation is turned into an external
+ * request of the respective slave, so that the operations of different
+ * slaves are processed concurrently by the slave state machines.
+ */
+typedef struct {
+    ec_master_t *master; /**< Parent master. */
+    uint8_t *memory; /**< Shared memory, or NULL if not set up. */
+    size_t size; /**< Size of \a memory. */
+    ec_ioctl_acyclic_rings_t *rings; /**< Ring indices. */
+    uint32_t *sq; /**< Submission ring. */
+    ec_ioctl_acyclic_sqe_t *sqes; /**< Submission entries. */
+    ec_ioctl_acyclic_cqe_t *cq; /**< Completion ring. */
+    uint8_t *data; /**< Data areas of the submission entries. */
+    unsigned int entries; /**< Number of entries. */
+    size_t data_size; /**< Data size per entry. */
+    uint32_t sq_tail; /**< Number of consumed submissions. */
+    uint32_t cq_head; /**< Number of written completions. */
+    struct list_head ops; /**< Operations in progress. */
+    unsigned int op_count; /**< Number of operations in progress. */
+} ec_acyclic_queue_t;
+
+/*****************************************************************************/
+
+void ec_acyclic_queue_init(ec_acyclic_queue_t *, ec_master_t *);
+void ec_acyclic_queue_clear(ec_acyclic_queue_t *);
+
+int ec_acyclic_queue_setup(ec_acyclic_queue_t *, ec_ioctl_acyclic_setup_t *);
+int ec_acyclic_queue_submit(ec_acyclic_queue_t *);
+unsigned int ec_acyclic_queue_reap(ec_acyclic_queue_t *);
+int ec_acyclic_queue_pending(const ec_acyclic_queue_t *);
+struct page *ec_acyclic_queue_page(const ec_acyclic_queue_t *,
+        unsigned long);
+
+/*****************************************************************************/
+
+#endif
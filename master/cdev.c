@@ -35,6 +35,7 @@
 #include <linux/module.h>
 #include <linux/vmalloc.h>
 #include <linux/mm.h>
+#include <linux/poll.h>
 
 #include "cdev.h"
 #include "master.h"
@@ -54,6 +55,14 @@ static int eccdev_release(struct inode *, struct file *);
 static long eccdev_ioctl(struct file *, unsigned int, unsigned long);
 static int eccdev_mmap(struct file *, struct vm_area_struct *);
 
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4, 16, 0)
+# define POLL_RETURN_TYPE unsigned int
+#else
+# define POLL_RETURN_TYPE __poll_t
+#endif
+
+static POLL_RETURN_TYPE eccdev_poll(struct file *, poll_table *);
+
 /** This is the kernel version from which the .fault member of the
  * vm_operations_struct is usable.
  */
@@ -85,7 +94,8 @@ static struct file_operations eccdev_fops = {
     .open           = eccdev_open,
     .release        = eccdev_release,
     .unlocked_ioctl = eccdev_ioctl,
-    .mmap           = eccdev_mmap
+    .mmap           = eccdev_mmap,
+    .poll           = eccdev_poll
 };
 
 /** Callbacks for a virtual memory area retrieved with ecdevc_mmap().
@@ -167,6 +177,7 @@ int eccdev_open(struct inode *inode, struct file *filp)
     priv->ctx.requested = 0;
     priv->ctx.process_data = NULL;
     priv->ctx.process_data_size = 0;
+    priv->ctx.share_request_data = 0;
 
     filp->private_data = priv;
 
@@ -220,6 +231,37 @@ long eccdev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 
 /*****************************************************************************/
 
+/** Called when the cdev is polled.
+ *
+ * The file handle becomes readable, as soon as there are request completions
+ * to read with EC_IOCTL_COMPLETIONS_READ or from the completion ring of the
+ * acyclic queue.
+ *
+ * \return Poll mask.
+ */
+POLL_RETURN_TYPE eccdev_poll(struct file *filp, poll_table *wait)
+{
+    ec_cdev_priv_t *priv = (ec_cdev_priv_t *) filp->private_data;
+    ec_master_t *master = priv->cdev->master;
+    POLL_RETURN_TYPE mask = 0;
+    int pending;
+
+    poll_wait(filp, &master->completion_queue, wait);
+
+    // the acyclic queue may be cleared concurrently
+    ec_lock_down(&master->master_sem);
+    pending = ec_master_completions_pending(master);
+    ec_lock_up(&master->master_sem);
+
+    if (pending) {
+        mask |= POLLIN | POLLRDNORM;
+    }
+
+    return mask;
+}
+
+/*****************************************************************************/
+
 #ifndef VM_DONTDUMP
 /** VM_RESERVED disappeared in 3.7.
  */
@@ -229,9 +271,13 @@ long eccdev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 /** Memory-map callback for the EtherCAT character device.
  *
  * The actual mapping will be done in the eccdev_vma_nopage() callback of the
- * virtual memory area.
+ * virtual memory area. The state page at EC_IOCTL_STATE_PAGE_OFFSET may only
+ * be mapped read-only, the cycle ring at EC_IOCTL_CYCLE_RING_OFFSET and the
+ * acyclic queue at EC_IOCTL_ACYCLIC_QUEUE_OFFSET only by the file handle
+ * that requested the master. A mapping must not span more than one of these
+ * areas.
  *
- * \return Always zero (success).
+ * \return Zero on success, otherwise a negative error code.
  */
 int eccdev_mmap(
         struct file *filp,
@@ -239,9 +285,36 @@ int eccdev_mmap(
         )
 {
     ec_cdev_priv_t *priv = (ec_cdev_priv_t *) filp->private_data;
+    unsigned long end = vma->vm_pgoff + vma_pages(vma), limit;
 
     EC_MASTER_DBG(priv->cdev->master, 1, "mmap()\n");
 
+    // the mapping must not reach into the following area
+    if (vma->vm_pgoff >= (EC_IOCTL_STATE_PAGE_OFFSET >> PAGE_SHIFT)) {
+        if (vma->vm_flags & VM_WRITE) {
+            return -EPERM;
+        }
+        vma->vm_flags &= ~VM_MAYWRITE;
+        limit = (EC_IOCTL_STATE_PAGE_OFFSET >> PAGE_SHIFT) + 1;
+    } else if (vma->vm_pgoff >=
+            (EC_IOCTL_ACYCLIC_QUEUE_OFFSET >> PAGE_SHIFT)) {
+        if (!priv->ctx.requested) {
+            return -EPERM;
+        }
+        limit = EC_IOCTL_STATE_PAGE_OFFSET >> PAGE_SHIFT;
+    } else if (vma->vm_pgoff >= (EC_IOCTL_CYCLE_RING_OFFSET >> PAGE_SHIFT)) {
+        if (!priv->ctx.requested) {
+            return -EPERM;
+        }
+        limit = (EC_IOCTL_CYCLE_RING_OFFSET >> PAGE_SHIFT) + 1;
+    } else {
+        limit = EC_IOCTL_CYCLE_RING_OFFSET >> PAGE_SHIFT;
+    }
+
+    if (end < vma->vm_pgoff || end > limit) {
+        return -EINVAL;
+    }
+
     vma->vm_ops = &eccdev_vm_ops;
     vma->vm_flags |= VM_DONTDUMP; /* Pages will not be swapped out */
     vma->vm_private_data = priv;
@@ -251,6 +324,43 @@ int eccdev_mmap(
 
 /*****************************************************************************/
 
+/** Looks up the page to map at a given offset.
+ *
+ * \return Page, or NULL if the offset is invalid.
+ */
+static struct page *eccdev_lookup_page(
+        ec_cdev_priv_t *priv, /**< Private data of the file handle. */
+        unsigned long offset /**< Offset in the mapping. */
+        )
+{
+    if (offset >= EC_IOCTL_STATE_PAGE_OFFSET) {
+        if (offset - EC_IOCTL_STATE_PAGE_OFFSET >= PAGE_SIZE) {
+            return NULL;
+        }
+        return virt_to_page(priv->cdev->master->state_page);
+    }
+
+    if (offset >= EC_IOCTL_ACYCLIC_QUEUE_OFFSET) {
+        return ec_acyclic_queue_page(&priv->cdev->master->acyclic_queue,
+                offset - EC_IOCTL_ACYCLIC_QUEUE_OFFSET);
+    }
+
+    if (offset >= EC_IOCTL_CYCLE_RING_OFFSET) {
+        if (offset - EC_IOCTL_CYCLE_RING_OFFSET >= PAGE_SIZE) {
+            return NULL;
+        }
+        return virt_to_page(priv->cdev->master->cycle_ring);
+    }
+
+    if (offset >= priv->ctx.process_data_size) {
+        return NULL;
+    }
+
+    return vmalloc_to_page(priv->ctx.process_data + offset);
+}
+
+/*****************************************************************************/
+
 #if LINUX_VERSION_CODE >= PAGE_FAULT_VERSION
 
 /** Page fault callback for a virtual memory area.
@@ -274,11 +384,7 @@ static FAULT_RETURN_TYPE eccdev_vma_fault(
     ec_cdev_priv_t *priv = (ec_cdev_priv_t *) vma->vm_private_data;
     struct page *page;
 
-    if (offset >= priv->ctx.process_data_size) {
-        return VM_FAULT_SIGBUS;
-    }
-
-    page = vmalloc_to_page(priv->ctx.process_data + offset);
+    page = eccdev_lookup_page(priv, offset);
     if (!page) {
         return VM_FAULT_SIGBUS;
     }
@@ -317,11 +423,10 @@ struct page *eccdev_vma_nopage(
 
     offset = (address - vma->vm_start) + (vma->vm_pgoff << PAGE_SHIFT);
 
-    if (offset >= priv->ctx.process_data_size)
+    page = eccdev_lookup_page(priv, offset);
+    if (!page)
         return NOPAGE_SIGBUS;
 
-    page = vmalloc_to_page(priv->ctx.process_data + offset);
-
     EC_MASTER_DBG(master, 1, "Nopage fault vma, address = %#lx,"
             " offset = %#lx, page = %p\n", address, offset, page);
 
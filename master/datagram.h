@@ -88,17 +88,23 @@ typedef enum {
 typedef struct {
     struct list_head queue; /**< Master datagram queue item. */
     struct list_head sent; /**< Master list item for sent datagrams. */
+    struct list_head timeout; /**< Master list item for timeout
+                                supervision. */
     ec_device_index_t device_index; /**< Device via which the datagram shall
                                       be / was sent. */
     ec_datagram_type_t type; /**< Datagram type (APRD, BWR, etc.). */
     uint8_t address[EC_ADDR_LEN]; /**< Recipient address. */
     uint8_t *data; /**< Datagram payload. */
+    const uint8_t *tx_data; /**< Payload to transmit instead of \a data, or
+                              NULL. The received payload is still stored in
+                              \a data. */
     ec_origin_t data_origin; /**< Origin of the \a data memory. */
     size_t mem_size; /**< Datagram \a data memory size. */
     size_t data_size; /**< Size of the data in \a data. */
     uint8_t index; /**< Index (set by master). */
     uint16_t working_counter; /**< Working counter. */
     ec_datagram_state_t state; /**< State. */
+    ec_traffic_class_t traffic_class; /**< Traffic class for scheduling. */
 #ifdef EC_HAVE_CYCLES
     cycles_t cycles_sent; /**< Time, when the datagram was sent. */
 #endif
@@ -35,6 +35,7 @@
 /*****************************************************************************/
 
 #include <linux/slab.h>
+#include <linux/bitmap.h>
 
 #include "master.h"
 #include "datagram_pair.h"
@@ -59,6 +60,13 @@ int ec_datagram_pair_init(
 
     INIT_LIST_HEAD(&pair->list);
     pair->domain = domain;
+#if EC_MAX_NUM_DEVICES > 1
+    pair->send_buffer = NULL;
+    pair->inputs = NULL;
+    pair->input_count = 0;
+    pair->main_changed = NULL;
+    pair->backup_changed = NULL;
+#endif
 
     for (dev_idx = EC_DEVICE_MAIN;
             dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
@@ -67,6 +75,7 @@ int ec_datagram_pair_init(
                 EC_DATAGRAM_NAME_SIZE, "domain%u-%u-%s", domain->index,
                 logical_offset, ec_device_names[dev_idx != 0]);
         pair->datagrams[dev_idx].device_index = dev_idx;
+        pair->datagrams[dev_idx].traffic_class = EC_TRAFFIC_CYCLIC;
     }
 
     pair->expected_working_counter = 0U;
@@ -87,6 +96,12 @@ int ec_datagram_pair_init(
         ret = -ENOMEM;
         goto out_datagrams;
     }
+
+    /* backup datagrams transmit the snapshot of the main payload */
+    for (dev_idx = EC_DEVICE_BACKUP;
+            dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
+        pair->datagrams[dev_idx].tx_data = pair->send_buffer;
+    }
 #endif
 
     /* The ec_datagram_lxx() calls below can not fail, because either the
@@ -164,6 +179,8 @@ void ec_datagram_pair_clear(
     if (pair->send_buffer) {
         kfree(pair->send_buffer);
     }
+    kfree(pair->inputs);
+    kfree(pair->main_changed);
 #endif
 }
 
@@ -199,3 +216,114 @@ uint16_t ec_datagram_pair_process(
 }
 
 /*****************************************************************************/
+
+#if EC_MAX_NUM_DEVICES > 1
+
+/** Adds an input FMMU range for the redundancy change detection.
+ *
+ * Ranges have to be added in ascending offset order.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_datagram_pair_add_input(
+        ec_datagram_pair_t *pair, /**< Datagram pair. */
+        uint32_t offset, /**< Offset in the datagram data. */
+        uint32_t size /**< Size of the range. */
+        )
+{
+    unsigned int count = pair->input_count + 1;
+    ec_datagram_pair_range_t *inputs;
+    unsigned long *changed;
+
+    inputs = krealloc(pair->inputs, count * sizeof(*inputs), GFP_KERNEL);
+    if (!inputs) {
+        return -ENOMEM;
+    }
+    pair->inputs = inputs;
+
+    changed = krealloc(pair->main_changed,
+            2 * BITS_TO_LONGS(count) * sizeof(unsigned long), GFP_KERNEL);
+    if (!changed) {
+        return -ENOMEM;
+    }
+    pair->main_changed = changed;
+    pair->backup_changed = changed + BITS_TO_LONGS(count);
+
+    inputs[pair->input_count].offset = offset;
+    inputs[pair->input_count].size = size;
+    pair->input_count = count;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Checks, if received data differ from the sent data.
+ *
+ * Compares word by word and does not return at the first difference, so
+ * that the run time of one call only depends on the size.
+ *
+ * \return Non-zero, if the data differ.
+ */
+static inline int ec_datagram_pair_differs(
+        const uint8_t *sent, /**< Sent data. */
+        const uint8_t *recv, /**< Received data. */
+        size_t size /**< Number of bytes. */
+        )
+{
+    unsigned long diff = 0, a, b;
+    size_t i = 0;
+
+    for (; i + sizeof(a) <= size; i += sizeof(a)) {
+        memcpy(&a, sent + i, sizeof(a));
+        memcpy(&b, recv + i, sizeof(b));
+        diff |= a ^ b;
+    }
+
+    for (; i < size; i++) {
+        diff |= sent[i] ^ recv[i];
+    }
+
+    return diff != 0;
+}
+
+/*****************************************************************************/
+
+/** Detects the input changes on the main and the backup link.
+ *
+ * Compares the received data of all input ranges with the send buffer in
+ * one pass. Afterwards, \a main_changed has a bit set for every range, that
+ * changed on the main link, and \a backup_changed for every range, that
+ * changed on the backup link only. The backup data of a range are only
+ * compared, if the range did not change on the main link and the backup
+ * datagram was received, because the backup memory is not refreshed on
+ * transmission. So the total run time depends on the data.
+ */
+void ec_datagram_pair_detect_changes(
+        ec_datagram_pair_t *pair /**< Datagram pair. */
+        )
+{
+    const ec_datagram_t *backup = &pair->datagrams[EC_DEVICE_BACKUP];
+    const uint8_t *sent = pair->send_buffer;
+    const uint8_t *main_data = pair->datagrams[EC_DEVICE_MAIN].data;
+    const ec_datagram_pair_range_t *range;
+    unsigned int i;
+
+    bitmap_zero(pair->main_changed, pair->input_count);
+    bitmap_zero(pair->backup_changed, pair->input_count);
+
+    for (i = 0; i < pair->input_count; i++) {
+        range = &pair->inputs[i];
+        if (ec_datagram_pair_differs(sent + range->offset,
+                    main_data + range->offset, range->size)) {
+            __set_bit(i, pair->main_changed);
+        } else if (backup->state == EC_DATAGRAM_RECEIVED
+                && ec_datagram_pair_differs(sent + range->offset,
+                    backup->data + range->offset, range->size)) {
+            __set_bit(i, pair->backup_changed);
+        }
+    }
+}
+
+#endif
+
+/*****************************************************************************/
@@ -44,6 +44,19 @@
 
 /*****************************************************************************/
 
+#if EC_MAX_NUM_DEVICES > 1
+
+/** Input FMMU range of a datagram pair, relative to the datagram data.
+ */
+typedef struct {
+    uint32_t offset; /**< Offset in the datagram data. */
+    uint32_t size; /**< Size of the range. */
+} ec_datagram_pair_range_t;
+
+#endif
+
+/*****************************************************************************/
+
 /** Domain datagram pair.
  */
 typedef struct {
@@ -52,6 +65,12 @@ typedef struct {
     ec_datagram_t datagrams[EC_MAX_NUM_DEVICES]; /**< Datagrams.  */
 #if EC_MAX_NUM_DEVICES > 1
     uint8_t *send_buffer;
+    ec_datagram_pair_range_t *inputs; /**< Input FMMU ranges, sorted by
+                                        offset. */
+    unsigned int input_count; /**< Number of \a inputs. */
+    unsigned long *main_changed; /**< Inputs changed on the main link. */
+    unsigned long *backup_changed; /**< Inputs changed only on the backup
+                                     link. */
 #endif
     unsigned int expected_working_counter; /**< Expectord working conter. */
 } ec_datagram_pair_t;
@@ -64,6 +83,11 @@ void ec_datagram_pair_clear(ec_datagram_pair_t *);
 
 uint16_t ec_datagram_pair_process(ec_datagram_pair_t *, uint16_t[]);
 
+#if EC_MAX_NUM_DEVICES > 1
+int ec_datagram_pair_add_input(ec_datagram_pair_t *, uint32_t, uint32_t);
+void ec_datagram_pair_detect_changes(ec_datagram_pair_t *);
+#endif
+
 /*****************************************************************************/
 
 #endif
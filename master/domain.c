@@ -35,6 +35,7 @@
 /*****************************************************************************/
 
 #include <linux/module.h>
+#include <linux/sort.h>
 
 #include "globals.h"
 #include "master.h"
@@ -42,6 +43,7 @@
 
 #include "domain.h"
 #include "datagram_pair.h"
+#include "frame_template.h"
 
 /** Extra debug output for redundancy functions.
  */
@@ -76,6 +78,7 @@ void ec_domain_init(
     domain->data_origin = EC_ORIG_INTERNAL;
     domain->logical_base_address = 0x00000000;
     INIT_LIST_HEAD(&domain->datagram_pairs);
+    INIT_LIST_HEAD(&domain->frame_templates);
     for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
             dev_idx++) {
         domain->working_counter[dev_idx] = 0x0000;
@@ -83,11 +86,32 @@ void ec_domain_init(
     domain->expected_working_counter = 0x0000;
     domain->working_counter_changes = 0;
     domain->redundancy_active = 0;
+    domain->period = 1;
+    domain->phase = 0;
+    domain->countdown = 0;
+    domain->exchanged = 0;
+    domain->stale_cycles = 0;
     domain->notify_jiffies = 0;
 
     /* Used by ec_domain_add_fmmu_config */
     memset(domain->offset_used, 0, sizeof(domain->offset_used));
     domain->sc_in_work = 0;
+
+    domain->optimize_layout = 0;
+    domain->layout_done = 0;
+    domain->remap = NULL;
+    domain->remap_count = 0;
+    domain->offset_refs = NULL;
+    domain->offset_ref_count = 0;
+
+    domain->overlapping_pdos = 0;
+    domain->wire_data = NULL;
+    domain->wire_size = 0;
+    domain->shadow = NULL;
+    domain->shadow_count = 0;
+
+    /* Reset state left over by a former domain with the same index. */
+    ec_master_publish_domain_state(master, domain);
 }
 
 /*****************************************************************************/
@@ -97,14 +121,32 @@ void ec_domain_init(
 void ec_domain_clear(ec_domain_t *domain /**< EtherCAT domain */)
 {
     ec_datagram_pair_t *datagram_pair, *next_pair;
+    ec_frame_template_t *tmpl, *next_tmpl;
+    ec_device_index_t dev_idx;
+
+    list_for_each_entry_safe(tmpl, next_tmpl,
+            &domain->frame_templates, list) {
+        list_del(&tmpl->list);
+        kfree(tmpl);
+    }
 
     // dequeue and free datagrams
     list_for_each_entry_safe(datagram_pair, next_pair,
             &domain->datagram_pairs, list) {
+        for (dev_idx = EC_DEVICE_MAIN;
+                dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
+            ec_master_forget_datagram(domain->master,
+                    &datagram_pair->datagrams[dev_idx]);
+        }
         ec_datagram_pair_clear(datagram_pair);
         kfree(datagram_pair);
     }
 
+    kfree(domain->remap);
+    kfree(domain->offset_refs);
+    kfree(domain->wire_data);
+    kfree(domain->shadow);
+
     ec_domain_clear_data(domain);
 }
 
@@ -276,6 +318,10 @@ static int emplace_datagram(ec_domain_t *domain,
     unsigned int datagram_used[EC_DIR_COUNT];
     const ec_fmmu_config_t *curr_fmmu;
     size_t data_size;
+    int ret;
+#if EC_MAX_NUM_DEVICES > 1
+    ec_datagram_pair_t *datagram_pair;
+#endif
 
     data_size = datagram_end_offset - datagram_begin_offset;
 
@@ -288,11 +334,535 @@ static int emplace_datagram(ec_domain_t *domain,
         }
     }
 
-    return ec_domain_add_datagram_pair(domain,
+    ret = ec_domain_add_datagram_pair(domain,
             domain->logical_base_address + datagram_begin_offset,
             data_size,
-            domain->data + datagram_begin_offset,
+            ec_domain_wire_data(domain) + datagram_begin_offset,
             datagram_used);
+    if (ret < 0)
+        return ret;
+
+#if EC_MAX_NUM_DEVICES > 1
+    /* Remember the input ranges for the redundancy change detection. */
+    datagram_pair = list_entry(domain->datagram_pairs.prev,
+            ec_datagram_pair_t, list);
+    for (curr_fmmu = datagram_first_fmmu;
+            &curr_fmmu->list != &datagram_end_fmmu->list;
+            curr_fmmu = list_next_entry(curr_fmmu, list)) {
+        if (curr_fmmu->dir != EC_DIR_INPUT) {
+            continue;
+        }
+        ret = ec_datagram_pair_add_input(datagram_pair,
+                curr_fmmu->logical_domain_offset - datagram_begin_offset,
+                curr_fmmu->data_size);
+        if (ret < 0) {
+            EC_MASTER_ERR(domain->master, "Failed to allocate"
+                    " redundancy ranges!\n");
+            return ret;
+        }
+    }
+#endif
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Builds the frame templates for the domain datagrams.
+ *
+ * The datagrams of each device are packed into frames in datagram pair
+ * order.
+ *
+ * \retval  0 Success
+ * \retval <0 Error code.
+ */
+static int ec_domain_build_frame_templates(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    ec_datagram_pair_t *datagram_pair;
+    ec_frame_template_t *tmpl;
+    ec_device_index_t dev_idx;
+
+    for (dev_idx = EC_DEVICE_MAIN;
+            dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
+        tmpl = NULL;
+
+        list_for_each_entry(datagram_pair, &domain->datagram_pairs, list) {
+            ec_datagram_t *datagram = &datagram_pair->datagrams[dev_idx];
+
+            if (tmpl && !ec_frame_template_add(tmpl, datagram)) {
+                continue;
+            }
+
+            if (!(tmpl = kmalloc(sizeof(ec_frame_template_t), GFP_KERNEL))) {
+                EC_MASTER_ERR(domain->master, "Failed to allocate"
+                        " frame template!\n");
+                return -ENOMEM;
+            }
+
+            ec_frame_template_init(tmpl, dev_idx);
+            list_add_tail(&tmpl->list, &domain->frame_templates);
+            ec_frame_template_add(tmpl, datagram);
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** FMMU placement used by the layout optimizer.
+ */
+typedef struct {
+    ec_fmmu_config_t *fmmu; /**< FMMU configuration. */
+    unsigned int pos; /**< Registration order. */
+    uint8_t residues; /**< Bit mask of start offsets (modulo 8), that align
+                        the most PDO entries naturally. */
+    unsigned int bin; /**< Datagram the FMMU is placed in. */
+    uint32_t offset; /**< Offset in the datagram, later in the domain. */
+} ec_domain_layout_item_t;
+
+/*****************************************************************************/
+
+/** Determines the FMMU start offsets, that naturally align the most
+ * byte-aligned 16, 32 and 64 bit PDO entries.
+ *
+ * \return Bit mask of suitable start offsets modulo 8.
+ */
+static uint8_t ec_domain_fmmu_residues(
+        const ec_fmmu_config_t *fmmu /**< FMMU configuration. */
+        )
+{
+    const ec_sync_config_t *sync_config =
+        &fmmu->sc->sync_configs[fmmu->sync_index];
+    const ec_pdo_t *pdo;
+    const ec_pdo_entry_t *entry;
+    unsigned int score[8] = {}, bit_offset = 0, size, r, best = 0;
+    uint8_t residues = 0;
+
+    list_for_each_entry(pdo, &sync_config->pdos.list, list) {
+        list_for_each_entry(entry, &pdo->entries, list) {
+            size = entry->bit_length / 8;
+            if (!(bit_offset % 8) && !(entry->bit_length % 8)
+                    && (size == 2 || size == 4 || size == 8)) {
+                for (r = 0; r < 8; r++) {
+                    if (!((r + bit_offset / 8) % size)) {
+                        score[r] += size;
+                    }
+                }
+            }
+            bit_offset += entry->bit_length;
+        }
+    }
+
+    for (r = 0; r < 8; r++) {
+        best = max(best, score[r]);
+    }
+    for (r = 0; r < 8; r++) {
+        if (score[r] == best) {
+            residues |= 1 << r;
+        }
+    }
+
+    return residues;
+}
+
+/*****************************************************************************/
+
+/** Advances an offset to the next one matching a residue mask.
+ */
+static uint32_t ec_domain_align_offset(
+        uint32_t offset, /**< Candidate offset. */
+        uint8_t residues /**< Residue mask (non-zero). */
+        )
+{
+    while (!(residues & (1 << (offset % 8)))) {
+        offset++;
+    }
+    return offset;
+}
+
+/*****************************************************************************/
+
+/** Placement order: Outputs first, then larger FMMUs first.
+ */
+static int ec_domain_cmp_placement(const void *a, const void *b)
+{
+    const ec_domain_layout_item_t *x = a, *y = b;
+
+    if (x->fmmu->dir != y->fmmu->dir) {
+        return x->fmmu->dir == EC_DIR_OUTPUT ? -1 : 1;
+    }
+    if (x->fmmu->data_size != y->fmmu->data_size) {
+        return x->fmmu->data_size > y->fmmu->data_size ? -1 : 1;
+    }
+    return x->pos < y->pos ? -1 : x->pos > y->pos;
+}
+
+/*****************************************************************************/
+
+/** Domain order: Ascending domain offset.
+ */
+static int ec_domain_cmp_offset(const void *a, const void *b)
+{
+    const ec_domain_layout_item_t *x = a, *y = b;
+
+    if (x->offset != y->offset) {
+        return x->offset < y->offset ? -1 : 1;
+    }
+    return x->pos < y->pos ? -1 : x->pos > y->pos;
+}
+
+/*****************************************************************************/
+
+/** Counts the datagrams, that ec_domain_finish() would create for the
+ * current (non-overlapping) layout.
+ */
+static unsigned int ec_domain_datagram_count(
+        const ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    const ec_fmmu_config_t *fmmu;
+    uint32_t datagram_offset = 0;
+    unsigned int count = 0;
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        if (fmmu->logical_domain_offset + fmmu->data_size - datagram_offset
+                > EC_MAX_DATA_SIZE) {
+            datagram_offset = fmmu->logical_domain_offset;
+            count++;
+        }
+    }
+
+    return count + (domain->data_size > datagram_offset);
+}
+
+/*****************************************************************************/
+
+/** Rearranges the FMMUs of a domain to reduce the number of datagrams and to
+ * align multi-byte PDO entries naturally.
+ *
+ * FMMUs are packed first-fit into datagrams of at most EC_MAX_DATA_SIZE
+ * bytes, outputs before inputs and larger FMMUs first. The registration
+ * layout is kept, if it needs fewer datagrams. Offsets returned at
+ * registration are translated via the domain's remap table.
+ *
+ * Has to be called with the master semaphore held, before
+ * ec_domain_finish(). Does nothing, if the optimization was not requested or
+ * has already been done.
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
+ */
+int ec_domain_optimize_layout(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    ec_domain_layout_item_t *items;
+    ec_domain_remap_t *remap;
+    ec_fmmu_config_t *fmmu;
+    uint32_t *bins, start, size, data_size = 0;
+    size_t old_size = domain->data_size;
+    unsigned int count = 0, bin_count = 0, old_count, i, b;
+
+    if (!domain->optimize_layout || domain->layout_done) {
+        return 0;
+    }
+    domain->layout_done = 1;
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        if (fmmu->sc->allow_overlapping_pdos || domain->overlapping_pdos) {
+            EC_MASTER_WARN(domain->master, "Domain%u: Not optimizing the"
+                    " layout, because of overlapping PDOs.\n",
+                    domain->index);
+            return 0;
+        }
+        if (fmmu->data_size > EC_MAX_DATA_SIZE) {
+            return 0; // reported by ec_domain_finish()
+        }
+        count++;
+    }
+
+    if (!count) {
+        return 0;
+    }
+
+    items = kmalloc(count * sizeof(*items), GFP_KERNEL);
+    bins = kmalloc(count * sizeof(*bins), GFP_KERNEL);
+    remap = kmalloc(count * sizeof(*remap), GFP_KERNEL);
+    if (!items || !bins || !remap) {
+        EC_MASTER_ERR(domain->master, "Failed to allocate layout memory"
+                " for domain %u!\n", domain->index);
+        kfree(items);
+        kfree(bins);
+        kfree(remap);
+        return -ENOMEM;
+    }
+
+    i = 0;
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        items[i].fmmu = fmmu;
+        items[i].pos = i;
+        items[i].residues = ec_domain_fmmu_residues(fmmu);
+        i++;
+    }
+
+    sort(items, count, sizeof(*items), ec_domain_cmp_placement, NULL);
+
+    // first fit into datagrams, remembering the used size of each one
+    for (i = 0; i < count; i++) {
+        size = items[i].fmmu->data_size;
+        for (b = 0; b < bin_count; b++) {
+            start = ec_domain_align_offset(bins[b], items[i].residues);
+            if (start + size <= EC_MAX_DATA_SIZE) {
+                break;
+            }
+        }
+        if (b == bin_count) {
+            bins[bin_count++] = 0;
+            start = ec_domain_align_offset(0, items[i].residues);
+            if (start + size > EC_MAX_DATA_SIZE) {
+                start = 0;
+            }
+        }
+        items[i].bin = b;
+        items[i].offset = start;
+        bins[b] = start + size;
+    }
+
+    old_count = ec_domain_datagram_count(domain);
+    if (bin_count > old_count) {
+        EC_MASTER_DBG(domain->master, 1, "Domain%u: Keeping the"
+                " registration layout with %u datagrams.\n",
+                domain->index, old_count);
+        goto out_free;
+    }
+
+    // turn used sizes into datagram start offsets, aligned to 8 byte
+    for (b = 0, start = 0; b < bin_count; b++) {
+        size = bins[b];
+        bins[b] = start;
+        data_size = start + size;
+        start = ALIGN(data_size, 8);
+    }
+    data_size = min_t(uint32_t, ALIGN(data_size, 8),
+            bins[bin_count - 1] + EC_MAX_DATA_SIZE);
+
+    if (domain->data_origin == EC_ORIG_EXTERNAL && data_size > old_size) {
+        EC_MASTER_WARN(domain->master, "Domain%u: Not optimizing the"
+                " layout, because external memory would be exceeded.\n",
+                domain->index);
+        goto out_free;
+    }
+
+    // apply the layout; the registration order equals the old offset order
+    for (i = 0; i < count; i++) {
+        fmmu = items[i].fmmu;
+        items[i].offset += bins[items[i].bin];
+        remap[items[i].pos].old_offset = fmmu->logical_domain_offset;
+        remap[items[i].pos].new_offset = items[i].offset;
+        remap[items[i].pos].size = fmmu->data_size;
+        ec_fmmu_set_domain_offset_size(fmmu, items[i].offset,
+                fmmu->data_size);
+    }
+
+    sort(items, count, sizeof(*items), ec_domain_cmp_offset, NULL);
+    for (i = 0; i < count; i++) {
+        list_move_tail(&items[i].fmmu->list, &domain->fmmu_configs);
+    }
+
+    domain->data_size = data_size;
+    domain->offset_used[EC_DIR_INPUT] = data_size;
+    domain->offset_used[EC_DIR_OUTPUT] = data_size;
+
+    kfree(domain->remap);
+    domain->remap = remap;
+    domain->remap_count = count;
+    remap = NULL;
+
+    for (i = 0; i < domain->offset_ref_count; i++) {
+        *domain->offset_refs[i] =
+            ecrt_domain_remap_offset(domain, *domain->offset_refs[i]);
+    }
+    kfree(domain->offset_refs);
+    domain->offset_refs = NULL;
+    domain->offset_ref_count = 0;
+
+    EC_MASTER_INFO(domain->master, "Domain%u: Optimized layout, %zu -> %zu"
+            " byte, %u -> %u datagrams.\n", domain->index, old_size,
+            domain->data_size, old_count, bin_count);
+
+out_free:
+    kfree(items);
+    kfree(bins);
+    kfree(remap);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Checks, if the inputs and outputs of a slave may share the frame space.
+ *
+ * This requires the slave to be present and to support LRW.
+ */
+static int ec_domain_sc_may_overlap(
+        const ec_slave_config_t *sc /**< Slave configuration. */
+        )
+{
+    return sc->slave && sc->slave->sii_image
+        && !sc->slave->sii_image->sii.general_flags.enable_not_lrw;
+}
+
+/*****************************************************************************/
+
+/** Wire order of the shadow ranges: Ascending wire offset, outputs first.
+ */
+static int ec_domain_cmp_shadow(const void *a, const void *b)
+{
+    const ec_domain_shadow_t *x = a, *y = b;
+
+    if (x->wire_offset != y->wire_offset) {
+        return x->wire_offset < y->wire_offset ? -1 : 1;
+    }
+    return x->dir == y->dir ? 0 : (x->dir == EC_DIR_OUTPUT ? -1 : 1);
+}
+
+/*****************************************************************************/
+
+/** Wire order of the FMMUs, matching ec_domain_cmp_shadow().
+ */
+static int ec_domain_cmp_wire(const void *a, const void *b)
+{
+    const ec_fmmu_config_t *x = *(ec_fmmu_config_t * const *) a;
+    const ec_fmmu_config_t *y = *(ec_fmmu_config_t * const *) b;
+
+    if (x->logical_domain_offset != y->logical_domain_offset) {
+        return x->logical_domain_offset < y->logical_domain_offset ? -1 : 1;
+    }
+    return x->dir == y->dir ? 0 : (x->dir == EC_DIR_OUTPUT ? -1 : 1);
+}
+
+/*****************************************************************************/
+
+/** Lays out the frame image of a domain with overlapping PDOs.
+ *
+ * The FMMUs of every slave configuration form a block in the frame image,
+ * in which the outputs and the inputs both start at the beginning of the
+ * block, if the slave supports it. The FMMU offsets are changed to the frame
+ * image, while the application keeps the process data in registration
+ * layout. ecrt_domain_queue() copies the outputs into the frame image and
+ * ecrt_domain_process() copies the received inputs back.
+ *
+ * Does nothing, if no frame space can be saved.
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
+ */
+static int ec_domain_overlap_pdos(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    unsigned int count = ec_domain_fmmu_count(domain), i, j, k = 0;
+    ec_fmmu_config_t *fmmu, **fmmus, **order;
+    ec_domain_shadow_t *shadow;
+    const ec_slave_config_t *sc;
+    uint32_t used[EC_DIR_COUNT], block = 0, offset;
+    int overlap;
+
+    if (!domain->overlapping_pdos || !count) {
+        return 0;
+    }
+
+    fmmus = kmalloc(2 * count * sizeof(*fmmus), GFP_KERNEL);
+    shadow = kmalloc(count * sizeof(*shadow), GFP_KERNEL);
+    if (!fmmus || !shadow) {
+        EC_MASTER_ERR(domain->master, "Failed to allocate overlapping"
+                " layout memory for domain %u!\n", domain->index);
+        kfree(fmmus);
+        kfree(shadow);
+        return -ENOMEM;
+    }
+    order = fmmus + count;
+
+    i = 0;
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        fmmus[i++] = fmmu;
+    }
+
+    // one block per slave configuration, in order of registration
+    for (i = 0; i < count; i++) {
+        if (!fmmus[i]) {
+            continue;
+        }
+
+        sc = fmmus[i]->sc;
+        overlap = ec_domain_sc_may_overlap(sc);
+        used[EC_DIR_OUTPUT] = used[EC_DIR_INPUT] = block;
+
+        for (j = i; j < count; j++) {
+            if (!fmmus[j] || fmmus[j]->sc != sc) {
+                continue;
+            }
+
+            fmmu = fmmus[j];
+            if (overlap) {
+                offset = used[fmmu->dir];
+                used[fmmu->dir] += fmmu->data_size;
+            } else {
+                offset = max(used[EC_DIR_OUTPUT], used[EC_DIR_INPUT]);
+                used[EC_DIR_OUTPUT] = used[EC_DIR_INPUT] =
+                    offset + fmmu->data_size;
+            }
+
+            shadow[k].data_offset = fmmu->logical_domain_offset;
+            shadow[k].wire_offset = offset;
+            shadow[k].size = fmmu->data_size;
+            shadow[k].dir = fmmu->dir;
+            order[k++] = fmmu;
+            fmmus[j] = NULL;
+        }
+
+        block = max(used[EC_DIR_OUTPUT], used[EC_DIR_INPUT]);
+    }
+
+    if (block >= domain->data_size) {
+        EC_MASTER_DBG(domain->master, 1, "Domain%u: No frame space saved"
+                " by overlapping PDOs.\n", domain->index);
+        kfree(fmmus);
+        kfree(shadow);
+        return 0;
+    }
+
+    if (!(domain->wire_data = kzalloc(block, GFP_KERNEL))) {
+        EC_MASTER_ERR(domain->master, "Failed to allocate %u bytes frame"
+                " image for domain %u!\n", block, domain->index);
+        kfree(fmmus);
+        kfree(shadow);
+        return -ENOMEM;
+    }
+    domain->wire_size = block;
+
+    // move the FMMUs into the frame image, keeping the list in wire order
+    for (i = 0; i < count; i++) {
+        ec_fmmu_set_domain_offset_size(order[i], shadow[i].wire_offset,
+                order[i]->data_size);
+    }
+    sort(order, count, sizeof(*order), ec_domain_cmp_wire, NULL);
+    for (i = 0; i < count; i++) {
+        list_move_tail(&order[i]->list, &domain->fmmu_configs);
+    }
+
+    sort(shadow, count, sizeof(*shadow), ec_domain_cmp_shadow, NULL);
+    domain->shadow = shadow;
+    domain->shadow_count = count;
+
+    EC_MASTER_INFO(domain->master, "Domain%u: Overlapping PDOs, frame"
+            " image %zu -> %zu byte.\n", domain->index, domain->data_size,
+            domain->wire_size);
+
+    kfree(fmmus);
+    return 0;
 }
 
 /*****************************************************************************/
@@ -332,6 +902,10 @@ int ec_domain_finish(
         }
     }
 
+    ret = ec_domain_overlap_pdos(domain);
+    if (ret < 0)
+        return ret;
+
     // Cycle through all domain FMMUs and
     // - correct the logical base addresses
     // - set up the datagrams to carry the process data
@@ -376,14 +950,19 @@ int ec_domain_finish(
 
     /* Allocate last datagram pair, if data are left (this is also the case if
      * the process data fit into a single datagram) */
-    if (domain->data_size > datagram_offset) {
-        ret = emplace_datagram(domain, datagram_offset, domain->data_size,
+    if (ec_domain_wire_size(domain) > datagram_offset) {
+        ret = emplace_datagram(domain, datagram_offset,
+            ec_domain_wire_size(domain),
             datagram_first_fmmu, fmmu);
         if (ret < 0)
             return ret;
         datagram_count++;
     }
 
+    ret = ec_domain_build_frame_templates(domain);
+    if (ret < 0)
+        return ret;
+
     EC_MASTER_INFO(domain->master, "Domain%u: Logical address 0x%08x,"
             " %zu byte, expected working counter %u.\n", domain->index,
             domain->logical_base_address, domain->data_size,
@@ -403,6 +982,76 @@ int ec_domain_finish(
 
 /*****************************************************************************/
 
+/** Get the memory carried by the domain datagrams.
+ *
+ * This is the frame image, if the domain has overlapping PDOs, otherwise the
+ * process data.
+ */
+uint8_t *ec_domain_wire_data(const ec_domain_t *domain)
+{
+    return domain->wire_data ? domain->wire_data : domain->data;
+}
+
+/*****************************************************************************/
+
+/** Get the size of the memory carried by the domain datagrams.
+ */
+size_t ec_domain_wire_size(const ec_domain_t *domain)
+{
+    return domain->wire_data ? domain->wire_size : domain->data_size;
+}
+
+/*****************************************************************************/
+
+/** Copies the outputs of a domain with overlapping PDOs into the frame
+ * image.
+ */
+static void ec_domain_copy_outputs(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    const ec_domain_shadow_t *shadow;
+    unsigned int i;
+
+    for (i = 0; i < domain->shadow_count; i++) {
+        shadow = &domain->shadow[i];
+        if (shadow->dir == EC_DIR_OUTPUT) {
+            memcpy(domain->wire_data + shadow->wire_offset,
+                    domain->data + shadow->data_offset, shadow->size);
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/** Copies the received inputs of a datagram pair from the frame image of a
+ * domain with overlapping PDOs into the process data.
+ */
+static void ec_domain_copy_inputs(
+        ec_domain_t *domain, /**< EtherCAT domain. */
+        const ec_datagram_pair_t *pair /**< Received datagram pair. */
+        )
+{
+    const ec_datagram_t *datagram = &pair->datagrams[EC_DEVICE_MAIN];
+    uint32_t begin = datagram->data - domain->wire_data,
+             end = begin + datagram->data_size;
+    const ec_domain_shadow_t *shadow;
+    unsigned int i;
+
+    for (i = 0; i < domain->shadow_count; i++) {
+        shadow = &domain->shadow[i];
+        if (shadow->wire_offset >= end) {
+            break;
+        }
+        if (shadow->dir == EC_DIR_INPUT && shadow->wire_offset >= begin) {
+            memcpy(domain->data + shadow->data_offset,
+                    domain->wire_data + shadow->wire_offset, shadow->size);
+        }
+    }
+}
+
+/*****************************************************************************/
+
 /** Get the number of FMMU configurations of the domain.
  */
 unsigned int ec_domain_fmmu_count(const ec_domain_t *domain)
@@ -441,32 +1090,31 @@ const ec_fmmu_config_t *ec_domain_find_fmmu(
 
 /*****************************************************************************/
 
-#if EC_MAX_NUM_DEVICES > 1
-
-/** Process received data.
+/** Remembers an offset variable, that has to be patched by the layout pass.
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
  */
-int data_changed(
-        uint8_t *send_buffer,
-        const ec_datagram_t *datagram,
-        size_t offset,
-        size_t size
+static int ec_domain_add_offset_ref(
+        ec_domain_t *domain, /**< EtherCAT domain. */
+        unsigned int *offset /**< Offset variable. */
         )
 {
-    uint8_t *sent = send_buffer + offset;
-    uint8_t *recv = datagram->data + offset;
-    size_t i;
+    unsigned int **refs;
 
-    for (i = 0; i < size; i++) {
-        if (recv[i] != sent[i]) {
-            return 1;
-        }
+    refs = krealloc(domain->offset_refs,
+            (domain->offset_ref_count + 1) * sizeof(*refs), GFP_KERNEL);
+    if (!refs) {
+        EC_MASTER_ERR(domain->master, "Failed to allocate offset"
+                " reference memory for domain %u!\n", domain->index);
+        return -ENOMEM;
     }
 
+    refs[domain->offset_ref_count++] = offset;
+    domain->offset_refs = refs;
     return 0;
 }
 
-#endif
-
 /******************************************************************************
  *  Application interface
  *****************************************************************************/
@@ -493,6 +1141,12 @@ int ecrt_domain_reg_pdo_entry_list(ec_domain_t *domain,
             return ret;
 
         *reg->offset = ret;
+
+        if (domain->optimize_layout) {
+            ret = ec_domain_add_offset_ref(domain, reg->offset);
+            if (ret < 0)
+                return ret;
+        }
     }
 
     return 0;
@@ -524,6 +1178,91 @@ void ecrt_domain_external_memory(ec_domain_t *domain, uint8_t *mem)
 
 /*****************************************************************************/
 
+int ecrt_domain_set_period(ec_domain_t *domain, unsigned int period,
+        int phase)
+{
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_set_period("
+            "domain = 0x%p, period = %u, phase = %i)\n",
+            domain, period, phase);
+
+    if (!period || period > INT_MAX || phase >= (int) period) {
+        EC_MASTER_ERR(domain->master, "Invalid period %u or phase %i"
+                " for domain %u!\n", period, phase, domain->index);
+        return -EINVAL;
+    }
+
+    if (domain->master->active) {
+        EC_MASTER_ERR(domain->master, "Period of domain %u can only be"
+                " changed before activation!\n", domain->index);
+        return -EBUSY;
+    }
+
+    domain->period = period;
+    domain->phase = phase < 0 ? -1 : phase;
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_optimize_layout(ec_domain_t *domain)
+{
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_optimize_layout("
+            "domain = 0x%p)\n", domain);
+
+    if (domain->master->active) {
+        EC_MASTER_ERR(domain->master, "Layout of domain %u can only be"
+                " optimized before activation!\n", domain->index);
+        return -EBUSY;
+    }
+
+    domain->optimize_layout = 1;
+    return 0;
+}
+
+/*****************************************************************************/
+
+unsigned int ecrt_domain_remap_offset(const ec_domain_t *domain,
+        unsigned int offset)
+{
+    unsigned int low = 0, high = domain->remap_count, mid;
+    const ec_domain_remap_t *remap;
+
+    while (low < high) {
+        mid = (low + high) / 2;
+        remap = &domain->remap[mid];
+        if (offset < remap->old_offset) {
+            high = mid;
+        } else if (offset >= remap->old_offset + remap->size) {
+            low = mid + 1;
+        } else {
+            return remap->new_offset + (offset - remap->old_offset);
+        }
+    }
+
+    return offset;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_overlapping_pdos(ec_domain_t *domain,
+        uint8_t overlapping_pdos)
+{
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_overlapping_pdos("
+            "domain = 0x%p, overlapping_pdos = %u)\n",
+            domain, overlapping_pdos);
+
+    if (domain->master->active) {
+        EC_MASTER_ERR(domain->master, "Overlapping PDOs of domain %u can"
+                " only be changed before activation!\n", domain->index);
+        return -EBUSY;
+    }
+
+    domain->overlapping_pdos = overlapping_pdos;
+    return 0;
+}
+
+/*****************************************************************************/
+
 uint8_t *ecrt_domain_data(ec_domain_t *domain)
 {
     return domain->data;
@@ -535,12 +1274,10 @@ void ecrt_domain_process(ec_domain_t *domain)
 {
     uint16_t wc_sum[EC_MAX_NUM_DEVICES] = {}, wc_total;
     ec_datagram_pair_t *pair;
+    uint16_t datagram_pair_wc;
 #if EC_MAX_NUM_DEVICES > 1
-    uint16_t datagram_pair_wc, redundant_wc;
-    unsigned int datagram_offset;
-    ec_fmmu_config_t *fmmu = list_first_entry(&domain->fmmu_configs,
-            ec_fmmu_config_t, list);
-    unsigned int redundancy;
+    uint16_t redundant_wc;
+    unsigned int i, redundancy;
 #endif
     unsigned int dev_idx;
 #ifdef EC_RT_SYSLOG
@@ -551,71 +1288,61 @@ void ecrt_domain_process(ec_domain_t *domain)
     EC_MASTER_DBG(domain->master, 1, "domain %u process\n", domain->index);
 #endif
 
+    if (!domain->exchanged) {
+        /* Not queued in the last cycle due to the domain period: keep the
+         * process data and working counters of the last exchange. */
+        domain->stale_cycles++;
+        ec_master_publish_domain_state(domain->master, domain);
+        return;
+    }
+    domain->stale_cycles = 0;
+
     list_for_each_entry(pair, &domain->datagram_pairs, list) {
-#if EC_MAX_NUM_DEVICES > 1
         datagram_pair_wc = ec_datagram_pair_process(pair, wc_sum);
-#else
-        ec_datagram_pair_process(pair, wc_sum);
-#endif
 
 #if EC_MAX_NUM_DEVICES > 1
         if (ec_master_num_devices(domain->master) > 1) {
             ec_datagram_t *main_datagram = &pair->datagrams[EC_DEVICE_MAIN];
-            uint32_t logical_datagram_address =
-                EC_READ_U32(main_datagram->address);
-            size_t datagram_size = main_datagram->data_size;
 
 #if DEBUG_REDUNDANCY
             EC_MASTER_DBG(domain->master, 1, "dgram %s log=%u\n",
-                    main_datagram->name, logical_datagram_address);
+                    main_datagram->name,
+                    EC_READ_U32(main_datagram->address));
 #endif
 
-            /* Redundancy: Go through FMMU configs to detect data changes. */
-            list_for_each_entry_from(fmmu, &domain->fmmu_configs, list) {
-                ec_datagram_t *backup_datagram =
-                    &pair->datagrams[EC_DEVICE_BACKUP];
+            /* Redundancy: Detect the input changes of all FMMUs at once. */
+            ec_datagram_pair_detect_changes(pair);
 
-                if (fmmu->dir != EC_DIR_INPUT) {
-                    continue;
-                }
-
-                if (fmmu->logical_domain_offset >= datagram_size) {
-                    // fmmu data contained in next datagram pair
-                    break;
-                }
-
-                datagram_offset = fmmu->logical_domain_offset;
+            for (i = 0; i < pair->input_count; i++) {
+                const ec_datagram_pair_range_t *range = &pair->inputs[i];
 
 #if DEBUG_REDUNDANCY
                 EC_MASTER_DBG(domain->master, 1,
-                        "input fmmu log_off=%u size=%u offset=%u\n",
-                        fmmu->logical_domain_offset, fmmu->data_size,
-                        datagram_offset);
+                        "input range offset=%u size=%u\n",
+                        range->offset, range->size);
                 if (domain->master->debug_level > 0) {
-                    ec_print_data(pair->send_buffer + datagram_offset,
-                            fmmu->data_size);
-                    ec_print_data(main_datagram->data + datagram_offset,
-                            fmmu->data_size);
-                    ec_print_data(backup_datagram->data + datagram_offset,
-                            fmmu->data_size);
+                    ec_print_data(pair->send_buffer + range->offset,
+                            range->size);
+                    ec_print_data(main_datagram->data + range->offset,
+                            range->size);
+                    ec_print_data(pair->datagrams[EC_DEVICE_BACKUP].data
+                            + range->offset, range->size);
                 }
 #endif
 
-                if (data_changed(pair->send_buffer, main_datagram,
-                            datagram_offset, fmmu->data_size)) {
+                if (test_bit(i, pair->main_changed)) {
                     /* data changed on main link: no copying necessary. */
 #if DEBUG_REDUNDANCY
                     EC_MASTER_DBG(domain->master, 1, "main changed\n");
 #endif
-                } else if (data_changed(pair->send_buffer, backup_datagram,
-                            datagram_offset, fmmu->data_size)) {
+                } else if (test_bit(i, pair->backup_changed)) {
                     /* data changed on backup link: copy to main memory. */
 #if DEBUG_REDUNDANCY
                     EC_MASTER_DBG(domain->master, 1, "backup changed\n");
 #endif
-                    memcpy(main_datagram->data + datagram_offset,
-                            backup_datagram->data + datagram_offset,
-                            fmmu->data_size);
+                    memcpy(main_datagram->data + range->offset,
+                            pair->datagrams[EC_DEVICE_BACKUP].data
+                            + range->offset, range->size);
                 } else if (datagram_pair_wc ==
                         pair->expected_working_counter) {
                     /* no change, but WC complete: use main data. */
@@ -635,6 +1362,15 @@ void ecrt_domain_process(ec_domain_t *domain)
             }
         }
 #endif // EC_MAX_NUM_DEVICES > 1
+
+        if (domain->wire_data && datagram_pair_wc ==
+                pair->expected_working_counter) {
+            /* Overlapping PDOs: A slave, that did not respond, leaves its
+             * outputs in the input range. As the working counter can not
+             * tell, which slave is missing, the inputs are only taken over
+             * from a complete response. Otherwise the old inputs are kept. */
+            ec_domain_copy_inputs(domain, pair);
+        }
     }
 
 #if EC_MAX_NUM_DEVICES > 1
@@ -715,6 +1451,8 @@ void ecrt_domain_process(ec_domain_t *domain)
         domain->working_counter_changes = 0;
     }
 #endif
+
+    ec_master_publish_domain_state(domain->master, domain);
 }
 
 /*****************************************************************************/
@@ -724,23 +1462,31 @@ void ecrt_domain_queue(ec_domain_t *domain)
     ec_datagram_pair_t *datagram_pair;
     ec_device_index_t dev_idx;
 
+    domain->exchanged = !domain->countdown;
+    if (!domain->exchanged) {
+        return;
+    }
+
+    if (domain->wire_data) {
+        ec_domain_copy_outputs(domain);
+    }
+
     list_for_each_entry(datagram_pair, &domain->datagram_pairs, list) {
 
 #if EC_MAX_NUM_DEVICES > 1
-        /* copy main data to send buffer */
-        memcpy(datagram_pair->send_buffer,
-                datagram_pair->datagrams[EC_DEVICE_MAIN].data,
-                datagram_pair->datagrams[EC_DEVICE_MAIN].data_size);
+        /* Snapshot the main data once. The backup datagrams transmit the
+         * snapshot, so that their memory only receives data. */
+        if (ec_master_num_devices(domain->master) > 1) {
+            memcpy(datagram_pair->send_buffer,
+                    datagram_pair->datagrams[EC_DEVICE_MAIN].data,
+                    datagram_pair->datagrams[EC_DEVICE_MAIN].data_size);
+        }
 #endif
         ec_master_queue_datagram(domain->master,
                 &datagram_pair->datagrams[EC_DEVICE_MAIN]);
 
-        /* copy main data to backup datagram */
         for (dev_idx = EC_DEVICE_BACKUP;
                 dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
-            memcpy(datagram_pair->datagrams[dev_idx].data,
-                    datagram_pair->datagrams[EC_DEVICE_MAIN].data,
-                    datagram_pair->datagrams[EC_DEVICE_MAIN].data_size);
             ec_master_queue_datagram(domain->master,
                     &datagram_pair->datagrams[dev_idx]);
         }
@@ -772,6 +1518,7 @@ void ecrt_domain_state(const ec_domain_t *domain, ec_domain_state_t *state)
     }
 
     state->redundancy_active = domain->redundancy_active;
+    state->stale_cycles = domain->stale_cycles;
 }
 
 /*****************************************************************************/
@@ -781,6 +1528,10 @@ void ecrt_domain_state(const ec_domain_t *domain, ec_domain_state_t *state)
 EXPORT_SYMBOL(ecrt_domain_reg_pdo_entry_list);
 EXPORT_SYMBOL(ecrt_domain_size);
 EXPORT_SYMBOL(ecrt_domain_external_memory);
+EXPORT_SYMBOL(ecrt_domain_set_period);
+EXPORT_SYMBOL(ecrt_domain_optimize_layout);
+EXPORT_SYMBOL(ecrt_domain_remap_offset);
+EXPORT_SYMBOL(ecrt_domain_overlapping_pdos);
 EXPORT_SYMBOL(ecrt_domain_data);
 EXPORT_SYMBOL(ecrt_domain_process);
 EXPORT_SYMBOL(ecrt_domain_queue);
@@ -46,6 +46,28 @@
 
 /*****************************************************************************/
 
+/** Process data range moved by the domain layout optimizer.
+ */
+typedef struct {
+    uint32_t old_offset; /**< Domain offset at registration. */
+    uint32_t new_offset; /**< Domain offset after optimization. */
+    uint32_t size; /**< Size of the range. */
+} ec_domain_remap_t;
+
+/*****************************************************************************/
+
+/** FMMU range copied between the process data and the frame image of a
+ * domain with overlapping PDOs.
+ */
+typedef struct {
+    uint32_t data_offset; /**< Offset in the process data. */
+    uint32_t wire_offset; /**< Offset in the frame image. */
+    uint32_t size; /**< Size of the range. */
+    ec_direction_t dir; /**< Copy direction. */
+} ec_domain_shadow_t;
+
+/*****************************************************************************/
+
 /** EtherCAT domain.
  *
  * Handles the process data and the therefore needed datagrams of a certain
@@ -65,18 +87,50 @@ struct ec_domain
                                      process data. */
     struct list_head datagram_pairs; /**< Datagrams pairs (main/backup) for
                                        process data exchange. */
+    struct list_head frame_templates; /**< Precomputed frames carrying the
+                                        datagrams of \a datagram_pairs. */
     uint16_t working_counter[EC_MAX_NUM_DEVICES]; /**< Last working counter
                                                 values. */
     uint16_t expected_working_counter; /**< Expected working counter. */
     unsigned int working_counter_changes; /**< Working counter changes
                                              since last notification. */
     unsigned int redundancy_active; /**< Non-zero, if redundancy is in use. */
+    unsigned int period; /**< The process data are exchanged every
+                           \a period application cycles. */
+    int phase; /**< Application cycle within the \a period, in which the
+                 process data are exchanged, or -1 for automatic selection
+                 on activation. */
+    unsigned int countdown; /**< Application cycles (calls to
+                              ecrt_master_send()) until the process data are
+                              exchanged next. */
+    unsigned int exchanged; /**< Non-zero, if the datagrams were queued in
+                              the last application cycle. */
+    unsigned int stale_cycles; /**< Number of consecutive cycles, in which
+                                 the process data were not exchanged. */
     unsigned long notify_jiffies; /**< Time of last notification. */
     uint32_t offset_used[EC_DIR_COUNT]; /**< Next available domain offset of
         PDO, by direction */
     const ec_slave_config_t *sc_in_work; /**< slave_config which is actively
         being registered in this domain
         (i.e. ecrt_slave_config_reg_pdo_entry() ) */
+    unsigned int optimize_layout; /**< Non-zero, if the layout shall be
+                                    optimized on activation. */
+    unsigned int layout_done; /**< The layout pass has been run. */
+    ec_domain_remap_t *remap; /**< Offset indirection table of the optimized
+                                layout, sorted by old offset. */
+    unsigned int remap_count; /**< Number of entries in \a remap. */
+    unsigned int **offset_refs; /**< Offsets stored by
+                                  ecrt_domain_reg_pdo_entry_list(), that are
+                                  patched by the layout pass. */
+    unsigned int offset_ref_count; /**< Number of \a offset_refs. */
+    unsigned int overlapping_pdos; /**< Non-zero, if inputs and outputs of
+                                     a slave shall share the frame space. */
+    uint8_t *wire_data; /**< Frame image of a domain with overlapping PDOs,
+                          or NULL, if the datagrams carry \a data. */
+    size_t wire_size; /**< Size of \a wire_data. */
+    ec_domain_shadow_t *shadow; /**< Copy ranges between \a data and
+                                  \a wire_data, sorted by wire offset. */
+    unsigned int shadow_count; /**< Number of \a shadow ranges. */
 };
 
 /*****************************************************************************/
@@ -85,8 +139,12 @@ void ec_domain_init(ec_domain_t *, ec_master_t *, unsigned int);
 void ec_domain_clear(ec_domain_t *);
 
 void ec_domain_add_fmmu_config(ec_domain_t *, ec_fmmu_config_t *);
+int ec_domain_optimize_layout(ec_domain_t *);
 int ec_domain_finish(ec_domain_t *, uint32_t);
 
+uint8_t *ec_domain_wire_data(const ec_domain_t *);
+size_t ec_domain_wire_size(const ec_domain_t *);
+
 unsigned int ec_domain_fmmu_count(const ec_domain_t *);
 const ec_fmmu_config_t *ec_domain_find_fmmu(const ec_domain_t *, unsigned int);
 
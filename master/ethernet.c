@@ -227,6 +227,7 @@ int ec_eoe_init(
     eoe->auto_created = 0;
 
     ec_datagram_init(&eoe->datagram);
+    eoe->datagram.traffic_class = EC_TRAFFIC_EOE;
     eoe->queue_datagram = 0;
     eoe->state = ec_eoe_state_rx_start;
     eoe->opened = 0;
@@ -515,6 +516,7 @@ void ec_eoe_clear(ec_eoe_t *eoe /**< EoE handler */)
 
     free_netdev(eoe->dev);
 
+    ec_master_forget_datagram(eoe->master, &eoe->datagram);
     ec_datagram_clear(&eoe->datagram);
 }
 
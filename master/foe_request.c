@@ -68,6 +68,7 @@ void ec_foe_request_init(
     req->issue_timeout = 0; // no timeout
     req->response_timeout = EC_FOE_REQUEST_RESPONSE_TIMEOUT;
     req->state = EC_INT_REQUEST_INIT;
+    req->notify = 0;
     req->result = FOE_BUSY;
     req->error_code = 0x00000000;
 }
@@ -272,6 +273,8 @@ void ecrt_foe_request_read(
     req->state = EC_INT_REQUEST_QUEUED;
     req->result = FOE_BUSY;
     req->jiffies_start = jiffies;
+    smp_wmb();
+    req->notify = 1;
 }
 
 /*****************************************************************************/
@@ -295,6 +298,8 @@ void ecrt_foe_request_write(
     req->state = EC_INT_REQUEST_QUEUED;
     req->result = FOE_BUSY;
     req->jiffies_start = jiffies;
+    smp_wmb();
+    req->notify = 1;
 }
 
 /*****************************************************************************/
@@ -62,6 +62,8 @@ struct ec_foe_request {
                           the slave, EC_DIR_INPUT means uploading from the
                           slave. */
     ec_internal_request_state_t state; /**< FoE request state. */
+    uint8_t notify; /**< Completion has to be reported to the application.
+                      Set after the request state was written. */
     unsigned long jiffies_start; /**< Jiffies, when the request was issued. */
     unsigned long jiffies_sent; /**< Jiffies, when the upload/download
                                      request was sent. */
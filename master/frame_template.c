@@ -0,0 +1,137 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   EtherCAT frame template methods.
+*/
+
+/*****************************************************************************/
+
+#include <linux/string.h>
+#include <linux/if_ether.h>
+
+#include "frame_template.h"
+
+/*****************************************************************************/
+
+/** Frame template constructor.
+ */
+void ec_frame_template_init(
+        ec_frame_template_t *tmpl, /**< Frame template. */
+        ec_device_index_t device_index /**< Device index. */
+        )
+{
+    INIT_LIST_HEAD(&tmpl->list);
+    tmpl->device_index = device_index;
+    tmpl->datagram_count = 0;
+    tmpl->size = EC_FRAME_HEADER_SIZE;
+}
+
+/*****************************************************************************/
+
+/** Appends a datagram to a frame template.
+ *
+ * Builds the datagram header and sets the "more datagrams follow" flag in
+ * the header of the previous datagram.
+ *
+ * \retval 0 Success.
+ * \retval -ENOSPC The datagram does not fit into the frame.
+ */
+int ec_frame_template_add(
+        ec_frame_template_t *tmpl, /**< Frame template. */
+        ec_datagram_t *datagram /**< Datagram. */
+        )
+{
+    size_t datagram_size = EC_DATAGRAM_HEADER_SIZE + datagram->data_size
+        + EC_DATAGRAM_FOOTER_SIZE;
+    uint8_t *header;
+
+    if (tmpl->datagram_count >= EC_FRAME_TEMPLATE_MAX_DATAGRAMS
+            || tmpl->size + datagram_size > ETH_DATA_LEN) {
+        return -ENOSPC;
+    }
+
+    if (tmpl->datagram_count) {
+        header = tmpl->headers[tmpl->datagram_count - 1];
+        EC_WRITE_U16(header + 6, EC_READ_U16(header + 6) | 0x8000);
+    }
+
+    header = tmpl->headers[tmpl->datagram_count];
+    EC_WRITE_U8 (header, datagram->type);
+    EC_WRITE_U8 (header + 1, 0x00); // index is set on send
+    memcpy(header + 2, datagram->address, EC_ADDR_LEN);
+    EC_WRITE_U16(header + 6, datagram->data_size & 0x7FF);
+    EC_WRITE_U16(header + 8, 0x0000);
+
+    tmpl->datagrams[tmpl->datagram_count] = datagram;
+    tmpl->offsets[tmpl->datagram_count] = tmpl->size;
+    tmpl->datagram_count++;
+    tmpl->size += datagram_size;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Writes the datagrams of a template into a frame.
+ *
+ * Writes the datagram headers, the payload of all datagrams and the working
+ * counters, starting at \a cur_data. The frame header, the "more datagrams
+ * follow" flag of the last datagram and the padding are left to the caller,
+ * so that other datagrams can share the frame. The datagram indices have to
+ * be assigned before.
+ */
+void ec_frame_template_write(
+        const ec_frame_template_t *tmpl, /**< Frame template. */
+        uint8_t *cur_data /**< Frame memory for the first datagram header. */
+        )
+{
+    const ec_datagram_t *datagram;
+    const uint8_t *payload;
+    uint8_t *datagram_data;
+    unsigned int i;
+
+    for (i = 0; i < tmpl->datagram_count; i++) {
+        datagram = tmpl->datagrams[i];
+        datagram_data = cur_data + tmpl->offsets[i] - EC_FRAME_HEADER_SIZE;
+
+        memcpy(datagram_data, tmpl->headers[i], EC_DATAGRAM_HEADER_SIZE);
+        EC_WRITE_U8(datagram_data + 1, datagram->index);
+        datagram_data += EC_DATAGRAM_HEADER_SIZE;
+
+        payload = datagram->tx_data ? datagram->tx_data : datagram->data;
+        memcpy(datagram_data, payload, datagram->data_size);
+        datagram_data += datagram->data_size;
+
+        EC_WRITE_U16(datagram_data, 0x0000); // reset working counter
+    }
+}
+
+/*****************************************************************************/
+
@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   EtherCAT frame template structure.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_FRAME_TEMPLATE_H__
+#define __EC_FRAME_TEMPLATE_H__
+
+#include <linux/list.h>
+
+#include "globals.h"
+#include "datagram.h"
+
+/*****************************************************************************/
+
+/** Maximum number of datagrams in a frame template.
+ */
+#define EC_FRAME_TEMPLATE_MAX_DATAGRAMS 16
+
+/*****************************************************************************/
+
+/** Frame template.
+ *
+ * Precomputed layout of a frame, that carries a fixed set of datagrams, for
+ * example the process data datagrams of a domain. The header bytes and
+ * offsets are built when the master is activated, so that the cyclic send
+ * only has to patch the datagram indices and to copy the payload. The
+ * remaining space of the frame may be filled with other templates or
+ * datagrams on send.
+ */
+typedef struct {
+    struct list_head list; /**< List item. */
+    ec_device_index_t device_index; /**< Device to send the frame with. */
+    unsigned int datagram_count; /**< Number of datagrams in the frame. */
+    ec_datagram_t *datagrams[EC_FRAME_TEMPLATE_MAX_DATAGRAMS]; /**<
+                                                   Datagrams in frame order. */
+    uint16_t offsets[EC_FRAME_TEMPLATE_MAX_DATAGRAMS]; /**< Frame offsets of
+                                                         the datagram
+                                                         headers. */
+    uint8_t headers[EC_FRAME_TEMPLATE_MAX_DATAGRAMS]
+        [EC_DATAGRAM_HEADER_SIZE]; /**< Precomputed datagram headers,
+                                     including the "more datagrams follow"
+                                     flags. The index is patched on send. */
+    size_t size; /**< Frame size without padding, including the frame
+                   header. */
+} ec_frame_template_t;
+
+/*****************************************************************************/
+
+void ec_frame_template_init(ec_frame_template_t *, ec_device_index_t);
+int ec_frame_template_add(ec_frame_template_t *, ec_datagram_t *);
+void ec_frame_template_write(const ec_frame_template_t *, uint8_t *);
+
+/*****************************************************************************/
+
+#endif
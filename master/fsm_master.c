@@ -404,6 +404,7 @@ void ec_fsm_master_state_broadcast(
             }
             master->slave_count = count;
             master->fsm_slave = master->slaves;
+            ec_master_map_station_addresses(master);
 
             ec_master_slaves_available(master);
             ec_fsm_master_enter_dc_read_old_times(fsm);
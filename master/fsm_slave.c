@@ -70,6 +70,23 @@ void ec_fsm_slave_state_mbg_request(ec_fsm_slave_t *, ec_datagram_t *);
 
 /*****************************************************************************/
 
+/** Signals a finished request.
+ *
+ * Wakes up the waiting callers and marks the slave configuration, so that
+ * the completion of its request is reported.
+ */
+static void ec_fsm_slave_request_done(
+        ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    if (slave->config) {
+        ec_slave_config_mark_completion(slave->config);
+    }
+    wake_up_all(&slave->master->request_queue);
+}
+
+/*****************************************************************************/
+
 /** Constructor.
  */
 void ec_fsm_slave_init(
@@ -129,22 +146,22 @@ void ec_fsm_slave_clear(
 
     if (fsm->sdo_request) {
         fsm->sdo_request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&fsm->slave->master->request_queue);
+        ec_fsm_slave_request_done(fsm->slave);
     }
 
     if (fsm->reg_request) {
         fsm->reg_request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&fsm->slave->master->request_queue);
+        ec_fsm_slave_request_done(fsm->slave);
     }
 
     if (fsm->foe_request) {
         fsm->foe_request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&fsm->slave->master->request_queue);
+        ec_fsm_slave_request_done(fsm->slave);
     }
 
     if (fsm->soe_request) {
         fsm->soe_request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&fsm->slave->master->request_queue);
+        ec_fsm_slave_request_done(fsm->slave);
     }
 
 #ifdef EC_EOE
@@ -852,7 +869,7 @@ int ec_fsm_slave_action_process_sdo(
         EC_SLAVE_WARN(slave, "Aborting SDO request,"
                 " slave has error flag set.\n");
         request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
+        ec_fsm_slave_request_done(slave);
         fsm->state = ec_fsm_slave_state_idle;
         return 0;
     }
@@ -860,7 +877,7 @@ int ec_fsm_slave_action_process_sdo(
     if (slave->current_state == EC_SLAVE_STATE_INIT) {
         EC_SLAVE_WARN(slave, "Aborting SDO request, slave is in INIT.\n");
         request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
+        ec_fsm_slave_request_done(slave);
         fsm->state = ec_fsm_slave_state_idle;
         return 0;
     }
@@ -897,7 +914,7 @@ void ec_fsm_slave_state_sdo_request(
     if (!ec_fsm_coe_success(&fsm->fsm_coe)) {
         EC_SLAVE_ERR(slave, "Failed to process SDO request.\n");
         request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
+        ec_fsm_slave_request_done(slave);
         fsm->sdo_request = NULL;
         fsm->state = ec_fsm_slave_state_ready;
         return;
@@ -907,7 +924,7 @@ void ec_fsm_slave_state_sdo_request(
 
     // SDO request finished
     request->state = EC_INT_REQUEST_SUCCESS;
-    wake_up_all(&slave->master->request_queue);
+    ec_fsm_slave_request_done(slave);
     fsm->sdo_request = NULL;
     fsm->state = ec_fsm_slave_state_ready;
 }
@@ -960,7 +977,7 @@ int ec_fsm_slave_action_process_reg(
         EC_SLAVE_WARN(slave, "Aborting register request,"
                 " slave has error flag set.\n");
         fsm->reg_request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
+        ec_fsm_slave_request_done(slave);
         fsm->reg_request = NULL;
         fsm->state = ec_fsm_slave_state_idle;
         return 0;
@@ -995,7 +1012,7 @@ int ec_fsm_slave_action_process_reg(
     default:
         EC_SLAVE_WARN(slave, "Aborting register request, unknown direction.\n");
         fsm->reg_request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
+        ec_fsm_slave_request_done(slave);
         fsm->reg_request = NULL;
         fsm->state = ec_fsm_slave_state_idle;
         return 1;
@@ -1029,7 +1046,7 @@ void ec_fsm_slave_state_reg_request(
                 " request datagram: ");
         ec_datagram_print_state(fsm->datagram);
         reg->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
+        ec_fsm_slave_request_done(slave);
         fsm->reg_request = NULL;
         fsm->state = ec_fsm_slave_state_ready;
         return;
@@ -1050,7 +1067,7 @@ void ec_fsm_slave_state_reg_request(
                 fsm->datagram->working_counter);
     }
 
-    wake_up_all(&slave->master->request_queue);
+    ec_fsm_slave_request_done(slave);
     fsm->reg_request = NULL;
     fsm->state = ec_fsm_slave_state_ready;
 }
@@ -1094,7 +1111,7 @@ int ec_fsm_slave_action_process_foe(
         EC_SLAVE_WARN(slave, "Aborting FoE request,"
                 " slave has error flag set.\n");
         fsm->foe_request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
+        ec_fsm_slave_request_done(slave);
         fsm->foe_request = NULL;
         fsm->state = ec_fsm_slave_state_idle;
         return 0;
@@ -1129,7 +1146,7 @@ void ec_fsm_slave_state_foe_request(
     if (!ec_fsm_foe_success(&fsm->fsm_foe)) {
         EC_SLAVE_ERR(slave, "Failed to handle FoE request.\n");
         request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
+        ec_fsm_slave_request_done(slave);
         fsm->foe_request = NULL;
         fsm->state = ec_fsm_slave_state_ready;
         return;
@@ -1140,7 +1157,7 @@ void ec_fsm_slave_state_foe_request(
             " data.\n", request->data_size);
 
     request->state = EC_INT_REQUEST_SUCCESS;
-    wake_up_all(&slave->master->request_queue);
+    ec_fsm_slave_request_done(slave);
     fsm->foe_request = NULL;
     fsm->state = ec_fsm_slave_state_ready;
 }
@@ -1171,7 +1188,7 @@ int ec_fsm_slave_action_process_soe(
         EC_SLAVE_WARN(slave, "Aborting SoE request,"
                 " slave has error flag set.\n");
         req->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
+        ec_fsm_slave_request_done(slave);
         fsm->state = ec_fsm_slave_state_idle;
         return 0;
     }
@@ -1179,7 +1196,7 @@ int ec_fsm_slave_action_process_soe(
     if (slave->current_state == EC_SLAVE_STATE_INIT) {
         EC_SLAVE_WARN(slave, "Aborting SoE request, slave is in INIT.\n");
         req->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
+        ec_fsm_slave_request_done(slave);
         fsm->state = ec_fsm_slave_state_idle;
         return 0;
     }
@@ -1303,7 +1320,7 @@ void ec_fsm_slave_state_soe_request(
     if (!ec_fsm_soe_success(&fsm->fsm_soe)) {
         EC_SLAVE_ERR(slave, "Failed to process SoE request.\n");
         request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
+        ec_fsm_slave_request_done(slave);
         fsm->soe_request = NULL;
         fsm->state = ec_fsm_slave_state_ready;
         return;
@@ -1313,7 +1330,7 @@ void ec_fsm_slave_state_soe_request(
 
     // SoE request finished
     request->state = EC_INT_REQUEST_SUCCESS;
-    wake_up_all(&slave->master->request_queue);
+    ec_fsm_slave_request_done(slave);
     fsm->soe_request = NULL;
     fsm->state = ec_fsm_slave_state_ready;
 }
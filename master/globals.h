@@ -46,9 +46,6 @@
 /** Datagram timeout in microseconds. */
 #define EC_IO_TIMEOUT 1000
 
-/** SDO injection timeout in microseconds. */
-#define EC_SDO_INJECTION_TIMEOUT 10000
-
 /** Time to send a byte in nanoseconds.
  *
  * t_ns = 1 / (100 MBit/s / 8 bit/byte) = 80 ns/byte
@@ -70,6 +67,20 @@
 /** Number of statistic rate intervals to maintain. */
 #define EC_RATE_COUNT 3
 
+/** Datagram traffic classes.
+ *
+ * The classes are listed in descending priority. Datagrams of a class with
+ * higher priority are placed into the frames first.
+ */
+typedef enum {
+    EC_TRAFFIC_CYCLIC, /**< Cyclic process data. */
+    EC_TRAFFIC_DC, /**< Distributed clocks synchronisation. */
+    EC_TRAFFIC_FSM, /**< Master state machine. */
+    EC_TRAFFIC_MAILBOX, /**< Slave state machines and mailbox access. */
+    EC_TRAFFIC_EOE, /**< Ethernet over EtherCAT. */
+    EC_TRAFFIC_CLASS_COUNT /**< Number of traffic classes. */
+} ec_traffic_class_t;
+
 /******************************************************************************
  * EtherCAT protocol
  *****************************************************************************/
@@ -0,0 +1,145 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *  vim: expandtab
+ *
+ *****************************************************************************/
+
+/** \file
+ * EtherCAT index table methods.
+ */
+
+/*****************************************************************************/
+
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include "index_table.h"
+
+/*****************************************************************************/
+
+/** Initial number of entries allocated by ec_index_table_append(). */
+#define EC_INDEX_TABLE_MIN_SIZE 8
+
+/*****************************************************************************/
+
+/** Index table constructor.
+ */
+void ec_index_table_init(
+        ec_index_table_t *table /**< Index table. */
+        )
+{
+    table->array = NULL;
+    table->count = 0;
+}
+
+/*****************************************************************************/
+
+/** Index table destructor.
+ *
+ * The entries themselves are not freed. The table is empty afterwards and
+ * can be reused. The entry array is freed after an RCU grace period.
+ */
+void ec_index_table_clear(
+        ec_index_table_t *table /**< Index table. */
+        )
+{
+    ec_index_array_t *array = table->array;
+
+    WRITE_ONCE(table->count, 0);
+    rcu_assign_pointer(table->array, NULL);
+    if (array) {
+        kfree_rcu(array, rcu);
+    }
+}
+
+/*****************************************************************************/
+
+/** Removes the entries beyond a given count.
+ *
+ * Undoes the latest appends. The array is kept for further appends. Calls
+ * have to be serialized with ec_index_table_append().
+ */
+void ec_index_table_truncate(
+        ec_index_table_t *table, /**< Index table. */
+        unsigned int count /**< Number of entries to keep. */
+        )
+{
+    if (count < table->count) {
+        WRITE_ONCE(table->count, count);
+    }
+}
+
+/*****************************************************************************/
+
+/** Appends an entry to the table.
+ *
+ * The entry can be retrieved with ec_index_table_get() using the previous
+ * number of entries as index. Calls have to be serialized by the caller.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_index_table_append(
+        ec_index_table_t *table, /**< Index table. */
+        void *entry /**< Entry to append. */
+        )
+{
+    ec_index_array_t *array = table->array, *old;
+    unsigned int size;
+
+    if (!array || table->count == array->size) {
+        size = array ? array->size * 2 : EC_INDEX_TABLE_MIN_SIZE;
+        old = array;
+
+        array = kmalloc(sizeof(ec_index_array_t) + size * sizeof(void *),
+                GFP_KERNEL);
+        if (!array) {
+            return -ENOMEM;
+        }
+
+        array->size = size;
+        if (table->count) {
+            memcpy(array->entries, old->entries,
+                    table->count * sizeof(void *));
+        }
+        array->entries[table->count] = entry;
+
+        // readers still using the old array only see the old count
+        rcu_assign_pointer(table->array, array);
+        if (old) {
+            kfree_rcu(old, rcu);
+        }
+    } else {
+        array->entries[table->count] = entry;
+    }
+
+    // publish the count only after the entry (and the array) are visible
+    smp_store_release(&table->count, table->count + 1);
+    return 0;
+}
+
+/*****************************************************************************/
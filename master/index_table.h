@@ -0,0 +1,108 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   EtherCAT index table structure.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_INDEX_TABLE_H__
+#define __EC_INDEX_TABLE_H__
+
+#include <linux/rcupdate.h>
+
+#include "globals.h"
+
+/*****************************************************************************/
+
+/** Entry array of an index table.
+ */
+typedef struct {
+    struct rcu_head rcu; /**< Frees the array after it was replaced. */
+    unsigned int size; /**< Allocated number of entries. */
+    void *entries[]; /**< Table entries. */
+} ec_index_array_t;
+
+/** Table of objects, that are addressed by their creation index.
+ *
+ * Objects are only appended and are removed all at once, or from the end
+ * to undo appends. This allows looking up an object in constant time,
+ * instead of walking its list.
+ *
+ * Appending has to be serialized by the caller, but lookups need no lock:
+ * A grown entry array is published via RCU and the old one is freed after a
+ * grace period. The count is only incremented after the entry was stored.
+ */
+typedef struct {
+    ec_index_array_t *array; /**< Entry array, or NULL. */
+    unsigned int count; /**< Number of entries. */
+} ec_index_table_t;
+
+/*****************************************************************************/
+
+void ec_index_table_init(ec_index_table_t *);
+void ec_index_table_clear(ec_index_table_t *);
+void ec_index_table_truncate(ec_index_table_t *, unsigned int);
+
+int ec_index_table_append(ec_index_table_t *, void *);
+
+/*****************************************************************************/
+
+/** Get an entry via its index.
+ *
+ * This may be called concurrently to ec_index_table_append().
+ *
+ * \return Entry, or NULL if the index is out of range.
+ */
+static inline void *ec_index_table_get(
+        const ec_index_table_t *table, /**< Index table. */
+        unsigned int index /**< Index of the entry. */
+        )
+{
+    const ec_index_array_t *array;
+    void *entry = NULL;
+
+    // pairs with the release in ec_index_table_append()
+    if (index < smp_load_acquire(&table->count)) {
+        rcu_read_lock();
+        array = rcu_dereference(table->array);
+        if (array && index < array->size) { // not cleared meanwhile
+            entry = array->entries[index];
+        }
+        rcu_read_unlock();
+    }
+
+    return entry;
+}
+
+/*****************************************************************************/
+
+#endif
@@ -132,6 +132,9 @@ static ATTRIBUTES int ec_ioctl_master(
     io.phase = (uint8_t) master->phase;
     io.active = (uint8_t) master->active;
     io.scan_busy = master->scan_busy;
+    io.ext_ring_size = master->ext_ring_size;
+    io.fsm_exec_count = master->fsm_exec_count;
+    io.ext_ring_stalls = master->ext_ring_stalls;
 
     ec_lock_up(&master->master_sem);
 
@@ -187,6 +190,13 @@ static ATTRIBUTES int ec_ioctl_master(
             master->device_stats.loss_rates[j];
     }
 
+    for (j = 0; j < EC_TRAFFIC_CLASS_COUNT; j++) {
+        io.traffic_classes[j].budget = master->traffic_budgets[j];
+        io.traffic_classes[j].datagrams = master->traffic_stats[j].datagrams;
+        io.traffic_classes[j].bytes = master->traffic_stats[j].bytes;
+        io.traffic_classes[j].deferred = master->traffic_stats[j].deferred;
+    }
+
     ec_lock_up(&master->device_sem);
 
     io.app_time = master->app_time;
@@ -219,111 +229,18 @@ static ATTRIBUTES int ec_ioctl_slave(
         )
 {
     ec_ioctl_slave_t data;
-    const ec_slave_t *slave;
-    int i;
 
     if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    if (ec_lock_down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    if (!(slave = ec_master_find_slave_const(
-                    master, 0, data.position))) {
-        ec_lock_up(&master->master_sem);
+    /* Served from the published slave information without taking the
+     * master_sem, so that diagnostics do not delay the application. */
+    if (ec_master_read_slave_info(master, data.position, &data)) {
         EC_MASTER_DBG(master, 1, "Slave %u does not exist!\n", data.position);
         return -EINVAL;
     }
 
-    data.device_index = slave->device_index;
-    data.alias = slave->effective_alias;
-    if (slave->sii_image) {
-        data.vendor_id = slave->sii_image->sii.vendor_id;
-        data.product_code = slave->sii_image->sii.product_code;
-        data.revision_number = slave->sii_image->sii.revision_number;
-        data.serial_number = slave->sii_image->sii.serial_number;
-        data.boot_rx_mailbox_offset = slave->sii_image->sii.boot_rx_mailbox_offset;
-        data.boot_rx_mailbox_size = slave->sii_image->sii.boot_rx_mailbox_size;
-        data.boot_tx_mailbox_offset = slave->sii_image->sii.boot_tx_mailbox_offset;
-        data.boot_tx_mailbox_size = slave->sii_image->sii.boot_tx_mailbox_size;
-        data.std_rx_mailbox_offset = slave->sii_image->sii.std_rx_mailbox_offset;
-        data.std_rx_mailbox_size = slave->sii_image->sii.std_rx_mailbox_size;
-        data.std_tx_mailbox_offset = slave->sii_image->sii.std_tx_mailbox_offset;
-        data.std_tx_mailbox_size = slave->sii_image->sii.std_tx_mailbox_size;
-        data.mailbox_protocols = slave->sii_image->sii.mailbox_protocols;
-        data.has_general_category = slave->sii_image->sii.has_general;
-        data.coe_details = slave->sii_image->sii.coe_details;
-        data.general_flags = slave->sii_image->sii.general_flags;
-        data.current_on_ebus = slave->sii_image->sii.current_on_ebus;
-        data.sync_count = slave->sii_image->sii.sync_count;
-        data.sii_nwords = slave->sii_image->nwords;
-        ec_ioctl_strcpy(data.group, slave->sii_image->sii.group);
-        ec_ioctl_strcpy(data.image, slave->sii_image->sii.image);
-        ec_ioctl_strcpy(data.order, slave->sii_image->sii.order);
-        ec_ioctl_strcpy(data.name, slave->sii_image->sii.name);
-    }
-    else {
-        data.vendor_id = 0x00000000;
-        data.product_code = 0x00000000;
-        data.revision_number = 0x00000000;
-        data.serial_number = 0x00000000;
-        data.boot_rx_mailbox_offset = 0x0000;
-        data.boot_rx_mailbox_size = 0x0000;
-        data.boot_tx_mailbox_offset = 0x0000;
-        data.boot_tx_mailbox_size = 0x0000;
-        data.std_rx_mailbox_offset = 0x0000;
-        data.std_rx_mailbox_size = 0x0000;
-        data.std_tx_mailbox_offset = 0x0000;
-        data.std_tx_mailbox_size = 0x0000;
-        data.mailbox_protocols = 0;
-        data.has_general_category = 0;
-        data.coe_details.enable_pdo_assign = 0;
-        data.coe_details.enable_pdo_configuration = 0;
-        data.coe_details.enable_sdo = 0;
-        data.coe_details.enable_sdo_complete_access = 0;
-        data.coe_details.enable_sdo_info = 0;
-        data.coe_details.enable_upload_at_startup = 0;
-        data.general_flags.enable_not_lrw = 0;
-        data.general_flags.enable_safeop = 0;
-        data.sync_count = 0;
-        data.sii_nwords = 0;
-        ec_ioctl_strcpy(data.group, "");
-        ec_ioctl_strcpy(data.image, "");
-        ec_ioctl_strcpy(data.order, "");
-        ec_ioctl_strcpy(data.name, "");
-    }
-
-    for (i = 0; i < EC_MAX_PORTS; i++) {
-        data.ports[i].desc = slave->ports[i].desc;
-        data.ports[i].link.link_up = slave->ports[i].link.link_up;
-        data.ports[i].link.loop_closed = slave->ports[i].link.loop_closed;
-        data.ports[i].link.signal_detected =
-            slave->ports[i].link.signal_detected;
-        data.ports[i].link.bypassed = slave->ports[i].link.bypassed;
-        data.ports[i].receive_time = slave->ports[i].receive_time;
-        if (slave->ports[i].next_slave) {
-            data.ports[i].next_slave =
-                slave->ports[i].next_slave->ring_position;
-        } else {
-            data.ports[i].next_slave = 0xffff;
-        }
-        data.ports[i].delay_to_next_dc = slave->ports[i].delay_to_next_dc;
-    }
-    data.upstream_port = slave->upstream_port;
-    data.fmmu_bit = slave->base_fmmu_bit_operation;
-    data.dc_supported = slave->base_dc_supported;
-    data.dc_range = slave->base_dc_range;
-    data.has_dc_system_time = slave->has_dc_system_time;
-    data.transmission_delay = slave->transmission_delay;
-    data.al_state = slave->current_state;
-    data.error_flag = slave->error_flag;
-    data.scan_required = slave->scan_required;
-    data.sdo_count = ec_slave_sdo_count(slave);
-    data.ready = ec_fsm_slave_is_ready(&slave->fsm);
-
-    ec_lock_up(&master->master_sem);
-
     if (copy_to_user((void __user *) arg, &data, sizeof(data)))
         return -EFAULT;
 
@@ -569,7 +486,7 @@ static ATTRIBUTES int ec_ioctl_domain(
         return -EINVAL;
     }
 
-    data.data_size = domain->data_size;
+    data.data_size = ec_domain_wire_size(domain);
     data.logical_base_address = domain->logical_base_address;
     for (dev_idx = EC_DEVICE_MAIN;
             dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
@@ -666,15 +583,15 @@ static ATTRIBUTES int ec_ioctl_domain_data(
         return -EINVAL;
     }
 
-    if (domain->data_size != data.data_size) {
+    if (ec_domain_wire_size(domain) != data.data_size) {
         ec_lock_up(&master->master_sem);
         EC_MASTER_ERR(master, "Data size mismatch %u/%zu!\n",
-                data.data_size, domain->data_size);
+                data.data_size, ec_domain_wire_size(domain));
         return -EFAULT;
     }
 
-    if (copy_to_user((void __user *) data.target, domain->data,
-                domain->data_size)) {
+    if (copy_to_user((void __user *) data.target,
+                ec_domain_wire_data(domain), data.data_size)) {
         ec_lock_up(&master->master_sem);
         return -EFAULT;
     }
@@ -993,6 +910,300 @@ static ATTRIBUTES int ec_ioctl_slave_sdo_entry(
 
 /*****************************************************************************/
 
+/** Output cursor of a bulk snapshot.
+ */
+typedef struct {
+    uint8_t *buffer; /**< Kernel buffer, or NULL. */
+    size_t size; /**< Size of \a buffer. */
+    size_t length; /**< Number of bytes serialized so far. */
+} ec_ioctl_snapshot_cursor_t;
+
+/*****************************************************************************/
+
+/** Appends data to a bulk snapshot.
+ *
+ * Data that do not fit into the buffer are only accounted for, so that the
+ * caller learns the required buffer size. The buffer is kernel memory, so
+ * that the serialization does not fault with the master_sem held.
+ */
+static ATTRIBUTES void ec_ioctl_snapshot_put(
+        ec_ioctl_snapshot_cursor_t *cursor, /**< Snapshot cursor. */
+        const void *data, /**< Data to append. */
+        size_t size /**< Size of \a data. */
+        )
+{
+    if (cursor->length + size <= cursor->size) {
+        memcpy(cursor->buffer + cursor->length, data, size);
+    }
+
+    cursor->length += size;
+}
+
+/*****************************************************************************/
+
+/** Returns the serialized size of a snapshot string.
+ *
+ * \return String size without terminator.
+ */
+static ATTRIBUTES uint8_t ec_ioctl_snapshot_string_size(
+        const char *source /**< String, or NULL. */
+        )
+{
+    return source ? strnlen(source, EC_IOCTL_STRING_SIZE - 1) : 0;
+}
+
+/*****************************************************************************/
+
+/** Serializes the information of all slaves.
+ *
+ * The records are read from the published slave information, so the
+ * master_sem is not taken.
+ *
+ */
+static ATTRIBUTES void ec_ioctl_snapshot_slaves(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_snapshot_cursor_t *cursor, /**< Snapshot cursor. */
+        uint32_t *count /**< Number of records. */
+        )
+{
+    ec_ioctl_slave_t info;
+
+    for (*count = 0; *count <= 0xffff; (*count)++) {
+        if (ec_master_read_slave_info(master, *count, &info)) {
+            break;
+        }
+
+        ec_ioctl_snapshot_put(cursor, &info, sizeof(info));
+    }
+}
+
+/*****************************************************************************/
+
+/** Serializes the sync managers, PDOs and PDO entries of a slave.
+ *
+ * The master_sem has to be held.
+ */
+static ATTRIBUTES void ec_ioctl_snapshot_pdos(
+        const ec_slave_t *slave, /**< EtherCAT slave. */
+        ec_ioctl_snapshot_cursor_t *cursor, /**< Snapshot cursor. */
+        uint32_t *count /**< Number of sync managers. */
+        )
+{
+    const ec_sync_t *sync;
+    const ec_pdo_t *pdo;
+    const ec_pdo_entry_t *entry;
+    ec_ioctl_snapshot_sync_t sync_rec;
+    ec_ioctl_snapshot_pdo_t pdo_rec;
+    ec_ioctl_snapshot_pdo_entry_t entry_rec;
+    unsigned int i;
+
+    *count = 0;
+
+    if (!slave->sii_image) {
+        EC_SLAVE_INFO(slave, "No access to SII data for sync managers!\n");
+        return;
+    }
+
+    for (i = 0; i < slave->sii_image->sii.sync_count; i++) {
+        sync = &slave->sii_image->sii.syncs[i];
+
+        memset(&sync_rec, 0, sizeof(sync_rec));
+        sync_rec.physical_start_address = sync->physical_start_address;
+        sync_rec.default_size = sync->default_length;
+        sync_rec.control_register = sync->control_register;
+        sync_rec.enable = sync->enable;
+        sync_rec.pdo_count = ec_pdo_list_count(&sync->pdos);
+        ec_ioctl_snapshot_put(cursor, &sync_rec, sizeof(sync_rec));
+
+        list_for_each_entry(pdo, &sync->pdos.list, list) {
+            memset(&pdo_rec, 0, sizeof(pdo_rec));
+            pdo_rec.index = pdo->index;
+            pdo_rec.entry_count = ec_pdo_entry_count(pdo);
+            pdo_rec.name_size = ec_ioctl_snapshot_string_size(pdo->name);
+            ec_ioctl_snapshot_put(cursor, &pdo_rec, sizeof(pdo_rec));
+            ec_ioctl_snapshot_put(cursor, pdo->name, pdo_rec.name_size);
+
+            list_for_each_entry(entry, &pdo->entries, list) {
+                memset(&entry_rec, 0, sizeof(entry_rec));
+                entry_rec.index = entry->index;
+                entry_rec.subindex = entry->subindex;
+                entry_rec.bit_length = entry->bit_length;
+                entry_rec.name_size =
+                    ec_ioctl_snapshot_string_size(entry->name);
+                ec_ioctl_snapshot_put(cursor, &entry_rec, sizeof(entry_rec));
+                ec_ioctl_snapshot_put(cursor, entry->name,
+                        entry_rec.name_size);
+            }
+        }
+
+        (*count)++;
+    }
+}
+
+/*****************************************************************************/
+
+/** Serializes the SDO dictionary of a slave.
+ *
+ * The master_sem has to be held.
+ */
+static ATTRIBUTES void ec_ioctl_snapshot_dict(
+        const ec_slave_t *slave, /**< EtherCAT slave. */
+        ec_ioctl_snapshot_cursor_t *cursor, /**< Snapshot cursor. */
+        uint32_t *count /**< Number of SDOs. */
+        )
+{
+    const ec_sdo_t *sdo;
+    const ec_sdo_entry_t *entry;
+    ec_ioctl_snapshot_sdo_t sdo_rec;
+    ec_ioctl_snapshot_sdo_entry_t entry_rec;
+    unsigned int entry_count;
+
+    *count = 0;
+
+    list_for_each_entry(sdo, &slave->sdo_dictionary, list) {
+        entry_count = 0;
+        list_for_each_entry(entry, &sdo->entries, list) {
+            entry_count++;
+        }
+
+        memset(&sdo_rec, 0, sizeof(sdo_rec));
+        sdo_rec.index = sdo->index;
+        sdo_rec.object_code = sdo->object_code;
+        sdo_rec.max_subindex = sdo->max_subindex;
+        sdo_rec.entry_count = entry_count;
+        sdo_rec.name_size = ec_ioctl_snapshot_string_size(sdo->name);
+        ec_ioctl_snapshot_put(cursor, &sdo_rec, sizeof(sdo_rec));
+        ec_ioctl_snapshot_put(cursor, sdo->name, sdo_rec.name_size);
+
+        list_for_each_entry(entry, &sdo->entries, list) {
+            memset(&entry_rec, 0, sizeof(entry_rec));
+            entry_rec.data_type = entry->data_type;
+            entry_rec.bit_length = entry->bit_length;
+            entry_rec.subindex = entry->subindex;
+            memcpy(entry_rec.read_access, entry->read_access,
+                    sizeof(entry_rec.read_access));
+            memcpy(entry_rec.write_access, entry->write_access,
+                    sizeof(entry_rec.write_access));
+            entry_rec.description_size =
+                ec_ioctl_snapshot_string_size(entry->description);
+            ec_ioctl_snapshot_put(cursor, &entry_rec, sizeof(entry_rec));
+            ec_ioctl_snapshot_put(cursor, entry->description,
+                    entry_rec.description_size);
+        }
+
+        (*count)++;
+    }
+}
+
+/*****************************************************************************/
+
+/** Serializes a whole information table.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_snapshot_table(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_snapshot_t *data, /**< Snapshot parameters. */
+        ec_ioctl_snapshot_cursor_t *cursor /**< Snapshot cursor. */
+        )
+{
+    const ec_slave_t *slave;
+
+    if (data->table == EC_IOCTL_SNAPSHOT_SLAVES) {
+        ec_ioctl_snapshot_slaves(master, cursor, &data->count);
+        return 0;
+    }
+
+    if (data->table != EC_IOCTL_SNAPSHOT_PDOS
+            && data->table != EC_IOCTL_SNAPSHOT_DICT) {
+        EC_MASTER_ERR(master, "Unknown snapshot table %u!\n", data->table);
+        return -EINVAL;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    if (!(slave = ec_master_find_slave_const(
+                    master, 0, data->slave_position))) {
+        ec_lock_up(&master->master_sem);
+        EC_MASTER_ERR(master, "Slave %u does not exist!\n",
+                data->slave_position);
+        return -EINVAL;
+    }
+
+    if (data->table == EC_IOCTL_SNAPSHOT_PDOS) {
+        ec_ioctl_snapshot_pdos(slave, cursor, &data->count);
+    } else {
+        ec_ioctl_snapshot_dict(slave, cursor, &data->count);
+    }
+
+    ec_lock_up(&master->master_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Serialize a whole information table into one userspace buffer.
+ *
+ * The table is measured first and then serialized into a kernel buffer of
+ * that size, which is copied to userspace without any lock held. If the
+ * table grew in the meantime, nothing is copied and the new length is
+ * returned.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_snapshot(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_snapshot_t data;
+    ec_ioctl_snapshot_cursor_t cursor;
+    int ret;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    cursor.buffer = NULL;
+    cursor.size = 0;
+    cursor.length = 0;
+
+    ret = ec_ioctl_snapshot_table(master, &data, &cursor);
+    if (ret) {
+        return ret;
+    }
+
+    if (cursor.length && cursor.length <= data.size) {
+        cursor.size = cursor.length;
+        cursor.length = 0;
+        if (!(cursor.buffer = vmalloc(cursor.size))) {
+            return -ENOMEM;
+        }
+
+        ret = ec_ioctl_snapshot_table(master, &data, &cursor);
+        if (!ret && cursor.length <= cursor.size
+                && copy_to_user((void __user *) data.buffer, cursor.buffer,
+                    cursor.length)) {
+            ret = -EFAULT;
+        }
+
+        vfree(cursor.buffer);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    data.length = cursor.length;
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 /** Upload SDO.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -2139,6 +2350,67 @@ out_return:
 
 /*****************************************************************************/
 
+/** Gets the size of the request data memory to share with the application.
+ *
+ * The caller has to hold the master_sem.
+ *
+ * \return Size in bytes, zero if the application did not ask for it with
+ *         EC_IOCTL_SHARE_REQUEST_DATA.
+ */
+static ATTRIBUTES size_t ec_ioctl_request_memory_size(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_slave_config_t *sc;
+    size_t size = 0;
+
+    if (!ctx->share_request_data) {
+        return 0;
+    }
+
+    list_for_each_entry(sc, &master->configs, list) {
+        size += ec_slave_config_request_memory_size(sc);
+    }
+
+    return size;
+}
+
+/*****************************************************************************/
+
+/** Places the request data memory in the process data area.
+ *
+ * The SDO and SoE requests and VoE handlers share their data with the
+ * application behind the domains' process data, starting at \a offset.
+ */
+static ATTRIBUTES void ec_ioctl_request_external_memory(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_context_t *ctx, /**< Private data structure of file handle. */
+        off_t offset /**< Offset in the process data area. */
+        )
+{
+    ec_slave_config_t *sc;
+
+    memset(ctx->process_data + offset, 0x00,
+            ctx->process_data_size - offset);
+
+    ec_lock_down(&master->master_sem);
+
+    list_for_each_entry(sc, &master->configs, list) {
+        // configurations may have been added in the meantime
+        if (offset + ec_slave_config_request_memory_size(sc) >
+                ctx->process_data_size) {
+            break;
+        }
+        offset += ec_slave_config_request_external_memory(sc,
+                ctx->process_data + offset);
+    }
+
+    ec_lock_up(&master->master_sem);
+}
+
+/*****************************************************************************/
+
 /** Sets up domain memory.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -2151,10 +2423,9 @@ static ATTRIBUTES int ec_ioctl_setup_domain_memory(
 {
     ec_ioctl_master_activate_t io;
     ec_domain_t *domain;
-    off_t offset;
-#ifdef EC_IOCTL_RTDM
+    off_t offset, request_offset;
+    size_t request_size;
     int ret;
-#endif
 
     if (unlikely(!ctx->requested))
         return -EPERM;
@@ -2172,9 +2443,22 @@ static ATTRIBUTES int ec_ioctl_setup_domain_memory(
             return -EINTR;
 
         list_for_each_entry(domain, &master->domains, list) {
+            ret = ec_domain_optimize_layout(domain);
+            if (ret < 0) {
+                ec_lock_up(&master->master_sem);
+                return ret;
+            }
             ctx->process_data_size += ecrt_domain_size(domain);
         }
 
+        /* The request data memory follows on the next cache line. */
+        request_offset = ALIGN(ctx->process_data_size,
+                EC_IOCTL_CACHE_LINE_SIZE);
+        request_size = ec_ioctl_request_memory_size(master, ctx);
+        if (request_size) {
+            ctx->process_data_size = request_offset + request_size;
+        }
+
         ec_lock_up(&master->master_sem);
 
         if (ctx->process_data_size) {
@@ -2194,6 +2478,11 @@ static ATTRIBUTES int ec_ioctl_setup_domain_memory(
                 offset += ecrt_domain_size(domain);
             }
 
+            if (request_size) {
+                ec_ioctl_request_external_memory(master, ctx,
+                        request_offset);
+            }
+
 #ifdef EC_IOCTL_RTDM
             /* RTDM uses a different approach for memory-mapping, which has to be
              * initiated by the kernel.
@@ -2237,7 +2526,8 @@ static ATTRIBUTES int ec_ioctl_activate(
 {
     ec_ioctl_master_activate_t io;
     ec_domain_t *domain;
-    off_t offset;
+    off_t offset, request_offset;
+    size_t request_size;
     int ret;
 
     if (unlikely(!ctx->requested))
@@ -2256,9 +2546,22 @@ static ATTRIBUTES int ec_ioctl_activate(
             return -EINTR;
 
         list_for_each_entry(domain, &master->domains, list) {
+            ret = ec_domain_optimize_layout(domain);
+            if (ret < 0) {
+                ec_lock_up(&master->master_sem);
+                return ret;
+            }
             ctx->process_data_size += ecrt_domain_size(domain);
         }
 
+        /* The request data memory follows on the next cache line. */
+        request_offset = ALIGN(ctx->process_data_size,
+                EC_IOCTL_CACHE_LINE_SIZE);
+        request_size = ec_ioctl_request_memory_size(master, ctx);
+        if (request_size) {
+            ctx->process_data_size = request_offset + request_size;
+        }
+
         ec_lock_up(&master->master_sem);
 
         if (ctx->process_data_size) {
@@ -2278,6 +2581,11 @@ static ATTRIBUTES int ec_ioctl_activate(
                 offset += ecrt_domain_size(domain);
             }
 
+            if (request_size) {
+                ec_ioctl_request_external_memory(master, ctx,
+                        request_offset);
+            }
+
 #ifdef EC_IOCTL_RTDM
             /* RTDM uses a different approach for memory-mapping, which has to be
              * initiated by the kernel.
@@ -3314,47 +3622,662 @@ static ATTRIBUTES int ec_ioctl_sc_sdo(
 
 /*****************************************************************************/
 
-#ifdef EC_EOE
-/** Configures EoE.
+/** Maximum number of operations in a configuration transaction.
+ */
+#define EC_IOCTL_TXN_MAX_OPS 65536
+
+/** Checks the references of a configuration transaction operation.
+ *
+ * The master semaphore has to be held by the caller.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_eoe(
+static ATTRIBUTES int ec_ioctl_txn_check(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
-)
+        const ec_ioctl_txn_op_t *ops, /**< Operations. */
+        unsigned int pos /**< Position of the operation to check. */
+        )
 {
-    ec_ioctl_sc_eoe_t data;
-    ec_slave_config_t *sc;
+    const ec_ioctl_txn_op_t *op = &ops[pos];
+    uint32_t ref;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
-
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
-    return -EFAULT;
+    if (op->type >= EC_IOCTL_TXN_COUNT) {
+        return -EINVAL;
+    }
 
-    if (ec_lock_down_interruptible(&master->master_sem))
-        return -EINTR;
+    if (op->type == EC_IOCTL_TXN_CONFIG) {
+        return 0;
+    }
 
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        ec_lock_up(&master->master_sem);
+    if (op->config_index & EC_IOCTL_TXN_PENDING) {
+        ref = op->config_index & ~EC_IOCTL_TXN_PENDING;
+        if (ref >= pos || ops[ref].type != EC_IOCTL_TXN_CONFIG) {
+            return -ENOENT;
+        }
+    } else if (!ec_master_get_config(master, op->config_index)) {
         return -ENOENT;
     }
 
-    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
-
-    return ecrt_slave_config_eoe(sc, data.mac_address, data.ip_address,
-                data.subnet_mask, data.gateway, data.dns, data.name);
+    switch (op->type) {
+        case EC_IOCTL_TXN_SYNC_MANAGER:
+            if (op->u.sync.sync_index >= EC_MAX_SYNC_MANAGERS) {
+                return -ENOENT;
+            }
+            break;
+        case EC_IOCTL_TXN_REG_PDO_ENTRY:
+            if (!ec_master_find_domain(master,
+                        op->u.reg_pdo_entry.domain_index)) {
+                return -ENOENT;
+            }
+            break;
+        case EC_IOCTL_TXN_SDO:
+            if (!op->u.sdo.size) {
+                return -EINVAL;
+            }
+            break;
+        default:
+            break;
+    }
 
+    return 0;
 }
-#endif
 
 /*****************************************************************************/
 
-/** Set the emergency ring buffer size.
+/** Prepares the SDO configuration of a transaction operation.
  *
- * \return Zero on success, otherwise a negative error code.
+ * The data are copied from user space before the master_sem is taken.
+ *
+ * \return SDO request, or an ERR_PTR() code.
+ */
+static ATTRIBUTES ec_sdo_request_t *ec_ioctl_txn_prepare_sdo(
+        const ec_ioctl_txn_op_t *op /**< EC_IOCTL_TXN_SDO operation. */
+        )
+{
+    ec_sdo_request_t *req;
+    uint8_t *sdo_data;
+    int ret;
+
+    if (!(sdo_data = kmalloc(op->u.sdo.size, GFP_KERNEL))) {
+        return ERR_PTR(-ENOMEM);
+    }
+
+    if (copy_from_user(sdo_data, (void __user *) op->u.sdo.data,
+                op->u.sdo.size)) {
+        kfree(sdo_data);
+        return ERR_PTR(-EFAULT);
+    }
+
+    if (!(req = kmalloc(sizeof(*req), GFP_KERNEL))) {
+        kfree(sdo_data);
+        return ERR_PTR(-ENOMEM);
+    }
+
+    ec_sdo_request_init(req);
+    if (op->u.sdo.complete_access) {
+        ecrt_sdo_request_index_complete(req, op->u.sdo.index);
+    } else {
+        ecrt_sdo_request_index(req, op->u.sdo.index, op->u.sdo.subindex);
+    }
+
+    ret = ec_sdo_request_copy_data(req, sdo_data, op->u.sdo.size);
+    kfree(sdo_data);
+    if (ret < 0) {
+        ec_sdo_request_clear(req);
+        kfree(req);
+        return ERR_PTR(ret);
+    }
+
+    return req;
+}
+
+/*****************************************************************************/
+
+/** State of a slave configuration before a transaction modified it.
+ */
+typedef struct {
+    ec_direction_t dir[EC_MAX_SYNC_MANAGERS]; /**< Sync manager directions.
+                                               */
+    ec_watchdog_mode_t watchdog_mode[EC_MAX_SYNC_MANAGERS]; /**< Sync
+                                                          manager watchdog
+                                                          modes. */
+    ec_pdo_list_t pdos[EC_MAX_SYNC_MANAGERS]; /**< Copies of the PDO
+                                                assignments. */
+    uint16_t watchdog_divider; /**< Watchdog divider. */
+    uint16_t watchdog_intervals; /**< Watchdog intervals. */
+    uint16_t dc_assign_activate; /**< DC AssignActivate word. */
+    ec_sync_signal_t dc_sync[EC_SYNC_SIGNAL_COUNT]; /**< DC sync signals. */
+    uint8_t used_fmmus; /**< Number of FMMUs used. */
+    struct list_head *last_sdo; /**< Last SDO configuration. */
+} ec_ioctl_txn_config_state_t;
+
+/** State of a domain before a transaction registered PDO entries in it.
+ */
+typedef struct {
+    int saved; /**< The state was saved. */
+    uint32_t offset_used[EC_DIR_COUNT]; /**< Next free offsets. */
+    const ec_slave_config_t *sc_in_work; /**< Last configuration. */
+    size_t data_size; /**< Size of the process data. */
+} ec_ioctl_txn_domain_state_t;
+
+/** Saved state, that allows rolling back a configuration transaction.
+ *
+ * The state of a slave configuration or domain is saved, before the first
+ * operation modifies it. Configurations, that are created by the
+ * transaction, are removed on rollback instead.
+ */
+typedef struct {
+    unsigned int config_count; /**< Number of slave configurations before
+                                 the transaction. */
+    ec_ioctl_txn_config_state_t **configs; /**< Saved configurations by
+                                             index. */
+    unsigned int domain_count; /**< Number of domains. */
+    ec_ioctl_txn_domain_state_t *domains; /**< Saved domains by index. */
+} ec_ioctl_txn_undo_t;
+
+/*****************************************************************************/
+
+/** Prepares the rollback of a configuration transaction.
+ *
+ * The master_sem has to be held by the caller.
+ *
+ * \return Zero on success, otherwise -ENOMEM.
+ */
+static ATTRIBUTES int ec_ioctl_txn_undo_init(
+        ec_ioctl_txn_undo_t *undo, /**< Rollback state. */
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    undo->config_count = master->config_table.count;
+    undo->domain_count = ec_master_domain_count(master);
+    undo->configs =
+        vzalloc(sizeof(*undo->configs) * (undo->config_count + 1));
+    undo->domains =
+        vzalloc(sizeof(*undo->domains) * (undo->domain_count + 1));
+    if (!undo->configs || !undo->domains) {
+        vfree(undo->configs);
+        vfree(undo->domains);
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Frees the saved state of a slave configuration.
+ */
+static ATTRIBUTES void ec_ioctl_txn_config_state_free(
+        ec_ioctl_txn_config_state_t *state /**< Saved state. */
+        )
+{
+    unsigned int i;
+
+    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++) {
+        ec_pdo_list_clear(&state->pdos[i]);
+    }
+    kfree(state);
+}
+
+/*****************************************************************************/
+
+/** Frees the rollback state of a configuration transaction.
+ */
+static ATTRIBUTES void ec_ioctl_txn_undo_clear(
+        ec_ioctl_txn_undo_t *undo /**< Rollback state. */
+        )
+{
+    unsigned int i;
+
+    for (i = 0; i < undo->config_count; i++) {
+        if (undo->configs[i]) {
+            ec_ioctl_txn_config_state_free(undo->configs[i]);
+        }
+    }
+    vfree(undo->configs);
+    vfree(undo->domains);
+}
+
+/*****************************************************************************/
+
+/** Saves the state of a slave configuration, before it is modified.
+ *
+ * Configurations created by the transaction are not saved.
+ *
+ * \return Zero on success, otherwise -ENOMEM.
+ */
+static ATTRIBUTES int ec_ioctl_txn_save_config(
+        ec_ioctl_txn_undo_t *undo, /**< Rollback state. */
+        const ec_slave_config_t *sc, /**< Slave configuration. */
+        unsigned int index /**< Configuration index. */
+        )
+{
+    ec_ioctl_txn_config_state_t *state;
+    unsigned int i;
+
+    if (index >= undo->config_count || undo->configs[index]) {
+        return 0;
+    }
+
+    if (!(state = kmalloc(sizeof(*state), GFP_KERNEL))) {
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++) {
+        state->dir[i] = sc->sync_configs[i].dir;
+        state->watchdog_mode[i] = sc->sync_configs[i].watchdog_mode;
+        ec_pdo_list_init(&state->pdos[i]);
+    }
+
+    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++) {
+        if (ec_pdo_list_copy(&state->pdos[i], &sc->sync_configs[i].pdos)) {
+            ec_ioctl_txn_config_state_free(state);
+            return -ENOMEM;
+        }
+    }
+
+    state->watchdog_divider = sc->watchdog_divider;
+    state->watchdog_intervals = sc->watchdog_intervals;
+    state->dc_assign_activate = sc->dc_assign_activate;
+    memcpy(state->dc_sync, sc->dc_sync, sizeof(state->dc_sync));
+    state->used_fmmus = sc->used_fmmus;
+    state->last_sdo = sc->sdo_configs.prev;
+
+    undo->configs[index] = state;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Saves the state of a domain, before PDO entries are registered.
+ */
+static ATTRIBUTES void ec_ioctl_txn_save_domain(
+        ec_ioctl_txn_undo_t *undo, /**< Rollback state. */
+        const ec_domain_t *domain /**< Domain. */
+        )
+{
+    ec_ioctl_txn_domain_state_t *state = &undo->domains[domain->index];
+
+    if (state->saved) {
+        return;
+    }
+
+    memcpy(state->offset_used, domain->offset_used,
+            sizeof(state->offset_used));
+    state->sc_in_work = domain->sc_in_work;
+    state->data_size = domain->data_size;
+    state->saved = 1;
+}
+
+/*****************************************************************************/
+
+/** Restores a slave configuration from its saved state.
+ */
+static ATTRIBUTES void ec_ioctl_txn_restore_config(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        ec_ioctl_txn_config_state_t *state /**< Saved state. */
+        )
+{
+    ec_sdo_request_t *req, *next;
+    unsigned int i;
+
+    // FMMUs of registered PDO entries are appended to the domains
+    for (i = state->used_fmmus; i < sc->used_fmmus; i++) {
+        list_del_init(&sc->fmmu_configs[i].list);
+    }
+    sc->used_fmmus = state->used_fmmus;
+
+    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++) {
+        sc->sync_configs[i].dir = state->dir[i];
+        sc->sync_configs[i].watchdog_mode = state->watchdog_mode[i];
+        ec_pdo_list_clear_pdos(&sc->sync_configs[i].pdos);
+        list_splice_init(&state->pdos[i].list,
+                &sc->sync_configs[i].pdos.list);
+    }
+
+    sc->watchdog_divider = state->watchdog_divider;
+    sc->watchdog_intervals = state->watchdog_intervals;
+    sc->dc_assign_activate = state->dc_assign_activate;
+    memcpy(sc->dc_sync, state->dc_sync, sizeof(sc->dc_sync));
+
+    // SDO configurations are appended
+    req = list_entry(state->last_sdo->next, ec_sdo_request_t, list);
+    list_for_each_entry_safe_from(req, next, &sc->sdo_configs, list) {
+        list_del(&req->list);
+        ec_sdo_request_clear(req);
+        kfree(req);
+    }
+}
+
+/*****************************************************************************/
+
+/** Rolls back the operations of a configuration transaction.
+ *
+ * The master_sem has to be held by the caller.
+ */
+static ATTRIBUTES void ec_ioctl_txn_rollback(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_txn_undo_t *undo /**< Rollback state. */
+        )
+{
+    ec_slave_config_t *sc;
+    ec_domain_t *domain;
+    ec_ioctl_txn_domain_state_t *state;
+    unsigned int i, j;
+
+    // remove the configurations created by the transaction
+    for (i = master->config_table.count; i-- > undo->config_count; ) {
+        sc = ec_index_table_get(&master->config_table, i);
+        for (j = 0; j < sc->used_fmmus; j++) {
+            list_del_init(&sc->fmmu_configs[j].list);
+        }
+        list_del(&sc->list);
+        ec_slave_config_clear(sc);
+        kfree(sc);
+    }
+    ec_index_table_truncate(&master->config_table, undo->config_count);
+
+    for (i = 0; i < undo->config_count; i++) {
+        if (undo->configs[i]) {
+            ec_ioctl_txn_restore_config(
+                    ec_index_table_get(&master->config_table, i),
+                    undo->configs[i]);
+        }
+    }
+
+    for (i = 0; i < undo->domain_count; i++) {
+        state = &undo->domains[i];
+        if (!state->saved) {
+            continue;
+        }
+        domain = ec_master_find_domain(master, i);
+        memcpy(domain->offset_used, state->offset_used,
+                sizeof(domain->offset_used));
+        domain->sc_in_work = state->sc_in_work;
+        domain->data_size = state->data_size;
+    }
+}
+
+/*****************************************************************************/
+
+/** Applies a configuration transaction operation.
+ *
+ * The master_sem has to be held by the caller.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_txn_apply(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_txn_op_t *ops, /**< Operations. */
+        unsigned int pos, /**< Position of the operation to apply. */
+        void **objects, /**< Configurations created by EC_IOCTL_TXN_CONFIG
+                          and prepared SDO requests, by position. */
+        ec_ioctl_txn_undo_t *undo /**< Rollback state. */
+        )
+{
+    ec_ioctl_txn_op_t *op = &ops[pos];
+    ec_slave_config_t *sc;
+    ec_domain_t *domain;
+    unsigned int i;
+    int ret = 0;
+
+    if (op->type == EC_IOCTL_TXN_CONFIG) {
+        sc = ec_master_slave_config_nolock(master, op->u.config.alias,
+                op->u.config.position, op->u.config.vendor_id,
+                op->u.config.product_code);
+        if (IS_ERR(sc)) {
+            return PTR_ERR(sc);
+        }
+
+        for (i = 0; i < master->config_table.count; i++) {
+            if (ec_index_table_get(&master->config_table, i) == sc) {
+                break;
+            }
+        }
+
+        objects[pos] = sc;
+        op->config_index = i;
+        return 0;
+    }
+
+    if (op->config_index & EC_IOCTL_TXN_PENDING) {
+        i = op->config_index & ~EC_IOCTL_TXN_PENDING;
+        sc = objects[i];
+        i = ops[i].config_index;
+    } else {
+        sc = ec_master_get_config(master, op->config_index);
+        i = op->config_index;
+    }
+
+    if ((ret = ec_ioctl_txn_save_config(undo, sc, i))) {
+        return ret;
+    }
+
+    switch (op->type) {
+        case EC_IOCTL_TXN_SYNC_MANAGER:
+            ret = ecrt_slave_config_sync_manager(sc, op->u.sync.sync_index,
+                    op->u.sync.dir, op->u.sync.watchdog_mode);
+            break;
+        case EC_IOCTL_TXN_WATCHDOG:
+            ecrt_slave_config_watchdog(sc, op->u.watchdog.divider,
+                    op->u.watchdog.intervals);
+            break;
+        case EC_IOCTL_TXN_PDO_ASSIGN_CLEAR:
+            ec_slave_config_pdo_assign_clear_nolock(sc,
+                    op->u.pdo_assign.sync_index);
+            break;
+        case EC_IOCTL_TXN_PDO_ASSIGN_ADD:
+            ret = ec_slave_config_pdo_assign_add_nolock(sc,
+                    op->u.pdo_assign.sync_index, op->u.pdo_assign.pdo_index);
+            break;
+        case EC_IOCTL_TXN_PDO_MAPPING_CLEAR:
+            ec_slave_config_pdo_mapping_clear_nolock(sc,
+                    op->u.pdo_mapping.pdo_index);
+            break;
+        case EC_IOCTL_TXN_PDO_MAPPING_ADD:
+            ret = ec_slave_config_pdo_mapping_add_nolock(sc,
+                    op->u.pdo_mapping.pdo_index,
+                    op->u.pdo_mapping.entry_index,
+                    op->u.pdo_mapping.entry_subindex,
+                    op->u.pdo_mapping.entry_bit_length);
+            break;
+        case EC_IOCTL_TXN_REG_PDO_ENTRY:
+            domain = ec_master_find_domain(master,
+                    op->u.reg_pdo_entry.domain_index);
+            ec_ioctl_txn_save_domain(undo, domain);
+            ret = ec_slave_config_reg_pdo_entry_nolock(sc,
+                    op->u.reg_pdo_entry.entry_index,
+                    op->u.reg_pdo_entry.entry_subindex, domain,
+                    &op->u.reg_pdo_entry.bit_position);
+            if (ret >= 0) {
+                op->u.reg_pdo_entry.offset = ret;
+                ret = 0;
+            }
+            break;
+        case EC_IOCTL_TXN_DC:
+            ecrt_slave_config_dc(sc, op->u.dc.assign_activate,
+                    op->u.dc.sync0_cycle_time, op->u.dc.sync0_shift_time,
+                    op->u.dc.sync1_cycle_time, op->u.dc.sync1_shift_time);
+            break;
+        case EC_IOCTL_TXN_SDO:
+            // the slave configuration takes over the prepared request
+            list_add_tail(&((ec_sdo_request_t *) objects[pos])->list,
+                    &sc->sdo_configs);
+            objects[pos] = NULL;
+            break;
+        default:
+            break;
+    }
+
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Applies a configuration transaction.
+ *
+ * All operations are checked first, so that nothing is applied if an
+ * operation refers to a missing slave configuration or domain. The
+ * operations are then applied in order under one hold of the master_sem, so
+ * that no other caller sees a partially applied transaction. If an
+ * operation fails, the operations before it are rolled back, the
+ * configuration indices of all EC_IOCTL_TXN_CONFIG operations are set to
+ * EC_IOCTL_TXN_FAILED and the position of the failed operation is returned
+ * in \a failed_op.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_transaction(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_transaction_t data;
+    ec_ioctl_txn_op_t *ops;
+    ec_ioctl_txn_undo_t undo;
+    void **objects;
+    ec_sdo_request_t *req;
+    unsigned int i, j;
+    int ret = 0;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    if (data.op_count > EC_IOCTL_TXN_MAX_OPS)
+        return -EINVAL;
+
+    if (!data.op_count)
+        return 0;
+
+    if (!(ops = vmalloc(sizeof(*ops) * data.op_count))) {
+        return -ENOMEM;
+    }
+
+    if (!(objects = vzalloc(sizeof(*objects) * data.op_count))) {
+        vfree(ops);
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(ops, (void __user *) data.ops,
+                sizeof(*ops) * data.op_count)) {
+        ret = -EFAULT;
+        goto out_free;
+    }
+
+    for (i = 0; i < data.op_count; i++) {
+        if (ops[i].type != EC_IOCTL_TXN_SDO || !ops[i].u.sdo.size) {
+            continue;
+        }
+        req = ec_ioctl_txn_prepare_sdo(&ops[i]);
+        if (IS_ERR(req)) {
+            ret = PTR_ERR(req);
+            data.failed_op = i;
+            goto out_copy;
+        }
+        objects[i] = req;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        ret = -EINTR;
+        goto out_free;
+    }
+
+    for (i = 0; i < data.op_count; i++) {
+        if ((ret = ec_ioctl_txn_check(master, ops, i))) {
+            break;
+        }
+    }
+
+    if (!ret && !(ret = ec_ioctl_txn_undo_init(&undo, master))) {
+        for (i = 0; i < data.op_count; i++) {
+            if ((ret = ec_ioctl_txn_apply(master, ops, i, objects, &undo))) {
+                break;
+            }
+        }
+
+        if (ret) {
+            ec_ioctl_txn_rollback(master, &undo);
+            for (j = 0; j < data.op_count; j++) {
+                if (ops[j].type == EC_IOCTL_TXN_CONFIG) {
+                    ops[j].config_index = EC_IOCTL_TXN_FAILED;
+                }
+            }
+        }
+
+        ec_ioctl_txn_undo_clear(&undo);
+    }
+
+    ec_lock_up(&master->master_sem);
+
+    data.failed_op = i;
+
+out_copy:
+    if (copy_to_user((void __user *) data.ops, ops,
+                sizeof(*ops) * data.op_count) ||
+            copy_to_user((void __user *) arg, &data, sizeof(data))) {
+        ret = -EFAULT;
+    }
+
+out_free:
+    // free the SDO requests that were not applied
+    for (i = 0; i < data.op_count; i++) {
+        if (ops[i].type == EC_IOCTL_TXN_SDO && objects[i]) {
+            ec_sdo_request_clear(objects[i]);
+            kfree(objects[i]);
+        }
+    }
+    vfree(objects);
+    vfree(ops);
+    return ret;
+}
+
+/*****************************************************************************/
+
+#ifdef EC_EOE
+/** Configures EoE.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_eoe(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+)
+{
+    ec_ioctl_sc_eoe_t data;
+    ec_slave_config_t *sc;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+    return -EFAULT;
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        ec_lock_up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+
+    return ecrt_slave_config_eoe(sc, data.mac_address, data.ip_address,
+                data.subnet_mask, data.gateway, data.dns, data.name);
+
+}
+#endif
+
+/*****************************************************************************/
+
+/** Set the emergency ring buffer size.
+ *
+ * \return Zero on success, otherwise a negative error code.
  */
 static ATTRIBUTES int ec_ioctl_sc_emerg_size(
         ec_master_t *master, /**< EtherCAT master. */
@@ -3362,169 +4285,766 @@ static ATTRIBUTES int ec_ioctl_sc_emerg_size(
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sc_emerg_t io;
+    ec_ioctl_sc_emerg_t io;
+    ec_slave_config_t *sc;
+    int ret;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io)))
+        return -EFAULT;
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        ec_lock_up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    ret = ecrt_slave_config_emerg_size(sc, io.size);
+
+    ec_lock_up(&master->master_sem);
+
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Get an emergency message from the ring.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_emerg_pop(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sc_emerg_t io;
+    ec_slave_config_t *sc;
+    u8 msg[EC_COE_EMERGENCY_MSG_SIZE];
+    int ret;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because configuration will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        return -ENOENT;
+    }
+
+    ret = ecrt_slave_config_emerg_pop(sc, msg);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (copy_to_user((void __user *) io.target, msg, sizeof(msg))) {
+        return -EFAULT;
+    }
+
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Clear the emergency ring.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_emerg_clear(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sc_emerg_t io;
+    ec_slave_config_t *sc;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because configuration will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        return -ENOENT;
+    }
+
+    return ecrt_slave_config_emerg_clear(sc);
+}
+
+/*****************************************************************************/
+
+/** Get the number of emergency overruns.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_emerg_overruns(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sc_emerg_t io;
+    ec_slave_config_t *sc;
+    int ret;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because configuration will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        return -ENOENT;
+    }
+
+    ret = ecrt_slave_config_emerg_overruns(sc);
+    if (ret < 0) {
+        return ret;
+    }
+
+    io.overruns = ret;
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Create an SDO request.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_create_sdo_request(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sdo_request_t data;
+    ec_slave_config_t *sc;
+    ec_sdo_request_t *req;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    data.request_index = 0;
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    sc = ec_master_get_config(master, data.config_index);
+    if (!sc) {
+        ec_lock_up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    list_for_each_entry(req, &sc->sdo_requests, list) {
+        data.request_index++;
+    }
+
+    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+
+    req = ecrt_slave_config_create_sdo_request_err(sc, data.sdo_index,
+            data.sdo_subindex, data.complete_access, data.size);
+    if (IS_ERR(req))
+        return PTR_ERR(req);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Create an FoE request.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_create_foe_request(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_foe_request_t data;
+    ec_slave_config_t *sc;
+    ec_foe_request_t *req;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    data.request_index = 0;
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    sc = ec_master_get_config(master, data.config_index);
+    if (!sc) {
+        ec_lock_up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    list_for_each_entry(req, &sc->foe_requests, list) {
+        data.request_index++;
+    }
+
+    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+
+    req = ecrt_slave_config_create_foe_request_err(sc, data.size);
+    if (IS_ERR(req))
+        return PTR_ERR(req);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Create a register request.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_create_reg_request(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_reg_request_t io;
+    ec_slave_config_t *sc;
+    ec_reg_request_t *reg;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    io.request_index = 0;
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    sc = ec_master_get_config(master, io.config_index);
+    if (!sc) {
+        ec_lock_up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    list_for_each_entry(reg, &sc->reg_requests, list) {
+        io.request_index++;
+    }
+
+    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+
+    reg = ecrt_slave_config_create_reg_request_err(sc, io.mem_size);
+    if (IS_ERR(reg)) {
+        return PTR_ERR(reg);
+    }
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Create a VoE handler.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_create_voe_handler(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_voe_t data;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    data.voe_index = 0;
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    sc = ec_master_get_config(master, data.config_index);
+    if (!sc) {
+        ec_lock_up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    list_for_each_entry(voe, &sc->voe_handlers, list) {
+        data.voe_index++;
+    }
+
+    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+
+    voe = ecrt_slave_config_create_voe_handler_err(sc, data.size);
+    if (IS_ERR(voe))
+        return PTR_ERR(voe);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Get the slave configuration's state.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_state(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sc_state_t data;
+    const ec_slave_config_t *sc;
+    ec_slave_config_state_t state;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because sc will not be deleted in the
+     * meantime. */
+
+    if (!(sc = ec_master_get_config_const(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    ecrt_slave_config_state(sc, &state);
+
+    if (copy_to_user((void __user *) data.state, &state, sizeof(state)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Configures an IDN.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_idn(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sc_idn_t ioctl;
     ec_slave_config_t *sc;
+    uint8_t *data = NULL;
     int ret;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io)))
+    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl)))
+        return -EFAULT;
+
+    if (!ioctl.size)
+        return -EINVAL;
+
+    if (!(data = kmalloc(ioctl.size, GFP_KERNEL))) {
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(data, (void __user *) ioctl.data, ioctl.size)) {
+        kfree(data);
         return -EFAULT;
+    }
 
     if (ec_lock_down_interruptible(&master->master_sem)) {
+        kfree(data);
         return -EINTR;
     }
 
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
+    if (!(sc = ec_master_get_config(master, ioctl.config_index))) {
         ec_lock_up(&master->master_sem);
+        kfree(data);
         return -ENOENT;
     }
 
-    ret = ecrt_slave_config_emerg_size(sc, io.size);
+    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+
+    ret = ecrt_slave_config_idn(
+            sc, ioctl.drive_no, ioctl.idn, ioctl.al_state, data, ioctl.size);
+    kfree(data);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Gets the domain's data size.
+ *
+ * \return Domain size, or a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_size(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    const ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    list_for_each_entry(domain, &master->domains, list) {
+        if (domain->index == (unsigned long) arg) {
+            size_t size = ecrt_domain_size(domain);
+            ec_lock_up(&master->master_sem);
+            return size;
+        }
+    }
+
+    ec_lock_up(&master->master_sem);
+    return -ENOENT;
+}
+
+/*****************************************************************************/
+
+/** Sets the exchange period of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_period(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_period_t data;
+    ec_domain_t *domain;
+    int ret;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        ec_lock_up(&master->master_sem);
+        return -ENOENT;
+    }
 
+    ret = ecrt_domain_set_period(domain, data.period, data.phase);
     ec_lock_up(&master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Requests the layout optimization of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_optimize(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_domain_t *domain;
+    int ret;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
+        ec_lock_up(&master->master_sem);
+        return -ENOENT;
+    }
 
+    ret = ecrt_domain_optimize_layout(domain);
+    ec_lock_up(&master->master_sem);
     return ret;
 }
 
 /*****************************************************************************/
 
-/** Get an emergency message from the ring.
+/** Configures overlapping PDOs for a domain.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_emerg_pop(
+static ATTRIBUTES int ec_ioctl_domain_overlapping(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sc_emerg_t io;
-    ec_slave_config_t *sc;
-    u8 msg[EC_COE_EMERGENCY_MSG_SIZE];
+    ec_ioctl_domain_overlapping_t data;
+    ec_domain_t *domain;
     int ret;
 
     if (unlikely(!ctx->requested)) {
         return -EPERM;
     }
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    /* no locking of master_sem needed, because configuration will not be
-     * deleted in the meantime. */
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
 
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        ec_lock_up(&master->master_sem);
         return -ENOENT;
     }
 
-    ret = ecrt_slave_config_emerg_pop(sc, msg);
-    if (ret < 0) {
-        return ret;
+    ret = ecrt_domain_overlapping_pdos(domain, data.overlapping_pdos);
+    ec_lock_up(&master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Gets the offset remap table of an optimized domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_layout(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_layout_t data;
+    ec_ioctl_domain_remap_t entry;
+    const ec_domain_t *domain;
+    unsigned int i;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
     }
 
-    if (copy_to_user((void __user *) io.target, msg, sizeof(msg))) {
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    return ret;
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    if (!(domain = ec_master_find_domain_const(master,
+                    data.domain_index))) {
+        ec_lock_up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    for (i = 0; i < domain->remap_count && i < data.size; i++) {
+        entry.old_offset = domain->remap[i].old_offset;
+        entry.new_offset = domain->remap[i].new_offset;
+        entry.size = domain->remap[i].size;
+        if (copy_to_user((void __user *) (data.entries + i), &entry,
+                    sizeof(entry))) {
+            ec_lock_up(&master->master_sem);
+            return -EFAULT;
+        }
+    }
+    data.count = domain->remap_count;
+
+    ec_lock_up(&master->master_sem);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Gets the domain's offset in the total process data.
+ *
+ * \return Domain offset, or a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_offset(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    int offset = 0;
+    const ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    list_for_each_entry(domain, &master->domains, list) {
+        if (domain->index == (unsigned long) arg) {
+            ec_lock_up(&master->master_sem);
+            return offset;
+        }
+        offset += ecrt_domain_size(domain);
+    }
+
+    ec_lock_up(&master->master_sem);
+    return -ENOENT;
 }
 
 /*****************************************************************************/
 
-/** Clear the emergency ring.
+/** Process the domain.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_emerg_clear(
+static ATTRIBUTES int ec_ioctl_domain_process(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sc_emerg_t io;
-    ec_slave_config_t *sc;
+    ec_domain_t *domain;
 
-    if (unlikely(!ctx->requested)) {
+    if (unlikely(!ctx->requested))
         return -EPERM;
-    }
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
-        return -EFAULT;
+    /* Locking added as domain processing is likely to be used by more than
+       one application tasks */
+    if (ec_ioctl_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
     }
 
-    /* no locking of master_sem needed, because configuration will not be
-     * deleted in the meantime. */
-
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
+        ec_ioctl_lock_up(&master->master_sem);
         return -ENOENT;
     }
 
-    return ecrt_slave_config_emerg_clear(sc);
+    ecrt_domain_process(domain);
+    ec_ioctl_lock_up(&master->master_sem);
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Get the number of emergency overruns.
+/** Queue the domain.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_emerg_overruns(
+static ATTRIBUTES int ec_ioctl_domain_queue(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sc_emerg_t io;
-    ec_slave_config_t *sc;
-    int ret;
+    ec_domain_t *domain;
 
-    if (unlikely(!ctx->requested)) {
+    if (unlikely(!ctx->requested))
         return -EPERM;
-    }
-
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
-        return -EFAULT;
-    }
 
-    /* no locking of master_sem needed, because configuration will not be
-     * deleted in the meantime. */
+    /* Locking added as domain queing is likely to be used by more than
+       one application tasks */
+    if (ec_ioctl_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
 
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
+        ec_ioctl_lock_up(&master->master_sem);
         return -ENOENT;
     }
 
-    ret = ecrt_slave_config_emerg_overruns(sc);
-    if (ret < 0) {
-        return ret;
-    }
-
-    io.overruns = ret;
+    ecrt_domain_queue(domain);
 
-    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
-        return -EFAULT;
-    }
+    ec_ioctl_lock_up(&master->master_sem);
 
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Create an SDO request.
+/** Get the domain state.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_create_sdo_request(
+static ATTRIBUTES int ec_ioctl_domain_state(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sdo_request_t data;
-    ec_slave_config_t *sc;
-    ec_sdo_request_t *req;
+    ec_ioctl_domain_state_t data;
+    const ec_domain_t *domain;
+    ec_domain_state_t state;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
@@ -3533,29 +5053,16 @@ static ATTRIBUTES int ec_ioctl_sc_create_sdo_request(
         return -EFAULT;
     }
 
-    data.request_index = 0;
-
-    if (ec_lock_down_interruptible(&master->master_sem))
-        return -EINTR;
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
 
-    sc = ec_master_get_config(master, data.config_index);
-    if (!sc) {
-        ec_lock_up(&master->master_sem);
+    if (!(domain = ec_master_find_domain_const(master, data.domain_index))) {
         return -ENOENT;
     }
 
-    list_for_each_entry(req, &sc->sdo_requests, list) {
-        data.request_index++;
-    }
-
-    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
-
-    req = ecrt_slave_config_create_sdo_request_err(sc, data.sdo_index,
-            data.sdo_subindex, data.complete_access, data.size);
-    if (IS_ERR(req))
-        return PTR_ERR(req);
+    ecrt_domain_state(domain, &state);
 
-    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+    if (copy_to_user((void __user *) data.state, &state, sizeof(state)))
         return -EFAULT;
 
     return 0;
@@ -3563,103 +5070,155 @@ static ATTRIBUTES int ec_ioctl_sc_create_sdo_request(
 
 /*****************************************************************************/
 
-/** Create an FoE request.
+/** Number of cyclic operations processed at once by ec_ioctl_cycle().
+ */
+#define EC_IOCTL_CYCLE_CHUNK 16
+
+/** Maximum number of operations executed by the cycle thread.
+ */
+#define EC_IOCTL_CYCLE_THREAD_MAX_OPS 256
+
+/** Execute a single cyclic operation.
+ *
+ * The master semaphore has to be held by the caller.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_create_foe_request(
+static ATTRIBUTES int ec_ioctl_cycle_op(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        const ec_ioctl_cycle_op_t *op, /**< Operation. */
+        ec_domain_state_t *state /**< Domain state output. */
         )
 {
-    ec_ioctl_foe_request_t data;
-    ec_slave_config_t *sc;
-    ec_foe_request_t *req;
-
-    if (unlikely(!ctx->requested))
-        return -EPERM;
-
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
-        return -EFAULT;
-    }
-
-    data.request_index = 0;
-
-    if (ec_lock_down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    sc = ec_master_get_config(master, data.config_index);
-    if (!sc) {
-        ec_lock_up(&master->master_sem);
-        return -ENOENT;
+    ec_domain_t *domain = NULL;
+
+    switch (op->type) {
+        case EC_CYCLE_DOMAIN_PROCESS:
+        case EC_CYCLE_DOMAIN_STATE:
+        case EC_CYCLE_DOMAIN_QUEUE:
+            if (!(domain = ec_master_find_domain(master, op->domain_index))) {
+                return -ENOENT;
+            }
+            break;
+        default:
+            break;
     }
 
-    list_for_each_entry(req, &sc->foe_requests, list) {
-        data.request_index++;
+    switch (op->type) {
+        case EC_CYCLE_RECEIVE:
+#if defined(EC_RTDM) && defined(EC_EOE)
+            ecrt_master_receive(master);
+#else
+            if (master->receive_cb != NULL)
+                master->receive_cb(master->cb_data);
+            else
+                ecrt_master_receive(master);
+#endif
+            break;
+        case EC_CYCLE_DOMAIN_PROCESS:
+            ecrt_domain_process(domain);
+            break;
+        case EC_CYCLE_DOMAIN_STATE:
+            ecrt_domain_state(domain, state);
+            break;
+        case EC_CYCLE_DOMAIN_QUEUE:
+            ecrt_domain_queue(domain);
+            break;
+        case EC_CYCLE_APPLICATION_TIME:
+            ecrt_master_application_time(master, op->time);
+            break;
+        case EC_CYCLE_SYNC_REFERENCE_CLOCK:
+            ecrt_master_sync_reference_clock(master);
+            break;
+        case EC_CYCLE_SYNC_REFERENCE_CLOCK_TO:
+            ecrt_master_sync_reference_clock_to(master, op->time);
+            break;
+        case EC_CYCLE_SYNC_SLAVE_CLOCKS:
+            ecrt_master_sync_slave_clocks(master);
+            break;
+        case EC_CYCLE_SYNC_MONITOR_QUEUE:
+            ecrt_master_sync_monitor_queue(master);
+            break;
+        case EC_CYCLE_SEND:
+#if defined(EC_RTDM) && defined(EC_EOE)
+            ecrt_master_send(master);
+#else
+            if (master->send_cb != NULL)
+                master->send_cb(master->cb_data);
+            else
+                ecrt_master_send(master);
+#endif
+            break;
+        default:
+            return -EINVAL;
     }
 
-    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
-
-    req = ecrt_slave_config_create_foe_request_err(sc, data.size);
-    if (IS_ERR(req))
-        return PTR_ERR(req);
-
-    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
-        return -EFAULT;
-
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Create a register request.
+/** Execute a sequence of cyclic operations.
+ *
+ * The operations are copied and executed in chunks of EC_IOCTL_CYCLE_CHUNK,
+ * each with the master semaphore held once. Domain states are copied to
+ * userspace after releasing the semaphore.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_create_reg_request(
+static ATTRIBUTES int ec_ioctl_cycle(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_reg_request_t io;
-    ec_slave_config_t *sc;
-    ec_reg_request_t *reg;
+    ec_ioctl_cycle_t data;
+    ec_ioctl_cycle_op_t ops[EC_IOCTL_CYCLE_CHUNK];
+    ec_domain_state_t states[EC_IOCTL_CYCLE_CHUNK];
+    unsigned int done, count, i;
+    int ret = 0;
 
-    if (unlikely(!ctx->requested)) {
+    if (unlikely(!ctx->requested))
         return -EPERM;
-    }
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    io.request_index = 0;
+    for (done = 0; done < data.op_count; done += count) {
+        count = min(data.op_count - done, (uint32_t) EC_IOCTL_CYCLE_CHUNK);
 
-    if (ec_lock_down_interruptible(&master->master_sem)) {
-        return -EINTR;
-    }
+        if (copy_from_user(ops, (void __user *) (data.ops + done),
+                    sizeof(ops[0]) * count)) {
+            return -EFAULT;
+        }
 
-    sc = ec_master_get_config(master, io.config_index);
-    if (!sc) {
-        ec_lock_up(&master->master_sem);
-        return -ENOENT;
-    }
+        if (ec_ioctl_lock_down_interruptible(&master->master_sem)) {
+            return -EINTR;
+        }
 
-    list_for_each_entry(reg, &sc->reg_requests, list) {
-        io.request_index++;
-    }
+        for (i = 0; i < count; i++) {
+            ret = ec_ioctl_cycle_op(master, &ops[i], &states[i]);
+            if (ret) {
+                break;
+            }
+        }
 
-    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+        ec_ioctl_lock_up(&master->master_sem);
 
-    reg = ecrt_slave_config_create_reg_request_err(sc, io.mem_size);
-    if (IS_ERR(reg)) {
-        return PTR_ERR(reg);
-    }
+        // i is the number of executed operations
+        count = i;
+        for (i = 0; i < count; i++) {
+            if (ops[i].type == EC_CYCLE_DOMAIN_STATE &&
+                    copy_to_user((void __user *) ops[i].state, &states[i],
+                        sizeof(states[i]))) {
+                return -EFAULT;
+            }
+        }
 
-    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
-        return -EFAULT;
+        if (ret) {
+            return ret;
+        }
     }
 
     return 0;
@@ -3667,19 +5226,21 @@ static ATTRIBUTES int ec_ioctl_sc_create_reg_request(
 
 /*****************************************************************************/
 
-/** Create a VoE handler.
+/** Start the cycle thread.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_create_voe_handler(
+static ATTRIBUTES int ec_ioctl_cycle_thread_start(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_voe_t data;
-    ec_slave_config_t *sc;
-    ec_voe_handler_t *voe;
+    ec_ioctl_cycle_thread_t data;
+    ec_ioctl_cycle_op_t op;
+    ec_cycle_op_t *ops;
+    unsigned int i;
+    int ret;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
@@ -3688,293 +5249,359 @@ static ATTRIBUTES int ec_ioctl_sc_create_voe_handler(
         return -EFAULT;
     }
 
-    data.voe_index = 0;
-
-    if (ec_lock_down_interruptible(&master->master_sem))
-        return -EINTR;
+    if (!data.op_count || data.op_count > EC_IOCTL_CYCLE_THREAD_MAX_OPS) {
+        return -EINVAL;
+    }
 
-    sc = ec_master_get_config(master, data.config_index);
-    if (!sc) {
-        ec_lock_up(&master->master_sem);
-        return -ENOENT;
+    if (!(ops = kmalloc(sizeof(*ops) * data.op_count, GFP_KERNEL))) {
+        return -ENOMEM;
     }
 
-    list_for_each_entry(voe, &sc->voe_handlers, list) {
-        data.voe_index++;
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        kfree(ops);
+        return -EINTR;
     }
 
-    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+    for (i = 0; i < data.op_count; i++) {
+        if (copy_from_user(&op, (void __user *) (data.ops + i),
+                    sizeof(op))) {
+            ret = -EFAULT;
+            goto out_free;
+        }
 
-    voe = ecrt_slave_config_create_voe_handler_err(sc, data.size);
-    if (IS_ERR(voe))
-        return PTR_ERR(voe);
+        ops[i].type = op.type;
+        ops[i].domain = NULL;
+        ops[i].time = op.time;
+        ops[i].state = NULL;
+
+        switch (op.type) {
+            case EC_CYCLE_DOMAIN_PROCESS:
+            case EC_CYCLE_DOMAIN_QUEUE:
+                ops[i].domain = ec_master_find_domain(master,
+                        op.domain_index);
+                if (!ops[i].domain) {
+                    ret = -ENOENT;
+                    goto out_free;
+                }
+                break;
+            case EC_CYCLE_DOMAIN_STATE:
+                /* The domain states are published in the state page. */
+                ret = -EINVAL;
+                goto out_free;
+            default:
+                break;
+        }
+    }
 
-    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
-        return -EFAULT;
+    // ops are freed by the master
+    ret = ec_master_cycle_thread_start(master, data.cpu, ops, data.op_count);
+    ec_lock_up(&master->master_sem);
+    return ret;
 
-    return 0;
+out_free:
+    ec_lock_up(&master->master_sem);
+    kfree(ops);
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Get the slave configuration's state.
+/** Stop the cycle thread.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_state(
+static ATTRIBUTES int ec_ioctl_cycle_thread_stop(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sc_state_t data;
-    const ec_slave_config_t *sc;
-    ec_slave_config_state_t state;
-
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
-        return -EFAULT;
-    }
+    ec_master_cycle_thread_stop(master);
+    return 0;
+}
 
-    /* no locking of master_sem needed, because sc will not be deleted in the
-     * meantime. */
+/*****************************************************************************/
 
-    if (!(sc = ec_master_get_config_const(master, data.config_index))) {
-        return -ENOENT;
-    }
+/** Enables the completion queue for the requests of the application.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_completions_enable(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    if (unlikely(!ctx->requested))
+        return -EPERM;
 
-    ecrt_slave_config_state(sc, &state);
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
 
-    if (copy_to_user((void __user *) data.state, &state, sizeof(state)))
-        return -EFAULT;
+    master->completions_enabled = 1;
 
+    ec_lock_up(&master->master_sem);
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Configures an IDN.
+/** Reads the queued request completions.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_idn(
+static ATTRIBUTES int ec_ioctl_completions_read(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sc_idn_t ioctl;
-    ec_slave_config_t *sc;
-    uint8_t *data = NULL;
-    int ret;
+    ec_ioctl_completions_t data;
+    ec_ioctl_completion_t *completions;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl)))
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
         return -EFAULT;
 
-    if (!ioctl.size)
+    if (!data.max_count) {
         return -EINVAL;
+    }
 
-    if (!(data = kmalloc(ioctl.size, GFP_KERNEL))) {
-        return -ENOMEM;
+    if (data.max_count > EC_IOCTL_COMPLETION_QUEUE_SIZE) {
+        data.max_count = EC_IOCTL_COMPLETION_QUEUE_SIZE;
     }
 
-    if (copy_from_user(data, (void __user *) ioctl.data, ioctl.size)) {
-        kfree(data);
-        return -EFAULT;
+    completions = kmalloc(data.max_count * sizeof(*completions), GFP_KERNEL);
+    if (!completions) {
+        return -ENOMEM;
     }
 
     if (ec_lock_down_interruptible(&master->master_sem)) {
-        kfree(data);
+        kfree(completions);
         return -EINTR;
     }
 
-    if (!(sc = ec_master_get_config(master, ioctl.config_index))) {
-        ec_lock_up(&master->master_sem);
-        kfree(data);
-        return -ENOENT;
+    data.count = ec_master_read_completions(master, completions,
+            data.max_count);
+
+    ec_lock_up(&master->master_sem);
+
+    if (copy_to_user((void __user *) data.completions, completions,
+                data.count * sizeof(*completions))) {
+        kfree(completions);
+        return -EFAULT;
     }
+    kfree(completions);
 
-    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
 
-    ret = ecrt_slave_config_idn(
-            sc, ioctl.drive_no, ioctl.idn, ioctl.al_state, data, ioctl.size);
-    kfree(data);
-    return ret;
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Gets the domain's data size.
+/** Sets up the acyclic queue.
  *
- * \return Domain size, or a negative error code.
+ * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_domain_size(
+static ATTRIBUTES int ec_ioctl_acyclic_setup(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    const ec_domain_t *domain;
+    ec_ioctl_acyclic_setup_t data;
+    int ret;
 
-    if (unlikely(!ctx->requested)) {
+    if (unlikely(!ctx->requested))
         return -EPERM;
-    }
 
-    if (ec_lock_down_interruptible(&master->master_sem)) {
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    if (ec_lock_down_interruptible(&master->master_sem))
         return -EINTR;
-    }
 
-    list_for_each_entry(domain, &master->domains, list) {
-        if (domain->index == (unsigned long) arg) {
-            size_t size = ecrt_domain_size(domain);
-            ec_lock_up(&master->master_sem);
-            return size;
-        }
-    }
+    ret = ec_acyclic_queue_setup(&master->acyclic_queue, &data);
 
     ec_lock_up(&master->master_sem);
-    return -ENOENT;
+
+    if (ret)
+        return ret;
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Gets the domain's offset in the total process data.
+/** Clears the acyclic queue.
  *
- * \return Domain offset, or a negative error code.
+ * Operations in progress are finished, queued ones are aborted.
+ *
+ * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_domain_offset(
+static ATTRIBUTES int ec_ioctl_acyclic_clear(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    int offset = 0;
-    const ec_domain_t *domain;
-
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    if (ec_lock_down_interruptible(&master->master_sem)) {
-        return -EINTR;
-    }
-
-    list_for_each_entry(domain, &master->domains, list) {
-        if (domain->index == (unsigned long) arg) {
-            ec_lock_up(&master->master_sem);
-            return offset;
-        }
-        offset += ecrt_domain_size(domain);
-    }
-
-    ec_lock_up(&master->master_sem);
-    return -ENOENT;
+    ec_acyclic_queue_clear(&master->acyclic_queue);
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Process the domain.
+/** Schedules the entries of the acyclic submission ring.
  *
- * \return Zero on success, otherwise a negative error code.
+ * \return Number of consumed entries, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_domain_process(
+static ATTRIBUTES int ec_ioctl_acyclic_submit(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_domain_t *domain;
+    int ret, pending;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    /* Locking added as domain processing is likely to be used by more than
-       one application tasks */
-    if (ec_ioctl_lock_down_interruptible(&master->master_sem)) {
+    if (ec_lock_down_interruptible(&master->master_sem))
         return -EINTR;
-    }
 
-    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
-        ec_ioctl_lock_up(&master->master_sem);
-        return -ENOENT;
+    ret = ec_acyclic_queue_submit(&master->acyclic_queue);
+    pending = ec_acyclic_queue_pending(&master->acyclic_queue);
+
+    ec_lock_up(&master->master_sem);
+
+    if (pending) {
+        // invalid entries are completed immediately
+        wake_up_interruptible(&master->completion_queue);
     }
 
-    ecrt_domain_process(domain);
-    ec_ioctl_lock_up(&master->master_sem);
-    return 0;
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Queue the domain.
+/** Asks the master to share the request data with the application.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_domain_queue(
+static ATTRIBUTES int ec_ioctl_share_request_data(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_domain_t *domain;
-
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    /* Locking added as domain queing is likely to be used by more than
-       one application tasks */
-    if (ec_ioctl_lock_down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
-        ec_ioctl_lock_up(&master->master_sem);
-        return -ENOENT;
-    }
-
-    ecrt_domain_queue(domain);
-
-    ec_ioctl_lock_up(&master->master_sem);
+    // the process data area is already set up
+    if (ctx->process_data)
+        return -EBUSY;
 
+    ctx->share_request_data = 1;
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Get the domain state.
+/** Gets the location of a request's data in the process data area.
  *
- * \return Zero on success, otherwise a negative error code.
+ * \return Zero on success, otherwise a negative error code. -ENOBUFS means,
+ *         that the request data are not shared.
  */
-static ATTRIBUTES int ec_ioctl_domain_state(
+static ATTRIBUTES int ec_ioctl_request_memory(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_domain_state_t data;
-    const ec_domain_t *domain;
-    ec_domain_state_t state;
+    ec_ioctl_request_memory_t io;
+    ec_slave_config_t *sc;
+    ec_origin_t origin;
+    uint8_t *data;
+    size_t size;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io)))
         return -EFAULT;
-    }
 
-    /* no locking of master_sem needed, because domain will not be deleted in
-     * the meantime. */
+    /* no locking of master_sem needed, because neither sc nor the request
+     * will not be deleted in the meantime. */
 
-    if (!(domain = ec_master_find_domain_const(master, data.domain_index))) {
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
         return -ENOENT;
     }
 
-    ecrt_domain_state(domain, &state);
+    switch (io.type) {
+        case EC_IOCTL_COMPLETION_SDO:
+            {
+                ec_sdo_request_t *req =
+                    ec_slave_config_find_sdo_request(sc, io.request_index);
+                if (!req) {
+                    return -ENOENT;
+                }
+                origin = req->data_origin;
+                data = req->data;
+                size = req->mem_size;
+            }
+            break;
+        case EC_IOCTL_COMPLETION_SOE:
+            {
+                ec_soe_request_t *req =
+                    ec_slave_config_find_soe_request(sc, io.request_index);
+                if (!req) {
+                    return -ENOENT;
+                }
+                origin = req->data_origin;
+                data = req->data;
+                size = req->mem_size;
+            }
+            break;
+        case EC_IOCTL_COMPLETION_VOE:
+            {
+                ec_voe_handler_t *voe =
+                    ec_slave_config_find_voe_handler(sc, io.request_index);
+                if (!voe) {
+                    return -ENOENT;
+                }
+                origin = voe->shared_data ? EC_ORIG_EXTERNAL
+                    : EC_ORIG_INTERNAL;
+                data = voe->shared_data;
+                size = voe->shared_size;
+            }
+            break;
+        default:
+            return -EINVAL;
+    }
 
-    if (copy_to_user((void __user *) data.state, &state, sizeof(state)))
+    if (origin != EC_ORIG_EXTERNAL || !ctx->process_data
+            || data < ctx->process_data
+            || data + size > ctx->process_data + ctx->process_data_size) {
+        return -ENOBUFS;
+    }
+
+    io.offset = data - ctx->process_data;
+    io.size = size;
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io)))
         return -EFAULT;
 
     return 0;
@@ -4179,12 +5806,17 @@ static ATTRIBUTES int ec_ioctl_sdo_request_write(
         return -ENOENT;
     }
 
-    ret = ec_sdo_request_alloc(req, data.size);
-    if (ret)
-        return ret;
+    if (data.data) {
+        ret = ec_sdo_request_alloc(req, data.size);
+        if (ret)
+            return ret;
 
-    if (copy_from_user(req->data, (void __user *) data.data, data.size))
-        return -EFAULT;
+        if (copy_from_user(req->data, (void __user *) data.data, data.size))
+            return -EFAULT;
+    } else if (data.size > req->mem_size) {
+        // shared data memory was written by the application in place
+        return -EOVERFLOW;
+    }
 
     req->data_size = data.size;
     ecrt_sdo_request_write(req);
@@ -4911,9 +6543,16 @@ static ATTRIBUTES int ec_ioctl_voe_write(
         if (data.size > ec_voe_handler_mem_size(voe))
             return -EOVERFLOW;
 
-        if (copy_from_user(ecrt_voe_handler_data(voe),
-                    (void __user *) data.data, data.size))
-            return -EFAULT;
+        if (data.data) {
+            if (copy_from_user(ecrt_voe_handler_data(voe),
+                        (void __user *) data.data, data.size))
+                return -EFAULT;
+        } else if (voe->shared_data) {
+            // the application wrote the shared data memory in place
+            if (data.size > voe->shared_size)
+                return -EOVERFLOW;
+            memcpy(ecrt_voe_handler_data(voe), voe->shared_data, data.size);
+        }
     }
 
     ecrt_voe_handler_write(voe, data.size);
@@ -4959,6 +6598,12 @@ static ATTRIBUTES int ec_ioctl_voe_exec(
     else
         data.size = 0;
 
+    if (data.size && voe->shared_data) {
+        if (data.size > voe->shared_size)
+            return -EOVERFLOW;
+        memcpy(voe->shared_data, ecrt_voe_handler_data(voe), data.size);
+    }
+
     if (copy_to_user((void __user *) arg, &data, sizeof(data)))
         return -EFAULT;
 
@@ -5625,12 +7270,17 @@ static ATTRIBUTES int ec_ioctl_soe_request_write(
         return -ENOENT;
     }
 
-    ret = ec_soe_request_alloc(req, data.size);
-    if (ret)
-        return ret;
+    if (data.data) {
+        ret = ec_soe_request_alloc(req, data.size);
+        if (ret)
+            return ret;
 
-    if (copy_from_user(req->data, (void __user *) data.data, data.size))
-        return -EFAULT;
+        if (copy_from_user(req->data, (void __user *) data.data, data.size))
+            return -EFAULT;
+    } else if (data.size > req->mem_size) {
+        // shared data memory was written by the application in place
+        return -EOVERFLOW;
+    }
 
     req->data_size = data.size;
     ecrt_soe_request_write(req);
@@ -5769,6 +7419,9 @@ long EC_IOCTL(
         case EC_IOCTL_SLAVE_SDO_ENTRY:
             ret = ec_ioctl_slave_sdo_entry(master, arg);
             break;
+        case EC_IOCTL_SNAPSHOT:
+            ret = ec_ioctl_snapshot(master, arg);
+            break;
         case EC_IOCTL_SLAVE_SDO_UPLOAD:
             ret = ec_ioctl_slave_sdo_upload(master, arg);
             break;
@@ -6177,6 +7830,30 @@ long EC_IOCTL(
         case EC_IOCTL_DOMAIN_OFFSET:
             ret = ec_ioctl_domain_offset(master, arg, ctx);
             break;
+        case EC_IOCTL_DOMAIN_PERIOD:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_domain_period(master, arg, ctx);
+            break;
+        case EC_IOCTL_DOMAIN_OPTIMIZE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_domain_optimize(master, arg, ctx);
+            break;
+        case EC_IOCTL_DOMAIN_LAYOUT:
+            ret = ec_ioctl_domain_layout(master, arg, ctx);
+            break;
+        case EC_IOCTL_DOMAIN_OVERLAPPING:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_domain_overlapping(master, arg, ctx);
+            break;
         case EC_IOCTL_DOMAIN_PROCESS:
             if (!ctx->writable) {
                 ret = -EPERM;
@@ -6194,6 +7871,83 @@ long EC_IOCTL(
         case EC_IOCTL_DOMAIN_STATE:
             ret = ec_ioctl_domain_state(master, arg, ctx);
             break;
+        case EC_IOCTL_CYCLE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_cycle(master, arg, ctx);
+            break;
+        case EC_IOCTL_CYCLE_THREAD_START:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_cycle_thread_start(master, arg, ctx);
+            break;
+        case EC_IOCTL_CYCLE_THREAD_STOP:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_cycle_thread_stop(master, arg, ctx);
+            break;
+        case EC_IOCTL_TRANSACTION:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_transaction(master, arg, ctx);
+            break;
+        case EC_IOCTL_COMPLETIONS_ENABLE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_completions_enable(master, arg, ctx);
+            break;
+        case EC_IOCTL_COMPLETIONS_READ:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_completions_read(master, arg, ctx);
+            break;
+        case EC_IOCTL_ACYCLIC_SETUP:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_acyclic_setup(master, arg, ctx);
+            break;
+        case EC_IOCTL_ACYCLIC_SUBMIT:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_acyclic_submit(master, arg, ctx);
+            break;
+        case EC_IOCTL_ACYCLIC_CLEAR:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_acyclic_clear(master, arg, ctx);
+            break;
+        case EC_IOCTL_REQUEST_MEMORY:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_request_memory(master, arg, ctx);
+            break;
+        case EC_IOCTL_SHARE_REQUEST_DATA:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_share_request_data(master, arg, ctx);
+            break;
         case EC_IOCTL_SDO_REQUEST_INDEX:
             if (!ctx->writable) {
                 ret = -EPERM;
@@ -60,7 +60,7 @@
  *
  * Increment this when changing the ioctl interface!
  */
-#define EC_IOCTL_VERSION_MAGIC 36
+#define EC_IOCTL_VERSION_MAGIC 53
 
 // Command-line tool
 #define EC_IOCTL_MODULE                EC_IOR(0x00, ec_ioctl_module_t)
@@ -165,6 +165,7 @@
 #define EC_IOCTL_SLAVE_REBOOT         EC_IOW(0x5c, ec_ioctl_slave_reboot_t)
 #define EC_IOCTL_SLAVE_REG_READWRITE  EC_IOWR(0x5d, ec_ioctl_slave_reg_t)
 #define EC_IOCTL_REG_REQUEST_READWRITE EC_IOWR(0x5e, ec_ioctl_reg_request_t)
+#define EC_IOCTL_CYCLE                 EC_IOW(0x5f, ec_ioctl_cycle_t)
 #define EC_IOCTL_SETUP_DOMAIN_MEMORY   EC_IOR(0x60, ec_ioctl_master_activate_t)
 #define EC_IOCTL_DEACTIVATE_SLAVES      EC_IO(0x61)
 #define EC_IOCTL_64_REF_CLK_TIME_QUEUE  EC_IO(0x62)
@@ -195,6 +196,18 @@
 // Mailbox Gateway
 #define EC_IOCTL_MBOX_GATEWAY         EC_IOWR(0x73, ec_ioctl_mbox_gateway_t)
 
+#define EC_IOCTL_CYCLE_THREAD_START    EC_IOW(0x74, ec_ioctl_cycle_thread_t)
+#define EC_IOCTL_CYCLE_THREAD_STOP      EC_IO(0x75)
+#define EC_IOCTL_TRANSACTION          EC_IOWR(0x76, ec_ioctl_transaction_t)
+#define EC_IOCTL_COMPLETIONS_ENABLE     EC_IO(0x77)
+#define EC_IOCTL_COMPLETIONS_READ     EC_IOWR(0x78, ec_ioctl_completions_t)
+#define EC_IOCTL_ACYCLIC_SETUP        EC_IOWR(0x79, ec_ioctl_acyclic_setup_t)
+#define EC_IOCTL_ACYCLIC_SUBMIT         EC_IO(0x7a)
+#define EC_IOCTL_REQUEST_MEMORY       EC_IOWR(0x7b, ec_ioctl_request_memory_t)
+#define EC_IOCTL_SNAPSHOT             EC_IOWR(0x7c, ec_ioctl_snapshot_t)
+#define EC_IOCTL_DOMAIN_PERIOD         EC_IOW(0x7d, ec_ioctl_domain_period_t)
+#define EC_IOCTL_DOMAIN_OPTIMIZE        EC_IO(0x7e)
+
 #define EC_IOCTL_SC_SOE_REQUEST       EC_IOWR(0x80, ec_ioctl_soe_request_t)
 #define EC_IOCTL_SOE_REQUEST_STATE    EC_IOWR(0x81, ec_ioctl_soe_request_t)
 #define EC_IOCTL_SOE_REQUEST_READ     EC_IOWR(0x82, ec_ioctl_soe_request_t)
@@ -206,6 +219,11 @@
 #define EC_IOCTL_SC_EOE               EC_IOW(0x86, ec_ioctl_sc_eoe_t)
 #endif
 
+#define EC_IOCTL_DOMAIN_LAYOUT       EC_IOWR(0x87, ec_ioctl_domain_layout_t)
+#define EC_IOCTL_DOMAIN_OVERLAPPING   EC_IOW(0x88, ec_ioctl_domain_overlapping_t)
+#define EC_IOCTL_ACYCLIC_CLEAR          EC_IO(0x89)
+#define EC_IOCTL_SHARE_REQUEST_DATA     EC_IO(0x8a)
+
 /*****************************************************************************/
 
 #define EC_IOCTL_STRING_SIZE 64
@@ -253,6 +271,15 @@ typedef struct {
     int32_t tx_byte_rates[EC_RATE_COUNT];
     int32_t rx_byte_rates[EC_RATE_COUNT];
     int32_t loss_rates[EC_RATE_COUNT];
+    struct ec_ioctl_traffic_class {
+        uint32_t budget;
+        uint64_t datagrams;
+        uint64_t bytes;
+        uint64_t deferred;
+    } traffic_classes[EC_TRAFFIC_CLASS_COUNT];
+    uint32_t ext_ring_size;
+    uint32_t fsm_exec_count;
+    uint64_t ext_ring_stalls;
     uint64_t app_time;
     uint64_t dc_ref_time;
     uint16_t ref_clock;
@@ -821,6 +848,61 @@ typedef struct {
 
 /*****************************************************************************/
 
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint32_t period;
+    int32_t phase;
+} ec_ioctl_domain_period_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    uint32_t old_offset;
+    uint32_t new_offset;
+    uint32_t size;
+} ec_ioctl_domain_remap_t;
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint32_t size; // capacity of entries
+    ec_ioctl_domain_remap_t *entries;
+
+    // outputs
+    uint32_t count;
+} ec_ioctl_domain_layout_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint8_t overlapping_pdos;
+} ec_ioctl_domain_overlapping_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t type;
+    uint32_t domain_index;
+    uint64_t time;
+
+    // outputs
+    ec_domain_state_t *state;
+} ec_ioctl_cycle_op_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t op_count;
+    const ec_ioctl_cycle_op_t *ops;
+} ec_ioctl_cycle_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint32_t config_index;
@@ -931,6 +1013,382 @@ typedef struct {
 
 /*****************************************************************************/
 
+/** Configuration transaction operation types.
+ */
+typedef enum {
+    EC_IOCTL_TXN_CONFIG, /**< ecrt_master_slave_config(). */
+    EC_IOCTL_TXN_SYNC_MANAGER, /**< ecrt_slave_config_sync_manager(). */
+    EC_IOCTL_TXN_WATCHDOG, /**< ecrt_slave_config_watchdog(). */
+    EC_IOCTL_TXN_PDO_ASSIGN_CLEAR, /**< ecrt_slave_config_pdo_assign_clear().
+                                    */
+    EC_IOCTL_TXN_PDO_ASSIGN_ADD, /**< ecrt_slave_config_pdo_assign_add(). */
+    EC_IOCTL_TXN_PDO_MAPPING_CLEAR, /**<
+                                      ecrt_slave_config_pdo_mapping_clear().
+                                     */
+    EC_IOCTL_TXN_PDO_MAPPING_ADD, /**< ecrt_slave_config_pdo_mapping_add().
+                                   */
+    EC_IOCTL_TXN_REG_PDO_ENTRY, /**< ecrt_slave_config_reg_pdo_entry(). */
+    EC_IOCTL_TXN_DC, /**< ecrt_slave_config_dc(). */
+    EC_IOCTL_TXN_SDO, /**< ecrt_slave_config_sdo() and
+                        ecrt_slave_config_complete_sdo(). */
+    EC_IOCTL_TXN_COUNT /**< Number of operation types. */
+} ec_ioctl_txn_type_t;
+
+/** Marks a configuration index as the position of an EC_IOCTL_TXN_CONFIG
+ * operation in the same transaction.
+ */
+#define EC_IOCTL_TXN_PENDING 0x80000000
+
+/** Configuration index of an EC_IOCTL_TXN_CONFIG operation, that was not
+ * applied. The master replaces it, when it applies the operation.
+ */
+#define EC_IOCTL_TXN_FAILED 0xffffffff
+
+typedef struct {
+    // inputs
+    uint32_t type;
+    uint32_t config_index; // output for EC_IOCTL_TXN_CONFIG
+    union {
+        struct {
+            uint16_t alias;
+            uint16_t position;
+            uint32_t vendor_id;
+            uint32_t product_code;
+        } config;
+        struct {
+            uint8_t sync_index;
+            uint8_t dir;
+            uint8_t watchdog_mode;
+        } sync;
+        struct {
+            uint16_t divider;
+            uint16_t intervals;
+        } watchdog;
+        struct {
+            uint8_t sync_index;
+            uint16_t pdo_index;
+        } pdo_assign;
+        struct {
+            uint16_t pdo_index;
+            uint16_t entry_index;
+            uint8_t entry_subindex;
+            uint8_t entry_bit_length;
+        } pdo_mapping;
+        struct {
+            uint16_t entry_index;
+            uint8_t entry_subindex;
+            uint32_t domain_index;
+
+            // outputs
+            uint32_t offset;
+            uint32_t bit_position;
+        } reg_pdo_entry;
+        struct {
+            uint16_t assign_activate;
+            uint32_t sync0_cycle_time;
+            int32_t sync0_shift_time;
+            uint32_t sync1_cycle_time;
+            int32_t sync1_shift_time;
+        } dc;
+        struct {
+            uint16_t index;
+            uint8_t subindex;
+            uint8_t complete_access;
+            size_t size;
+            const uint8_t *data;
+        } sdo;
+    } u;
+} ec_ioctl_txn_op_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t op_count;
+    ec_ioctl_txn_op_t *ops;
+
+    // outputs
+    uint32_t failed_op;
+} ec_ioctl_transaction_t;
+
+/*****************************************************************************/
+
+/** Number of entries in the completion queue of a master. */
+#define EC_IOCTL_COMPLETION_QUEUE_SIZE 256
+
+/** Request types reported by the completion queue. */
+typedef enum {
+    EC_IOCTL_COMPLETION_SDO,
+    EC_IOCTL_COMPLETION_SOE,
+    EC_IOCTL_COMPLETION_FOE,
+    EC_IOCTL_COMPLETION_REG,
+    EC_IOCTL_COMPLETION_VOE
+} ec_ioctl_completion_type_t;
+
+typedef struct {
+    uint32_t config_index;
+    uint32_t request_index;
+    uint16_t type;
+    uint16_t state;
+} ec_ioctl_completion_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t max_count;
+    ec_ioctl_completion_t *completions;
+
+    // outputs
+    uint32_t count;
+} ec_ioctl_completions_t;
+
+/*****************************************************************************/
+
+/** mmap() offset of the state page. */
+#define EC_IOCTL_STATE_PAGE_OFFSET 0x40000000
+
+/** Number of domains, whose state is published in the state page. */
+#define EC_IOCTL_STATE_PAGE_DOMAINS 64
+
+/** Read-only state page.
+ *
+ * The page is mapped via mmap() at EC_IOCTL_STATE_PAGE_OFFSET and is updated
+ * by ecrt_master_receive() and ecrt_domain_process(). Each section is
+ * protected by a sequence counter, that is odd while the section is being
+ * written. A reader has to retry, if the counter was odd or changed while
+ * reading.
+ */
+typedef struct {
+    uint32_t master_seq; /**< Sequence counter of the master section. */
+    uint32_t num_devices; /**< Number of Ethernet devices. */
+    ec_master_state_t master_state; /**< Master state. */
+    ec_master_link_state_t link_states[EC_MAX_NUM_DEVICES]; /**< Link
+                                                              states. */
+    struct {
+        uint32_t seq; /**< Sequence counter of the domain section. */
+        ec_domain_state_t state; /**< Domain state. */
+    } domains[EC_IOCTL_STATE_PAGE_DOMAINS]; /**< Domain states by index. */
+} ec_ioctl_state_page_t;
+
+/*****************************************************************************/
+
+/** mmap() offset of the cycle ring. */
+#define EC_IOCTL_CYCLE_RING_OFFSET 0x20000000
+
+/** Number of slots in the cycle ring. */
+#define EC_IOCTL_CYCLE_RING_SIZE 32
+
+/** Alignment of the cycle ring indices, to keep them in own cache lines. */
+#define EC_IOCTL_CACHE_LINE_SIZE 64
+
+/** Cycle ring slot.
+ */
+typedef struct {
+    uint64_t app_time; /**< Application time of the cycle, written by the
+                         application. */
+    int32_t result; /**< Result of the cycle, written by the master. */
+    uint32_t reserved; /**< Reserved. */
+} ec_ioctl_cycle_slot_t;
+
+/** Cycle ring.
+ *
+ * Single-producer single-consumer ring between the application and the
+ * cycle thread of the master. The ring is mapped via mmap() at
+ * EC_IOCTL_CYCLE_RING_OFFSET. The application fills the slot at \a head and
+ * increments \a head afterwards. The cycle thread executes a cycle for each
+ * slot, stores the result and increments \a tail afterwards. \a running
+ * is cleared when the thread is stopped, so that the application does not
+ * wait for cycles that are never executed.
+ */
+typedef struct {
+    uint32_t head __attribute__((aligned(EC_IOCTL_CACHE_LINE_SIZE))); /**<
+        Number of posted cycles, written by the application. */
+    uint32_t tail __attribute__((aligned(EC_IOCTL_CACHE_LINE_SIZE))); /**<
+        Number of completed cycles, written by the master. */
+    uint32_t running; /**< Non-zero while the cycle thread executes cycles,
+                        written by the master. */
+    ec_ioctl_cycle_slot_t slots[EC_IOCTL_CYCLE_RING_SIZE]
+        __attribute__((aligned(EC_IOCTL_CACHE_LINE_SIZE))); /**< Slots. */
+} ec_ioctl_cycle_ring_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    int32_t cpu;
+    uint32_t op_count;
+    const ec_ioctl_cycle_op_t *ops;
+} ec_ioctl_cycle_thread_t;
+
+/*****************************************************************************/
+
+/** mmap() offset of the acyclic queue. */
+#define EC_IOCTL_ACYCLIC_QUEUE_OFFSET 0x30000000
+
+/** Maximum number of entries of the acyclic queue. */
+#define EC_IOCTL_ACYCLIC_MAX_ENTRIES 4096
+
+/** Maximum data size per entry of the acyclic queue. */
+#define EC_IOCTL_ACYCLIC_MAX_DATA_SIZE 0x10000
+
+/** Size of the FoE file name in an acyclic submission entry. */
+#define EC_IOCTL_ACYCLIC_FILE_NAME_SIZE 64
+
+/** Acyclic operations. */
+typedef enum {
+    EC_IOCTL_ACYCLIC_SDO_UPLOAD,
+    EC_IOCTL_ACYCLIC_SDO_DOWNLOAD,
+    EC_IOCTL_ACYCLIC_SOE_READ,
+    EC_IOCTL_ACYCLIC_SOE_WRITE,
+    EC_IOCTL_ACYCLIC_FOE_READ,
+    EC_IOCTL_ACYCLIC_FOE_WRITE,
+    EC_IOCTL_ACYCLIC_REG_READ,
+    EC_IOCTL_ACYCLIC_REG_WRITE,
+    EC_IOCTL_ACYCLIC_OPCODE_COUNT
+} ec_ioctl_acyclic_opcode_t;
+
+/** Acyclic submission entry.
+ *
+ * The data of the operation is located in the data area of the entry. For
+ * downloads and writes, \a size is the number of bytes to transfer, for
+ * uploads and reads, it is the maximum number of bytes to receive.
+ */
+typedef struct {
+    uint64_t user_data; /**< Passed through to the completion. */
+    uint16_t opcode; /**< Operation (ec_ioctl_acyclic_opcode_t). */
+    uint16_t slave_position; /**< Slave ring position. */
+    uint16_t index; /**< SDO index, IDN or register address. */
+    uint8_t subindex; /**< SDO subindex or SoE drive number. */
+    uint8_t complete_access; /**< SDO shall be transferred completely. */
+    uint32_t size; /**< Data size. */
+    uint32_t password; /**< FoE password. */
+    char file_name[EC_IOCTL_ACYCLIC_FILE_NAME_SIZE]; /**< FoE file name. */
+} ec_ioctl_acyclic_sqe_t;
+
+/** Acyclic completion entry.
+ */
+typedef struct {
+    uint64_t user_data; /**< User data of the submission entry. */
+    uint32_t entry; /**< Index of the submission entry. */
+    int32_t result; /**< Zero on success, otherwise a negative error code. */
+    uint32_t size; /**< Number of bytes received. */
+    uint32_t error_code; /**< SDO abort code, SoE error code or FoE result.
+                           */
+} ec_ioctl_acyclic_cqe_t;
+
+/** Ring indices of the acyclic queue.
+ *
+ * The application writes the indices of its submission entries to the
+ * submission ring at \a sq_head and increments \a sq_head afterwards. The
+ * master consumes them with EC_IOCTL_ACYCLIC_SUBMIT and increments \a
+ * sq_tail. Completions are written to the completion ring at \a cq_head,
+ * the application consumes them and increments \a cq_tail. A submission
+ * entry may be reused as soon as its completion was consumed.
+ */
+typedef struct {
+    uint32_t sq_head __attribute__((aligned(EC_IOCTL_CACHE_LINE_SIZE)));
+    uint32_t sq_tail __attribute__((aligned(EC_IOCTL_CACHE_LINE_SIZE)));
+    uint32_t cq_head __attribute__((aligned(EC_IOCTL_CACHE_LINE_SIZE)));
+    uint32_t cq_tail __attribute__((aligned(EC_IOCTL_CACHE_LINE_SIZE)));
+} ec_ioctl_acyclic_rings_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t entries;
+    uint32_t data_size;
+
+    // outputs
+    uint32_t size;
+    uint32_t sq_offset;
+    uint32_t sqe_offset;
+    uint32_t cq_offset;
+    uint32_t data_offset;
+} ec_ioctl_acyclic_setup_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t config_index;
+    uint32_t request_index;
+    uint16_t type; // ec_ioctl_completion_type_t
+
+    // outputs
+    uint32_t offset; // in the process data area
+    uint32_t size;
+} ec_ioctl_request_memory_t;
+
+/*****************************************************************************/
+
+/** Tables serialized by EC_IOCTL_SNAPSHOT.
+ *
+ * The records of a table are stored back to back without padding between
+ * them. Variable-length strings directly follow their record and are not
+ * null-terminated; they are truncated to EC_IOCTL_STRING_SIZE - 1 bytes.
+ */
+typedef enum {
+    EC_IOCTL_SNAPSHOT_SLAVES, /**< One ec_ioctl_slave_t per slave. */
+    EC_IOCTL_SNAPSHOT_PDOS, /**< Sync managers of a slave, each followed by
+                              its PDOs, each followed by its entries. */
+    EC_IOCTL_SNAPSHOT_DICT /**< SDOs of a slave, each followed by its
+                             entries. */
+} ec_ioctl_snapshot_table_t;
+
+typedef struct {
+    uint16_t physical_start_address;
+    uint16_t default_size;
+    uint8_t control_register;
+    uint8_t enable;
+    uint8_t pdo_count;
+} ec_ioctl_snapshot_sync_t;
+
+typedef struct {
+    uint16_t index;
+    uint8_t entry_count;
+    uint8_t name_size;
+} ec_ioctl_snapshot_pdo_t;
+
+typedef struct {
+    uint16_t index;
+    uint8_t subindex;
+    uint8_t bit_length;
+    uint8_t name_size;
+} ec_ioctl_snapshot_pdo_entry_t;
+
+typedef struct {
+    uint16_t index;
+    uint16_t entry_count; // up to 256 subindices
+    uint8_t object_code;
+    uint8_t max_subindex;
+    uint8_t name_size;
+} ec_ioctl_snapshot_sdo_t;
+
+typedef struct {
+    uint16_t data_type;
+    uint16_t bit_length;
+    uint8_t subindex;
+    uint8_t read_access[EC_SDO_ENTRY_ACCESS_COUNT];
+    uint8_t write_access[EC_SDO_ENTRY_ACCESS_COUNT];
+    uint8_t description_size;
+} ec_ioctl_snapshot_sdo_entry_t;
+
+typedef struct {
+    // inputs
+    uint16_t table; // ec_ioctl_snapshot_table_t
+    uint16_t slave_position;
+    uint32_t size;
+    uint8_t *buffer;
+
+    // outputs
+    uint32_t count; // top-level records
+    uint32_t length; // bytes needed; nothing is copied if above size
+} ec_ioctl_snapshot_t;
+
+/*****************************************************************************/
+
 #ifdef __KERNEL__
 
 /** Context data structure for file handles.
@@ -940,6 +1398,8 @@ typedef struct {
     unsigned int requested; /**< Master was requested via this file handle. */
     uint8_t *process_data; /**< Total process data area. */
     size_t process_data_size; /**< Size of the \a process_data. */
+    unsigned int share_request_data; /**< Place the request data in the
+                                       process data area on activation. */
 } ec_ioctl_context_t;
 
 long ec_ioctl(ec_master_t *, ec_ioctl_context_t *, unsigned int,
@@ -43,7 +43,11 @@
 #include <linux/version.h>
 #include <linux/hrtimer.h>
 #include <linux/vmalloc.h>
+#include <linux/rcupdate.h>
 #include <linux/freezer.h>
+#include <linux/bitmap.h>
+#include <linux/gcd.h>
+#include <linux/list_sort.h>
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 11, 0)
 #include <uapi/linux/sched/types.h> // struct sched_param
@@ -56,7 +60,9 @@
 #include "slave_config.h"
 #include "device.h"
 #include "datagram.h"
+#include "frame_template.h"
 #include "mailbox.h"
+#include "voe_handler.h"
 #ifdef EC_EOE
 #include "ethernet.h"
 #endif
@@ -78,20 +84,12 @@
  */
 static cycles_t timeout_cycles;
 
-/** Timeout for external datagram injection [cycles].
- */
-static cycles_t ext_injection_timeout_cycles;
-
 #else
 
 /** Frame timeout in jiffies.
  */
 static unsigned long timeout_jiffies;
 
-/** Timeout for external datagram injection [jiffies].
- */
-static unsigned long ext_injection_timeout_jiffies;
-
 #endif
 
 /** List of intervals for statistics [s].
@@ -100,12 +98,27 @@ const unsigned int rate_intervals[] = {
     1, 10, 60
 };
 
+/** Number of slave information entries updated per call of
+ * ec_master_update_slave_info().
+ */
+#define EC_SLAVE_INFO_UPDATES 16
+
+/** Number of polls of an empty cycle ring, before the cycle thread sleeps.
+ */
+#define EC_CYCLE_THREAD_SPIN_POLLS 10000
+
+/** Minimum sleep time of the idle cycle thread [us].
+ */
+#define EC_CYCLE_THREAD_SLEEP_US 20
+
 /*****************************************************************************/
 
 void ec_master_clear_slave_configs(ec_master_t *);
 void ec_master_clear_domains(ec_master_t *);
 static int ec_master_idle_thread(void *);
+static void ec_master_prepare_slave_info(ec_master_t *);
 static int ec_master_operation_thread(void *);
+static int ec_master_cycle_thread(void *);
 #ifdef EC_EOE
 static int ec_master_eoe_thread(void *);
 #endif
@@ -121,13 +134,9 @@ void ec_master_init_static(void)
 {
 #ifdef EC_HAVE_CYCLES
     timeout_cycles = (cycles_t) EC_IO_TIMEOUT /* us */ * (cpu_khz / 1000);
-    ext_injection_timeout_cycles =
-        (cycles_t) EC_SDO_INJECTION_TIMEOUT /* us */ * (cpu_khz / 1000);
 #else
     // one jiffy may always elapse between time measurement
     timeout_jiffies = max(EC_IO_TIMEOUT * HZ / 1000000, 1);
-    ext_injection_timeout_jiffies =
-        max(EC_SDO_INJECTION_TIMEOUT * HZ / 1000000, 1);
 #endif
 }
 
@@ -144,7 +153,9 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
         const uint8_t *backup_mac, /**< MAC address of backup device */
         dev_t device_number, /**< Character device number. */
         struct class *class, /**< Device class. */
-        unsigned int debug_level /**< Debug level (module parameter). */
+        unsigned int debug_level, /**< Debug level (module parameter). */
+        unsigned int ext_ring_size /**< External datagram ring size (module
+                                     parameter). */
         )
 {
     int ret;
@@ -183,9 +194,17 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
 
     master->slaves = NULL;
     master->slave_count = 0;
+    master->station_slaves = NULL;
+    master->station_slave_count = 0;
+    master->slave_info = NULL;
+    master->slave_info_next = NULL;
+    master->slave_info_pos = 0;
+    master->slave_info_scan_busy = 0;
 
     INIT_LIST_HEAD(&master->configs);
+    ec_index_table_init(&master->config_table);
     INIT_LIST_HEAD(&master->domains);
+    ec_index_table_init(&master->domain_table);
     INIT_LIST_HEAD(&master->sii_images);
 
     master->app_time = 0ULL;
@@ -203,6 +222,11 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
 
     INIT_LIST_HEAD(&master->datagram_queue);
     master->datagram_index = 0;
+    INIT_LIST_HEAD(&master->timeout_list);
+    for (i = 0; i < EC_DATAGRAM_INDEX_COUNT; i++) {
+        master->sent_datagrams[i] = NULL;
+    }
+    bitmap_zero(master->datagram_indices, EC_DATAGRAM_INDEX_COUNT);
 
     INIT_LIST_HEAD(&master->ext_datagram_queue);
     ec_lock_init(&master->ext_queue_sem);
@@ -212,8 +236,40 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     master->rt_slave_requests = 0;
     master->rt_slaves_available = 0;
 
+    // init state page
+    BUILD_BUG_ON(sizeof(ec_ioctl_state_page_t) > PAGE_SIZE);
+    master->state_page =
+        (ec_ioctl_state_page_t *) get_zeroed_page(GFP_KERNEL);
+    if (!master->state_page) {
+        EC_MASTER_ERR(master, "Failed to allocate state page.\n");
+        return -ENOMEM;
+    }
+
+    // init cycle ring
+    BUILD_BUG_ON(sizeof(ec_ioctl_cycle_ring_t) > PAGE_SIZE);
+    master->cycle_ring =
+        (ec_ioctl_cycle_ring_t *) get_zeroed_page(GFP_KERNEL);
+    if (!master->cycle_ring) {
+        EC_MASTER_ERR(master, "Failed to allocate cycle ring.\n");
+        free_page((unsigned long) master->state_page);
+        return -ENOMEM;
+    }
+    master->cycle_thread = NULL;
+    master->cycle_ops = NULL;
+    master->cycle_op_count = 0;
+
     // init external datagram ring
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
+    master->ext_ring_size = ext_ring_size;
+    master->ext_datagram_ring = kmalloc_array(ext_ring_size,
+            sizeof(ec_datagram_t), GFP_KERNEL);
+    if (!master->ext_datagram_ring) {
+        EC_MASTER_ERR(master, "Failed to allocate external datagram"
+                " ring.\n");
+        free_page((unsigned long) master->cycle_ring);
+        free_page((unsigned long) master->state_page);
+        return -ENOMEM;
+    }
+    for (i = 0; i < master->ext_ring_size; i++) {
         ec_datagram_t *datagram = &master->ext_datagram_ring[i];
         ec_datagram_init(datagram);
         snprintf(datagram->name, EC_DATAGRAM_NAME_SIZE, "ext-%u", i);
@@ -225,11 +281,13 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     master->fsm_slave = NULL;
     INIT_LIST_HEAD(&master->fsm_exec_list);
     master->fsm_exec_count = 0U;
+    master->ext_ring_stalls = 0;
 
     master->debug_level = debug_level;
     master->stats.timeouts = 0;
     master->stats.corrupted = 0;
     master->stats.unmatched = 0;
+    memset(master->traffic_stats, 0x00, sizeof(master->traffic_stats));
     master->stats.output_jiffies = 0;
 
     // set up pcap debugging
@@ -260,6 +318,14 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
 
     init_waitqueue_head(&master->request_queue);
 
+    master->completions_enabled = 0;
+    master->completion_pending = 0;
+    master->completion_head = 0;
+    master->completion_tail = 0;
+    init_waitqueue_head(&master->completion_queue);
+
+    ec_acyclic_queue_init(&master->acyclic_queue, master);
+
     // init devices
     for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
             dev_idx++) {
@@ -272,6 +338,7 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     // init state machine datagram
     ec_datagram_init(&master->fsm_datagram);
     snprintf(master->fsm_datagram.name, EC_DATAGRAM_NAME_SIZE, "master-fsm");
+    master->fsm_datagram.traffic_class = EC_TRAFFIC_FSM;
     ret = ec_datagram_prealloc(&master->fsm_datagram, EC_MAX_DATA_SIZE);
     if (ret < 0) {
         ec_datagram_clear(&master->fsm_datagram);
@@ -283,7 +350,7 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     ec_fsm_master_init(&master->fsm, master, &master->fsm_datagram);
 
     // alloc external datagram ring
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
+    for (i = 0; i < master->ext_ring_size; i++) {
         ec_datagram_t *datagram = &master->ext_datagram_ring[i];
         ret = ec_datagram_prealloc(datagram, EC_MAX_DATA_SIZE);
         if (ret) {
@@ -295,6 +362,7 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
 
     // init reference sync datagram
     ec_datagram_init(&master->ref_sync_datagram);
+    master->ref_sync_datagram.traffic_class = EC_TRAFFIC_DC;
     snprintf(master->ref_sync_datagram.name, EC_DATAGRAM_NAME_SIZE,
             "refsync");
     ret = ec_datagram_prealloc(&master->ref_sync_datagram, 4);
@@ -307,6 +375,7 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
 
     // init sync datagram
     ec_datagram_init(&master->sync_datagram);
+    master->sync_datagram.traffic_class = EC_TRAFFIC_DC;
     snprintf(master->sync_datagram.name, EC_DATAGRAM_NAME_SIZE, "sync");
     ret = ec_datagram_prealloc(&master->sync_datagram, 4);
     if (ret < 0) {
@@ -318,6 +387,7 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
 
     // init sync64 datagram
     ec_datagram_init(&master->sync64_datagram);
+    master->sync64_datagram.traffic_class = EC_TRAFFIC_DC;
     snprintf(master->sync64_datagram.name, EC_DATAGRAM_NAME_SIZE, "sync64");
     ret = ec_datagram_prealloc(&master->sync64_datagram, 8);
     if (ret < 0) {
@@ -329,6 +399,7 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
 
     // init sync monitor datagram
     ec_datagram_init(&master->sync_mon_datagram);
+    master->sync_mon_datagram.traffic_class = EC_TRAFFIC_DC;
     snprintf(master->sync_mon_datagram.name, EC_DATAGRAM_NAME_SIZE,
             "syncmon");
     ret = ec_datagram_brd(&master->sync_mon_datagram, 0x092c, 4);
@@ -399,7 +470,7 @@ out_clear_sync:
 out_clear_ref_sync:
     ec_datagram_clear(&master->ref_sync_datagram);
 out_clear_ext_datagrams:
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
+    for (i = 0; i < master->ext_ring_size; i++) {
         ec_datagram_clear(&master->ext_datagram_ring[i]);
     }
     ec_fsm_master_clear(&master->fsm);
@@ -408,6 +479,9 @@ out_clear_devices:
     for (; dev_idx > 0; dev_idx--) {
         ec_device_clear(&master->devices[dev_idx - 1]);
     }
+    kfree(master->ext_datagram_ring);
+    free_page((unsigned long) master->cycle_ring);
+    free_page((unsigned long) master->state_page);
     return ret;
 }
 
@@ -442,15 +516,28 @@ void ec_master_clear(
     ec_master_clear_slave_configs(master);
     ec_master_clear_slaves(master);
     ec_master_clear_sii_images(master);
+    if (master->slave_info) {
+        vfree(master->slave_info);
+    }
+    if (master->slave_info_next) {
+        vfree(master->slave_info_next);
+    }
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 9, 0)
+    // wait for ec_master_free_slave_info()
+    rcu_barrier();
+#endif
 
     ec_datagram_clear(&master->sync_mon_datagram);
     ec_datagram_clear(&master->sync64_datagram);
     ec_datagram_clear(&master->sync_datagram);
     ec_datagram_clear(&master->ref_sync_datagram);
 
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
+    for (i = 0; i < master->ext_ring_size; i++) {
         ec_datagram_clear(&master->ext_datagram_ring[i]);
     }
+    kfree(master->ext_datagram_ring);
+    free_page((unsigned long) master->cycle_ring);
+    free_page((unsigned long) master->state_page);
 
     ec_fsm_master_clear(&master->fsm);
     ec_datagram_clear(&master->fsm_datagram);
@@ -504,6 +591,8 @@ void ec_master_clear_slave_configs(ec_master_t *master)
 
     master->dc_ref_config = NULL;
 
+    ec_index_table_clear(&master->config_table);
+
     list_for_each_entry_safe(sc, next, &master->configs, list) {
         list_del(&sc->list);
         ec_slave_config_clear(sc);
@@ -624,6 +713,12 @@ void ec_master_clear_slaves(ec_master_t *master)
     INIT_LIST_HEAD(&master->fsm_exec_list);
     master->fsm_exec_count = 0;
 
+    master->station_slave_count = 0;
+    if (master->station_slaves) {
+        kfree(master->station_slaves);
+        master->station_slaves = NULL;
+    }
+
     for (slave = master->slaves;
             slave < master->slaves + master->slave_count;
             slave++) {
@@ -640,12 +735,62 @@ void ec_master_clear_slaves(ec_master_t *master)
 
 /*****************************************************************************/
 
+/** Builds the station address lookup table.
+ *
+ * Has to be called, after the slaves got their station addresses assigned.
+ * If the table can not be allocated, ec_master_find_station() falls back to
+ * searching the slave array.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_master_map_station_addresses(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    ec_slave_t *slave;
+    ec_slave_t **station_slaves;
+    unsigned int count = 0;
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count;
+            slave++) {
+        if (slave->station_address >= count) {
+            count = slave->station_address + 1;
+        }
+    }
+
+    if (!count) {
+        return 0;
+    }
+
+    if (!(station_slaves = (ec_slave_t **)
+                kzalloc(sizeof(ec_slave_t *) * count, GFP_KERNEL))) {
+        EC_MASTER_ERR(master, "Failed to allocate station address"
+                " table for %u entries!\n", count);
+        return -ENOMEM;
+    }
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count;
+            slave++) {
+        station_slaves[slave->station_address] = slave;
+    }
+
+    master->station_slaves = station_slaves;
+    master->station_slave_count = count;
+    return 0;
+}
+
+/*****************************************************************************/
+
 /** Clear all domains.
  */
 void ec_master_clear_domains(ec_master_t *master)
 {
     ec_domain_t *domain, *next;
 
+    ec_index_table_clear(&master->domain_table);
+
     list_for_each_entry_safe(domain, next, &master->domains, list) {
         list_del(&domain->list);
         ec_domain_clear(domain);
@@ -672,10 +817,17 @@ void ec_master_clear_config(
         ec_master_t *master /**< EtherCAT master. */
         )
 {
+    // the cycle thread refers to the domains
+    ec_master_cycle_thread_stop(master);
+
     ec_lock_down(&master->master_sem);
     ec_master_clear_domains(master);
     ec_master_clear_slave_configs(master);
     ec_master_reset_slave_fsms(master);
+
+    // queued completions refer to the configurations
+    master->completions_enabled = 0;
+    master->completion_tail = master->completion_head;
     ec_lock_up(&master->master_sem);
 }
 
@@ -931,6 +1083,9 @@ void ec_master_leave_operation_phase(
         ec_master_clear_config(master);
     }
 
+    // the idle thread finishes the operations in progress
+    ec_acyclic_queue_clear(&master->acyclic_queue);
+
     /* Re-allow scanning for IDLE phase. */
     master->allow_scan = 1;
 
@@ -941,110 +1096,34 @@ void ec_master_leave_operation_phase(
 
 /*****************************************************************************/
 
-/** Injects external datagrams that fit into the datagram queue.
+/** Injects the external datagrams into the datagram queue.
+ *
+ * The amount of slave FSM data sent per cycle is limited by the traffic
+ * class budgets in ec_master_send_datagrams().
  */
 void ec_master_inject_external_datagrams(
         ec_master_t *master /**< EtherCAT master */
         )
 {
     ec_datagram_t *datagram;
-    size_t queue_size = 0, new_queue_size = 0;
 #if DEBUG_INJECT
     unsigned int datagram_count = 0;
 #endif
 
-    if (master->ext_ring_idx_rt == master->ext_ring_idx_fsm) {
-        // nothing to inject
-        return;
-    }
-
-    list_for_each_entry(datagram, &master->datagram_queue, queue) {
-        if (datagram->state == EC_DATAGRAM_QUEUED) {
-            queue_size += datagram->data_size;
-        }
-    }
-
-#if DEBUG_INJECT
-    EC_MASTER_DBG(master, 1, "Injecting datagrams, queue_size=%zu\n",
-            queue_size);
-#endif
-
     while (master->ext_ring_idx_rt != master->ext_ring_idx_fsm) {
         datagram = &master->ext_datagram_ring[master->ext_ring_idx_rt];
 
-        if (datagram->state != EC_DATAGRAM_INIT) {
-            // skip datagram
-            master->ext_ring_idx_rt =
-                (master->ext_ring_idx_rt + 1) % EC_EXT_RING_SIZE;
-            continue;
-        }
-
-        new_queue_size = queue_size + datagram->data_size;
-        if (new_queue_size <= master->max_queue_size) {
+        if (datagram->state == EC_DATAGRAM_INIT) {
 #if DEBUG_INJECT
-            EC_MASTER_DBG(master, 1, "Injecting datagram %s"
-                    " size=%zu, queue_size=%zu\n", datagram->name,
-                    datagram->data_size, new_queue_size);
+            EC_MASTER_DBG(master, 1, "Injecting datagram %s size=%zu\n",
+                    datagram->name, datagram->data_size);
             datagram_count++;
 #endif
-#ifdef EC_HAVE_CYCLES
-            datagram->cycles_sent = 0;
-#endif
-            datagram->jiffies_sent = 0;
             ec_master_queue_datagram(master, datagram);
-            queue_size = new_queue_size;
-        }
-        else if (datagram->data_size > master->max_queue_size) {
-            datagram->state = EC_DATAGRAM_ERROR;
-            EC_MASTER_ERR(master, "External datagram %s is too large,"
-                    " size=%zu, max_queue_size=%zu\n",
-                    datagram->name, datagram->data_size,
-                    master->max_queue_size);
-        }
-        else { // datagram does not fit in the current cycle
-#ifdef EC_HAVE_CYCLES
-            cycles_t cycles_now = get_cycles();
-
-            if (cycles_now - datagram->cycles_sent
-                    > ext_injection_timeout_cycles)
-#else
-            if (jiffies - datagram->jiffies_sent
-                    > ext_injection_timeout_jiffies)
-#endif
-            {
-#if defined EC_RT_SYSLOG || DEBUG_INJECT
-                unsigned int time_us;
-#endif
-
-                datagram->state = EC_DATAGRAM_ERROR;
-
-#if defined EC_RT_SYSLOG || DEBUG_INJECT
-#ifdef EC_HAVE_CYCLES
-                time_us = (unsigned int)
-                    ((cycles_now - datagram->cycles_sent) * 1000LL)
-                    / cpu_khz;
-#else
-                time_us = (unsigned int)
-                    ((jiffies - datagram->jiffies_sent) * 1000000 / HZ);
-#endif
-                EC_MASTER_ERR(master, "Timeout %u us: Injecting"
-                        " external datagram %s size=%zu,"
-                        " max_queue_size=%zu\n", time_us, datagram->name,
-                        datagram->data_size, master->max_queue_size);
-#endif
-            }
-            else {
-#if DEBUG_INJECT
-                EC_MASTER_DBG(master, 1, "Deferred injecting"
-                        " external datagram %s size=%u, queue_size=%u\n",
-                        datagram->name, datagram->data_size, queue_size);
-#endif
-                break;
-            }
         }
 
         master->ext_ring_idx_rt =
-            (master->ext_ring_idx_rt + 1) % EC_EXT_RING_SIZE;
+            (master->ext_ring_idx_rt + 1) % master->ext_ring_size;
     }
 
 #if DEBUG_INJECT
@@ -1056,6 +1135,10 @@ void ec_master_inject_external_datagrams(
 
 /** Sets the expected interval between calls to ecrt_master_send
  * and calculates the maximum amount of data to queue.
+ *
+ * Cyclic process data, distributed clocks and the master state machine are
+ * never deferred. The slave state machines may use the whole queue, EoE
+ * half of it.
  */
 void ec_master_set_send_interval(
         ec_master_t *master, /**< EtherCAT master */
@@ -1066,6 +1149,12 @@ void ec_master_set_send_interval(
     master->max_queue_size =
         (send_interval * 1000) / EC_BYTE_TRANSMISSION_TIME_NS;
     master->max_queue_size -= master->max_queue_size / 10;
+
+    master->traffic_budgets[EC_TRAFFIC_CYCLIC] = 0;
+    master->traffic_budgets[EC_TRAFFIC_DC] = 0;
+    master->traffic_budgets[EC_TRAFFIC_FSM] = 0;
+    master->traffic_budgets[EC_TRAFFIC_MAILBOX] = master->max_queue_size;
+    master->traffic_budgets[EC_TRAFFIC_EOE] = master->max_queue_size / 2;
 }
 
 /*****************************************************************************/
@@ -1089,19 +1178,12 @@ ec_datagram_t *ec_master_get_external_datagram(
         ec_master_t *master /**< EtherCAT master */
         )
 {
-    if ((master->ext_ring_idx_fsm + 1) % EC_EXT_RING_SIZE !=
+    if ((master->ext_ring_idx_fsm + 1) % master->ext_ring_size !=
             master->ext_ring_idx_rt) {
-        ec_datagram_t *datagram =
-            &master->ext_datagram_ring[master->ext_ring_idx_fsm];
-        /* Record the queued time for ec_master_inject_external_datagrams */
-#ifdef EC_HAVE_CYCLES
-        datagram->cycles_sent = get_cycles();
-#endif
-        datagram->jiffies_sent = jiffies;
-
-        return datagram;
+        return &master->ext_datagram_ring[master->ext_ring_idx_fsm];
     }
     else {
+        master->ext_ring_stalls++;
         return NULL;
     }
 }
@@ -1115,24 +1197,22 @@ void ec_master_queue_datagram(
         ec_datagram_t *datagram /**< datagram */
         )
 {
-    ec_datagram_t *queued_datagram;
-
     /* It is possible, that a datagram in the queue is re-initialized with the
      * ec_datagram_<type>() methods and then shall be queued with this method.
      * In that case, the state is already reset to EC_DATAGRAM_INIT. Check if
      * the datagram is queued to avoid duplicate queuing (which results in an
      * infinite loop!). Set the state to EC_DATAGRAM_QUEUED again, probably
-     * causing an unmatched datagram. */
-    list_for_each_entry(queued_datagram, &master->datagram_queue, queue) {
-        if (queued_datagram == datagram) {
-            datagram->skip_count++;
+     * causing an unmatched datagram. The queue list head of a datagram is
+     * always re-initialized on dequeuing, so it is empty, if and only if the
+     * datagram is not queued. */
+    if (!list_empty(&datagram->queue)) {
+        datagram->skip_count++;
 #ifdef EC_RT_SYSLOG
-            EC_MASTER_DBG(master, 1,
-                    "Datagram %p already queued (skipping).\n", datagram);
+        EC_MASTER_DBG(master, 1,
+                "Datagram %p already queued (skipping).\n", datagram);
 #endif
-            datagram->state = EC_DATAGRAM_QUEUED;
-            return;
-        }
+        datagram->state = EC_DATAGRAM_QUEUED;
+        return;
     }
 
     if (datagram->state != EC_DATAGRAM_INVALID) {
@@ -1157,167 +1237,607 @@ void ec_master_queue_datagram_ext(
 
 /*****************************************************************************/
 
-static int index_in_use(ec_master_t *master, uint8_t index)
+/** Releases a datagram index.
+ *
+ * Clears the table entry and marks the index as free for
+ * ec_master_alloc_index().
+ */
+static inline void ec_master_release_index(
+        ec_master_t *master, /**< EtherCAT master */
+        uint8_t index /**< Datagram index. */
+        )
 {
-    ec_datagram_t *datagram;
-    list_for_each_entry(datagram, &master->datagram_queue, queue)
-        if (datagram->state == EC_DATAGRAM_SENT && datagram->index == index)
-            return 1;
-    return 0;
+    master->sent_datagrams[index] = NULL;
+    clear_bit(index, master->datagram_indices);
 }
 
-/** Sends the datagrams in the queue for a certain device.
+/*****************************************************************************/
+
+/** Removes a datagram from the table of datagrams in flight.
  *
+ * This has to be called before the memory of a datagram, that may have been
+ * sent, is freed. Otherwise a late response carrying the datagram's index
+ * could be matched against freed memory.
  */
-size_t ec_master_send_datagrams(
+void ec_master_forget_datagram(
         ec_master_t *master, /**< EtherCAT master */
-        ec_device_index_t device_index /**< Device index. */
+        ec_datagram_t *datagram /**< datagram */
         )
 {
-    ec_datagram_t *datagram, *next;
-    size_t datagram_size;
-    uint8_t *frame_data, *cur_data = NULL;
-    void *follows_word;
-#ifdef EC_HAVE_CYCLES
-    cycles_t cycles_start, cycles_sent, cycles_end;
-#endif
-    unsigned long jiffies_sent;
-    unsigned int frame_count, more_datagrams_waiting;
-    struct list_head sent_datagrams;
-    size_t sent_bytes = 0;
-    uint8_t last_index;
-
-#ifdef EC_HAVE_CYCLES
-    cycles_start = get_cycles();
-#endif
-    frame_count = 0;
-    INIT_LIST_HEAD(&sent_datagrams);
+    unsigned int i;
 
-    EC_MASTER_DBG(master, 2, "%s(device_index = %u)\n",
-            __func__, device_index);
+    list_del_init(&datagram->timeout);
 
-    do {
-        frame_data = NULL;
-        follows_word = NULL;
-        more_datagrams_waiting = 0;
+    for (i = 0; i < EC_DATAGRAM_INDEX_COUNT; i++) {
+        if (master->sent_datagrams[i] == datagram) {
+            ec_master_release_index(master, i);
+        }
+    }
+}
 
-        // fill current frame with datagrams
-        list_for_each_entry(datagram, &master->datagram_queue, queue) {
-            if (datagram->state != EC_DATAGRAM_QUEUED ||
-                    datagram->device_index != device_index) {
-                continue;
-            }
+/*****************************************************************************/
 
-            if (!frame_data) {
-                // fetch pointer to transmit socket buffer
-                frame_data =
-                    ec_device_tx_data(&master->devices[device_index]);
-                cur_data = frame_data + EC_FRAME_HEADER_SIZE;
-            }
+/** Releases datagram indices, that are held by stale table entries.
+ *
+ * A datagram can be re-initialized while it is in flight. Its index is then
+ * neither released by reception nor by a timeout, so it is reclaimed here,
+ * when the index space runs out.
+ */
+static void ec_master_reclaim_indices(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    ec_datagram_t *datagram;
+    unsigned int i;
 
-            // does the current datagram fit in the frame?
-            datagram_size = EC_DATAGRAM_HEADER_SIZE + datagram->data_size
-                + EC_DATAGRAM_FOOTER_SIZE;
-            if (cur_data - frame_data + datagram_size > ETH_DATA_LEN) {
-                more_datagrams_waiting = 1;
-                break;
-            }
+    for_each_set_bit(i, master->datagram_indices, EC_DATAGRAM_INDEX_COUNT) {
+        datagram = master->sent_datagrams[i];
+        if (!datagram || datagram->index != i ||
+                (datagram->state != EC_DATAGRAM_SENT &&
+                 datagram->state != EC_DATAGRAM_QUEUED)) {
+            ec_master_release_index(master, i);
+        }
+    }
+}
 
-            // do not reuse the index of a pending datagram to avoid confusion
-            // in ec_master_receive_datagrams()
-            last_index = master->datagram_index;
-            while (index_in_use(master, master->datagram_index)) {
-                if (++master->datagram_index == last_index) {
-                    EC_MASTER_ERR(master, "No free datagram index, sending delayed\n");
-                    goto break_send;
-                }
-            }
-            datagram->index = master->datagram_index++;
+/*****************************************************************************/
 
-            list_add_tail(&datagram->sent, &sent_datagrams);
+/** Allocates a free datagram index for a datagram to send.
+ *
+ * Indices of pending datagrams are not re-used to avoid confusion in
+ * ec_master_receive_datagrams(). The search starts at the current datagram
+ * index, so that indices are handed out round-robin.
+ *
+ * \return Zero on success, otherwise -EBUSY, if all indices are in use.
+ */
+static int ec_master_alloc_index(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_datagram_t *datagram /**< Datagram to send. */
+        )
+{
+    unsigned int index;
 
-            EC_MASTER_DBG(master, 2, "Adding datagram 0x%02X\n",
-                    datagram->index);
+    index = find_next_zero_bit(master->datagram_indices,
+            EC_DATAGRAM_INDEX_COUNT, master->datagram_index);
+    if (index >= EC_DATAGRAM_INDEX_COUNT) {
+        index = find_first_zero_bit(master->datagram_indices,
+                EC_DATAGRAM_INDEX_COUNT);
+    }
+    if (unlikely(index >= EC_DATAGRAM_INDEX_COUNT)) {
+        ec_master_reclaim_indices(master);
+        index = find_first_zero_bit(master->datagram_indices,
+                EC_DATAGRAM_INDEX_COUNT);
+        if (index >= EC_DATAGRAM_INDEX_COUNT) {
+            return -EBUSY;
+        }
+    }
 
-            // set "datagram following" flag in previous datagram
-            if (follows_word) {
-                EC_WRITE_U16(follows_word,
-                        EC_READ_U16(follows_word) | 0x8000);
-            }
+    set_bit(index, master->datagram_indices);
+    master->sent_datagrams[index] = datagram;
+    datagram->index = index;
+    master->datagram_index = index + 1;
+    return 0;
+}
 
-            // EtherCAT datagram header
-            EC_WRITE_U8 (cur_data, datagram->type);
-            EC_WRITE_U8 (cur_data + 1, datagram->index);
-            memcpy(cur_data + 2, datagram->address, EC_ADDR_LEN);
-            EC_WRITE_U16(cur_data + 6, datagram->data_size & 0x7FF);
-            EC_WRITE_U16(cur_data + 8, 0x0000);
-            follows_word = cur_data + 6;
-            cur_data += EC_DATAGRAM_HEADER_SIZE;
+/*****************************************************************************/
 
-            // EtherCAT datagram data
-            memcpy(cur_data, datagram->data, datagram->data_size);
-            cur_data += datagram->data_size;
+/** Schedules the queued datagrams of a certain device for sending.
+ *
+ * The datagrams are linked into the list of their traffic class via their
+ * \a sent list head, in queueing order. Datagrams of a class exceeding the
+ * per-cycle budget of the class, or the maximum queue size, stay queued for
+ * the next cycle. The first datagram of each class is always scheduled, so
+ * that no class can be starved.
+ */
+static void ec_master_schedule_datagrams(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_device_index_t device_index, /**< Device index. */
+        struct list_head *classes, /**< Lists of scheduled datagrams, indexed
+                                     by ec_traffic_class_t. */
+        size_t queue_size /**< Number of bytes already sent in this cycle. */
+        )
+{
+    ec_datagram_t *datagram, *next;
+    size_t budget, class_size;
+    unsigned int i;
 
-            // EtherCAT datagram footer
-            EC_WRITE_U16(cur_data, 0x0000); // reset working counter
-            cur_data += EC_DATAGRAM_FOOTER_SIZE;
+    list_for_each_entry(datagram, &master->datagram_queue, queue) {
+        if (datagram->state == EC_DATAGRAM_QUEUED &&
+                datagram->device_index == device_index) {
+            list_add_tail(&datagram->sent, &classes[datagram->traffic_class]);
         }
+    }
 
-break_send:
-        if (list_empty(&sent_datagrams)) {
-            EC_MASTER_DBG(master, 2, "nothing to send.\n");
-            break;
+    for (i = 0; i < EC_TRAFFIC_CLASS_COUNT; i++) {
+        budget = master->traffic_budgets[i];
+        class_size = 0;
+
+        list_for_each_entry_safe(datagram, next, &classes[i], sent) {
+            if (budget && class_size &&
+                    (class_size + datagram->data_size > budget ||
+                     queue_size + datagram->data_size
+                     > master->max_queue_size)) {
+                list_del_init(&datagram->sent);
+                master->traffic_stats[i].deferred++;
+                continue;
+            }
+            class_size += datagram->data_size;
+            queue_size += datagram->data_size;
         }
+    }
+}
 
-        // EtherCAT frame header
-        EC_WRITE_U16(frame_data, ((cur_data - frame_data
-                        - EC_FRAME_HEADER_SIZE) & 0x7FF) | 0x1000);
+/*****************************************************************************/
 
-        // pad frame
-        while (cur_data - frame_data < ETH_ZLEN - ETH_HLEN)
-            EC_WRITE_U8(cur_data++, 0x00);
+/** Maximum number of frame templates in a frame.
+ */
+#define EC_FRAME_MAX_TEMPLATES 8
 
-        EC_MASTER_DBG(master, 2, "frame size: %zu\n", cur_data - frame_data);
+/** Frame to be filled by ec_master_pack_frames().
+ */
+typedef struct {
+    struct list_head datagrams; /**< Datagrams in the frame, starting with
+                                  the datagrams of the templates. */
+    const ec_frame_template_t *templates[EC_FRAME_MAX_TEMPLATES]; /**<
+                                                  Templates in the frame. */
+    unsigned int template_count; /**< Number of templates in the frame. */
+    size_t size; /**< Size of the EtherCAT frame data. */
+} ec_frame_bin_t;
 
-        // send frame
-        ec_device_send(&master->devices[device_index],
-                cur_data - frame_data);
-        /* preamble and inter-frame gap */
-        sent_bytes += ETH_HLEN + cur_data - frame_data + ETH_FCS_LEN + 20;
-#ifdef EC_HAVE_CYCLES
-        cycles_sent = get_cycles();
-#endif
-        jiffies_sent = jiffies;
+/*****************************************************************************/
 
-        // set datagram states and sending timestamps
-        list_for_each_entry_safe(datagram, next, &sent_datagrams, sent) {
-            datagram->state = EC_DATAGRAM_SENT;
-#ifdef EC_HAVE_CYCLES
-            datagram->cycles_sent = cycles_sent;
+/** Compares two scheduled datagrams by descending size.
+ *
+ * \return Positive, if \a b shall be placed before \a a.
+ */
+static int ec_master_cmp_datagram_size(
+        void *priv, /**< Unused. */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 13, 0)
+        const struct list_head *a, /**< First datagram. */
+        const struct list_head *b /**< Second datagram. */
+#else
+        struct list_head *a, /**< First datagram. */
+        struct list_head *b /**< Second datagram. */
 #endif
-            datagram->jiffies_sent = jiffies_sent;
-            datagram->app_time_sent = master->app_time;
-            list_del_init(&datagram->sent); // empty list of sent datagrams
-        }
-
-        frame_count++;
-    }
-    while (more_datagrams_waiting && frame_count < EC_TX_RING_SIZE);
+        )
+{
+    size_t size_a = list_entry(a, ec_datagram_t, sent)->data_size;
+    size_t size_b = list_entry(b, ec_datagram_t, sent)->data_size;
 
-#ifdef EC_HAVE_CYCLES
-    if (unlikely(master->debug_level > 1)) {
-        cycles_end = get_cycles();
-        EC_MASTER_DBG(master, 0, "%s()"
-                " sent %u frames in %uus.\n", __func__, frame_count,
-               (unsigned int) (cycles_end - cycles_start) * 1000 / cpu_khz);
-    }
-#endif
-    return sent_bytes;
+    return size_a < size_b;
 }
 
 /*****************************************************************************/
 
-/** Processes a received frame.
+/** Sorts a list of scheduled datagrams by descending size.
+ *
+ * list_sort() is a stable merge sort, so datagrams of the same size keep
+ * their queueing order.
+ */
+static void ec_master_sort_datagrams(
+        struct list_head *list /**< List of scheduled datagrams. */
+        )
+{
+    list_sort(NULL, list, ec_master_cmp_datagram_size);
+}
+
+/*****************************************************************************/
+
+/** Distributes the scheduled datagrams to as few frames as possible.
+ *
+ * The traffic classes are packed in the order of their priority, each using
+ * first-fit-decreasing, so that the cyclic process data occupies the first
+ * frames and the smaller datagrams of the other classes fill up the gaps.
+ * Distributed clock datagrams keep their relative order. Datagrams that do
+ * not fit into \a max_frames frames remain in their class list.
+ *
+ * The first \a frame_count frames may already be filled, for example by
+ * ec_master_pack_frame_templates(). Their remaining space is used as well.
+ *
+ * \return Number of frames used.
+ */
+static unsigned int ec_master_pack_frames(
+        struct list_head *classes, /**< Lists of scheduled datagrams, indexed
+                                     by ec_traffic_class_t. */
+        ec_frame_bin_t *frames, /**< Frames to fill. */
+        unsigned int frame_count, /**< Number of frames already filled. */
+        unsigned int max_frames /**< Maximum number of frames. */
+        )
+{
+    ec_datagram_t *datagram, *next;
+    unsigned int first, ordered, i, c;
+    size_t datagram_size;
+
+    for (c = 0; c < EC_TRAFFIC_CLASS_COUNT; c++) {
+        ordered = c == EC_TRAFFIC_DC;
+        if (!ordered) {
+            ec_master_sort_datagrams(&classes[c]);
+        }
+        first = 0;
+
+        list_for_each_entry_safe(datagram, next, &classes[c], sent) {
+            datagram_size = EC_DATAGRAM_HEADER_SIZE + datagram->data_size
+                + EC_DATAGRAM_FOOTER_SIZE;
+
+            for (i = first; i < frame_count; i++) {
+                if (frames[i].size + datagram_size <= ETH_DATA_LEN) {
+                    break;
+                }
+            }
+
+            if (i == frame_count) {
+                if (frame_count == max_frames || EC_FRAME_HEADER_SIZE
+                        + datagram_size > ETH_DATA_LEN) {
+                    if (ordered) {
+                        break;
+                    }
+                    continue;
+                }
+                INIT_LIST_HEAD(&frames[i].datagrams);
+                frames[i].template_count = 0;
+                frames[i].size = EC_FRAME_HEADER_SIZE;
+                frame_count++;
+            }
+
+            list_move_tail(&datagram->sent, &frames[i].datagrams);
+            frames[i].size += datagram_size;
+            if (ordered) {
+                first = i;
+            }
+        }
+    }
+
+    return frame_count;
+}
+
+/*****************************************************************************/
+
+/** Allocates the datagram indices for the datagrams of a frame template.
+ *
+ * Either all datagrams of the template get an index, or none.
+ *
+ * \return Zero on success, otherwise -EBUSY.
+ */
+static int ec_master_alloc_template_indices(
+        ec_master_t *master, /**< EtherCAT master */
+        const ec_frame_template_t *tmpl /**< Frame template. */
+        )
+{
+    unsigned int i;
+
+    for (i = 0; i < tmpl->datagram_count; i++) {
+        if (ec_master_alloc_index(master, tmpl->datagrams[i])) {
+            EC_MASTER_ERR(master, "No free datagram index,"
+                    " sending delayed\n");
+            while (i--) {
+                ec_master_release_index(master, tmpl->datagrams[i]->index);
+            }
+            return -EBUSY;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Places the domain frame templates of a certain device into frames.
+ *
+ * A template is only used, if all of its datagrams are scheduled. Otherwise,
+ * the scheduled datagrams are left to ec_master_pack_frames(). The datagrams
+ * of a used template are moved from their class list to the frame. Frames
+ * are filled first-fit, so that the templates of small domains share a
+ * frame and the remaining space is left to the other traffic classes.
+ *
+ * \return Number of frames used.
+ */
+static unsigned int ec_master_pack_frame_templates(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_device_index_t device_index, /**< Device index. */
+        ec_frame_bin_t *frames, /**< Frames to fill. */
+        unsigned int max_frames /**< Maximum number of frames. */
+        )
+{
+    ec_domain_t *domain;
+    const ec_frame_template_t *tmpl;
+    ec_frame_bin_t *frame;
+    size_t tmpl_size;
+    unsigned int frame_count = 0, i;
+
+    list_for_each_entry(domain, &master->domains, list) {
+        list_for_each_entry(tmpl, &domain->frame_templates, list) {
+            if (tmpl->device_index != device_index) {
+                continue;
+            }
+
+            for (i = 0; i < tmpl->datagram_count; i++) {
+                if (tmpl->datagrams[i]->state != EC_DATAGRAM_QUEUED) {
+                    break;
+                }
+            }
+            if (i < tmpl->datagram_count) {
+                continue;
+            }
+
+            tmpl_size = tmpl->size - EC_FRAME_HEADER_SIZE;
+            for (i = 0; i < frame_count; i++) {
+                if (frames[i].template_count < EC_FRAME_MAX_TEMPLATES &&
+                        frames[i].size + tmpl_size <= ETH_DATA_LEN) {
+                    break;
+                }
+            }
+
+            if (i == frame_count) {
+                if (frame_count == max_frames) {
+                    return frame_count;
+                }
+                INIT_LIST_HEAD(&frames[i].datagrams);
+                frames[i].template_count = 0;
+                frames[i].size = EC_FRAME_HEADER_SIZE;
+                frame_count++;
+            }
+
+            frame = &frames[i];
+            frame->templates[frame->template_count++] = tmpl;
+            frame->size += tmpl_size;
+            for (i = 0; i < tmpl->datagram_count; i++) {
+                list_move_tail(&tmpl->datagrams[i]->sent, &frame->datagrams);
+            }
+        }
+    }
+
+    return frame_count;
+}
+
+/*****************************************************************************/
+
+/** Leaves a list of scheduled datagrams queued for the next cycle.
+ */
+static void ec_master_defer_datagrams(
+        ec_master_t *master, /**< EtherCAT master */
+        struct list_head *list /**< List of scheduled datagrams. */
+        )
+{
+    ec_datagram_t *datagram, *next;
+
+    list_for_each_entry_safe(datagram, next, list, sent) {
+        master->traffic_stats[datagram->traffic_class].deferred++;
+        list_del_init(&datagram->sent);
+    }
+}
+
+/*****************************************************************************/
+
+/** Sends the datagrams in the queue for a certain device.
+ *
+ * Cyclic process data is placed into the first frames, followed by the other
+ * traffic classes in the order of their priority.
+ */
+size_t ec_master_send_datagrams(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_device_index_t device_index /**< Device index. */
+        )
+{
+    ec_device_t *device = &master->devices[device_index];
+    ec_datagram_t *datagram, *next;
+    uint8_t *frame_data, *cur_data;
+    void *follows_word;
+#ifdef EC_HAVE_CYCLES
+    cycles_t cycles_start, cycles_sent, cycles_end;
+#endif
+    unsigned long jiffies_sent;
+    unsigned int frame_count, bin_count, i, j, k;
+    struct list_head classes[EC_TRAFFIC_CLASS_COUNT], sent_datagrams;
+    ec_frame_bin_t frames[EC_TX_RING_SIZE];
+    const ec_frame_template_t *tmpl;
+    size_t sent_bytes = 0;
+
+#ifdef EC_HAVE_CYCLES
+    cycles_start = get_cycles();
+#endif
+    frame_count = 0;
+    for (i = 0; i < EC_TRAFFIC_CLASS_COUNT; i++) {
+        INIT_LIST_HEAD(&classes[i]);
+    }
+    INIT_LIST_HEAD(&sent_datagrams);
+
+    EC_MASTER_DBG(master, 2, "%s(device_index = %u)\n",
+            __func__, device_index);
+
+    ec_master_schedule_datagrams(master, device_index, classes, 0);
+
+    // the precomputed domain frames go first, the other classes fill them up
+    bin_count = 0;
+    if (master->active) {
+        bin_count = ec_master_pack_frame_templates(master, device_index,
+                frames, EC_TX_RING_SIZE);
+    }
+    bin_count = ec_master_pack_frames(classes, frames, bin_count,
+            EC_TX_RING_SIZE);
+
+    for (i = 0; i < bin_count; i++) {
+        // fetch pointer to transmit socket buffer
+        frame_data = ec_device_tx_data(device);
+        cur_data = frame_data + EC_FRAME_HEADER_SIZE;
+        follows_word = NULL;
+
+        // copy the templates into the frame
+        for (j = 0; j < frames[i].template_count; j++) {
+            tmpl = frames[i].templates[j];
+            if (ec_master_alloc_template_indices(master, tmpl)) {
+                break;
+            }
+
+            EC_MASTER_DBG(master, 2, "Adding frame template with %u"
+                    " datagrams\n", tmpl->datagram_count);
+
+            if (follows_word) {
+                EC_WRITE_U16(follows_word,
+                        EC_READ_U16(follows_word) | 0x8000);
+            }
+
+            ec_frame_template_write(tmpl, cur_data);
+            for (k = 0; k < tmpl->datagram_count; k++) {
+                list_move_tail(&tmpl->datagrams[k]->sent, &sent_datagrams);
+            }
+            follows_word = cur_data + tmpl->offsets[k - 1]
+                - EC_FRAME_HEADER_SIZE + 6;
+            cur_data += tmpl->size - EC_FRAME_HEADER_SIZE;
+        }
+
+        // fill the rest of the frame with datagrams
+        list_for_each_entry_safe(datagram, next, &frames[i].datagrams,
+                sent) {
+            if (ec_master_alloc_index(master, datagram)) {
+                EC_MASTER_ERR(master, "No free datagram index, sending delayed\n");
+                break;
+            }
+
+            list_move_tail(&datagram->sent, &sent_datagrams);
+
+            EC_MASTER_DBG(master, 2, "Adding datagram 0x%02X\n",
+                    datagram->index);
+
+            // set "datagram following" flag in previous datagram
+            if (follows_word) {
+                EC_WRITE_U16(follows_word,
+                        EC_READ_U16(follows_word) | 0x8000);
+            }
+
+            // EtherCAT datagram header
+            EC_WRITE_U8 (cur_data, datagram->type);
+            EC_WRITE_U8 (cur_data + 1, datagram->index);
+            memcpy(cur_data + 2, datagram->address, EC_ADDR_LEN);
+            EC_WRITE_U16(cur_data + 6, datagram->data_size & 0x7FF);
+            EC_WRITE_U16(cur_data + 8, 0x0000);
+            follows_word = cur_data + 6;
+            cur_data += EC_DATAGRAM_HEADER_SIZE;
+
+            // EtherCAT datagram data
+            memcpy(cur_data, datagram->tx_data ? datagram->tx_data :
+                    datagram->data, datagram->data_size);
+            cur_data += datagram->data_size;
+
+            // EtherCAT datagram footer
+            EC_WRITE_U16(cur_data, 0x0000); // reset working counter
+            cur_data += EC_DATAGRAM_FOOTER_SIZE;
+        }
+
+        if (list_empty(&sent_datagrams)) {
+            EC_MASTER_DBG(master, 2, "nothing to send.\n");
+            break;
+        }
+
+        // EtherCAT frame header
+        EC_WRITE_U16(frame_data, ((cur_data - frame_data
+                        - EC_FRAME_HEADER_SIZE) & 0x7FF) | 0x1000);
+
+        // pad frame
+        while (cur_data - frame_data < ETH_ZLEN - ETH_HLEN)
+            EC_WRITE_U8(cur_data++, 0x00);
+
+        EC_MASTER_DBG(master, 2, "frame size: %zu\n", cur_data - frame_data);
+
+        // send frame
+        ec_device_send(device, cur_data - frame_data);
+        /* preamble and inter-frame gap */
+        sent_bytes += ETH_HLEN + cur_data - frame_data + ETH_FCS_LEN + 20;
+#ifdef EC_HAVE_CYCLES
+        cycles_sent = get_cycles();
+#endif
+        jiffies_sent = jiffies;
+
+        // set datagram states and sending timestamps
+        list_for_each_entry_safe(datagram, next, &sent_datagrams, sent) {
+            master->traffic_stats[datagram->traffic_class].datagrams++;
+            master->traffic_stats[datagram->traffic_class].bytes +=
+                datagram->data_size;
+            datagram->state = EC_DATAGRAM_SENT;
+#ifdef EC_HAVE_CYCLES
+            datagram->cycles_sent = cycles_sent;
+#endif
+            datagram->jiffies_sent = jiffies_sent;
+            datagram->app_time_sent = master->app_time;
+            list_del_init(&datagram->sent); // empty list of sent datagrams
+            list_move_tail(&datagram->timeout, &master->timeout_list);
+        }
+
+        frame_count++;
+    }
+
+    // datagrams that were not sent stay queued for the next cycle
+    for (i = 0; i < bin_count; i++) {
+        ec_master_defer_datagrams(master, &frames[i].datagrams);
+    }
+    for (i = 0; i < EC_TRAFFIC_CLASS_COUNT; i++) {
+        ec_master_defer_datagrams(master, &classes[i]);
+    }
+
+#ifdef EC_HAVE_CYCLES
+    if (unlikely(master->debug_level > 1)) {
+        cycles_end = get_cycles();
+        EC_MASTER_DBG(master, 0, "%s()"
+                " sent %u frames in %uus.\n", __func__, frame_count,
+               (unsigned int) (cycles_end - cycles_start) * 1000 / cpu_khz);
+    }
+#endif
+    return sent_bytes;
+}
+
+/*****************************************************************************/
+
+/** Finds the slave with the given station address.
+ *
+ * \return Slave, or NULL, if no slave with the station address exists.
+ */
+static inline ec_slave_t *ec_master_find_station(
+        ec_master_t *master, /**< EtherCAT master */
+        uint16_t station_address /**< Station address. */
+        )
+{
+    ec_slave_t *slave;
+
+    if (likely(master->station_slaves)) {
+        if (station_address < master->station_slave_count) {
+            return master->station_slaves[station_address];
+        }
+        return NULL;
+    }
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count;
+            slave++) {
+        if (slave->station_address == station_address) {
+            return slave;
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/** Processes a received frame.
  *
  * This function is called by the network driver for every received frame.
  *
@@ -1401,17 +1921,13 @@ void ec_master_receive_datagrams(
             return;
         }
 
-        // search for matching datagram in the queue
-        matched = 0;
-        list_for_each_entry(datagram, &master->datagram_queue, queue) {
-            if (datagram->index == datagram_index
-                && datagram->state == EC_DATAGRAM_SENT
-                && datagram->type == datagram_type
-                && datagram->data_size == data_size) {
-                matched = 1;
-                break;
-            }
-        }
+        // look up the matching datagram in the table of sent datagrams
+        datagram = master->sent_datagrams[datagram_index];
+        matched = datagram
+            && datagram->index == datagram_index
+            && datagram->state == EC_DATAGRAM_SENT
+            && datagram->type == datagram_type
+            && datagram->data_size == data_size;
 
         // no matching datagram was found
         if (!matched) {
@@ -1444,12 +1960,8 @@ void ec_master_receive_datagrams(
                 datagram_wc = EC_READ_U16(cur_data + data_size);
                 if (datagram_wc) {
                     if (master->slaves != NULL) {
-                        for (slave = master->slaves; slave < master->slaves + master->slave_count; slave++) {
-                            if (slave->station_address == datagram_slave_addr) {
-                                break;
-                            }
-                        }
-                        if (slave->station_address == datagram_slave_addr) {
+                        slave = ec_master_find_station(master, datagram_slave_addr);
+                        if (slave) {
                             if (slave->configured_tx_mailbox_offset != 0) {
                                 if (datagram_offset_addr == slave->configured_tx_mailbox_offset) {
                                     if (slave->valid_mbox_data) {
@@ -1579,6 +2091,8 @@ void ec_master_receive_datagrams(
         // dequeue the received datagram
         datagram->state = EC_DATAGRAM_RECEIVED;
         list_del_init(&datagram->queue);
+        list_del_init(&datagram->timeout);
+        ec_master_release_index(master, datagram_index);
     }
 }
 
@@ -1831,11 +2345,22 @@ static inline void set_normal_priority(struct task_struct *p, int nice)
 #endif
 }
 
-/*****************************************************************************/
-
-/** Execute slave FSMs.
- */
-void ec_master_exec_slave_fsms(
+/* compatibility for realtime priority */
+static inline void set_fifo_priority(struct task_struct *p)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 9, 0)
+    sched_set_fifo(p);
+#else
+    struct sched_param param = { .sched_priority = MAX_RT_PRIO / 2 };
+    sched_setscheduler(p, SCHED_FIFO, &param);
+#endif
+}
+
+/*****************************************************************************/
+
+/** Execute slave FSMs.
+ */
+void ec_master_exec_slave_fsms(
         ec_master_t *master /**< EtherCAT master. */
         )
 {
@@ -1863,10 +2388,8 @@ void ec_master_exec_slave_fsms(
 
         datagram = ec_master_get_external_datagram(master);
         if (!datagram) {
-            // no free datagrams at the moment
-            EC_MASTER_WARN(master, "No free datagram during"
-                    " slave FSM execution. This is a bug!\n");
-            continue;
+            // no free datagrams at the moment, wait for the RT side
+            return;
         }
 
 #if DEBUG_INJECT
@@ -1882,7 +2405,7 @@ void ec_master_exec_slave_fsms(
                         datagram->name);
 #endif
                 master->ext_ring_idx_fsm =
-                    (master->ext_ring_idx_fsm + 1) % EC_EXT_RING_SIZE;
+                    (master->ext_ring_idx_fsm + 1) % master->ext_ring_size;
             }
         }
         else {
@@ -1896,16 +2419,19 @@ void ec_master_exec_slave_fsms(
         }
     }
 
-    while (master->fsm_exec_count < EC_EXT_RING_SIZE / 2
+    while (master->fsm_exec_count < master->ext_ring_size / 2
             && count < master->slave_count) {
 
         if (ec_fsm_slave_is_ready(&master->fsm_slave->fsm)) {
             datagram = ec_master_get_external_datagram(master);
+            if (!datagram) {
+                return;
+            }
 
             if (ec_fsm_slave_exec(&master->fsm_slave->fsm, datagram)) {
                 if (datagram->state != EC_DATAGRAM_INVALID) {
                     master->ext_ring_idx_fsm =
-                        (master->ext_ring_idx_fsm + 1) % EC_EXT_RING_SIZE;
+                        (master->ext_ring_idx_fsm + 1) % master->ext_ring_size;
                 }
                 list_add_tail(&master->fsm_slave->fsm.list,
                         &master->fsm_exec_list);
@@ -1930,6 +2456,184 @@ void ec_master_exec_slave_fsms(
 
 /*****************************************************************************/
 
+/** Queues the completion of a request, if it has finished since it was
+ * issued.
+ *
+ * If the completion queue is full, the request is left as it is and will be
+ * reported by a later call.
+ */
+static void ec_master_reap_request(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_completion_type_t type, /**< Request type. */
+        unsigned int config_index, /**< Configuration index. */
+        unsigned int request_index, /**< Request index. */
+        uint8_t *notify, /**< Notification flag of the request. */
+        const ec_internal_request_state_t *state /**< Request state. */
+        )
+{
+    ec_ioctl_completion_t *completion;
+
+    if (!*notify) {
+        return;
+    }
+
+    smp_rmb();
+    if (*state != EC_INT_REQUEST_SUCCESS
+            && *state != EC_INT_REQUEST_FAILURE) {
+        return;
+    }
+
+    if (master->completion_head - master->completion_tail
+            >= EC_IOCTL_COMPLETION_QUEUE_SIZE) {
+        return;
+    }
+
+    completion = &master->completions[
+        master->completion_head % EC_IOCTL_COMPLETION_QUEUE_SIZE];
+    completion->config_index = config_index;
+    completion->request_index = request_index;
+    completion->type = type;
+    completion->state = ec_request_state_translation_table[*state];
+    master->completion_head++;
+    *notify = 0;
+}
+
+/*****************************************************************************/
+
+/** Queues the completions of all requests, that finished since the last
+ * call, and wakes up the readers of the completion queue.
+ *
+ * Only the requests of the slave configurations are reported. The state
+ * machines mark a configuration, when they finish one of its requests (see
+ * ec_slave_config_mark_completion()), so that only the marked configurations
+ * are looked at. Finished operations of the acyclic queue are completed as
+ * well. This has to be called with the master_sem held.
+ */
+void ec_master_reap_completions(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    unsigned int head = master->completion_head, i, j;
+    ec_slave_config_t *sc;
+
+    if (ec_acyclic_queue_reap(&master->acyclic_queue)) {
+        wake_up_interruptible(&master->completion_queue);
+    }
+
+    if (!master->completions_enabled
+            || !READ_ONCE(master->completion_pending)) {
+        return;
+    }
+
+    WRITE_ONCE(master->completion_pending, 0);
+    smp_mb();
+
+    for (i = 0; i < master->config_table.count; i++) {
+        sc = ec_index_table_get(&master->config_table, i);
+
+        if (!READ_ONCE(sc->completion_pending)) {
+            continue;
+        }
+
+        WRITE_ONCE(sc->completion_pending, 0);
+        smp_mb();
+
+        for (j = 0; j < sc->sdo_request_table.count; j++) {
+            ec_sdo_request_t *req =
+                ec_index_table_get(&sc->sdo_request_table, j);
+            ec_master_reap_request(master, EC_IOCTL_COMPLETION_SDO, i, j,
+                    &req->notify, &req->state);
+        }
+
+        for (j = 0; j < sc->soe_request_table.count; j++) {
+            ec_soe_request_t *req =
+                ec_index_table_get(&sc->soe_request_table, j);
+            ec_master_reap_request(master, EC_IOCTL_COMPLETION_SOE, i, j,
+                    &req->notify, &req->state);
+        }
+
+        for (j = 0; j < sc->foe_request_table.count; j++) {
+            ec_foe_request_t *req =
+                ec_index_table_get(&sc->foe_request_table, j);
+            ec_master_reap_request(master, EC_IOCTL_COMPLETION_FOE, i, j,
+                    &req->notify, &req->state);
+        }
+
+        for (j = 0; j < sc->reg_request_table.count; j++) {
+            ec_reg_request_t *reg =
+                ec_index_table_get(&sc->reg_request_table, j);
+            ec_master_reap_request(master, EC_IOCTL_COMPLETION_REG, i, j,
+                    &reg->notify, &reg->state);
+        }
+
+        for (j = 0; j < sc->voe_handler_table.count; j++) {
+            ec_voe_handler_t *voe =
+                ec_index_table_get(&sc->voe_handler_table, j);
+            ec_master_reap_request(master, EC_IOCTL_COMPLETION_VOE, i, j,
+                    &voe->notify, &voe->request_state);
+        }
+    }
+
+    if (master->completion_head - master->completion_tail
+            >= EC_IOCTL_COMPLETION_QUEUE_SIZE) {
+        // the remaining requests are reported by a later call
+        WRITE_ONCE(master->completion_pending, 1);
+        for (i = 0; i < master->config_table.count; i++) {
+            sc = ec_index_table_get(&master->config_table, i);
+            WRITE_ONCE(sc->completion_pending, 1);
+        }
+    }
+
+    if (master->completion_head != head) {
+        wake_up_interruptible(&master->completion_queue);
+    }
+}
+
+/*****************************************************************************/
+
+/** Dequeues request completions.
+ *
+ * This has to be called with the master_sem held.
+ *
+ * \return Number of dequeued completions.
+ */
+unsigned int ec_master_read_completions(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_completion_t *completions, /**< Destination. */
+        unsigned int max_count /**< Maximum number of completions. */
+        )
+{
+    unsigned int count = 0;
+
+    while (count < max_count
+            && master->completion_tail != master->completion_head) {
+        completions[count++] = master->completions[
+            master->completion_tail % EC_IOCTL_COMPLETION_QUEUE_SIZE];
+        master->completion_tail++;
+    }
+
+    return count;
+}
+
+/*****************************************************************************/
+
+/** Checks for unread request completions.
+ *
+ * This has to be called with the master_sem held.
+ *
+ * \return Non-zero, if there are completions to read, either from the
+ * completion queue or from the acyclic queue.
+ */
+int ec_master_completions_pending(
+        const ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    return READ_ONCE(master->completion_head) != master->completion_tail
+        || ec_acyclic_queue_pending(&master->acyclic_queue);
+}
+
+/*****************************************************************************/
+
 /** Master kernel thread function for IDLE phase.
  */
 static int ec_master_idle_thread(void *priv_data)
@@ -1953,6 +2657,8 @@ static int ec_master_idle_thread(void *priv_data)
         ecrt_master_receive(master);
         ec_lock_up(&master->io_sem);
 
+        ec_master_prepare_slave_info(master);
+
         // execute master & slave state machines
         if (ec_lock_down_interruptible(&master->master_sem)) {
             break;
@@ -1962,6 +2668,8 @@ static int ec_master_idle_thread(void *priv_data)
 
         // idle thread will still be in charge of calling the slave requests
         ec_master_exec_slave_fsms(master);
+        ec_master_reap_completions(master);
+        ec_master_update_slave_info(master);
 
         ec_lock_up(&master->master_sem);
 
@@ -2032,6 +2740,8 @@ static int ec_master_operation_thread(void *priv_data)
             // output statistics
             ec_master_output_stats(master);
 
+            ec_master_prepare_slave_info(master);
+
             // execute master & slave state machines
             if (ec_lock_down_interruptible(&master->master_sem)) {
                 break;
@@ -2049,6 +2759,8 @@ static int ec_master_operation_thread(void *priv_data)
             if (!master->rt_slave_requests || !master->rt_slaves_available) {
                 ec_master_exec_slave_fsms(master);
             }
+            ec_master_reap_completions(master);
+            ec_master_update_slave_info(master);
 
             ec_lock_up(&master->master_sem);
         }
@@ -2074,6 +2786,211 @@ static int ec_master_operation_thread(void *priv_data)
 
 /*****************************************************************************/
 
+/** Starts the cycle thread.
+ *
+ * The thread executes the operations \a ops once for each cycle posted to
+ * the cycle ring. The master takes ownership of \a ops, which has to be
+ * allocated with kmalloc().
+ *
+ * The thread busy-waits for cycles, so it has to be bound to a CPU, which
+ * should be isolated from the scheduler. Otherwise, the wake-up latency
+ * after an idle period grows by up to EC_CYCLE_THREAD_SLEEP_US.
+ *
+ * Has to be called with the master_sem held, so that the domains referenced
+ * by \a ops can not vanish before the thread is started.
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
+ */
+int ec_master_cycle_thread_start(
+        ec_master_t *master, /**< EtherCAT master */
+        int cpu, /**< CPU to bind the thread to. */
+        ec_cycle_op_t *ops, /**< Operations to execute per cycle. */
+        unsigned int op_count /**< Number of operations. */
+        )
+{
+    struct task_struct *thread;
+
+    if (!master->active) {
+        EC_MASTER_ERR(master, "Cycle thread needs an active master!\n");
+        kfree(ops);
+        return -EPERM;
+    }
+
+    if (master->cycle_thread) {
+        EC_MASTER_ERR(master, "Cycle thread already running!\n");
+        kfree(ops);
+        return -EBUSY;
+    }
+
+    if (cpu < 0 || cpu >= nr_cpu_ids || !cpu_online(cpu)) {
+        EC_MASTER_ERR(master, "Invalid CPU %i for cycle thread.\n", cpu);
+        kfree(ops);
+        return -EINVAL;
+    }
+
+    master->cycle_ops = ops;
+    master->cycle_op_count = op_count;
+    master->cycle_ring->tail = master->cycle_ring->head;
+
+    thread = kthread_create(ec_master_cycle_thread, master,
+            "EtherCAT-CYC%u", master->index);
+    if (IS_ERR(thread)) {
+        int err = (int) PTR_ERR(thread);
+        EC_MASTER_ERR(master, "Failed to start cycle thread (error %i)!\n",
+                err);
+        master->cycle_ops = NULL;
+        master->cycle_op_count = 0;
+        kfree(ops);
+        return err;
+    }
+
+    kthread_bind(thread, cpu);
+    set_fifo_priority(thread);
+
+    master->cycle_thread = thread;
+    WRITE_ONCE(master->cycle_ring->running, 1);
+    wake_up_process(thread);
+
+    EC_MASTER_INFO(master, "Started cycle thread on CPU %i.\n", cpu);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Stops the cycle thread.
+ *
+ * The thread is detached under the io_sem first, so that it does not
+ * execute any more cycles. Must not be called with the io_sem held,
+ * because the thread may be waiting for it.
+ */
+void ec_master_cycle_thread_stop(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    struct task_struct *thread;
+    ec_cycle_op_t *ops;
+
+    ec_lock_down(&master->io_sem);
+    thread = master->cycle_thread;
+    ops = master->cycle_ops;
+    master->cycle_thread = NULL;
+    master->cycle_ops = NULL;
+    master->cycle_op_count = 0;
+    WRITE_ONCE(master->cycle_ring->running, 0);
+    ec_lock_up(&master->io_sem);
+
+    if (!thread) {
+        return;
+    }
+
+    kthread_stop(thread);
+    kfree(ops);
+
+    EC_MASTER_INFO(master, "Cycle thread exited.\n");
+}
+
+/*****************************************************************************/
+
+/** Executes the operations of one cycle of the cycle thread.
+ *
+ * Unlike ecrt_master_cycle(), sending and receiving use the callbacks of the
+ * master, like the ioctl() interface does.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_master_cycle_thread_ops(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    ec_cycle_op_t *op;
+    int ret;
+
+    for (op = master->cycle_ops;
+            op < master->cycle_ops + master->cycle_op_count; op++) {
+        if (op->type == EC_CYCLE_RECEIVE && master->receive_cb) {
+            master->receive_cb(master->cb_data);
+        } else if (op->type == EC_CYCLE_SEND && master->send_cb) {
+            master->send_cb(master->cb_data);
+        } else if ((ret = ecrt_master_cycle(master, op, 1))) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Master kernel thread function for the cycle ring.
+ *
+ * Busy-waits for cycles posted to the cycle ring, so that the latency only
+ * depends on the cache line transfer between the CPUs. The thread is bound
+ * to the CPU given to ec_master_cycle_thread_start(). As a realtime thread
+ * would starve all other tasks on a CPU, that is not isolated, it sleeps
+ * for EC_CYCLE_THREAD_SLEEP_US after EC_CYCLE_THREAD_SPIN_POLLS polls of an
+ * empty ring.
+ *
+ * Only the io_sem is taken for a cycle, which is not used by any other
+ * thread while the master is active, so that informational ioctls holding
+ * the master_sem do not delay the cycles.
+ */
+static int ec_master_cycle_thread(void *priv_data)
+{
+    ec_master_t *master = (ec_master_t *) priv_data;
+    ec_ioctl_cycle_ring_t *ring = master->cycle_ring;
+    ec_ioctl_cycle_slot_t *slot;
+    uint32_t tail = ring->tail;
+    unsigned int i, idle_polls = 0;
+
+    EC_MASTER_DBG(master, 1, "Cycle thread running.\n");
+
+    while (!kthread_should_stop()) {
+        if (READ_ONCE(ring->head) == tail) {
+            if (++idle_polls < EC_CYCLE_THREAD_SPIN_POLLS) {
+                cpu_relax();
+            } else {
+                usleep_range(EC_CYCLE_THREAD_SLEEP_US,
+                        2 * EC_CYCLE_THREAD_SLEEP_US);
+            }
+            continue;
+        }
+        idle_polls = 0;
+
+        smp_rmb();
+        slot = &ring->slots[tail % EC_IOCTL_CYCLE_RING_SIZE];
+
+        ec_lock_down(&master->io_sem);
+
+        if (master->cycle_thread != current) {
+            // detached by ec_master_cycle_thread_stop()
+            ec_lock_up(&master->io_sem);
+            usleep_range(EC_CYCLE_THREAD_SLEEP_US,
+                    2 * EC_CYCLE_THREAD_SLEEP_US);
+            continue;
+        }
+
+        for (i = 0; i < master->cycle_op_count; i++) {
+            if (master->cycle_ops[i].type == EC_CYCLE_APPLICATION_TIME ||
+                    master->cycle_ops[i].type ==
+                    EC_CYCLE_SYNC_REFERENCE_CLOCK_TO) {
+                master->cycle_ops[i].time = slot->app_time;
+            }
+        }
+
+        slot->result = ec_master_cycle_thread_ops(master);
+        ec_lock_up(&master->io_sem);
+
+        smp_wmb();
+        WRITE_ONCE(ring->tail, ++tail);
+    }
+
+    EC_MASTER_DBG(master, 1, "Cycle thread exiting...\n");
+    return 0;
+}
+
+/*****************************************************************************/
+
 #ifdef EC_EOE
 /** Starts Ethernet over EtherCAT processing on demand.
  */
@@ -2375,31 +3292,11 @@ unsigned int ec_master_config_count(
         const ec_master_t *master /**< EtherCAT master. */
         )
 {
-    const ec_slave_config_t *sc;
-    unsigned int count = 0;
-
-    list_for_each_entry(sc, &master->configs, list) {
-        count++;
-    }
-
-    return count;
+    return master->config_table.count;
 }
 
 /*****************************************************************************/
 
-/** Common implementation for ec_master_get_config()
- * and ec_master_get_config_const().
- */
-#define EC_FIND_CONFIG \
-    do { \
-        list_for_each_entry(sc, &master->configs, list) { \
-            if (pos--) \
-                continue; \
-            return sc; \
-        } \
-        return NULL; \
-    } while (0)
-
 /** Get a slave configuration via its position in the list.
  *
  * \return Slave configuration or \a NULL.
@@ -2409,8 +3306,7 @@ ec_slave_config_t *ec_master_get_config(
         unsigned int pos /**< List position. */
         )
 {
-    ec_slave_config_t *sc;
-    EC_FIND_CONFIG;
+    return ec_index_table_get(&master->config_table, pos);
 }
 
 /** Get a slave configuration via its position in the list.
@@ -2424,8 +3320,7 @@ const ec_slave_config_t *ec_master_get_config_const(
         unsigned int pos /**< List position. */
         )
 {
-    const ec_slave_config_t *sc;
-    EC_FIND_CONFIG;
+    return ec_index_table_get(&master->config_table, pos);
 }
 
 /*****************************************************************************/
@@ -2438,32 +3333,11 @@ unsigned int ec_master_domain_count(
         const ec_master_t *master /**< EtherCAT master. */
         )
 {
-    const ec_domain_t *domain;
-    unsigned int count = 0;
-
-    list_for_each_entry(domain, &master->domains, list) {
-        count++;
-    }
-
-    return count;
+    return master->domain_table.count;
 }
 
 /*****************************************************************************/
 
-/** Common implementation for ec_master_find_domain() and
- * ec_master_find_domain_const().
- */
-#define EC_FIND_DOMAIN \
-    do { \
-        list_for_each_entry(domain, &master->domains, list) { \
-            if (index--) \
-                continue; \
-            return domain; \
-        } \
-        \
-        return NULL; \
-    } while (0)
-
 /** Get a domain via its position in the list.
  *
  * \return Domain pointer, or \a NULL if not found.
@@ -2473,8 +3347,7 @@ ec_domain_t *ec_master_find_domain(
         unsigned int index /**< Domain index. */
         )
 {
-    ec_domain_t *domain;
-    EC_FIND_DOMAIN;
+    return ec_index_table_get(&master->domain_table, index);
 }
 
 /** Get a domain via its position in the list.
@@ -2488,8 +3361,7 @@ const ec_domain_t *ec_master_find_domain_const(
         unsigned int index /**< Domain index. */
         )
 {
-    const ec_domain_t *domain;
-    EC_FIND_DOMAIN;
+    return ec_index_table_get(&master->domain_table, index);
 }
 
 /*****************************************************************************/
@@ -2861,6 +3733,13 @@ ec_domain_t *ecrt_master_create_domain_err(
         index = last_domain->index + 1;
     }
 
+    if (ec_index_table_append(&master->domain_table, domain)) {
+        ec_lock_up(&master->master_sem);
+        EC_MASTER_ERR(master, "Failed to allocate domain table!\n");
+        kfree(domain);
+        return ERR_PTR(-ENOMEM);
+    }
+
     ec_domain_init(domain, master, index);
     list_add_tail(&domain->list, &master->domains);
 
@@ -2891,6 +3770,58 @@ int ecrt_master_setup_domain_memory(ec_master_t *master)
 
 /*****************************************************************************/
 
+/** Assigns the phases of domains with automatic phase selection.
+ *
+ * Each such domain gets the phase of its period, where the least process
+ * data of the other domains are exchanged, so that slow domains are spread
+ * across the cycles. Two domains share a cycle, if their phases are equal
+ * modulo the greatest common divisor of their periods. The cycle countdown
+ * of every domain is started, so that the first application cycle after
+ * activation has the number zero.
+ *
+ * The master_sem has to be held.
+ */
+static void ec_master_assign_domain_phases(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    ec_domain_t *domain, *other;
+    unsigned int phase, divisor;
+    size_t load, best_load;
+
+    list_for_each_entry(domain, &master->domains, list) {
+        if (domain->phase >= 0) {
+            domain->countdown = domain->phase;
+            continue;
+        }
+
+        best_load = (size_t) -1;
+        for (phase = 0; phase < domain->period; phase++) {
+            load = 0;
+            list_for_each_entry(other, &master->domains, list) {
+                if (other->phase < 0) {
+                    continue;
+                }
+                divisor = gcd(domain->period, other->period);
+                if (phase % divisor == other->phase % divisor) {
+                    load += other->data_size;
+                }
+            }
+
+            if (load < best_load) {
+                best_load = load;
+                domain->phase = phase;
+            }
+        }
+
+        domain->countdown = domain->phase;
+        EC_MASTER_DBG(master, 1, "Domain %u: period %u, phase %i.\n",
+                domain->index, domain->period, domain->phase);
+    }
+}
+
+/*****************************************************************************/
+
 int ecrt_master_activate(ec_master_t *master)
 {
     uint32_t domain_offset;
@@ -2909,16 +3840,25 @@ int ecrt_master_activate(ec_master_t *master)
 
     ec_lock_down(&master->master_sem);
 
+    ec_master_assign_domain_phases(master);
+
     // finish all domains
     domain_offset = 0;
     list_for_each_entry(domain, &master->domains, list) {
+        ret = ec_domain_optimize_layout(domain);
+        if (ret < 0) {
+            ec_lock_up(&master->master_sem);
+            EC_MASTER_ERR(master, "Failed to optimize domain 0x%p!\n",
+                    domain);
+            return ret;
+        }
         ret = ec_domain_finish(domain, domain_offset);
         if (ret < 0) {
             ec_lock_up(&master->master_sem);
             EC_MASTER_ERR(master, "Failed to finish domain 0x%p!\n", domain);
             return ret;
         }
-        domain_offset += domain->data_size;
+        domain_offset += ec_domain_wire_size(domain);
     }
 
     ec_lock_up(&master->master_sem);
@@ -3015,6 +3955,7 @@ void ecrt_master_deactivate(ec_master_t *master)
         return;
     }
 
+    ec_master_cycle_thread_stop(master);
     ec_master_thread_stop(master);
 #ifdef EC_EOE
     ec_master_eoe_stop(master);
@@ -3063,7 +4004,13 @@ void ecrt_master_deactivate(ec_master_t *master)
 
 /*****************************************************************************/
 
-size_t ecrt_master_send(ec_master_t *master)
+/** Sends all queued datagrams.
+ *
+ * \return Number of bytes sent on the busiest device.
+ */
+static size_t ec_master_send_queue(
+        ec_master_t *master /**< EtherCAT master */
+        )
 {
     ec_datagram_t *datagram, *n;
     ec_device_index_t dev_idx;
@@ -3085,8 +4032,12 @@ size_t ecrt_master_send(ec_master_t *master)
             list_for_each_entry_safe(datagram, n,
                     &master->datagram_queue, queue) {
                 if (datagram->device_index == dev_idx) {
+                    if (master->sent_datagrams[datagram->index] == datagram) {
+                        ec_master_release_index(master, datagram->index);
+                    }
                     datagram->state = EC_DATAGRAM_ERROR;
                     list_del_init(&datagram->queue);
+                    list_del_init(&datagram->timeout);
                 }
             }
 
@@ -3112,6 +4063,427 @@ size_t ecrt_master_send(ec_master_t *master)
 
 /*****************************************************************************/
 
+size_t ecrt_master_send(ec_master_t *master)
+{
+    size_t sent_bytes = ec_master_send_queue(master);
+    ec_domain_t *domain;
+
+    // a new application cycle starts
+    list_for_each_entry(domain, &master->domains, list) {
+        if (domain->countdown) {
+            domain->countdown--;
+        } else {
+            domain->countdown = domain->period - 1;
+        }
+    }
+
+    return sent_bytes;
+}
+
+/*****************************************************************************/
+
+/** Copies a string to the slave information.
+ */
+static void ec_master_info_strcpy(
+        char *target, /**< Target. */
+        const char *source /**< Source. */
+        )
+{
+    if (source) {
+        strncpy(target, source, EC_IOCTL_STRING_SIZE);
+        target[EC_IOCTL_STRING_SIZE - 1] = 0;
+    } else {
+        target[0] = 0;
+    }
+}
+
+/*****************************************************************************/
+
+/** Fills the information about a slave, as returned by EC_IOCTL_SLAVE.
+ */
+static void ec_master_fill_slave_info(
+        const ec_slave_t *slave, /**< EtherCAT slave. */
+        ec_ioctl_slave_t *data /**< Slave information. */
+        )
+{
+    int i;
+
+    data->position = slave - slave->master->slaves;
+    data->device_index = slave->device_index;
+    data->alias = slave->effective_alias;
+    if (slave->sii_image) {
+        const ec_sii_t *sii = &slave->sii_image->sii;
+
+        data->vendor_id = sii->vendor_id;
+        data->product_code = sii->product_code;
+        data->revision_number = sii->revision_number;
+        data->serial_number = sii->serial_number;
+        data->boot_rx_mailbox_offset = sii->boot_rx_mailbox_offset;
+        data->boot_rx_mailbox_size = sii->boot_rx_mailbox_size;
+        data->boot_tx_mailbox_offset = sii->boot_tx_mailbox_offset;
+        data->boot_tx_mailbox_size = sii->boot_tx_mailbox_size;
+        data->std_rx_mailbox_offset = sii->std_rx_mailbox_offset;
+        data->std_rx_mailbox_size = sii->std_rx_mailbox_size;
+        data->std_tx_mailbox_offset = sii->std_tx_mailbox_offset;
+        data->std_tx_mailbox_size = sii->std_tx_mailbox_size;
+        data->mailbox_protocols = sii->mailbox_protocols;
+        data->has_general_category = sii->has_general;
+        data->coe_details = sii->coe_details;
+        data->general_flags = sii->general_flags;
+        data->current_on_ebus = sii->current_on_ebus;
+        data->sync_count = sii->sync_count;
+        data->sii_nwords = slave->sii_image->nwords;
+        ec_master_info_strcpy(data->group, sii->group);
+        ec_master_info_strcpy(data->image, sii->image);
+        ec_master_info_strcpy(data->order, sii->order);
+        ec_master_info_strcpy(data->name, sii->name);
+    }
+    else {
+        data->vendor_id = 0x00000000;
+        data->product_code = 0x00000000;
+        data->revision_number = 0x00000000;
+        data->serial_number = 0x00000000;
+        data->boot_rx_mailbox_offset = 0x0000;
+        data->boot_rx_mailbox_size = 0x0000;
+        data->boot_tx_mailbox_offset = 0x0000;
+        data->boot_tx_mailbox_size = 0x0000;
+        data->std_rx_mailbox_offset = 0x0000;
+        data->std_rx_mailbox_size = 0x0000;
+        data->std_tx_mailbox_offset = 0x0000;
+        data->std_tx_mailbox_size = 0x0000;
+        data->mailbox_protocols = 0;
+        data->has_general_category = 0;
+        data->coe_details.enable_pdo_assign = 0;
+        data->coe_details.enable_pdo_configuration = 0;
+        data->coe_details.enable_sdo = 0;
+        data->coe_details.enable_sdo_complete_access = 0;
+        data->coe_details.enable_sdo_info = 0;
+        data->coe_details.enable_upload_at_startup = 0;
+        data->general_flags.enable_not_lrw = 0;
+        data->general_flags.enable_safeop = 0;
+        data->current_on_ebus = 0;
+        data->sync_count = 0;
+        data->sii_nwords = 0;
+        ec_master_info_strcpy(data->group, "");
+        ec_master_info_strcpy(data->image, "");
+        ec_master_info_strcpy(data->order, "");
+        ec_master_info_strcpy(data->name, "");
+    }
+
+    for (i = 0; i < EC_MAX_PORTS; i++) {
+        data->ports[i].desc = slave->ports[i].desc;
+        data->ports[i].link.link_up = slave->ports[i].link.link_up;
+        data->ports[i].link.loop_closed = slave->ports[i].link.loop_closed;
+        data->ports[i].link.signal_detected =
+            slave->ports[i].link.signal_detected;
+        data->ports[i].link.bypassed = slave->ports[i].link.bypassed;
+        data->ports[i].receive_time = slave->ports[i].receive_time;
+        if (slave->ports[i].next_slave) {
+            data->ports[i].next_slave =
+                slave->ports[i].next_slave->ring_position;
+        } else {
+            data->ports[i].next_slave = 0xffff;
+        }
+        data->ports[i].delay_to_next_dc = slave->ports[i].delay_to_next_dc;
+    }
+    data->upstream_port = slave->upstream_port;
+    data->fmmu_bit = slave->base_fmmu_bit_operation;
+    data->dc_supported = slave->base_dc_supported;
+    data->dc_range = slave->base_dc_range;
+    data->has_dc_system_time = slave->has_dc_system_time;
+    data->transmission_delay = slave->transmission_delay;
+    data->al_state = slave->current_state;
+    data->error_flag = slave->error_flag;
+    data->scan_required = slave->scan_required;
+    data->sdo_count = ec_slave_sdo_count(slave);
+    data->ready = ec_fsm_slave_is_ready(&slave->fsm);
+}
+
+/*****************************************************************************/
+
+/** Updates an entry of the published slave information.
+ */
+static void ec_master_publish_slave_info(
+        ec_slave_info_entry_t *entry, /**< Slave information entry. */
+        const ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    /* Readers spin while the entry is written, so the writer must not be
+     * preempted. */
+    preempt_disable();
+    write_seqcount_begin(&entry->seq);
+    ec_master_fill_slave_info(slave, &entry->info);
+    write_seqcount_end(&entry->seq);
+    preempt_enable();
+}
+
+/*****************************************************************************/
+
+/** Checks, if the state of a slave differs from its published information.
+ *
+ * Only the frequently changing members are compared, the others are
+ * refreshed round-robin.
+ *
+ * \return Non-zero, if the entry has to be updated.
+ */
+static int ec_master_slave_info_changed(
+        const ec_ioctl_slave_t *info, /**< Published slave information. */
+        const ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    int i;
+
+    if (info->al_state != slave->current_state
+            || info->error_flag != slave->error_flag
+            || info->scan_required != slave->scan_required
+            || info->ready != ec_fsm_slave_is_ready(&slave->fsm)) {
+        return 1;
+    }
+
+    for (i = 0; i < EC_MAX_PORTS; i++) {
+        if (info->ports[i].link.link_up != slave->ports[i].link.link_up
+                || info->ports[i].link.loop_closed
+                != slave->ports[i].link.loop_closed) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 9, 0)
+
+/** Frees a replaced slave information table after the RCU grace period.
+ */
+static void ec_master_free_slave_info(
+        struct rcu_head *rcu /**< RCU head of the table. */
+        )
+{
+    vfree(container_of(rcu, ec_slave_info_table_t, rcu));
+}
+
+#endif
+
+/*****************************************************************************/
+
+/** Allocates a larger slave information table, if the slaves do not fit into
+ * the published one any more.
+ *
+ * This is called by the master thread without the master_sem held, so that
+ * ec_master_update_slave_info() does not need to allocate memory.
+ */
+static void ec_master_prepare_slave_info(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    unsigned int count = READ_ONCE(master->slave_count), i;
+    const ec_slave_info_table_t *table = master->slave_info;
+    ec_slave_info_table_t *next = master->slave_info_next;
+
+    if (!count || (table && count <= table->size)
+            || (next && count <= next->size)) {
+        return;
+    }
+
+    if (next) {
+        master->slave_info_next = NULL;
+        vfree(next);
+    }
+
+    next = vmalloc(sizeof(ec_slave_info_table_t) +
+            count * sizeof(ec_slave_info_entry_t));
+    if (!next) {
+        EC_MASTER_ERR(master, "Failed to allocate slave information"
+                " table.\n");
+        return;
+    }
+
+    next->size = count;
+    for (i = 0; i < count; i++) {
+        seqcount_init(&next->entries[i].seq);
+    }
+    master->slave_info_next = next;
+}
+
+/*****************************************************************************/
+
+/** Updates the slave information published for EC_IOCTL_SLAVE.
+ *
+ * Entries, whose application-layer state, error flag or link state changed,
+ * are updated at once. All entries are updated after a scan has finished.
+ * Beyond that, up to EC_SLAVE_INFO_UPDATES entries are updated per call in a
+ * round-robin manner, so that the time spent with the master_sem held stays
+ * bounded. If the number of slaves exceeds the table size, the table
+ * prepared by ec_master_prepare_slave_info() is filled completely and
+ * published, and the old one is freed after an RCU grace period. This has to
+ * be called with the master_sem held.
+ */
+void ec_master_update_slave_info(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_slave_info_table_t *table = master->slave_info, *old;
+    unsigned int i;
+
+    if (!table && !master->slave_count) {
+        return;
+    }
+
+    if (!table || master->slave_count > table->size) {
+        old = table;
+        table = master->slave_info_next;
+        if (!table || master->slave_count > table->size) {
+            return; // prepared by the next loop of the master thread
+        }
+        master->slave_info_next = NULL;
+
+        table->count = master->slave_count;
+        for (i = 0; i < table->count; i++) {
+            ec_master_fill_slave_info(master->slaves + i,
+                    &table->entries[i].info);
+        }
+        master->slave_info_pos = 0;
+        master->slave_info_scan_busy = master->scan_busy;
+
+        rcu_assign_pointer(master->slave_info, table);
+        if (old) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 9, 0)
+            kvfree_rcu(old, rcu);
+#else
+            call_rcu(&old->rcu, ec_master_free_slave_info);
+#endif
+        }
+        return;
+    }
+    if (table->count != master->slave_count) {
+        // entries beyond the count stay valid for concurrent readers
+        for (i = table->count; i < master->slave_count; i++) {
+            ec_master_publish_slave_info(&table->entries[i],
+                    master->slaves + i);
+        }
+        smp_wmb();
+        table->count = master->slave_count;
+    }
+
+    if (master->slave_info_scan_busy != master->scan_busy) {
+        master->slave_info_scan_busy = master->scan_busy;
+        if (!master->scan_busy) {
+            for (i = 0; i < table->count; i++) {
+                ec_master_publish_slave_info(&table->entries[i],
+                        master->slaves + i);
+            }
+            return;
+        }
+    }
+
+    for (i = 0; i < table->count; i++) {
+        if (ec_master_slave_info_changed(&table->entries[i].info,
+                    master->slaves + i)) {
+            ec_master_publish_slave_info(&table->entries[i],
+                    master->slaves + i);
+        }
+    }
+
+    for (i = 0; i < EC_SLAVE_INFO_UPDATES && i < table->count; i++) {
+        if (master->slave_info_pos >= table->count) {
+            master->slave_info_pos = 0;
+        }
+        ec_master_publish_slave_info(
+                &table->entries[master->slave_info_pos],
+                master->slaves + master->slave_info_pos);
+        master->slave_info_pos++;
+    }
+}
+
+/*****************************************************************************/
+
+/** Reads the published information about a slave.
+ *
+ * Does not take any lock, see ec_master_update_slave_info().
+ *
+ * \return Zero on success, otherwise -EINVAL.
+ */
+int ec_master_read_slave_info(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint16_t position, /**< Slave position. */
+        ec_ioctl_slave_t *data /**< Slave information. */
+        )
+{
+    const ec_slave_info_table_t *table;
+    const ec_slave_info_entry_t *entry;
+    unsigned int seq;
+    int ret = -EINVAL;
+
+    rcu_read_lock();
+
+    table = rcu_dereference(master->slave_info);
+    if (table && position < table->count) {
+        smp_rmb();
+        entry = &table->entries[position];
+        do {
+            seq = read_seqcount_begin(&entry->seq);
+            *data = entry->info;
+        } while (read_seqcount_retry(&entry->seq, seq));
+        ret = 0;
+    }
+
+    rcu_read_unlock();
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Publishes the master and link states in the state page.
+ */
+static void ec_master_publish_state(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    ec_ioctl_state_page_t *page = master->state_page;
+    unsigned int dev_idx;
+
+    page->master_seq++;
+    smp_wmb();
+
+    page->num_devices = ec_master_num_devices(master);
+    ecrt_master_state(master, &page->master_state);
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
+            dev_idx++) {
+        ecrt_master_link_state(master, dev_idx, &page->link_states[dev_idx]);
+    }
+
+    smp_wmb();
+    page->master_seq++;
+}
+
+/*****************************************************************************/
+
+/** Publishes the state of a domain in the state page.
+ *
+ * Domains with an index beyond EC_IOCTL_STATE_PAGE_DOMAINS are not published.
+ */
+void ec_master_publish_domain_state(
+        ec_master_t *master, /**< EtherCAT master */
+        const ec_domain_t *domain /**< Domain. */
+        )
+{
+    ec_ioctl_state_page_t *page = master->state_page;
+
+    if (domain->index >= EC_IOCTL_STATE_PAGE_DOMAINS) {
+        return;
+    }
+
+    page->domains[domain->index].seq++;
+    smp_wmb();
+    ecrt_domain_state(domain, &page->domains[domain->index].state);
+    smp_wmb();
+    page->domains[domain->index].seq++;
+}
+
+/*****************************************************************************/
+
 void ecrt_master_receive(ec_master_t *master)
 {
     unsigned int dev_idx;
@@ -3124,42 +4496,55 @@ void ecrt_master_receive(ec_master_t *master)
     }
     ec_master_update_device_stats(master);
 
-    // dequeue all datagrams that timed out
-    list_for_each_entry_safe(datagram, next, &master->datagram_queue, queue) {
-        if (datagram->state != EC_DATAGRAM_SENT) continue;
+    /* dequeue all datagrams that timed out. The timeout list is ordered by
+     * sending time, so the search stops at the first datagram that is not
+     * due yet. */
+    list_for_each_entry_safe(datagram, next, &master->timeout_list,
+            timeout) {
+        if (datagram->state != EC_DATAGRAM_SENT) {
+            // re-queued or re-initialized since sending
+            list_del_init(&datagram->timeout);
+            continue;
+        }
 
 #ifdef EC_HAVE_CYCLES
         if (master->devices[EC_DEVICE_MAIN].cycles_poll -
-                datagram->cycles_sent > timeout_cycles) {
+                datagram->cycles_sent <= timeout_cycles) {
 #else
         if (master->devices[EC_DEVICE_MAIN].jiffies_poll -
-                datagram->jiffies_sent > timeout_jiffies) {
+                datagram->jiffies_sent <= timeout_jiffies) {
 #endif
-            list_del_init(&datagram->queue);
-            datagram->state = EC_DATAGRAM_TIMED_OUT;
-            master->stats.timeouts++;
+            break;
+        }
+
+        list_del_init(&datagram->timeout);
+        list_del_init(&datagram->queue);
+        ec_master_release_index(master, datagram->index);
+        datagram->state = EC_DATAGRAM_TIMED_OUT;
+        master->stats.timeouts++;
 
 #ifdef EC_RT_SYSLOG
-            ec_master_output_stats(master);
+        ec_master_output_stats(master);
 
-            if (unlikely(master->debug_level > 0)) {
-                unsigned int time_us;
+        if (unlikely(master->debug_level > 0)) {
+            unsigned int time_us;
 #ifdef EC_HAVE_CYCLES
-                time_us = (unsigned int)
-                    (master->devices[EC_DEVICE_MAIN].cycles_poll -
-                        datagram->cycles_sent) * 1000 / cpu_khz;
+            time_us = (unsigned int)
+                (master->devices[EC_DEVICE_MAIN].cycles_poll -
+                    datagram->cycles_sent) * 1000 / cpu_khz;
 #else
-                time_us = (unsigned int)
-                    ((master->devices[EC_DEVICE_MAIN].jiffies_poll -
-                            datagram->jiffies_sent) * 1000000 / HZ);
+            time_us = (unsigned int)
+                ((master->devices[EC_DEVICE_MAIN].jiffies_poll -
+                        datagram->jiffies_sent) * 1000000 / HZ);
 #endif
-                EC_MASTER_DBG(master, 0, "TIMED OUT datagram %p,"
-                        " index %02X waited %u us.\n",
-                        datagram, datagram->index, time_us);
-            }
-#endif /* RT_SYSLOG */
+            EC_MASTER_DBG(master, 0, "TIMED OUT datagram %p,"
+                    " index %02X waited %u us.\n",
+                    datagram, datagram->index, time_us);
         }
+#endif /* RT_SYSLOG */
     }
+
+    ec_master_publish_state(master);
 }
 
 /*****************************************************************************/
@@ -3172,31 +4557,86 @@ size_t ecrt_master_send_ext(ec_master_t *master)
 
     list_for_each_entry_safe(datagram, next, &master->ext_datagram_queue,
             queue) {
-        list_del(&datagram->queue);
+        list_del_init(&datagram->queue);
         ec_master_queue_datagram(master, datagram);
     }
     ec_lock_up(&master->ext_queue_sem);
 
-    return ecrt_master_send(master);
+    /* External datagrams do not start a new application cycle. */
+    return ec_master_send_queue(master);
 }
 
 /*****************************************************************************/
 
-/** Same as ecrt_master_slave_config(), but with ERR_PTR() return value.
+int ecrt_master_cycle(ec_master_t *master, const ec_cycle_op_t *ops,
+        unsigned int op_count)
+{
+    unsigned int i;
+
+    for (i = 0; i < op_count; i++) {
+        if ((ops[i].type == EC_CYCLE_DOMAIN_PROCESS
+                    || ops[i].type == EC_CYCLE_DOMAIN_STATE
+                    || ops[i].type == EC_CYCLE_DOMAIN_QUEUE)
+                && !ops[i].domain) {
+            EC_MASTER_ERR(master, "Cyclic operation %u without domain.\n",
+                    i);
+            return -EINVAL;
+        }
+
+        switch (ops[i].type) {
+            case EC_CYCLE_RECEIVE:
+                ecrt_master_receive(master);
+                break;
+            case EC_CYCLE_DOMAIN_PROCESS:
+                ecrt_domain_process(ops[i].domain);
+                break;
+            case EC_CYCLE_DOMAIN_STATE:
+                ecrt_domain_state(ops[i].domain, ops[i].state);
+                break;
+            case EC_CYCLE_DOMAIN_QUEUE:
+                ecrt_domain_queue(ops[i].domain);
+                break;
+            case EC_CYCLE_APPLICATION_TIME:
+                ecrt_master_application_time(master, ops[i].time);
+                break;
+            case EC_CYCLE_SYNC_REFERENCE_CLOCK:
+                ecrt_master_sync_reference_clock(master);
+                break;
+            case EC_CYCLE_SYNC_REFERENCE_CLOCK_TO:
+                ecrt_master_sync_reference_clock_to(master, ops[i].time);
+                break;
+            case EC_CYCLE_SYNC_SLAVE_CLOCKS:
+                ecrt_master_sync_slave_clocks(master);
+                break;
+            case EC_CYCLE_SYNC_MONITOR_QUEUE:
+                ecrt_master_sync_monitor_queue(master);
+                break;
+            case EC_CYCLE_SEND:
+                ecrt_master_send(master);
+                break;
+            default:
+                EC_MASTER_ERR(master, "Invalid cyclic operation %u.\n",
+                        ops[i].type);
+                return -EINVAL;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Same as ecrt_master_slave_config_err(), but without locking.
+ *
+ * The master_sem has to be held by the caller.
  */
-ec_slave_config_t *ecrt_master_slave_config_err(ec_master_t *master,
+ec_slave_config_t *ec_master_slave_config_nolock(ec_master_t *master,
         uint16_t alias, uint16_t position, uint32_t vendor_id,
         uint32_t product_code)
 {
     ec_slave_config_t *sc;
     unsigned int found = 0;
 
-
-    EC_MASTER_DBG(master, 1, "ecrt_master_slave_config(master = 0x%p,"
-            " alias = %u, position = %u, vendor_id = 0x%08x,"
-            " product_code = 0x%08x)\n",
-            master, alias, position, vendor_id, product_code);
-
     list_for_each_entry(sc, &master->configs, list) {
         if (sc->alias == alias && sc->position == position) {
             found = 1;
@@ -3227,14 +4667,18 @@ ec_slave_config_t *ecrt_master_slave_config_err(ec_master_t *master,
         ec_slave_config_init(sc, master,
                 alias, position, vendor_id, product_code);
 
-        ec_lock_down(&master->master_sem);
+        if (ec_index_table_append(&master->config_table, sc)) {
+            EC_MASTER_ERR(master, "Failed to allocate memory"
+                    " for slave configuration table.\n");
+            ec_slave_config_clear(sc);
+            kfree(sc);
+            return ERR_PTR(-ENOMEM);
+        }
 
         // try to find the addressed slave
         ec_slave_config_attach(sc);
         ec_slave_config_load_default_sync_config(sc);
         list_add_tail(&sc->list, &master->configs);
-
-        ec_lock_up(&master->master_sem);
     }
 
     return sc;
@@ -3242,6 +4686,29 @@ ec_slave_config_t *ecrt_master_slave_config_err(ec_master_t *master,
 
 /*****************************************************************************/
 
+/** Same as ecrt_master_slave_config(), but with ERR_PTR() return value.
+ */
+ec_slave_config_t *ecrt_master_slave_config_err(ec_master_t *master,
+        uint16_t alias, uint16_t position, uint32_t vendor_id,
+        uint32_t product_code)
+{
+    ec_slave_config_t *sc;
+
+    EC_MASTER_DBG(master, 1, "ecrt_master_slave_config(master = 0x%p,"
+            " alias = %u, position = %u, vendor_id = 0x%08x,"
+            " product_code = 0x%08x)\n",
+            master, alias, position, vendor_id, product_code);
+
+    ec_lock_down(&master->master_sem);
+    sc = ec_master_slave_config_nolock(master, alias, position, vendor_id,
+            product_code);
+    ec_lock_up(&master->master_sem);
+
+    return sc;
+}
+
+/*****************************************************************************/
+
 ec_slave_config_t *ecrt_master_slave_config(ec_master_t *master,
         uint16_t alias, uint16_t position, uint32_t vendor_id,
         uint32_t product_code)
@@ -4065,6 +5532,7 @@ void ecrt_master_exec_slave_requests(ec_master_t *master)
     if (master->rt_slave_requests && master->rt_slaves_available &&
         (master->phase == EC_OPERATION)) {
         ec_master_exec_slave_fsms(master);
+        ec_master_reap_completions(master);
     }
 
     ec_lock_up(&master->master_sem);
@@ -4741,6 +6209,7 @@ EXPORT_SYMBOL(ecrt_master_deactivate_slaves);
 EXPORT_SYMBOL(ecrt_master_deactivate);
 EXPORT_SYMBOL(ecrt_master_send);
 EXPORT_SYMBOL(ecrt_master_send_ext);
+EXPORT_SYMBOL(ecrt_master_cycle);
 EXPORT_SYMBOL(ecrt_master_receive);
 EXPORT_SYMBOL(ecrt_master_callbacks);
 EXPORT_SYMBOL(ecrt_master);
@@ -42,13 +42,17 @@
 #include <linux/timer.h>
 #include <linux/wait.h>
 #include <linux/kthread.h>
+#include <linux/seqlock.h>
 
 #include "device.h"
 #include "domain.h"
 #include "ethernet.h"
 #include "fsm_master.h"
+#include "index_table.h"
+#include "acyclic_queue.h"
 #include "locks.h"
 #include "cdev.h"
+#include "ioctl.h"
 
 #ifdef EC_RTDM
 #include "rtdm.h"
@@ -112,12 +116,24 @@
     } while (0)
 
 
-/** Size of the external datagram ring.
+/** Default size of the external datagram ring.
  *
- * The external datagram ring is used for slave FSMs.
+ * The external datagram ring is used for slave FSMs. Up to half of the ring
+ * size slave FSMs are executed concurrently. The size can be changed with the
+ * ext_ring_size module parameter.
  */
 #define EC_EXT_RING_SIZE 32
 
+/** Maximum size of the external datagram ring.
+ */
+#define EC_EXT_RING_SIZE_MAX 1024
+
+/** Number of distinct datagram indices.
+ *
+ * The datagram index is an 8 bit value in the EtherCAT datagram header.
+ */
+#define EC_DATAGRAM_INDEX_COUNT 256
+
 /** return flag from ecrt_master_eoe_process() to indicate there is
  * something to send.  if this flag is set call ecrt_master_send_ext()
  */
@@ -158,6 +174,17 @@ typedef struct {
 
 /*****************************************************************************/
 
+/** Traffic class statistics.
+ */
+typedef struct {
+    u64 datagrams; /**< Number of datagrams sent. */
+    u64 bytes; /**< Number of payload bytes sent. */
+    u64 deferred; /**< Number of times a queued datagram was deferred to a
+                    later cycle. */
+} ec_traffic_stats_t;
+
+/*****************************************************************************/
+
 /** Device statistics.
  */
 typedef struct {
@@ -189,6 +216,32 @@ typedef struct {
 
 /*****************************************************************************/
 
+/** Slave information published for lock-free reading.
+ */
+typedef struct {
+    seqcount_t seq; /**< Sequence counter protecting \a info. */
+    ec_ioctl_slave_t info; /**< Slave information. */
+} ec_slave_info_entry_t;
+
+/** Table of published slave information.
+ *
+ * The table is only replaced, if the number of slaves exceeds its size.
+ * Readers access it inside an RCU read-side critical section and check the
+ * sequence counter of the entry, so they never need the master_sem.
+ *
+ * Only EC_IOCTL_SLAVE and the slave table of EC_IOCTL_SNAPSHOT are served
+ * from here. The other informational ioctls (configurations, domains, PDOs
+ * and the SDO dictionary) still take the master_sem.
+ */
+typedef struct {
+    struct rcu_head rcu; /**< Frees the table after it was replaced. */
+    unsigned int size; /**< Number of allocated entries. */
+    unsigned int count; /**< Number of valid entries. */
+    ec_slave_info_entry_t entries[]; /**< Entries by slave position. */
+} ec_slave_info_table_t;
+
+/*****************************************************************************/
+
 #if EC_MAX_NUM_DEVICES < 1
 #error Invalid number of devices
 #endif
@@ -238,10 +291,24 @@ struct ec_master {
 
     ec_slave_t *slaves; /**< Array of slaves on the bus. */
     unsigned int slave_count; /**< Number of slaves on the bus. */
+    ec_slave_t **station_slaves; /**< Slaves indexed by their station
+                                   address. */
+    unsigned int station_slave_count; /**< Number of entries in \a
+                                        station_slaves. */
+    ec_slave_info_table_t *slave_info; /**< Published slave information
+                                         (RCU-protected). */
+    ec_slave_info_table_t *slave_info_next; /**< Larger table to publish
+                                              next. */
+    unsigned int slave_info_pos; /**< Next entry of \a slave_info to
+                                   update. */
+    unsigned int slave_info_scan_busy; /**< Scan state at the last update
+                                         of \a slave_info. */
 
     /* Configuration applied by the application. */
     struct list_head configs; /**< List of slave configurations. */
+    ec_index_table_t config_table; /**< Slave configurations by position. */
     struct list_head domains; /**< List of domains. */
+    ec_index_table_t domain_table; /**< Domains by index. */
 
     /* Configuration applied during bus scanning. */
     struct list_head sii_images; /**< List of slave SII images. */
@@ -277,14 +344,25 @@ struct ec_master {
 
     struct list_head datagram_queue; /**< Datagram queue. */
     uint8_t datagram_index; /**< Current datagram index. */
+    struct list_head timeout_list; /**< Sent datagrams in the order of
+                                     sending, for timeout supervision. */
+    ec_datagram_t *sent_datagrams[EC_DATAGRAM_INDEX_COUNT]; /**< Datagrams
+                                                              in flight,
+                                                              indexed by
+                                                              their datagram
+                                                              index. */
+    DECLARE_BITMAP(datagram_indices, EC_DATAGRAM_INDEX_COUNT); /**< Datagram
+                                                                 indices in
+                                                                 use. */
 
     struct list_head ext_datagram_queue; /**< Queue for non-application
                                            datagrams. */
     ec_lock_t ext_queue_sem; /**< Semaphore protecting the \a
                                       ext_datagram_queue. */
 
-    ec_datagram_t ext_datagram_ring[EC_EXT_RING_SIZE]; /**< External datagram
-                                                         ring. */
+    ec_datagram_t *ext_datagram_ring; /**< External datagram ring. */
+    unsigned int ext_ring_size; /**< Number of datagrams in the external
+                                  datagram ring. */
     unsigned int ext_ring_idx_rt; /**< Index in external datagram ring for RT
                                     side. */
     unsigned int ext_ring_idx_fsm; /**< Index in external datagram ring for
@@ -292,6 +370,13 @@ struct ec_master {
     unsigned int send_interval; /**< Interval between two calls to
                                   ecrt_master_send(). */
     size_t max_queue_size; /**< Maximum size of datagram queue */
+    size_t traffic_budgets[EC_TRAFFIC_CLASS_COUNT]; /**< Per-cycle payload
+                                                      budgets of the traffic
+                                                      classes in byte. Zero
+                                                      means unlimited. */
+    ec_traffic_stats_t traffic_stats[EC_TRAFFIC_CLASS_COUNT]; /**< Traffic
+                                                                class
+                                                                statistics. */
     unsigned int rt_slave_requests; /**< if \a True, slave requests are to be
                                       handled by calls to 
                                       ecrt_master_exec_requests() from
@@ -306,6 +391,9 @@ struct ec_master {
     ec_slave_t *fsm_slave; /**< Slave that is queried next for FSM exec. */
     struct list_head fsm_exec_list; /**< Slave FSM execution list. */
     unsigned int fsm_exec_count; /**< Number of entries in execution list. */
+    u64 ext_ring_stalls; /**< Number of times a slave FSM could not be
+                           executed, because the external datagram ring was
+                           full. */
 
     unsigned int debug_level; /**< Master debug level. */
     ec_stats_t stats; /**< Cyclic statistics. */
@@ -320,7 +408,8 @@ struct ec_master {
     struct list_head eoe_handlers; /**< Ethernet over EtherCAT handlers. */
 #endif
 
-    ec_lock_t io_sem; /**< Semaphore used in \a IDLE phase. */
+    ec_lock_t io_sem; /**< Semaphore used in \a IDLE phase and by the
+                        cycle thread. */
 
     void (*send_cb)(void *); /**< Current send datagrams callback. */
     void (*receive_cb)(void *); /**< Current receive datagrams callback. */
@@ -337,6 +426,29 @@ struct ec_master {
 
     wait_queue_head_t request_queue; /**< Wait queue for external requests
                                        from user space. */
+
+    ec_ioctl_state_page_t *state_page; /**< State page mapped read-only to
+                                         user space. */
+
+    ec_ioctl_cycle_ring_t *cycle_ring; /**< Cycle ring shared with the
+                                         application. */
+    struct task_struct *cycle_thread; /**< Cycle thread. */
+    ec_cycle_op_t *cycle_ops; /**< Operations executed per cycle. */
+    unsigned int cycle_op_count; /**< Number of \a cycle_ops. */
+
+    uint8_t completions_enabled; /**< Request completions are queued. */
+    uint8_t completion_pending; /**< A configuration has a finished
+                                  request, see
+                                  ec_slave_config_mark_completion(). */
+    ec_ioctl_completion_t completions[EC_IOCTL_COMPLETION_QUEUE_SIZE]; /**<
+                                                   Completion queue. */
+    unsigned int completion_head; /**< Number of queued completions. */
+    unsigned int completion_tail; /**< Number of read completions. */
+    wait_queue_head_t completion_queue; /**< Wait queue for readers of the
+                                          completion queue. */
+
+    ec_acyclic_queue_t acyclic_queue; /**< Acyclic queue of the
+                                        application. */
 };
 
 /*****************************************************************************/
@@ -346,7 +458,7 @@ void ec_master_init_static(void);
 
 // master creation/deletion
 int ec_master_init(ec_master_t *, unsigned int, const uint8_t *,
-        const uint8_t *, dev_t, struct class *, unsigned int);
+        const uint8_t *, dev_t, struct class *, unsigned int, unsigned int);
 void ec_master_clear(ec_master_t *);
 
 void ec_sii_image_clear(ec_sii_image_t *);
@@ -365,6 +477,11 @@ void ec_master_leave_idle_phase(ec_master_t *);
 int ec_master_enter_operation_phase(ec_master_t *);
 void ec_master_leave_operation_phase(ec_master_t *);
 
+// cycle thread
+int ec_master_cycle_thread_start(ec_master_t *, int, ec_cycle_op_t *,
+        unsigned int);
+void ec_master_cycle_thread_stop(ec_master_t *);
+
 #ifdef EC_EOE
 // EoE
 void ec_master_eoe_start(ec_master_t *);
@@ -376,6 +493,7 @@ void ec_master_receive_datagrams(ec_master_t *, ec_device_t *,
         const uint8_t *, size_t);
 void ec_master_queue_datagram(ec_master_t *, ec_datagram_t *);
 void ec_master_queue_datagram_ext(ec_master_t *, ec_datagram_t *);
+void ec_master_forget_datagram(ec_master_t *, ec_datagram_t *);
 
 // misc.
 void ec_master_set_send_interval(ec_master_t *, unsigned int);
@@ -391,6 +509,7 @@ void ec_master_clear_eoe_handlers(ec_master_t *, unsigned int);
 void ec_master_slaves_not_available(ec_master_t *);
 void ec_master_slaves_available(ec_master_t *);
 void ec_master_clear_slaves(ec_master_t *);
+int ec_master_map_station_addresses(ec_master_t *);
 void ec_master_clear_sii_images(ec_master_t *);
 void ec_master_reboot_slaves(ec_master_t *);
 
@@ -420,8 +539,18 @@ int ec_master_debug_level(ec_master_t *, unsigned int);
 ec_domain_t *ecrt_master_create_domain_err(ec_master_t *);
 ec_slave_config_t *ecrt_master_slave_config_err(ec_master_t *, uint16_t,
         uint16_t, uint32_t, uint32_t);
+ec_slave_config_t *ec_master_slave_config_nolock(ec_master_t *, uint16_t,
+        uint16_t, uint32_t, uint32_t);
 
 void ec_master_calc_dc(ec_master_t *);
+void ec_master_publish_domain_state(ec_master_t *, const ec_domain_t *);
+
+void ec_master_reap_completions(ec_master_t *);
+void ec_master_update_slave_info(ec_master_t *);
+int ec_master_read_slave_info(ec_master_t *, uint16_t, ec_ioctl_slave_t *);
+unsigned int ec_master_read_completions(ec_master_t *,
+        ec_ioctl_completion_t *, unsigned int);
+int ec_master_completions_pending(const ec_master_t *);
 void ec_master_request_op(ec_master_t *);
 
 void ec_master_internal_send_cb(void *);
@@ -64,6 +64,9 @@ unsigned int eoe_count; /**< Number of EOE interfaces. */
 bool eoe_autocreate = 1;  /**< Auto-create EOE interfaces. */
 #endif
 static unsigned int debug_level;  /**< Debug level parameter. */
+static unsigned int ext_ring_size = EC_EXT_RING_SIZE; /**< External datagram
+                                                        ring size parameter.
+                                                       */
 unsigned long pcap_size;  /**< Pcap buffer size in bytes. */
 
 static ec_master_t *masters; /**< Array of masters. */
@@ -99,6 +102,8 @@ module_param_named(debug_level, debug_level, uint, S_IRUGO);
 MODULE_PARM_DESC(debug_level, "Debug level");
 module_param_named(pcap_size, pcap_size, ulong, S_IRUGO);
 MODULE_PARM_DESC(pcap_size, "Pcap buffer size");
+module_param_named(ext_ring_size, ext_ring_size, uint, S_IRUGO);
+MODULE_PARM_DESC(ext_ring_size, "External datagram ring size");
 
 /** \endcond */
 
@@ -117,6 +122,12 @@ int __init ec_init_module(void)
 
     ec_lock_init(&master_sem);
 
+    if (ext_ring_size < 2 || ext_ring_size > EC_EXT_RING_SIZE_MAX) {
+        EC_ERR("Invalid external datagram ring size %u!\n", ext_ring_size);
+        ret = -EINVAL;
+        goto out_return;
+    }
+
     if (master_count) {
         if (alloc_chrdev_region(&device_number,
                     0, master_count, "EtherCAT")) {
@@ -164,7 +175,7 @@ int __init ec_init_module(void)
 
     for (i = 0; i < master_count; i++) {
         ret = ec_master_init(&masters[i], i, macs[i][0], macs[i][1],
-                    device_number, class, debug_level);
+                    device_number, class, debug_level, ext_ring_size);
         if (ret)
             goto out_free_masters;
     }
@@ -62,6 +62,7 @@ int ec_reg_request_init(
     reg->address = 0;
     reg->transfer_size = 0;
     reg->state = EC_INT_REQUEST_INIT;
+    reg->notify = 0;
     reg->ring_position = 0;
     return 0;
 }
@@ -104,6 +105,8 @@ void ecrt_reg_request_write(ec_reg_request_t *reg, uint16_t address,
     reg->address = address;
     reg->transfer_size = min(size, reg->mem_size);
     reg->state = EC_INT_REQUEST_QUEUED;
+    smp_wmb();
+    reg->notify = 1;
 }
 
 /*****************************************************************************/
@@ -115,6 +118,8 @@ void ecrt_reg_request_read(ec_reg_request_t *reg, uint16_t address,
     reg->address = address;
     reg->transfer_size = min(size, reg->mem_size);
     reg->state = EC_INT_REQUEST_QUEUED;
+    smp_wmb();
+    reg->notify = 1;
 }
 
 /*****************************************************************************/
@@ -126,6 +131,8 @@ void ecrt_reg_request_readwrite(ec_reg_request_t *reg, uint16_t address,
     reg->address = address;
     reg->transfer_size = min(size, reg->mem_size);
     reg->state = EC_INT_REQUEST_QUEUED;
+    smp_wmb();
+    reg->notify = 1;
 }
 
 /*****************************************************************************/
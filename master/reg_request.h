@@ -54,6 +54,8 @@ struct ec_reg_request {
     uint16_t address; /**< Register address. */
     size_t transfer_size; /**< Size of the data to transfer. */
     ec_internal_request_state_t state; /**< Request state. */
+    uint8_t notify; /**< Completion has to be reported to the application.
+                      Set after the request state was written. */
     uint16_t ring_position; /**< Ring position for emergency requests. */
 };
 
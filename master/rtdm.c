@@ -154,6 +154,7 @@ int ec_rtdm_open(
     ctx->ioctl_ctx.requested = 0;
     ctx->ioctl_ctx.process_data = NULL;
     ctx->ioctl_ctx.process_data_size = 0;
+    ctx->ioctl_ctx.share_request_data = 0;
 
 #if DEBUG
     EC_MASTER_INFO(rtdm_dev->master, "RTDM device %s opened.\n",
@@ -61,6 +61,7 @@ static int ec_rtdm_open(struct rtdm_fd *fd, int oflags)
 	ctx->ioctl_ctx.requested = 0;
 	ctx->ioctl_ctx.process_data = NULL;
 	ctx->ioctl_ctx.process_data_size = 0;
+	ctx->ioctl_ctx.share_request_data = 0;
 
 #if DEBUG_RTDM
 	EC_MASTER_INFO(rtdm_dev->master, "RTDM device %s opened.\n",
@@ -198,6 +199,7 @@ static const struct ec_ioctl_desc ec_ioctls[] = {
 	EC_IOCTL_DEF(EC_IOCTL_SLAVE_REBOOT),
 	EC_IOCTL_DEF(EC_IOCTL_SLAVE_REG_READWRITE),
 	EC_IOCTL_DEF(EC_IOCTL_REG_REQUEST_READWRITE),
+	EC_IOCTL_DEF(EC_IOCTL_CYCLE),
 	EC_IOCTL_DEF(EC_IOCTL_SETUP_DOMAIN_MEMORY),
 	EC_IOCTL_DEF(EC_IOCTL_DEACTIVATE_SLAVES),
 	EC_IOCTL_DEF(EC_IOCTL_64_REF_CLK_TIME_QUEUE),
@@ -246,6 +248,7 @@ static int ec_rtdm_ioctl_rt(struct rtdm_fd *fd, unsigned int request,
 	case EC_IOCTL_DOMAIN_PROCESS:
 	case EC_IOCTL_DOMAIN_QUEUE:
 	case EC_IOCTL_DOMAIN_STATE:
+	case EC_IOCTL_CYCLE:
 		break;
 	default:
 		return -ENOSYS;
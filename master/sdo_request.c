@@ -59,12 +59,14 @@ void ec_sdo_request_init(
 {
     req->complete_access = 0;
     req->data = NULL;
+    req->data_origin = EC_ORIG_INTERNAL;
     req->mem_size = 0;
     req->data_size = 0;
     req->dir = EC_DIR_INVALID;
     req->issue_timeout = 0; // no timeout
     req->response_timeout = EC_SDO_REQUEST_RESPONSE_TIMEOUT;
     req->state = EC_INT_REQUEST_INIT;
+    req->notify = 0;
     req->errno = 0;
     req->abort_code = 0x00000000;
 }
@@ -107,11 +109,12 @@ void ec_sdo_request_clear_data(
         ec_sdo_request_t *req /**< SDO request. */
         )
 {
-    if (req->data) {
+    if (req->data_origin == EC_ORIG_INTERNAL && req->data) {
         kfree(req->data);
-        req->data = NULL;
     }
 
+    req->data = NULL;
+    req->data_origin = EC_ORIG_INTERNAL;
     req->mem_size = 0;
     req->data_size = 0;
 }
@@ -121,8 +124,9 @@ void ec_sdo_request_clear_data(
 /** Pre-allocates the data memory.
  *
  * If the \a mem_size is already bigger than \a size, nothing is done.
+ * External memory is never replaced.
  *
- * \return 0 on success, otherwise -ENOMEM.
+ * \return 0 on success, otherwise -ENOMEM or -EOVERFLOW.
  */
 int ec_sdo_request_alloc(
         ec_sdo_request_t *req, /**< SDO request. */
@@ -132,6 +136,12 @@ int ec_sdo_request_alloc(
     if (size <= req->mem_size)
         return 0;
 
+    if (req->data_origin == EC_ORIG_EXTERNAL) {
+        EC_ERR("%zu bytes do not fit into the SDO memory (%zu bytes).\n",
+                size, req->mem_size);
+        return -EOVERFLOW;
+    }
+
     ec_sdo_request_clear_data(req);
 
     if (!(req->data = (uint8_t *) kmalloc(size, GFP_KERNEL))) {
@@ -170,6 +180,32 @@ int ec_sdo_request_copy_data(
 
 /*****************************************************************************/
 
+/** Moves the SDO data to external memory.
+ *
+ * The current data are copied and the internal memory is freed. The request
+ * can not grow beyond \a size bytes afterwards.
+ */
+void ec_sdo_request_external_memory(
+        ec_sdo_request_t *req, /**< SDO request. */
+        uint8_t *mem, /**< External memory. */
+        size_t size /**< Size of \a mem (at least \a mem_size). */
+        )
+{
+    size_t data_size = req->data_size;
+
+    if (req->data) {
+        memcpy(mem, req->data, req->mem_size);
+    }
+
+    ec_sdo_request_clear_data(req);
+    req->data = mem;
+    req->data_origin = EC_ORIG_EXTERNAL;
+    req->mem_size = size;
+    req->data_size = data_size;
+}
+
+/*****************************************************************************/
+
 /** Checks, if the timeout was exceeded.
  *
  * \return non-zero if the timeout was exceeded, else zero.
@@ -236,6 +272,8 @@ void ecrt_sdo_request_read(ec_sdo_request_t *req)
     req->errno = 0;
     req->abort_code = 0x00000000;
     req->jiffies_start = jiffies;
+    smp_wmb();
+    req->notify = 1;
 }
 
 /*****************************************************************************/
@@ -247,6 +285,8 @@ void ecrt_sdo_request_write(ec_sdo_request_t *req)
     req->errno = 0;
     req->abort_code = 0x00000000;
     req->jiffies_start = jiffies;
+    smp_wmb();
+    req->notify = 1;
 }
 
 /*****************************************************************************/
@@ -264,6 +304,8 @@ void ecrt_sdo_request_write_with_size(ec_sdo_request_t *req, size_t size)
     req->errno = 0;
     req->abort_code = 0x00000000;
     req->jiffies_start = jiffies;
+    smp_wmb();
+    req->notify = 1;
 }
 
 /*****************************************************************************/
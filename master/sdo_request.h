@@ -50,6 +50,7 @@ struct ec_sdo_request {
     uint16_t index; /**< SDO index. */
     uint8_t subindex; /**< SDO subindex. */
     uint8_t *data; /**< Pointer to SDO data. */
+    ec_origin_t data_origin; /**< Origin of the \a data memory. */
     size_t mem_size; /**< Size of SDO data memory. */
     size_t data_size; /**< Size of SDO data. */
     uint8_t complete_access; /**< SDO shall be transferred completely. */
@@ -61,6 +62,8 @@ struct ec_sdo_request {
                           the slave, EC_DIR_INPUT means uploading from the
                           slave. */
     ec_internal_request_state_t state; /**< SDO request state. */
+    uint8_t notify; /**< Completion has to be reported to the application.
+                      Set after the request state was written. */
     unsigned long jiffies_start; /**< Jiffies, when the request was issued. */
     unsigned long jiffies_sent; /**< Jiffies, when the upload/download
                                      request was sent. */
@@ -76,6 +79,7 @@ void ec_sdo_request_clear(ec_sdo_request_t *);
 int ec_sdo_request_copy(ec_sdo_request_t *, const ec_sdo_request_t *);
 int ec_sdo_request_alloc(ec_sdo_request_t *, size_t);
 int ec_sdo_request_copy_data(ec_sdo_request_t *, const uint8_t *, size_t);
+void ec_sdo_request_external_memory(ec_sdo_request_t *, uint8_t *, size_t);
 int ec_sdo_request_timed_out(const ec_sdo_request_t *);
 
 /*****************************************************************************/
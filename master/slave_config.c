@@ -87,11 +87,17 @@ void ec_slave_config_init(
 
     INIT_LIST_HEAD(&sc->sdo_configs);
     INIT_LIST_HEAD(&sc->sdo_requests);
+    ec_index_table_init(&sc->sdo_request_table);
     INIT_LIST_HEAD(&sc->foe_requests);
+    ec_index_table_init(&sc->foe_request_table);
     INIT_LIST_HEAD(&sc->reg_requests);
+    ec_index_table_init(&sc->reg_request_table);
     INIT_LIST_HEAD(&sc->voe_handlers);
+    ec_index_table_init(&sc->voe_handler_table);
     INIT_LIST_HEAD(&sc->soe_configs);
     INIT_LIST_HEAD(&sc->soe_requests);
+    ec_index_table_init(&sc->soe_request_table);
+    sc->completion_pending = 0;
 #ifdef EC_EOE
     INIT_LIST_HEAD(&sc->eoe_configs);
 #endif
@@ -132,6 +138,7 @@ void ec_slave_config_clear(
     }
 
     // free all SDO requests
+    ec_index_table_clear(&sc->sdo_request_table);
     list_for_each_entry_safe(req, next_req, &sc->sdo_requests, list) {
         list_del(&req->list);
         ec_sdo_request_clear(req);
@@ -139,6 +146,7 @@ void ec_slave_config_clear(
     }
 
     // free all FoE requests
+    ec_index_table_clear(&sc->foe_request_table);
     list_for_each_entry_safe(foe, next_foe, &sc->foe_requests, list) {
         list_del(&foe->list);
         ec_foe_request_clear(foe);
@@ -146,6 +154,7 @@ void ec_slave_config_clear(
     }
 
     // free all register requests
+    ec_index_table_clear(&sc->reg_request_table);
     list_for_each_entry_safe(reg, next_reg, &sc->reg_requests, list) {
         list_del(&reg->list);
         ec_reg_request_clear(reg);
@@ -153,6 +162,7 @@ void ec_slave_config_clear(
     }
 
     // free all VoE handlers
+    ec_index_table_clear(&sc->voe_handler_table);
     list_for_each_entry_safe(voe, next_voe, &sc->voe_handlers, list) {
         list_del(&voe->list);
         ec_voe_handler_clear(voe);
@@ -167,6 +177,7 @@ void ec_slave_config_clear(
     }
 
     // free all SOE requests
+    ec_index_table_clear(&sc->soe_request_table);
     list_for_each_entry_safe(soe, next_soe, &sc->soe_requests, list) {
         list_del(&soe->list);
         ec_soe_request_clear(soe);
@@ -195,10 +206,12 @@ void ec_slave_config_clear(
  * FMMU configuration is already prepared, the function does nothing and
  * returns with success.
  *
+ * The master_sem has to be held by the caller.
+ *
  * \retval >=0 Success, logical offset byte address.
  * \retval  <0 Error code.
  */
-int ec_slave_config_prepare_fmmu(
+static int ec_slave_config_prepare_fmmu_nolock(
         ec_slave_config_t *sc, /**< Slave configuration. */
         ec_domain_t *domain, /**< Domain. */
         uint8_t sync_index, /**< Sync manager index. */
@@ -221,8 +234,6 @@ int ec_slave_config_prepare_fmmu(
     }
 
     fmmu = &sc->fmmu_configs[sc->used_fmmus];
-
-    ec_lock_down(&sc->master->master_sem);
     ec_fmmu_config_init(fmmu, sc, domain, sync_index, dir);
 
 #if 0 //TODO overlapping PDOs
@@ -255,13 +266,37 @@ int ec_slave_config_prepare_fmmu(
 #endif
 
     sc->used_fmmus++;
-    ec_lock_up(&sc->master->master_sem);
 
     return fmmu->logical_domain_offset;
 }
 
 /*****************************************************************************/
 
+/** Prepares an FMMU configuration.
+ *
+ * Same as ec_slave_config_prepare_fmmu_nolock(), but takes the master_sem.
+ *
+ * \retval >=0 Success, logical offset byte address.
+ * \retval  <0 Error code.
+ */
+int ec_slave_config_prepare_fmmu(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        ec_domain_t *domain, /**< Domain. */
+        uint8_t sync_index, /**< Sync manager index. */
+        ec_direction_t dir /**< PDO direction. */
+        )
+{
+    int ret;
+
+    ec_lock_down(&sc->master->master_sem);
+    ret = ec_slave_config_prepare_fmmu_nolock(sc, domain, sync_index, dir);
+    ec_lock_up(&sc->master->master_sem);
+
+    return ret;
+}
+
+/*****************************************************************************/
+
 /** Attaches the configuration to the addressed slave object.
  *
  * \retval  0 Success.
@@ -541,15 +576,7 @@ ec_sdo_request_t *ec_slave_config_find_sdo_request(
         unsigned int pos /**< Position in the list. */
         )
 {
-    ec_sdo_request_t *req;
-
-    list_for_each_entry(req, &sc->sdo_requests, list) {
-        if (pos--)
-            continue;
-        return req;
-    }
-
-    return NULL;
+    return ec_index_table_get(&sc->sdo_request_table, pos);
 }
 
 /*****************************************************************************/
@@ -563,15 +590,7 @@ ec_foe_request_t *ec_slave_config_find_foe_request(
         unsigned int pos /**< Position in the list. */
         )
 {
-    ec_foe_request_t *req;
-
-    list_for_each_entry(req, &sc->foe_requests, list) {
-        if (pos--)
-            continue;
-        return req;
-    }
-
-    return NULL;
+    return ec_index_table_get(&sc->foe_request_table, pos);
 }
 
 /*****************************************************************************/
@@ -585,15 +604,7 @@ ec_reg_request_t *ec_slave_config_find_reg_request(
         unsigned int pos /**< Position in the list. */
         )
 {
-    ec_reg_request_t *reg;
-
-    list_for_each_entry(reg, &sc->reg_requests, list) {
-        if (pos--)
-            continue;
-        return reg;
-    }
-
-    return NULL;
+    return ec_index_table_get(&sc->reg_request_table, pos);
 }
 
 /*****************************************************************************/
@@ -607,15 +618,7 @@ ec_voe_handler_t *ec_slave_config_find_voe_handler(
         unsigned int pos /**< Position in the list. */
         )
 {
-    ec_voe_handler_t *voe;
-
-    list_for_each_entry(voe, &sc->voe_handlers, list) {
-        if (pos--)
-            continue;
-        return voe;
-    }
-
-    return NULL;
+    return ec_index_table_get(&sc->voe_handler_table, pos);
 }
 
 /*****************************************************************************/
@@ -625,15 +628,7 @@ ec_soe_request_t *ec_slave_config_find_soe_request(
     unsigned int pos
     )
 {
-    ec_soe_request_t *req;
-
-    list_for_each_entry(req, &sc->soe_requests, list) {
-        if (pos--)
-            continue;
-        return req;
-    }
-
-    return NULL;
+    return ec_index_table_get(&sc->soe_request_table, pos);
 }
 
 /*****************************************************************************/
@@ -648,6 +643,7 @@ void ec_slave_config_expire_disconnected_requests(
     ec_foe_request_t *foe_req;
     ec_reg_request_t *reg_req;
     ec_soe_request_t *soe_req;
+    unsigned int expired = 0;
 
     if (sc->slave) { return; }
 
@@ -656,6 +652,7 @@ void ec_slave_config_expire_disconnected_requests(
                 sdo_req->state == EC_INT_REQUEST_BUSY) {
             EC_CONFIG_DBG(sc, 1, "Aborting SDO request; no slave attached.\n");
             sdo_req->state = EC_INT_REQUEST_FAILURE;
+            expired = 1;
         }
     }
 
@@ -664,6 +661,7 @@ void ec_slave_config_expire_disconnected_requests(
                 foe_req->state == EC_INT_REQUEST_BUSY) {
             EC_CONFIG_DBG(sc, 1, "Aborting FoE request; no slave attached.\n");
             foe_req->state = EC_INT_REQUEST_FAILURE;
+            expired = 1;
         }
     }
 
@@ -672,6 +670,7 @@ void ec_slave_config_expire_disconnected_requests(
                 reg_req->state == EC_INT_REQUEST_BUSY) {
             EC_CONFIG_DBG(sc, 1, "Aborting register request; no slave attached.\n");
             reg_req->state = EC_INT_REQUEST_FAILURE;
+            expired = 1;
         }
     }
 
@@ -680,10 +679,124 @@ void ec_slave_config_expire_disconnected_requests(
           soe_req->state == EC_INT_REQUEST_BUSY) {
         EC_CONFIG_DBG(sc, 1, "Aborting SOE request; no slave attached.\n");
         soe_req->state = EC_INT_REQUEST_FAILURE;
+        expired = 1;
       }
     }
+
+    if (expired) {
+        ec_slave_config_mark_completion(sc);
+    }
+}
+
+/*****************************************************************************/
+
+/** Marks, that a request of the configuration has finished.
+ *
+ * Has to be called after the request state was set.
+ * ec_master_reap_completions() only looks at the requests of marked
+ * configurations.
+ */
+void ec_slave_config_mark_completion(
+        ec_slave_config_t *sc /**< Slave configuration. */
+        )
+{
+    smp_wmb();
+    WRITE_ONCE(sc->completion_pending, 1);
+    smp_wmb();
+    WRITE_ONCE(sc->master->completion_pending, 1);
+}
+
+/** Size of the shared memory reserved for a request with \a mem_size bytes.
+ *
+ * The requests are packed, each one starting on a cache line. Requests
+ * without memory are not shared.
+ */
+#define EC_REQUEST_MEMORY_SIZE(mem_size) \
+    ALIGN((size_t) (mem_size), EC_IOCTL_CACHE_LINE_SIZE)
+
+/*****************************************************************************/
+
+/** Gets the size of the memory to share the request data with the
+ * application.
+ *
+ * \return Size in bytes, a multiple of EC_IOCTL_CACHE_LINE_SIZE.
+ */
+size_t ec_slave_config_request_memory_size(
+        const ec_slave_config_t *sc /**< Slave configuration. */
+        )
+{
+    const ec_sdo_request_t *sdo_req;
+    const ec_soe_request_t *soe_req;
+    const ec_voe_handler_t *voe;
+    size_t size = 0;
+
+    list_for_each_entry(sdo_req, &sc->sdo_requests, list) {
+        size += EC_REQUEST_MEMORY_SIZE(sdo_req->mem_size);
+    }
+
+    list_for_each_entry(soe_req, &sc->soe_requests, list) {
+        size += EC_REQUEST_MEMORY_SIZE(soe_req->mem_size);
+    }
+
+    list_for_each_entry(voe, &sc->voe_handlers, list) {
+        size += EC_REQUEST_MEMORY_SIZE(ec_voe_handler_mem_size(voe));
+    }
+
+    return size;
+}
+
+/*****************************************************************************/
+
+/** Moves the data of the SDO and SoE requests and VoE handlers to external
+ * memory, that is shared with the application.
+ *
+ * SDO and SoE requests that are currently processed keep their memory, but
+ * their share is reserved anyway. The VoE handlers keep building their
+ * mailboxes in their own memory, see ec_voe_handler_external_memory().
+ *
+ * \return Number of bytes used, see ec_slave_config_request_memory_size().
+ */
+size_t ec_slave_config_request_external_memory(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        uint8_t *mem /**< External memory. */
+        )
+{
+    ec_sdo_request_t *sdo_req;
+    ec_soe_request_t *soe_req;
+    ec_voe_handler_t *voe;
+    size_t offset = 0, size;
+
+    list_for_each_entry(sdo_req, &sc->sdo_requests, list) {
+        size = EC_REQUEST_MEMORY_SIZE(sdo_req->mem_size);
+        if (size && sdo_req->state != EC_INT_REQUEST_QUEUED &&
+                sdo_req->state != EC_INT_REQUEST_BUSY) {
+            ec_sdo_request_external_memory(sdo_req, mem + offset, size);
+        }
+        offset += size;
+    }
+
+    list_for_each_entry(soe_req, &sc->soe_requests, list) {
+        size = EC_REQUEST_MEMORY_SIZE(soe_req->mem_size);
+        if (size && soe_req->state != EC_INT_REQUEST_QUEUED &&
+                soe_req->state != EC_INT_REQUEST_BUSY) {
+            ec_soe_request_external_memory(soe_req, mem + offset, size);
+        }
+        offset += size;
+    }
+
+    list_for_each_entry(voe, &sc->voe_handlers, list) {
+        size = EC_REQUEST_MEMORY_SIZE(ec_voe_handler_mem_size(voe));
+        if (size) {
+            ec_voe_handler_external_memory(voe, mem + offset, size);
+        }
+        offset += size;
+    }
+
+    return offset;
 }
 
+/*****************************************************************************/
+
 /******************************************************************************
  *  Application interface
  *****************************************************************************/
@@ -738,109 +851,160 @@ void ecrt_slave_config_overlapping_pdos(ec_slave_config_t *sc,
 
 /*****************************************************************************/
 
-int ecrt_slave_config_pdo_assign_add(ec_slave_config_t *sc,
-        uint8_t sync_index, uint16_t pdo_index)
+/** Same as ecrt_slave_config_pdo_assign_add(), but without locking.
+ *
+ * The master_sem has to be held by the caller.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_slave_config_pdo_assign_add_nolock(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        uint8_t sync_index, /**< Sync manager index. */
+        uint16_t pdo_index /**< Index of the PDO to assign. */
+        )
 {
     ec_pdo_t *pdo;
 
-    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, sync_index = %u, "
-            "pdo_index = 0x%04X)\n", __func__, sc, sync_index, pdo_index);
-
     if (sync_index >= EC_MAX_SYNC_MANAGERS) {
         EC_CONFIG_ERR(sc, "Invalid sync manager index %u!\n", sync_index);
         return -EINVAL;
     }
 
-    ec_lock_down(&sc->master->master_sem);
-
     pdo = ec_pdo_list_add_pdo(&sc->sync_configs[sync_index].pdos, pdo_index);
     if (IS_ERR(pdo)) {
-        ec_lock_up(&sc->master->master_sem);
         return PTR_ERR(pdo);
     }
     pdo->sync_index = sync_index;
 
     ec_slave_config_load_default_mapping(sc, pdo);
-
-    ec_lock_up(&sc->master->master_sem);
     return 0;
 }
 
 /*****************************************************************************/
 
-void ecrt_slave_config_pdo_assign_clear(ec_slave_config_t *sc,
-        uint8_t sync_index)
+int ecrt_slave_config_pdo_assign_add(ec_slave_config_t *sc,
+        uint8_t sync_index, uint16_t pdo_index)
 {
-    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, sync_index = %u)\n",
-            __func__, sc, sync_index);
+    int ret;
+
+    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, sync_index = %u, "
+            "pdo_index = 0x%04X)\n", __func__, sc, sync_index, pdo_index);
 
+    ec_lock_down(&sc->master->master_sem);
+    ret = ec_slave_config_pdo_assign_add_nolock(sc, sync_index, pdo_index);
+    ec_lock_up(&sc->master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Same as ecrt_slave_config_pdo_assign_clear(), but without locking.
+ *
+ * The master_sem has to be held by the caller.
+ */
+void ec_slave_config_pdo_assign_clear_nolock(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        uint8_t sync_index /**< Sync manager index. */
+        )
+{
     if (sync_index >= EC_MAX_SYNC_MANAGERS) {
         EC_CONFIG_ERR(sc, "Invalid sync manager index %u!\n", sync_index);
         return;
     }
 
-    ec_lock_down(&sc->master->master_sem);
     ec_pdo_list_clear_pdos(&sc->sync_configs[sync_index].pdos);
+}
+
+/*****************************************************************************/
+
+void ecrt_slave_config_pdo_assign_clear(ec_slave_config_t *sc,
+        uint8_t sync_index)
+{
+    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, sync_index = %u)\n",
+            __func__, sc, sync_index);
+
+    ec_lock_down(&sc->master->master_sem);
+    ec_slave_config_pdo_assign_clear_nolock(sc, sync_index);
     ec_lock_up(&sc->master->master_sem);
 }
 
 /*****************************************************************************/
 
-int ecrt_slave_config_pdo_mapping_add(ec_slave_config_t *sc,
-        uint16_t pdo_index, uint16_t entry_index, uint8_t entry_subindex,
-        uint8_t entry_bit_length)
+/** Same as ecrt_slave_config_pdo_mapping_add(), but without locking.
+ *
+ * The master_sem has to be held by the caller.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_slave_config_pdo_mapping_add_nolock(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        uint16_t pdo_index, /**< Index of the PDO. */
+        uint16_t entry_index, /**< Index of the PDO entry to add. */
+        uint8_t entry_subindex, /**< Subindex of the PDO entry to add. */
+        uint8_t entry_bit_length /**< Size of the PDO entry in bit. */
+        )
 {
     uint8_t sync_index;
     ec_pdo_t *pdo = NULL;
     ec_pdo_entry_t *entry;
-    int retval = 0;
-
-    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, "
-            "pdo_index = 0x%04X, entry_index = 0x%04X, "
-            "entry_subindex = 0x%02X, entry_bit_length = %u)\n",
-            __func__, sc, pdo_index, entry_index, entry_subindex,
-            entry_bit_length);
 
     for (sync_index = 0; sync_index < EC_MAX_SYNC_MANAGERS; sync_index++)
         if ((pdo = ec_pdo_list_find_pdo(
                         &sc->sync_configs[sync_index].pdos, pdo_index)))
             break;
 
-    if (pdo) {
-        ec_lock_down(&sc->master->master_sem);
-        entry = ec_pdo_add_entry(pdo, entry_index, entry_subindex,
-                entry_bit_length);
-        ec_lock_up(&sc->master->master_sem);
-        if (IS_ERR(entry))
-            retval = PTR_ERR(entry);
-    } else {
+    if (!pdo) {
         EC_CONFIG_ERR(sc, "PDO 0x%04X is not assigned.\n", pdo_index);
-        retval = -ENOENT;
+        return -ENOENT;
     }
 
-    return retval;
+    entry = ec_pdo_add_entry(pdo, entry_index, entry_subindex,
+            entry_bit_length);
+    return IS_ERR(entry) ? PTR_ERR(entry) : 0;
 }
 
 /*****************************************************************************/
 
-void ecrt_slave_config_pdo_mapping_clear(ec_slave_config_t *sc,
-        uint16_t pdo_index)
+int ecrt_slave_config_pdo_mapping_add(ec_slave_config_t *sc,
+        uint16_t pdo_index, uint16_t entry_index, uint8_t entry_subindex,
+        uint8_t entry_bit_length)
+{
+    int ret;
+
+    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, "
+            "pdo_index = 0x%04X, entry_index = 0x%04X, "
+            "entry_subindex = 0x%02X, entry_bit_length = %u)\n",
+            __func__, sc, pdo_index, entry_index, entry_subindex,
+            entry_bit_length);
+
+    ec_lock_down(&sc->master->master_sem);
+    ret = ec_slave_config_pdo_mapping_add_nolock(sc, pdo_index, entry_index,
+            entry_subindex, entry_bit_length);
+    ec_lock_up(&sc->master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Same as ecrt_slave_config_pdo_mapping_clear(), but without locking.
+ *
+ * The master_sem has to be held by the caller.
+ */
+void ec_slave_config_pdo_mapping_clear_nolock(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        uint16_t pdo_index /**< Index of the PDO. */
+        )
 {
     uint8_t sync_index;
     ec_pdo_t *pdo = NULL;
 
-    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, pdo_index = 0x%04X)\n",
-            __func__, sc, pdo_index);
-
     for (sync_index = 0; sync_index < EC_MAX_SYNC_MANAGERS; sync_index++)
         if ((pdo = ec_pdo_list_find_pdo(
                         &sc->sync_configs[sync_index].pdos, pdo_index)))
             break;
 
     if (pdo) {
-        ec_lock_down(&sc->master->master_sem);
         ec_pdo_clear_entries(pdo);
-        ec_lock_up(&sc->master->master_sem);
     } else {
         EC_CONFIG_WARN(sc, "PDO 0x%04X is not assigned.\n", pdo_index);
     }
@@ -848,6 +1012,19 @@ void ecrt_slave_config_pdo_mapping_clear(ec_slave_config_t *sc,
 
 /*****************************************************************************/
 
+void ecrt_slave_config_pdo_mapping_clear(ec_slave_config_t *sc,
+        uint16_t pdo_index)
+{
+    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, pdo_index = 0x%04X)\n",
+            __func__, sc, pdo_index);
+
+    ec_lock_down(&sc->master->master_sem);
+    ec_slave_config_pdo_mapping_clear_nolock(sc, pdo_index);
+    ec_lock_up(&sc->master->master_sem);
+}
+
+/*****************************************************************************/
+
 int ecrt_slave_config_pdos(ec_slave_config_t *sc,
         unsigned int n_syncs, const ec_sync_info_t syncs[])
 {
@@ -915,12 +1092,19 @@ int ecrt_slave_config_pdos(ec_slave_config_t *sc,
 
 /*****************************************************************************/
 
-int ecrt_slave_config_reg_pdo_entry(
-        ec_slave_config_t *sc,
-        uint16_t index,
-        uint8_t subindex,
-        ec_domain_t *domain,
-        unsigned int *bit_position
+/** Same as ecrt_slave_config_reg_pdo_entry(), but without locking.
+ *
+ * The master_sem has to be held by the caller.
+ *
+ * \retval >=0 Success, offset of the PDO entry's process data.
+ * \retval  <0 Error code.
+ */
+int ec_slave_config_reg_pdo_entry_nolock(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        uint16_t index, /**< Index of the PDO entry. */
+        uint8_t subindex, /**< Subindex of the PDO entry. */
+        ec_domain_t *domain, /**< Domain. */
+        unsigned int *bit_position /**< Bit position, or NULL. */
         )
 {
     uint8_t sync_index;
@@ -930,10 +1114,6 @@ int ecrt_slave_config_reg_pdo_entry(
     ec_pdo_entry_t *entry;
     int sync_offset;
 
-    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, index = 0x%04X, "
-            "subindex = 0x%02X, domain = 0x%p, bit_position = 0x%p)\n",
-            __func__, sc, index, subindex, domain, bit_position);
-
     for (sync_index = 0; sync_index < EC_MAX_SYNC_MANAGERS; sync_index++) {
         sync_config = &sc->sync_configs[sync_index];
         bit_offset = 0;
@@ -952,8 +1132,8 @@ int ecrt_slave_config_reg_pdo_entry(
                         return -EFAULT;
                     }
 
-                    sync_offset = ec_slave_config_prepare_fmmu(
-                            sc, domain, sync_index, sync_config->dir);
+                    sync_offset = ec_slave_config_prepare_fmmu_nolock(sc,
+                            domain, sync_index, sync_config->dir);
                     if (sync_offset < 0)
                         return sync_offset;
 
@@ -970,6 +1150,29 @@ int ecrt_slave_config_reg_pdo_entry(
 
 /*****************************************************************************/
 
+int ecrt_slave_config_reg_pdo_entry(
+        ec_slave_config_t *sc,
+        uint16_t index,
+        uint8_t subindex,
+        ec_domain_t *domain,
+        unsigned int *bit_position
+        )
+{
+    int ret;
+
+    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, index = 0x%04X, "
+            "subindex = 0x%02X, domain = 0x%p, bit_position = 0x%p)\n",
+            __func__, sc, index, subindex, domain, bit_position);
+
+    ec_lock_down(&sc->master->master_sem);
+    ret = ec_slave_config_reg_pdo_entry_nolock(sc, index, subindex, domain,
+            bit_position);
+    ec_lock_up(&sc->master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
 int ecrt_slave_config_reg_pdo_entry_pos(
         ec_slave_config_t *sc,
         uint8_t sync_index,
@@ -1261,6 +1464,13 @@ ec_sdo_request_t *ecrt_slave_config_create_sdo_request_err(
     req->data_size = size;
 
     ec_lock_down(&sc->master->master_sem);
+    if (ec_index_table_append(&sc->sdo_request_table, req)) {
+        ec_lock_up(&sc->master->master_sem);
+        EC_CONFIG_ERR(sc, "Failed to allocate SDO request table!\n");
+        ec_sdo_request_clear(req);
+        kfree(req);
+        return ERR_PTR(-ENOMEM);
+    }
     list_add_tail(&req->list, &sc->sdo_requests);
     ec_lock_up(&sc->master->master_sem);
 
@@ -1321,6 +1531,13 @@ ec_soe_request_t *ecrt_slave_config_create_soe_request_err(
     req->data_size = size;
 
     ec_lock_down(&sc->master->master_sem);
+    if (ec_index_table_append(&sc->soe_request_table, req)) {
+        ec_lock_up(&sc->master->master_sem);
+        EC_CONFIG_ERR(sc, "Failed to allocate SoE request table!\n");
+        ec_soe_request_clear(req);
+        kfree(req);
+        return ERR_PTR(-ENOMEM);
+    }
     list_add_tail(&req->list, &sc->soe_requests);
     ec_lock_up(&sc->master->master_sem);
 
@@ -1373,6 +1590,13 @@ ec_foe_request_t *ecrt_slave_config_create_foe_request_err(
     req->data_size = size;
 
     ec_lock_down(&sc->master->master_sem);
+    if (ec_index_table_append(&sc->foe_request_table, req)) {
+        ec_lock_up(&sc->master->master_sem);
+        EC_CONFIG_ERR(sc, "Failed to allocate FoE request table!\n");
+        ec_foe_request_clear(req);
+        kfree(req);
+        return ERR_PTR(-ENOMEM);
+    }
     list_add_tail(&req->list, &sc->foe_requests);
     ec_lock_up(&sc->master->master_sem);
 
@@ -1415,6 +1639,13 @@ ec_reg_request_t *ecrt_slave_config_create_reg_request_err(
     }
 
     ec_lock_down(&sc->master->master_sem);
+    if (ec_index_table_append(&sc->reg_request_table, reg)) {
+        ec_lock_up(&sc->master->master_sem);
+        EC_CONFIG_ERR(sc, "Failed to allocate register request table!\n");
+        ec_reg_request_clear(reg);
+        kfree(reg);
+        return ERR_PTR(-ENOMEM);
+    }
     list_add_tail(&reg->list, &sc->reg_requests);
     ec_lock_up(&sc->master->master_sem);
 
@@ -1457,6 +1688,13 @@ ec_voe_handler_t *ecrt_slave_config_create_voe_handler_err(
     }
 
     ec_lock_down(&sc->master->master_sem);
+    if (ec_index_table_append(&sc->voe_handler_table, voe)) {
+        ec_lock_up(&sc->master->master_sem);
+        EC_CONFIG_ERR(sc, "Failed to allocate VoE handler table!\n");
+        ec_voe_handler_clear(voe);
+        kfree(voe);
+        return ERR_PTR(-ENOMEM);
+    }
     list_add_tail(&voe->list, &sc->voe_handlers);
     ec_lock_up(&sc->master->master_sem);
 
@@ -44,6 +44,7 @@
 #include "sync_config.h"
 #include "fmmu_config.h"
 #include "coe_emerg_ring.h"
+#include "index_table.h"
 
 /*****************************************************************************/
 
@@ -144,11 +145,19 @@ struct ec_slave_config {
 
     struct list_head sdo_configs; /**< List of SDO configurations. */
     struct list_head sdo_requests; /**< List of SDO requests. */
+    ec_index_table_t sdo_request_table; /**< SDO requests by position. */
     struct list_head foe_requests; /**< List of FoE requests. */
+    ec_index_table_t foe_request_table; /**< FoE requests by position. */
     struct list_head voe_handlers; /**< List of VoE handlers. */
+    ec_index_table_t voe_handler_table; /**< VoE handlers by position. */
     struct list_head reg_requests; /**< List of register requests. */
+    ec_index_table_t reg_request_table; /**< Register requests by
+                                          position. */
     struct list_head soe_configs; /**< List of SoE configurations. */
     struct list_head soe_requests; /**< List of SOE requests. */
+    ec_index_table_t soe_request_table; /**< SoE requests by position. */
+    uint8_t completion_pending; /**< A request has finished since the last
+                                  ec_master_reap_completions(). */
 #ifdef EC_EOE
     struct list_head eoe_configs; /**< List of EoE configurations. */
 #endif
@@ -167,6 +176,16 @@ void ec_slave_config_detach(ec_slave_config_t *);
 
 void ec_slave_config_load_default_sync_config(ec_slave_config_t *);
 
+int ec_slave_config_pdo_assign_add_nolock(ec_slave_config_t *, uint8_t,
+        uint16_t);
+void ec_slave_config_pdo_assign_clear_nolock(ec_slave_config_t *, uint8_t);
+int ec_slave_config_pdo_mapping_add_nolock(ec_slave_config_t *, uint16_t,
+        uint16_t, uint8_t, uint8_t);
+void ec_slave_config_pdo_mapping_clear_nolock(ec_slave_config_t *,
+        uint16_t);
+int ec_slave_config_reg_pdo_entry_nolock(ec_slave_config_t *, uint16_t,
+        uint8_t, ec_domain_t *, unsigned int *);
+
 unsigned int ec_slave_config_sdo_count(const ec_slave_config_t *);
 const ec_sdo_request_t *ec_slave_config_get_sdo_by_pos_const(
         const ec_slave_config_t *, unsigned int);
@@ -184,6 +203,10 @@ ec_voe_handler_t *ec_slave_config_find_voe_handler(ec_slave_config_t *,
 ec_soe_request_t *ec_slave_config_find_soe_request(ec_slave_config_t *,
         unsigned int);
 void ec_slave_config_expire_disconnected_requests(ec_slave_config_t *);
+void ec_slave_config_mark_completion(ec_slave_config_t *);
+size_t ec_slave_config_request_memory_size(const ec_slave_config_t *);
+size_t ec_slave_config_request_external_memory(ec_slave_config_t *,
+        uint8_t *);
 
 ec_sdo_request_t *ecrt_slave_config_create_sdo_request_err(
         ec_slave_config_t *, uint16_t, uint8_t, uint8_t, size_t);
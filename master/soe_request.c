@@ -62,10 +62,12 @@ void ec_soe_request_init(
     req->idn = 0x0000;
     req->al_state = EC_AL_STATE_INIT;
     req->data = NULL;
+    req->data_origin = EC_ORIG_INTERNAL;
     req->mem_size = 0;
     req->data_size = 0;
     req->dir = EC_DIR_INVALID;
     req->state = EC_INT_REQUEST_INIT;
+    req->notify = 0;
     req->jiffies_sent = 0U;
     req->error_code = 0x0000;
 }
@@ -130,11 +132,12 @@ void ec_soe_request_clear_data(
         ec_soe_request_t *req /**< SoE request. */
         )
 {
-    if (req->data) {
+    if (req->data_origin == EC_ORIG_INTERNAL && req->data) {
         kfree(req->data);
-        req->data = NULL;
     }
 
+    req->data = NULL;
+    req->data_origin = EC_ORIG_INTERNAL;
     req->mem_size = 0;
     req->data_size = 0;
 }
@@ -144,8 +147,9 @@ void ec_soe_request_clear_data(
 /** Pre-allocates the data memory.
  *
  * If the \a mem_size is already bigger than \a size, nothing is done.
+ * External memory is never replaced.
  *
- * \return 0 on success, otherwise -ENOMEM.
+ * \return 0 on success, otherwise -ENOMEM or -EOVERFLOW.
  */
 int ec_soe_request_alloc(
         ec_soe_request_t *req, /**< SoE request. */
@@ -155,6 +159,12 @@ int ec_soe_request_alloc(
     if (size <= req->mem_size)
         return 0;
 
+    if (req->data_origin == EC_ORIG_EXTERNAL) {
+        EC_ERR("%zu bytes do not fit into the SoE memory (%zu bytes).\n",
+                size, req->mem_size);
+        return -EOVERFLOW;
+    }
+
     ec_soe_request_clear_data(req);
 
     if (!(req->data = (uint8_t *) kmalloc(size, GFP_KERNEL))) {
@@ -208,7 +218,15 @@ int ec_soe_request_append_data(
 {
     if (req->data_size + size > req->mem_size) {
         size_t new_size = req->mem_size ? req->mem_size * 2 : size;
-        uint8_t *new_data = (uint8_t *) kmalloc(new_size, GFP_KERNEL);
+        uint8_t *new_data;
+
+        if (req->data_origin == EC_ORIG_EXTERNAL) {
+            EC_ERR("%zu bytes do not fit into the SoE memory (%zu bytes).\n",
+                    req->data_size + size, req->mem_size);
+            return -EOVERFLOW;
+        }
+
+        new_data = (uint8_t *) kmalloc(new_size, GFP_KERNEL);
         if (!new_data) {
             EC_ERR("Failed to allocate %zu bytes of SoE memory.\n",
                     new_size);
@@ -227,6 +245,32 @@ int ec_soe_request_append_data(
 
 /*****************************************************************************/
 
+/** Moves the SoE data to external memory.
+ *
+ * The current data are copied and the internal memory is freed. The request
+ * can not grow beyond \a size bytes afterwards.
+ */
+void ec_soe_request_external_memory(
+        ec_soe_request_t *req, /**< SoE request. */
+        uint8_t *mem, /**< External memory. */
+        size_t size /**< Size of \a mem (at least \a mem_size). */
+        )
+{
+    size_t data_size = req->data_size;
+
+    if (req->data) {
+        memcpy(mem, req->data, req->mem_size);
+    }
+
+    ec_soe_request_clear_data(req);
+    req->data = mem;
+    req->data_origin = EC_ORIG_EXTERNAL;
+    req->mem_size = size;
+    req->data_size = data_size;
+}
+
+/*****************************************************************************/
+
 /** Request a read operation.
  */
 void ec_soe_request_read(
@@ -269,12 +313,16 @@ size_t ecrt_soe_request_data_size(const ec_soe_request_t *req)
 
 void ecrt_soe_request_read(ec_soe_request_t *req) {
     ec_soe_request_read(req);
+    smp_wmb();
+    req->notify = 1;
 }
 
 /*****************************************************************************/
 
 void ecrt_soe_request_write(ec_soe_request_t *req) {
     ec_soe_request_write(req);
+    smp_wmb();
+    req->notify = 1;
 }
 
 /*****************************************************************************/
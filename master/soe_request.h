@@ -51,11 +51,14 @@ struct ec_soe_request {
     uint16_t idn; /**< Sercos ID-Number. */
     ec_al_state_t al_state; /**< AL state (only valid for IDN config). */
     uint8_t *data; /**< Pointer to SDO data. */
+    ec_origin_t data_origin; /**< Origin of the \a data memory. */
     size_t mem_size; /**< Size of SDO data memory. */
     size_t data_size; /**< Size of SDO data. */
     ec_direction_t dir; /**< Direction. EC_DIR_OUTPUT means writing to the
                           slave, EC_DIR_INPUT means reading from the slave. */
     ec_internal_request_state_t state; /**< Request state. */
+    uint8_t notify; /**< Completion has to be reported to the application.
+                      Set after the request state was written. */
     unsigned long jiffies_sent; /**< Jiffies, when the upload/download
                                      request was sent. */
     uint16_t error_code; /**< SoE error code. */
@@ -72,6 +75,7 @@ void ec_soe_request_set_idn(ec_soe_request_t *, uint16_t);
 int ec_soe_request_alloc(ec_soe_request_t *, size_t);
 int ec_soe_request_copy_data(ec_soe_request_t *, const uint8_t *, size_t);
 int ec_soe_request_append_data(ec_soe_request_t *, const uint8_t *, size_t);
+void ec_soe_request_external_memory(ec_soe_request_t *, uint8_t *, size_t);
 void ec_soe_request_read(ec_soe_request_t *);
 void ec_soe_request_write(ec_soe_request_t *);
 
@@ -83,6 +83,9 @@ int ec_voe_handler_init(
     voe->dir = EC_DIR_INVALID;
     voe->state = ec_voe_handler_state_error;
     voe->request_state = EC_INT_REQUEST_INIT;
+    voe->notify = 0;
+    voe->shared_data = NULL;
+    voe->shared_size = 0;
 
     ec_datagram_init(&voe->datagram);
     return ec_datagram_prealloc(&voe->datagram,
@@ -97,6 +100,7 @@ void ec_voe_handler_clear(
         ec_voe_handler_t *voe /**< VoE handler. */
         )
 {
+    ec_master_forget_datagram(voe->config->master, &voe->datagram);
     ec_datagram_clear(&voe->datagram);
 }
 
@@ -117,6 +121,26 @@ size_t ec_voe_handler_mem_size(
         return 0;
 }
 
+/*****************************************************************************/
+
+/** Shares the data of the handler with the application.
+ *
+ * The mailbox datagrams are still built in the handler's own memory, so
+ * that the application can not modify them while they are sent. The data
+ * are copied from and to \a mem, when the application writes or has read
+ * data (see ec_ioctl_voe_write() and ec_ioctl_voe_exec()).
+ */
+void ec_voe_handler_external_memory(
+        ec_voe_handler_t *voe, /**< VoE handler. */
+        uint8_t *mem, /**< External memory. */
+        size_t size /**< Size of \a mem (at least the data memory). */
+        )
+{
+    memcpy(mem, ecrt_voe_handler_data(voe), ec_voe_handler_mem_size(voe));
+    voe->shared_data = mem;
+    voe->shared_size = size;
+}
+
 /*****************************************************************************
  * Application interface.
  ****************************************************************************/
@@ -162,6 +186,8 @@ void ecrt_voe_handler_read(ec_voe_handler_t *voe)
     voe->dir = EC_DIR_INPUT;
     voe->state = ec_voe_handler_state_read_start;
     voe->request_state = EC_INT_REQUEST_BUSY;
+    smp_wmb();
+    voe->notify = 1;
 }
 
 /*****************************************************************************/
@@ -171,6 +197,8 @@ void ecrt_voe_handler_read_nosync(ec_voe_handler_t *voe)
     voe->dir = EC_DIR_INPUT;
     voe->state = ec_voe_handler_state_read_nosync_start;
     voe->request_state = EC_INT_REQUEST_BUSY;
+    smp_wmb();
+    voe->notify = 1;
 }
 
 /*****************************************************************************/
@@ -181,6 +209,8 @@ void ecrt_voe_handler_write(ec_voe_handler_t *voe, size_t size)
     voe->data_size = size;
     voe->state = ec_voe_handler_state_write_start;
     voe->request_state = EC_INT_REQUEST_BUSY;
+    smp_wmb();
+    voe->notify = 1;
 }
 
 /*****************************************************************************/
@@ -197,6 +227,11 @@ ec_request_state_t ecrt_voe_handler_execute(ec_voe_handler_t *voe)
         voe->request_state = EC_INT_REQUEST_FAILURE;
     }
 
+    if (voe->notify && (voe->request_state == EC_INT_REQUEST_SUCCESS
+                || voe->request_state == EC_INT_REQUEST_FAILURE)) {
+        ec_slave_config_mark_completion(voe->config);
+    }
+
     return ec_request_state_translation_table[voe->request_state];
 }
 
@@ -50,6 +50,9 @@ struct ec_voe_handler {
     struct list_head list; /**< List item. */
     ec_slave_config_t *config; /**< Parent slave configuration. */
     ec_datagram_t datagram; /**< State machine datagram. */
+    uint8_t *shared_data; /**< Data memory shared with the application, or
+                            NULL. */
+    size_t shared_size; /**< Size of \a shared_data. */
     uint32_t vendor_id; /**< Vendor ID for the header. */
     uint16_t vendor_type; /**< Vendor type for the header. */
     size_t data_size; /**< Size of VoE data. */
@@ -58,6 +61,8 @@ struct ec_voe_handler {
                           slave. */
     void (*state)(ec_voe_handler_t *); /**< State function */
     ec_internal_request_state_t request_state; /**< Handler state. */
+    uint8_t notify; /**< Completion has to be reported to the application.
+                      Set after the request state was written. */
     unsigned int retries; /**< retries upon datagram timeout */
     unsigned long jiffies_start; /**< Timestamp for timeout calculation. */
 };
@@ -67,6 +72,7 @@ struct ec_voe_handler {
 int ec_voe_handler_init(ec_voe_handler_t *, ec_slave_config_t *, size_t);
 void ec_voe_handler_clear(ec_voe_handler_t *);
 size_t ec_voe_handler_mem_size(const ec_voe_handler_t *);
+void ec_voe_handler_external_memory(ec_voe_handler_t *, uint8_t *, size_t);
 
 /*****************************************************************************/
 
@@ -0,0 +1,91 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Fake EtherCAT device, that captures the sent frames.
+*/
+
+/*****************************************************************************/
+
+#include "test.h"
+
+/*****************************************************************************/
+
+test_frame_t test_frames[TEST_FRAME_COUNT];
+unsigned int test_frame_count = 0;
+
+ec_master_t test_master;
+struct net_device test_dev = { .name = "test0" };
+ec_ioctl_state_page_t test_state_page;
+
+/*****************************************************************************/
+
+uint8_t *ec_device_tx_data(ec_device_t *device)
+{
+    TEST_ASSERT(test_frame_count < TEST_FRAME_COUNT);
+    return test_frames[test_frame_count].data;
+}
+
+/*****************************************************************************/
+
+void ec_device_send(ec_device_t *device, size_t size)
+{
+    test_frames[test_frame_count++].size = size;
+}
+
+/*****************************************************************************/
+
+void ec_device_poll(ec_device_t *device)
+{
+#ifdef EC_HAVE_CYCLES
+    device->cycles_poll = get_cycles();
+#endif
+    device->jiffies_poll = jiffies;
+}
+
+/*****************************************************************************/
+
+void ec_device_update_stats(ec_device_t *device)
+{
+}
+
+/*****************************************************************************/
+
+void ec_print_data(const uint8_t *data, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        printk(KERN_CONT "%02X ", data[i]);
+    }
+    printk(KERN_CONT "\n");
+}
+
+/*****************************************************************************/
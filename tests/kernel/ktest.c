@@ -0,0 +1,195 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Userspace implementations of the kernel functions used by the tests.
+*/
+
+/*****************************************************************************/
+
+#include "ktest.h"
+
+/*****************************************************************************/
+
+volatile unsigned long jiffies = 0;
+unsigned int cpu_khz = 1000;
+
+/** Value returned by get_cycles(), advanced by the tests.
+ */
+cycles_t ktest_cycles = 0;
+
+/*****************************************************************************/
+
+int printk(const char *format, ...)
+{
+    va_list args;
+    int ret;
+
+    va_start(args, format);
+    ret = vfprintf(stderr, format, args);
+    va_end(args);
+    return ret;
+}
+
+/*****************************************************************************/
+
+cycles_t get_cycles(void)
+{
+    return ktest_cycles;
+}
+
+/*****************************************************************************/
+
+unsigned long get_zeroed_page(gfp_t flags)
+{
+    void *page;
+
+    (void) flags;
+    if (posix_memalign(&page, PAGE_SIZE, PAGE_SIZE)) {
+        return 0;
+    }
+    memset(page, 0x00, PAGE_SIZE);
+    return (unsigned long) page;
+}
+
+/*****************************************************************************/
+
+void free_page(unsigned long addr)
+{
+    free((void *) addr);
+}
+
+/*****************************************************************************/
+
+/** Searches a bitmap for the next bit with a given value.
+ */
+static unsigned long find_next(
+        const unsigned long *addr, /**< Bitmap. */
+        unsigned long size, /**< Number of bits. */
+        unsigned long offset, /**< First bit to check. */
+        int value /**< Bit value to search for. */
+        )
+{
+    for (; offset < size; offset++) {
+        if (test_bit(offset, addr) == value) {
+            return offset;
+        }
+    }
+
+    return size;
+}
+
+/*****************************************************************************/
+
+unsigned long find_next_bit(const unsigned long *addr, unsigned long size,
+        unsigned long offset)
+{
+    return find_next(addr, size, offset, 1);
+}
+
+/*****************************************************************************/
+
+unsigned long find_next_zero_bit(const unsigned long *addr,
+        unsigned long size, unsigned long offset)
+{
+    return find_next(addr, size, offset, 0);
+}
+
+/*****************************************************************************/
+
+/** Sorts a list stably, like the kernel's merge sort.
+ *
+ * Insertion sort is sufficient for the list sizes of the tests.
+ */
+void list_sort(void *priv, struct list_head *head,
+        int (*cmp)(void *, const struct list_head *,
+            const struct list_head *))
+{
+    struct list_head sorted, *item, *pos;
+
+    INIT_LIST_HEAD(&sorted);
+
+    while (!list_empty(head)) {
+        item = head->next;
+        list_del(item);
+
+        // insert behind the last element, that is not greater
+        for (pos = sorted.prev; pos != &sorted; pos = pos->prev) {
+            if (cmp(priv, pos, item) <= 0) {
+                break;
+            }
+        }
+        __list_add(item, pos, pos->next);
+    }
+
+    list_splice(&sorted, head);
+}
+
+/*****************************************************************************/
+
+void sort(void *base, size_t num, size_t size,
+        int (*cmp)(const void *, const void *),
+        void (*swap)(void *, void *, int))
+{
+    (void) swap;
+    qsort(base, num, size, cmp);
+}
+
+/*****************************************************************************/
+
+unsigned long gcd(unsigned long a, unsigned long b)
+{
+    unsigned long r;
+
+    while (b) {
+        r = a % b;
+        a = b;
+        b = r;
+    }
+
+    return a;
+}
+
+/*****************************************************************************/
+
+size_t strlcpy(char *dest, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+
+    if (size) {
+        size_t n = len >= size ? size - 1 : len;
+        memcpy(dest, src, n);
+        dest[n] = '\0';
+    }
+
+    return len;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,782 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Userspace stand-in for the kernel interfaces used by the master sources.
+
+   The headers in linux/, asm/ and uapi/ only include this file, so that
+   master sources can be compiled into the unit tests. Locks, wait queues
+   and threads do nothing, memory comes from the C library. Functions, that
+   the tested code does not reach, are only declared; the tests are linked
+   with --gc-sections, so they need no definition.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_KTEST_H__
+#define __EC_KTEST_H__
+
+/* Keep the C library from defining struct timeval and errno, which the
+ * master sources declare themselves. */
+#define _ISOC11_SOURCE 1
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define __KERNEL__ 1
+
+#define LINUX_VERSION_CODE KERNEL_VERSION(5, 15, 0)
+#define KERNEL_VERSION(a, b, c) (((a) << 16) + ((b) << 8) + (c))
+
+/*****************************************************************************/
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef u16 __le16;
+typedef u32 __le32;
+typedef u64 __le64;
+typedef long loff_t;
+typedef unsigned int dev_t;
+typedef long __kernel_old_time_t;
+typedef long __kernel_suseconds_t;
+typedef unsigned int fmode_t;
+typedef unsigned int gfp_t;
+typedef unsigned long cycles_t;
+typedef s64 ktime_t;
+typedef unsigned int vm_fault_t;
+typedef unsigned int __poll_t;
+
+#define __user
+#define __iomem
+#define __init
+#define __exit
+
+#define likely(x) __builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
+
+#define EPERM 1
+#define ENOENT 2
+#define EINTR 4
+#define EIO 5
+#define ENXIO 6
+#define ECHILD 10
+#define EAGAIN 11
+#define ENOMEM 12
+#define EFAULT 14
+#define EBUSY 16
+#define EEXIST 17
+#define ENODEV 19
+#define EINVAL 22
+#define ENOTTY 25
+#define EFBIG 27
+#define ENOSPC 28
+#define ENOSYS 38
+#define EPROTO 71
+#define EOVERFLOW 75
+#define ENOPROTOOPT 92
+#define EPROTONOSUPPORT 93
+#define EOPNOTSUPP 95
+#define EADDRINUSE 98
+#define EADDRNOTAVAIL 99
+#define ENOBUFS 105
+#define ERESTARTSYS 512
+#define ENOIOCTLCMD 515
+#define ENOTSUPP 524
+
+#ifndef INT_MAX
+#define INT_MAX ((int) (~0U >> 1))
+#endif
+
+/*****************************************************************************/
+
+#define KERN_ERR ""
+#define KERN_WARNING ""
+#define KERN_NOTICE ""
+#define KERN_INFO ""
+#define KERN_DEBUG ""
+#define KERN_CONT ""
+
+int printk(const char *, ...) __attribute__((format(printf, 1, 2)));
+int printk_ratelimit(void);
+
+#define BUILD_BUG_ON(c) ((void) sizeof(char[1 - 2 * !!(c)]))
+#define BUG_ON(c) do { if (c) abort(); } while (0)
+#define WARN_ON(c) (!!(c))
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define min_t(t, a, b) ((t) (a) < (t) (b) ? (t) (a) : (t) (b))
+#define max_t(t, a, b) ((t) (a) > (t) (b) ? (t) (a) : (t) (b))
+#define DIV_ROUND_UP(n, d) (((n) + (d) - 1) / (d))
+#define ALIGN(x, a) (((x) + (a) - 1) & ~((typeof(x)) (a) - 1))
+#define IS_ALIGNED(x, a) (((x) & ((typeof(x)) (a) - 1)) == 0)
+#define BIT(n) (1UL << (n))
+#define do_div(n, base) ({ uint32_t __rem = (n) % (base); \
+        (n) /= (base); __rem; })
+
+#define container_of(ptr, type, member) \
+    ((type *) ((char *) (ptr) - offsetof(type, member)))
+
+#define barrier() __asm__ __volatile__("" ::: "memory")
+#define smp_mb() __sync_synchronize()
+#define smp_rmb() __sync_synchronize()
+#define smp_wmb() __sync_synchronize()
+#define READ_ONCE(x) (*(const volatile typeof(x) *) &(x))
+#define WRITE_ONCE(x, v) (*(volatile typeof(x) *) &(x) = (v))
+#define smp_load_acquire(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define smp_store_release(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define cpu_to_le16(x) ((u16) (x))
+#define cpu_to_le32(x) ((u32) (x))
+#define cpu_to_le64(x) ((u64) (x))
+#else
+#define cpu_to_le16(x) __builtin_bswap16(x)
+#define cpu_to_le32(x) __builtin_bswap32(x)
+#define cpu_to_le64(x) __builtin_bswap64(x)
+#endif
+#define le16_to_cpu(x) cpu_to_le16(x)
+#define le32_to_cpu(x) cpu_to_le32(x)
+#define le64_to_cpu(x) cpu_to_le64(x)
+#define le16_to_cpup(p) le16_to_cpu(*(const u16 *) (p))
+#define le32_to_cpup(p) le32_to_cpu(*(const u32 *) (p))
+#define le64_to_cpup(p) le64_to_cpu(*(const u64 *) (p))
+u16 htons(u16);
+u32 htonl(u32);
+
+/*****************************************************************************/
+
+struct list_head {
+    struct list_head *next, *prev;
+};
+
+#define LIST_HEAD_INIT(name) { &(name), &(name) }
+#define LIST_HEAD(name) struct list_head name = LIST_HEAD_INIT(name)
+
+static inline void INIT_LIST_HEAD(struct list_head *list)
+{
+    list->next = list;
+    list->prev = list;
+}
+
+static inline void __list_add(struct list_head *new,
+        struct list_head *prev, struct list_head *next)
+{
+    next->prev = new;
+    new->next = next;
+    new->prev = prev;
+    prev->next = new;
+}
+
+static inline void list_add(struct list_head *new, struct list_head *head)
+{
+    __list_add(new, head, head->next);
+}
+
+static inline void list_add_tail(struct list_head *new,
+        struct list_head *head)
+{
+    __list_add(new, head->prev, head);
+}
+
+static inline void list_del(struct list_head *entry)
+{
+    entry->next->prev = entry->prev;
+    entry->prev->next = entry->next;
+    entry->next = NULL;
+    entry->prev = NULL;
+}
+
+static inline void list_del_init(struct list_head *entry)
+{
+    entry->next->prev = entry->prev;
+    entry->prev->next = entry->next;
+    INIT_LIST_HEAD(entry);
+}
+
+static inline void list_move(struct list_head *list, struct list_head *head)
+{
+    list_del_init(list);
+    list_add(list, head);
+}
+
+static inline void list_move_tail(struct list_head *list,
+        struct list_head *head)
+{
+    list_del_init(list);
+    list_add_tail(list, head);
+}
+
+static inline int list_empty(const struct list_head *head)
+{
+    return head->next == head;
+}
+
+static inline int list_is_singular(const struct list_head *head)
+{
+    return !list_empty(head) && head->next == head->prev;
+}
+
+static inline int list_is_last(const struct list_head *list,
+        const struct list_head *head)
+{
+    return list->next == head;
+}
+
+static inline void __list_splice(const struct list_head *list,
+        struct list_head *prev, struct list_head *next)
+{
+    list->next->prev = prev;
+    prev->next = list->next;
+    list->prev->next = next;
+    next->prev = list->prev;
+}
+
+static inline void list_splice(const struct list_head *list,
+        struct list_head *head)
+{
+    if (!list_empty(list)) {
+        __list_splice(list, head, head->next);
+    }
+}
+
+static inline void list_splice_tail(const struct list_head *list,
+        struct list_head *head)
+{
+    if (!list_empty(list)) {
+        __list_splice(list, head->prev, head);
+    }
+}
+
+static inline void list_splice_init(struct list_head *list,
+        struct list_head *head)
+{
+    list_splice(list, head);
+    INIT_LIST_HEAD(list);
+}
+
+static inline void list_splice_tail_init(struct list_head *list,
+        struct list_head *head)
+{
+    list_splice_tail(list, head);
+    INIT_LIST_HEAD(list);
+}
+
+#define list_entry(ptr, type, member) container_of(ptr, type, member)
+#define list_first_entry(ptr, type, member) \
+    list_entry((ptr)->next, type, member)
+#define list_last_entry(ptr, type, member) \
+    list_entry((ptr)->prev, type, member)
+#define list_first_entry_or_null(ptr, type, member) \
+    (!list_empty(ptr) ? list_first_entry(ptr, type, member) : NULL)
+#define list_next_entry(pos, member) \
+    list_entry((pos)->member.next, typeof(*(pos)), member)
+#define list_prev_entry(pos, member) \
+    list_entry((pos)->member.prev, typeof(*(pos)), member)
+#define list_for_each(pos, head) \
+    for (pos = (head)->next; pos != (head); pos = pos->next)
+#define list_for_each_safe(pos, n, head) \
+    for (pos = (head)->next, n = pos->next; pos != (head); \
+            pos = n, n = pos->next)
+#define list_for_each_entry(pos, head, member) \
+    for (pos = list_first_entry(head, typeof(*pos), member); \
+            &pos->member != (head); pos = list_next_entry(pos, member))
+#define list_for_each_entry_reverse(pos, head, member) \
+    for (pos = list_last_entry(head, typeof(*pos), member); \
+            &pos->member != (head); pos = list_prev_entry(pos, member))
+#define list_for_each_entry_from(pos, head, member) \
+    for (; &pos->member != (head); pos = list_next_entry(pos, member))
+#define list_for_each_entry_continue(pos, head, member) \
+    for (pos = list_next_entry(pos, member); &pos->member != (head); \
+            pos = list_next_entry(pos, member))
+#define list_for_each_entry_safe(pos, n, head, member) \
+    for (pos = list_first_entry(head, typeof(*pos), member), \
+            n = list_next_entry(pos, member); &pos->member != (head); \
+            pos = n, n = list_next_entry(n, member))
+#define list_for_each_entry_safe_from(pos, n, head, member) \
+    for (n = list_next_entry(pos, member); &pos->member != (head); \
+            pos = n, n = list_next_entry(n, member))
+
+void list_sort(void *, struct list_head *,
+        int (*)(void *, const struct list_head *, const struct list_head *));
+void sort(void *, size_t, size_t, int (*)(const void *, const void *),
+        void (*)(void *, void *, int));
+unsigned long gcd(unsigned long, unsigned long);
+size_t strlcpy(char *, const char *, size_t);
+
+/*****************************************************************************/
+
+#define BITS_PER_LONG (8 * (int) sizeof(long))
+#define BITS_TO_LONGS(n) DIV_ROUND_UP(n, BITS_PER_LONG)
+#define DECLARE_BITMAP(name, bits) unsigned long name[BITS_TO_LONGS(bits)]
+
+static inline void set_bit(long nr, volatile unsigned long *addr)
+{
+    addr[nr / BITS_PER_LONG] |= 1UL << (nr % BITS_PER_LONG);
+}
+
+static inline void clear_bit(long nr, volatile unsigned long *addr)
+{
+    addr[nr / BITS_PER_LONG] &= ~(1UL << (nr % BITS_PER_LONG));
+}
+
+static inline int test_bit(long nr, const volatile unsigned long *addr)
+{
+    return (addr[nr / BITS_PER_LONG] >> (nr % BITS_PER_LONG)) & 1;
+}
+
+#define __set_bit(nr, addr) set_bit(nr, addr)
+#define __clear_bit(nr, addr) clear_bit(nr, addr)
+
+static inline void bitmap_zero(unsigned long *dst, unsigned int nbits)
+{
+    memset(dst, 0, BITS_TO_LONGS(nbits) * sizeof(unsigned long));
+}
+
+unsigned long find_next_bit(const unsigned long *, unsigned long,
+        unsigned long);
+unsigned long find_next_zero_bit(const unsigned long *, unsigned long,
+        unsigned long);
+#define find_first_bit(addr, size) find_next_bit(addr, size, 0)
+#define find_first_zero_bit(addr, size) find_next_zero_bit(addr, size, 0)
+#define for_each_set_bit(bit, addr, size) \
+    for ((bit) = find_first_bit((addr), (size)); (bit) < (size); \
+            (bit) = find_next_bit((addr), (size), (bit) + 1))
+
+/*****************************************************************************/
+
+#define GFP_KERNEL 0
+#define GFP_ATOMIC 1
+#define PAGE_SHIFT 12
+#define PAGE_SIZE (1UL << PAGE_SHIFT)
+#define PAGE_ALIGN(x) ALIGN(x, PAGE_SIZE)
+
+static inline void *kmalloc(size_t size, gfp_t flags)
+{
+    (void) flags;
+    return malloc(size ? size : 1);
+}
+
+static inline void *kzalloc(size_t size, gfp_t flags)
+{
+    (void) flags;
+    return calloc(1, size ? size : 1);
+}
+
+static inline void *kmalloc_array(size_t n, size_t size, gfp_t flags)
+{
+    (void) flags;
+    return malloc(n && size ? n * size : 1);
+}
+
+static inline void *kcalloc(size_t n, size_t size, gfp_t flags)
+{
+    (void) flags;
+    return calloc(n ? n : 1, size ? size : 1);
+}
+
+static inline void *krealloc(const void *p, size_t size, gfp_t flags)
+{
+    (void) flags;
+    return realloc((void *) p, size ? size : 1);
+}
+
+static inline void kfree(const void *p)
+{
+    free((void *) p);
+}
+
+#define kvfree(p) kfree(p)
+#define vmalloc(size) kmalloc(size, GFP_KERNEL)
+#define vzalloc(size) kzalloc(size, GFP_KERNEL)
+#define vmalloc_user(size) kzalloc(size, GFP_KERNEL)
+#define vfree(p) kfree(p)
+
+unsigned long get_zeroed_page(gfp_t);
+void free_page(unsigned long);
+char *kstrdup(const char *, gfp_t);
+unsigned long simple_strtoul(const char *, char **, unsigned int);
+
+struct page;
+struct page *virt_to_page(const void *);
+struct page *vmalloc_to_page(const void *);
+void get_page(struct page *);
+
+static inline unsigned long copy_to_user(void __user *to, const void *from,
+        unsigned long n)
+{
+    memcpy(to, from, n);
+    return 0;
+}
+
+static inline unsigned long copy_from_user(void *to,
+        const void __user *from, unsigned long n)
+{
+    memcpy(to, from, n);
+    return 0;
+}
+
+#define __copy_to_user(to, from, n) copy_to_user(to, from, n)
+#define get_user(x, p) ((x) = *(p), 0)
+#define put_user(x, p) (*(p) = (x), 0)
+
+#define ERR_PTR(err) ((void *) (long) (err))
+#define PTR_ERR(p) ((long) (p))
+#define IS_ERR(p) ((unsigned long) (p) >= (unsigned long) -4095)
+#define IS_ERR_OR_NULL(p) (!(p) || IS_ERR(p))
+
+/*****************************************************************************/
+
+struct semaphore {
+    int count;
+};
+
+struct rt_mutex {
+    int locked;
+};
+
+static inline void sema_init(struct semaphore *sem, int count)
+{
+    sem->count = count;
+}
+
+static inline void down(struct semaphore *sem)
+{
+    sem->count--;
+}
+
+static inline int down_interruptible(struct semaphore *sem)
+{
+    sem->count--;
+    return 0;
+}
+
+static inline void up(struct semaphore *sem)
+{
+    sem->count++;
+}
+
+static inline void rt_mutex_init(struct rt_mutex *lock)
+{
+    lock->locked = 0;
+}
+
+static inline void rt_mutex_lock(struct rt_mutex *lock)
+{
+    lock->locked = 1;
+}
+
+static inline int rt_mutex_lock_interruptible(struct rt_mutex *lock)
+{
+    lock->locked = 1;
+    return 0;
+}
+
+static inline void rt_mutex_unlock(struct rt_mutex *lock)
+{
+    lock->locked = 0;
+}
+
+typedef struct {
+    int unused;
+} spinlock_t;
+
+typedef struct wait_queue_head {
+    int unused;
+} wait_queue_head_t;
+
+#define init_waitqueue_head(q) ((void) (q))
+#define wake_up(q) ((void) (q))
+#define wake_up_all(q) ((void) (q))
+#define wake_up_interruptible(q) ((void) (q))
+#define wait_event(q, cond) do { (void) (q); } while (!(cond))
+#define wait_event_interruptible(q, cond) ((void) (q), !(cond) ? -EINTR : 0)
+#define wait_event_interruptible_timeout(q, cond, t) \
+    ((void) (q), (cond) ? 1 : 0)
+#define wait_event_timeout(q, cond, t) ((void) (q), (cond) ? 1 : 0)
+
+/*****************************************************************************/
+
+#define rcu_read_lock() do {} while (0)
+#define rcu_read_unlock() do {} while (0)
+#define rcu_dereference(p) READ_ONCE(p)
+#define rcu_assign_pointer(p, v) WRITE_ONCE(p, v)
+
+struct rcu_head {
+    struct rcu_head *next;
+    void (*func)(struct rcu_head *);
+};
+
+#define kfree_rcu(p, field) kfree(p)
+#define kvfree_rcu(p, field) kvfree(p)
+void call_rcu(struct rcu_head *, void (*)(struct rcu_head *));
+void synchronize_rcu(void);
+void rcu_barrier(void);
+
+/*****************************************************************************/
+
+#define preempt_disable() do {} while (0)
+#define preempt_enable() do {} while (0)
+
+typedef struct {
+    unsigned int sequence;
+} seqcount_t;
+
+#define seqcount_init(s) ((s)->sequence = 0)
+#define write_seqcount_begin(s) \
+    do { (s)->sequence++; smp_wmb(); } while (0)
+#define write_seqcount_end(s) \
+    do { smp_wmb(); (s)->sequence++; } while (0)
+
+static inline unsigned int read_seqcount_begin(const seqcount_t *s)
+{
+    unsigned int seq;
+
+    while ((seq = READ_ONCE(s->sequence)) & 1) {
+    }
+    smp_rmb();
+    return seq;
+}
+
+static inline int read_seqcount_retry(const seqcount_t *s, unsigned int seq)
+{
+    smp_rmb();
+    return READ_ONCE(s->sequence) != seq;
+}
+
+/*****************************************************************************/
+
+#define HZ 1000
+#define NSEC_PER_USEC 1000L
+#define NSEC_PER_SEC 1000000000L
+
+extern volatile unsigned long jiffies;
+extern unsigned int cpu_khz;
+cycles_t get_cycles(void);
+
+#define time_after(a, b) ((long) ((b) - (a)) < 0)
+#define time_before(a, b) time_after(b, a)
+
+struct timespec64 {
+    s64 tv_sec;
+    long tv_nsec;
+};
+
+void ktime_get_ts64(struct timespec64 *);
+ktime_t ktime_get(void);
+#define ktime_set(s, ns) ((ktime_t) (s) * NSEC_PER_SEC + (ns))
+#define ktime_to_ns(k) (k)
+#define ktime_to_us(k) ((k) / NSEC_PER_USEC)
+#define ktime_add_ns(k, ns) ((k) + (ns))
+#define ns_to_ktime(ns) ((ktime_t) (ns))
+ktime_t ktime_add_us(ktime_t, u64);
+
+struct timer_list {
+    int unused;
+};
+
+enum hrtimer_restart {
+    HRTIMER_NORESTART,
+    HRTIMER_RESTART
+};
+
+enum hrtimer_mode {
+    HRTIMER_MODE_ABS,
+    HRTIMER_MODE_REL
+};
+
+#define CLOCK_MONOTONIC 1
+
+struct hrtimer {
+    enum hrtimer_restart (*function)(struct hrtimer *);
+};
+
+struct hrtimer_sleeper {
+    struct hrtimer timer;
+    struct task_struct *task;
+};
+
+void hrtimer_init(struct hrtimer *, int, enum hrtimer_mode);
+void hrtimer_init_sleeper(struct hrtimer_sleeper *, struct task_struct *);
+void hrtimer_start(struct hrtimer *, ktime_t, enum hrtimer_mode);
+void hrtimer_start_expires(struct hrtimer *, enum hrtimer_mode);
+int hrtimer_cancel(struct hrtimer *);
+ktime_t hrtimer_get_expires(const struct hrtimer *);
+void hrtimer_set_expires(struct hrtimer *, ktime_t);
+
+/*****************************************************************************/
+
+#define TASK_RUNNING 0
+#define TASK_INTERRUPTIBLE 1
+#define TASK_UNINTERRUPTIBLE 2
+#define MAX_SCHEDULE_TIMEOUT 0x7fffffffL
+
+struct task_struct {
+    int pid;
+    char comm[16];
+};
+
+extern struct task_struct *current;
+extern unsigned int nr_cpu_ids;
+
+struct task_struct *kthread_create(int (*)(void *), void *,
+        const char *, ...);
+struct task_struct *kthread_run(int (*)(void *), void *, const char *, ...);
+int kthread_stop(struct task_struct *);
+int kthread_should_stop(void);
+void kthread_bind(struct task_struct *, unsigned int);
+int wake_up_process(struct task_struct *);
+void set_current_state(long);
+void __set_current_state(long);
+void schedule(void);
+long schedule_timeout(long);
+void freezable_schedule(void);
+int signal_pending(struct task_struct *);
+void cond_resched(void);
+void cpu_relax(void);
+void usleep_range(unsigned long, unsigned long);
+int cpu_online(unsigned int);
+void sched_set_fifo(struct task_struct *);
+void sched_set_normal(struct task_struct *, int);
+
+/*****************************************************************************/
+
+struct module {
+    int unused;
+};
+
+extern struct module __this_module;
+#define THIS_MODULE (&__this_module)
+
+int try_module_get(struct module *);
+void module_put(struct module *);
+
+#define EXPORT_SYMBOL(sym) extern typeof(sym) sym
+#define EXPORT_SYMBOL_GPL(sym) extern typeof(sym) sym
+#define MODULE_AUTHOR(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_LICENSE(x)
+#define MODULE_VERSION(x)
+#define MODULE_PARM_DESC(name, desc)
+#define module_param(name, type, perm)
+#define module_param_array(name, type, num, perm)
+#define module_param_named(name, value, type, perm)
+#define module_init(fn)
+#define module_exit(fn)
+#define S_IRUGO 0444
+
+/*****************************************************************************/
+
+#define _IOC(dir, type, nr, size) \
+    (((dir) << 30) | ((size) << 16) | ((type) << 8) | (nr))
+#define _IO(type, nr) _IOC(0U, type, nr, 0U)
+#define _IOW(type, nr, arg) _IOC(1U, type, nr, sizeof(arg))
+#define _IOR(type, nr, arg) _IOC(2U, type, nr, sizeof(arg))
+#define _IOWR(type, nr, arg) _IOC(3U, type, nr, sizeof(arg))
+#define _IOC_NR(nr) ((nr) & 0xff)
+
+#define MKDEV(major, minor) (((major) << 20) | (minor))
+#define MAJOR(dev) ((dev) >> 20)
+#define MINOR(dev) ((dev) & 0xfffff)
+
+struct device {
+    int unused;
+};
+
+struct class {
+    int unused;
+};
+
+struct device *device_create(struct class *, struct device *, dev_t,
+        void *, const char *, ...);
+void device_unregister(struct device *);
+
+struct inode;
+struct file;
+struct vm_area_struct;
+struct vm_fault;
+struct poll_table_struct;
+typedef struct poll_table_struct poll_table;
+
+struct cdev {
+    struct module *owner;
+};
+
+/*****************************************************************************/
+
+#define ETH_ALEN 6
+#define ETH_HLEN 14
+#define ETH_ZLEN 60
+#define ETH_DATA_LEN 1500
+#define ETH_FRAME_LEN 1514
+#define ETH_FCS_LEN 4
+#define ETH_P_ETHERCAT 0x88A4
+#define IFNAMSIZ 16
+
+struct ethhdr {
+    unsigned char h_dest[ETH_ALEN];
+    unsigned char h_source[ETH_ALEN];
+    u16 h_proto;
+} __attribute__((packed));
+
+struct net_device_stats {
+    unsigned long rx_packets, tx_packets, rx_bytes, tx_bytes;
+    unsigned long rx_errors, tx_errors, rx_dropped, tx_dropped;
+};
+
+struct net_device {
+    char name[IFNAMSIZ];
+    unsigned char dev_addr[ETH_ALEN];
+    struct net_device_stats stats;
+};
+
+struct sk_buff {
+    unsigned char *data;
+    unsigned int len;
+    struct net_device *dev;
+};
+
+/*****************************************************************************/
+
+#endif
+
+/*****************************************************************************/
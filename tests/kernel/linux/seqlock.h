@@ -0,0 +1 @@
+#include "ktest.h"
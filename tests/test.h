@@ -0,0 +1,153 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Helpers for the master unit tests.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_TEST_H__
+#define __EC_TEST_H__
+
+#include "../master/master.h"
+
+/*****************************************************************************/
+
+/** Aborts the test with a message, if a condition is not met.
+ */
+#define TEST_ASSERT(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%u: Assertion failed: %s\n", \
+                    __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+/*****************************************************************************/
+
+/** Maximum number of frames captured by the fake device.
+ */
+#define TEST_FRAME_COUNT 32
+
+/** Frame captured by the fake device.
+ */
+typedef struct {
+    uint8_t data[ETH_FRAME_LEN]; /**< EtherCAT frame without the Ethernet
+                                   header. */
+    size_t size; /**< Frame size. */
+} test_frame_t;
+
+extern test_frame_t test_frames[TEST_FRAME_COUNT];
+extern unsigned int test_frame_count;
+extern cycles_t ktest_cycles;
+
+extern ec_master_t test_master;
+extern struct net_device test_dev;
+extern ec_ioctl_state_page_t test_state_page;
+
+/*****************************************************************************/
+
+/** Initializes the parts of test_master, that the datagram exchange needs.
+ *
+ * The master has a single device, which captures the sent frames in
+ * test_frames.
+ */
+static inline void test_master_init(void)
+{
+    ec_master_t *master = &test_master;
+
+    memset(master, 0x00, sizeof(*master));
+#if EC_MAX_NUM_DEVICES > 1
+    master->num_devices = 1;
+#endif
+    master->devices[EC_DEVICE_MAIN].master = master;
+    master->devices[EC_DEVICE_MAIN].dev = &test_dev;
+    master->state_page = &test_state_page;
+    INIT_LIST_HEAD(&master->configs);
+    INIT_LIST_HEAD(&master->domains);
+    INIT_LIST_HEAD(&master->datagram_queue);
+    INIT_LIST_HEAD(&master->timeout_list);
+    INIT_LIST_HEAD(&master->ext_datagram_queue);
+    bitmap_zero(master->datagram_indices, EC_DATAGRAM_INDEX_COUNT);
+    memset(&test_state_page, 0x00, sizeof(test_state_page));
+    test_frame_count = 0;
+}
+
+/*****************************************************************************/
+
+/** Initializes datagrams as BRD datagrams with 2 bytes of data.
+ */
+static inline void test_datagrams_init(
+        ec_datagram_t *datagrams, /**< Datagrams to initialize. */
+        unsigned int count /**< Number of datagrams. */
+        )
+{
+    unsigned int i;
+
+    for (i = 0; i < count; i++) {
+        ec_datagram_init(&datagrams[i]);
+        TEST_ASSERT(!ec_datagram_brd(&datagrams[i], 0x0130, 2));
+    }
+}
+
+/*****************************************************************************/
+
+/** Turns a captured frame into the response of the slaves.
+ *
+ * Sets the working counter of every datagram in the frame and fills the
+ * data of every datagram with its index.
+ */
+static inline void test_frame_respond(
+        test_frame_t *frame, /**< Captured frame. */
+        uint16_t working_counter /**< Working counter to set. */
+        )
+{
+    uint8_t *cur = frame->data + EC_FRAME_HEADER_SIZE;
+    size_t data_size;
+    unsigned int follows = 1;
+
+    while (follows) {
+        data_size = EC_READ_U16(cur + 6) & 0x07FF;
+        follows = EC_READ_U16(cur + 6) & 0x8000;
+        memset(cur + EC_DATAGRAM_HEADER_SIZE, EC_READ_U8(cur + 1),
+                data_size);
+        cur += EC_DATAGRAM_HEADER_SIZE + data_size;
+        EC_WRITE_U16(cur, working_counter);
+        cur += EC_DATAGRAM_FOOTER_SIZE;
+    }
+}
+
+/*****************************************************************************/
+
+#endif
+
+/*****************************************************************************/
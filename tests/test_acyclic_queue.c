@@ -0,0 +1,318 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Tests the submission and completion rings of the acyclic queue.
+*/
+
+/*****************************************************************************/
+
+#include "../master/master.c"
+#include "../master/datagram.c"
+#include "../master/frame_template.c"
+#include "../master/sdo_request.c"
+#include "../master/soe_request.c"
+#include "../master/foe_request.c"
+#include "../master/reg_request.c"
+#include "../master/acyclic_queue.c"
+
+#include "test.h"
+
+/*****************************************************************************/
+
+#define ENTRIES 4
+#define DATA_SIZE 16
+
+static ec_slave_t slave;
+static ec_acyclic_queue_t queue;
+
+/*****************************************************************************/
+
+/** Initializes a master with a single slave and sets up the queue.
+ */
+static void init(void)
+{
+    ec_ioctl_acyclic_setup_t setup = {
+        .entries = ENTRIES,
+        .data_size = DATA_SIZE
+    };
+
+    test_master_init();
+    memset(&slave, 0x00, sizeof(slave));
+    slave.master = &test_master;
+    INIT_LIST_HEAD(&slave.sdo_requests);
+    INIT_LIST_HEAD(&slave.reg_requests);
+    INIT_LIST_HEAD(&slave.foe_requests);
+    INIT_LIST_HEAD(&slave.soe_requests);
+    test_master.slaves = &slave;
+    test_master.slave_count = 1;
+
+    ec_acyclic_queue_init(&queue, &test_master);
+    TEST_ASSERT(!ec_acyclic_queue_setup(&queue, &setup));
+}
+
+/*****************************************************************************/
+
+/** Submits an entry like the application.
+ */
+static void submit(
+        uint32_t entry, /**< Index of the submission entry. */
+        uint16_t opcode, /**< Operation. */
+        uint16_t position, /**< Slave position. */
+        uint32_t size, /**< Data size. */
+        uint64_t user_data /**< User data. */
+        )
+{
+    ec_ioctl_acyclic_sqe_t *sqe = &queue.sqes[entry];
+
+    memset(sqe, 0x00, sizeof(*sqe));
+    sqe->user_data = user_data;
+    sqe->opcode = opcode;
+    sqe->slave_position = position;
+    sqe->index = 0x0130;
+    sqe->size = size;
+    queue.sq[queue.rings->sq_head & (ENTRIES - 1)] = entry;
+    queue.rings->sq_head++;
+}
+
+/*****************************************************************************/
+
+/** Finishes the first register request of the slave like the slave FSM.
+ */
+static void finish_reg(uint8_t value)
+{
+    ec_reg_request_t *reg;
+
+    TEST_ASSERT(!list_empty(&slave.reg_requests));
+    reg = list_first_entry(&slave.reg_requests, ec_reg_request_t, list);
+    list_del_init(&reg->list);
+    memset(reg->data, value, reg->transfer_size);
+    reg->state = EC_INT_REQUEST_SUCCESS;
+}
+
+/*****************************************************************************/
+
+/** Returns the completion at a given ring position.
+ */
+static const ec_ioctl_acyclic_cqe_t *cqe(uint32_t position)
+{
+    return &queue.cq[position & (ENTRIES - 1)];
+}
+
+/*****************************************************************************/
+
+/** The setup checks its parameters and aligns the areas.
+ */
+static void test_setup(void)
+{
+    ec_ioctl_acyclic_setup_t setup = { .entries = 3, .data_size = 8 };
+
+    test_master_init();
+    ec_acyclic_queue_init(&queue, &test_master);
+
+    TEST_ASSERT(ec_acyclic_queue_submit(&queue) == -ENOMEM);
+    TEST_ASSERT(ec_acyclic_queue_setup(&queue, &setup) == -EINVAL);
+    setup.entries = 0;
+    TEST_ASSERT(ec_acyclic_queue_setup(&queue, &setup) == -EINVAL);
+    setup.entries = 8;
+    setup.data_size = 0;
+    TEST_ASSERT(ec_acyclic_queue_setup(&queue, &setup) == -EINVAL);
+    setup.data_size = EC_IOCTL_ACYCLIC_MAX_DATA_SIZE + 1;
+    TEST_ASSERT(ec_acyclic_queue_setup(&queue, &setup) == -EINVAL);
+
+    setup.data_size = 100;
+    TEST_ASSERT(!ec_acyclic_queue_setup(&queue, &setup));
+    TEST_ASSERT(setup.sqe_offset % EC_IOCTL_CACHE_LINE_SIZE == 0);
+    TEST_ASSERT(setup.cq_offset % EC_IOCTL_CACHE_LINE_SIZE == 0);
+    TEST_ASSERT(setup.data_offset % EC_IOCTL_CACHE_LINE_SIZE == 0);
+    TEST_ASSERT(setup.size % PAGE_SIZE == 0);
+    TEST_ASSERT(setup.data_offset + 8 * 100 <= setup.size);
+    TEST_ASSERT(ec_acyclic_queue_setup(&queue, &setup) == -EBUSY);
+
+    ec_acyclic_queue_clear(&queue);
+    TEST_ASSERT(!queue.memory);
+}
+
+/*****************************************************************************/
+
+/** A submission is turned into a slave request and completed with its data.
+ */
+static void test_round_trip(void)
+{
+    unsigned int i;
+
+    init();
+
+    submit(2, EC_IOCTL_ACYCLIC_REG_READ, 0, 4, 42);
+    TEST_ASSERT(ec_acyclic_queue_submit(&queue) == 1);
+    TEST_ASSERT(queue.rings->sq_tail == 1);
+    TEST_ASSERT(queue.op_count == 1);
+    TEST_ASSERT(list_is_singular(&slave.reg_requests));
+
+    // nothing to reap, as long as the request is busy
+    TEST_ASSERT(ec_acyclic_queue_reap(&queue) == 0);
+    TEST_ASSERT(!ec_acyclic_queue_pending(&queue));
+
+    finish_reg(0xA5);
+    TEST_ASSERT(ec_acyclic_queue_reap(&queue) == 1);
+    TEST_ASSERT(queue.op_count == 0);
+    TEST_ASSERT(queue.rings->cq_head == 1);
+    TEST_ASSERT(ec_acyclic_queue_pending(&queue));
+
+    TEST_ASSERT(cqe(0)->user_data == 42);
+    TEST_ASSERT(cqe(0)->entry == 2);
+    TEST_ASSERT(cqe(0)->result == 0);
+    TEST_ASSERT(cqe(0)->size == 4);
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(queue.data[2 * DATA_SIZE + i] == 0xA5);
+    }
+
+    queue.rings->cq_tail++;
+    TEST_ASSERT(!ec_acyclic_queue_pending(&queue));
+
+    ec_acyclic_queue_clear(&queue);
+}
+
+/*****************************************************************************/
+
+/** Invalid submissions are completed immediately with an error.
+ */
+static void test_invalid(void)
+{
+    init();
+
+    submit(0, EC_IOCTL_ACYCLIC_OPCODE_COUNT, 0, 4, 1);
+    submit(1, EC_IOCTL_ACYCLIC_REG_READ, 0, DATA_SIZE + 1, 2);
+    submit(2, EC_IOCTL_ACYCLIC_REG_READ, 1, 4, 3);
+    submit(3, EC_IOCTL_ACYCLIC_REG_READ, 0, 0, 4);
+
+    TEST_ASSERT(ec_acyclic_queue_submit(&queue) == 4);
+    TEST_ASSERT(queue.op_count == 0);
+    TEST_ASSERT(list_empty(&slave.reg_requests));
+    TEST_ASSERT(queue.rings->cq_head == 4);
+
+    TEST_ASSERT(cqe(0)->user_data == 1 && cqe(0)->result == -EINVAL);
+    TEST_ASSERT(cqe(1)->user_data == 2 && cqe(1)->result == -EOVERFLOW);
+    TEST_ASSERT(cqe(2)->user_data == 3 && cqe(2)->result == -EINVAL);
+    TEST_ASSERT(cqe(3)->user_data == 4 && cqe(3)->result == -EINVAL);
+    queue.rings->cq_tail += 4;
+
+    // an entry index beyond the submission entries
+    queue.sq[queue.rings->sq_head & (ENTRIES - 1)] = ENTRIES;
+    queue.rings->sq_head++;
+    TEST_ASSERT(ec_acyclic_queue_submit(&queue) == 1);
+    TEST_ASSERT(cqe(4)->entry == ENTRIES);
+    TEST_ASSERT(cqe(4)->user_data == 0 && cqe(4)->result == -EINVAL);
+
+    ec_acyclic_queue_clear(&queue);
+}
+
+/*****************************************************************************/
+
+/** Submissions are only consumed, as long as their completions fit into the
+ * completion ring. The ring indices wrap around.
+ */
+static void test_back_pressure(void)
+{
+    unsigned int i;
+
+    init();
+
+    for (i = 0; i < ENTRIES; i++) {
+        submit(i, EC_IOCTL_ACYCLIC_REG_READ, 0, 2, i);
+    }
+    TEST_ASSERT(ec_acyclic_queue_submit(&queue) == ENTRIES);
+    TEST_ASSERT(queue.op_count == ENTRIES);
+
+    // completions of the first two, not consumed by the application
+    finish_reg(1);
+    finish_reg(2);
+    TEST_ASSERT(ec_acyclic_queue_reap(&queue) == 2);
+    TEST_ASSERT(cqe(0)->user_data == 0 && cqe(1)->user_data == 1);
+
+    submit(0, EC_IOCTL_ACYCLIC_REG_READ, 0, 2, 4);
+    submit(1, EC_IOCTL_ACYCLIC_REG_READ, 0, 2, 5);
+    TEST_ASSERT(ec_acyclic_queue_submit(&queue) == 0);
+    TEST_ASSERT(queue.rings->sq_tail == ENTRIES);
+
+    // consuming a completion makes room for a single submission
+    queue.rings->cq_tail++;
+    TEST_ASSERT(ec_acyclic_queue_submit(&queue) == 1);
+    TEST_ASSERT(ec_acyclic_queue_submit(&queue) == 0);
+    queue.rings->cq_tail++;
+    TEST_ASSERT(ec_acyclic_queue_submit(&queue) == 1);
+    TEST_ASSERT(queue.rings->sq_tail == ENTRIES + 2);
+    TEST_ASSERT(queue.op_count == ENTRIES);
+
+    for (i = 0; i < ENTRIES; i++) {
+        finish_reg(i);
+    }
+    TEST_ASSERT(ec_acyclic_queue_reap(&queue) == ENTRIES);
+    TEST_ASSERT(queue.rings->cq_head == ENTRIES + 2);
+    for (i = 2; i < ENTRIES + 2; i++) {
+        TEST_ASSERT(cqe(i)->user_data == i);
+    }
+
+    ec_acyclic_queue_clear(&queue);
+}
+
+/*****************************************************************************/
+
+/** Clearing the queue aborts the operations, that were not picked up.
+ */
+static void test_clear(void)
+{
+    init();
+
+    submit(0, EC_IOCTL_ACYCLIC_REG_READ, 0, 2, 0);
+    submit(1, EC_IOCTL_ACYCLIC_REG_WRITE, 0, 2, 1);
+    TEST_ASSERT(ec_acyclic_queue_submit(&queue) == 2);
+    TEST_ASSERT(!list_empty(&slave.reg_requests));
+
+    ec_acyclic_queue_clear(&queue);
+    TEST_ASSERT(list_empty(&slave.reg_requests));
+    TEST_ASSERT(list_empty(&queue.ops));
+    TEST_ASSERT(queue.op_count == 0);
+    TEST_ASSERT(!queue.memory);
+}
+
+/*****************************************************************************/
+
+int main(void)
+{
+    test_setup();
+    test_round_trip();
+    test_invalid();
+    test_back_pressure();
+    test_clear();
+    return 0;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,191 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Tests the allocation of datagram indices from the in-flight bitmap.
+*/
+
+/*****************************************************************************/
+
+#include "../master/master.c"
+#include "../master/datagram.c"
+#include "../master/frame_template.c"
+
+#include "test.h"
+
+/*****************************************************************************/
+
+/** More datagrams than indices.
+ */
+#define DATAGRAM_COUNT (EC_DATAGRAM_INDEX_COUNT + 44)
+
+static ec_datagram_t datagrams[DATAGRAM_COUNT];
+
+/*****************************************************************************/
+
+/** Initializes the master and the datagrams.
+ */
+static void init(void)
+{
+    test_master_init();
+
+    test_datagrams_init(datagrams, DATAGRAM_COUNT);
+}
+
+/*****************************************************************************/
+
+/** Allocates an index for a datagram, like ec_master_send_datagrams().
+ */
+static int alloc(ec_datagram_t *datagram)
+{
+    int ret = ec_master_alloc_index(&test_master, datagram);
+
+    if (!ret) {
+        datagram->state = EC_DATAGRAM_SENT;
+    }
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Indices are handed out round-robin and released ones are not re-used
+ * before the others.
+ */
+static void test_round_robin(void)
+{
+    init();
+
+    TEST_ASSERT(!alloc(&datagrams[0]) && datagrams[0].index == 0);
+    TEST_ASSERT(!alloc(&datagrams[1]) && datagrams[1].index == 1);
+    TEST_ASSERT(!alloc(&datagrams[2]) && datagrams[2].index == 2);
+
+    ec_master_release_index(&test_master, 0);
+    TEST_ASSERT(!test_master.sent_datagrams[0]);
+    TEST_ASSERT(!test_bit(0, test_master.datagram_indices));
+
+    TEST_ASSERT(!alloc(&datagrams[3]) && datagrams[3].index == 3);
+
+    // wrap around at the end of the index space
+    test_master.datagram_index = EC_DATAGRAM_INDEX_COUNT - 1;
+    TEST_ASSERT(!alloc(&datagrams[4]) && datagrams[4].index == 255);
+    TEST_ASSERT(test_master.datagram_index == 0);
+    TEST_ASSERT(!alloc(&datagrams[5]) && datagrams[5].index == 0);
+    TEST_ASSERT(!alloc(&datagrams[6]) && datagrams[6].index == 4);
+}
+
+/*****************************************************************************/
+
+/** Allocation fails, if all indices are in flight, and succeeds again with
+ * the index of a datagram, that was re-initialized in flight.
+ */
+static void test_exhaustion(void)
+{
+    unsigned int i;
+
+    init();
+
+    for (i = 0; i < EC_DATAGRAM_INDEX_COUNT; i++) {
+        TEST_ASSERT(!alloc(&datagrams[i]));
+        TEST_ASSERT(datagrams[i].index == i);
+    }
+
+    TEST_ASSERT(alloc(&datagrams[i]) == -EBUSY);
+
+    // re-initializing resets the state, but keeps the table entry
+    TEST_ASSERT(!ec_datagram_brd(&datagrams[77], 0x0130, 2));
+    TEST_ASSERT(test_master.sent_datagrams[77] == &datagrams[77]);
+
+    TEST_ASSERT(!alloc(&datagrams[i]));
+    TEST_ASSERT(datagrams[i].index == 77);
+    TEST_ASSERT(test_master.sent_datagrams[77] == &datagrams[i]);
+    TEST_ASSERT(alloc(&datagrams[i + 1]) == -EBUSY);
+}
+
+/*****************************************************************************/
+
+/** Datagrams without a free index stay queued until indices are released
+ * by the reception.
+ */
+static void test_send(void)
+{
+    unsigned int i, f, sent = 0;
+
+    init();
+
+    for (i = 0; i < DATAGRAM_COUNT; i++) {
+        ec_master_queue_datagram(&test_master, &datagrams[i]);
+    }
+
+    ec_master_send_datagrams(&test_master, EC_DEVICE_MAIN);
+
+    for (i = 0; i < DATAGRAM_COUNT; i++) {
+        if (datagrams[i].state == EC_DATAGRAM_SENT) {
+            sent++;
+        } else {
+            TEST_ASSERT(datagrams[i].state == EC_DATAGRAM_QUEUED);
+        }
+    }
+    TEST_ASSERT(sent == EC_DATAGRAM_INDEX_COUNT);
+
+    for (f = 0; f < test_frame_count; f++) {
+        test_frame_respond(&test_frames[f], 1);
+        ec_master_receive_datagrams(&test_master,
+                &test_master.devices[EC_DEVICE_MAIN],
+                test_frames[f].data, test_frames[f].size);
+    }
+    TEST_ASSERT(test_master.stats.unmatched == 0);
+    TEST_ASSERT(find_first_bit(test_master.datagram_indices,
+                EC_DATAGRAM_INDEX_COUNT) == EC_DATAGRAM_INDEX_COUNT);
+
+    test_frame_count = 0;
+    ec_master_send_datagrams(&test_master, EC_DEVICE_MAIN);
+
+    sent = 0;
+    for (i = 0; i < DATAGRAM_COUNT; i++) {
+        if (datagrams[i].state == EC_DATAGRAM_SENT) {
+            sent++;
+        } else {
+            TEST_ASSERT(datagrams[i].state == EC_DATAGRAM_RECEIVED);
+        }
+    }
+    TEST_ASSERT(sent == DATAGRAM_COUNT - EC_DATAGRAM_INDEX_COUNT);
+}
+
+/*****************************************************************************/
+
+int main(void)
+{
+    test_round_robin();
+    test_exhaustion();
+    test_send();
+    return 0;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,199 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Tests the matching of received datagrams via the table of sent datagrams.
+*/
+
+/*****************************************************************************/
+
+#include "../master/master.c"
+#include "../master/datagram.c"
+#include "../master/frame_template.c"
+
+#include "test.h"
+
+/*****************************************************************************/
+
+#define DATAGRAM_COUNT 8
+
+static ec_datagram_t datagrams[DATAGRAM_COUNT];
+
+/*****************************************************************************/
+
+/** Queues APRD datagrams of different sizes and sends them.
+ */
+static void send_datagrams(void)
+{
+    unsigned int i;
+
+    test_master_init();
+
+    for (i = 0; i < DATAGRAM_COUNT; i++) {
+        ec_datagram_init(&datagrams[i]);
+        TEST_ASSERT(!ec_datagram_aprd(&datagrams[i], i, 0x0130, 2 + i));
+        ec_master_queue_datagram(&test_master, &datagrams[i]);
+    }
+
+    ec_master_send_datagrams(&test_master, EC_DEVICE_MAIN);
+    TEST_ASSERT(test_frame_count == 1);
+
+    for (i = 0; i < DATAGRAM_COUNT; i++) {
+        TEST_ASSERT(datagrams[i].state == EC_DATAGRAM_SENT);
+        TEST_ASSERT(test_master.sent_datagrams[datagrams[i].index]
+                == &datagrams[i]);
+    }
+}
+
+/*****************************************************************************/
+
+/** Responses are matched by index and removed from the table.
+ */
+static void test_match(void)
+{
+    unsigned int i, j;
+
+    send_datagrams();
+
+    test_frame_respond(&test_frames[0], 1);
+    ec_master_receive_datagrams(&test_master, &test_master.devices[EC_DEVICE_MAIN],
+            test_frames[0].data, test_frames[0].size);
+
+    TEST_ASSERT(test_master.stats.unmatched == 0);
+    TEST_ASSERT(list_empty(&test_master.datagram_queue));
+
+    for (i = 0; i < DATAGRAM_COUNT; i++) {
+        TEST_ASSERT(datagrams[i].state == EC_DATAGRAM_RECEIVED);
+        TEST_ASSERT(datagrams[i].working_counter == 1);
+        for (j = 0; j < datagrams[i].data_size; j++) {
+            TEST_ASSERT(datagrams[i].data[j] == datagrams[i].index);
+        }
+    }
+
+    for (i = 0; i < EC_DATAGRAM_INDEX_COUNT; i++) {
+        TEST_ASSERT(!test_master.sent_datagrams[i]);
+    }
+
+    // a duplicate of the frame matches nothing
+    ec_master_receive_datagrams(&test_master, &test_master.devices[EC_DEVICE_MAIN],
+            test_frames[0].data, test_frames[0].size);
+    TEST_ASSERT(test_master.stats.unmatched == DATAGRAM_COUNT);
+}
+
+/*****************************************************************************/
+
+/** Finds the datagram, that was sent with a given index.
+ */
+static ec_datagram_t *find_datagram(uint8_t index)
+{
+    unsigned int i;
+
+    for (i = 0; i < DATAGRAM_COUNT; i++) {
+        if (datagrams[i].index == index) {
+            return &datagrams[i];
+        }
+    }
+
+    TEST_ASSERT(0);
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/** Responses with the index of a sent datagram, but a different type or
+ * size, are not matched.
+ */
+static void test_mismatch(void)
+{
+    uint8_t *header = test_frames[0].data + EC_FRAME_HEADER_SIZE;
+    ec_datagram_t *first, *second;
+    unsigned int i;
+
+    send_datagrams();
+    test_frame_respond(&test_frames[0], 1);
+
+    // change the type of the first and the size of the second datagram
+    first = find_datagram(EC_READ_U8(header + 1));
+    EC_WRITE_U8(header, EC_DATAGRAM_APWR);
+    header += EC_DATAGRAM_HEADER_SIZE + first->data_size
+        + EC_DATAGRAM_FOOTER_SIZE;
+    second = find_datagram(EC_READ_U8(header + 1));
+    EC_WRITE_U16(header + 6, EC_READ_U16(header + 6) + 1);
+
+    ec_master_receive_datagrams(&test_master, &test_master.devices[EC_DEVICE_MAIN],
+            test_frames[0].data, test_frames[0].size);
+
+    // the wrong size also garbles all following datagrams
+    TEST_ASSERT(test_master.stats.unmatched >= 2);
+    for (i = 0; i < DATAGRAM_COUNT; i++) {
+        if (datagrams[i].state == EC_DATAGRAM_SENT) {
+            TEST_ASSERT(test_master.sent_datagrams[datagrams[i].index]
+                    == &datagrams[i]);
+        }
+    }
+    TEST_ASSERT(first->state == EC_DATAGRAM_SENT);
+    TEST_ASSERT(second->state == EC_DATAGRAM_SENT);
+}
+
+/*****************************************************************************/
+
+/** A forgotten datagram does not match its late response.
+ */
+static void test_forget(void)
+{
+    unsigned int i;
+
+    send_datagrams();
+
+    ec_master_forget_datagram(&test_master, &datagrams[3]);
+    TEST_ASSERT(!test_master.sent_datagrams[datagrams[3].index]);
+
+    test_frame_respond(&test_frames[0], 1);
+    ec_master_receive_datagrams(&test_master, &test_master.devices[EC_DEVICE_MAIN],
+            test_frames[0].data, test_frames[0].size);
+
+    TEST_ASSERT(test_master.stats.unmatched == 1);
+    for (i = 0; i < DATAGRAM_COUNT; i++) {
+        TEST_ASSERT(datagrams[i].state
+                == (i == 3 ? EC_DATAGRAM_SENT : EC_DATAGRAM_RECEIVED));
+    }
+}
+
+/*****************************************************************************/
+
+int main(void)
+{
+    test_match();
+    test_mismatch();
+    test_forget();
+    return 0;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,277 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Tests the rearrangement of the domain layout and the offset remapping.
+*/
+
+/*****************************************************************************/
+
+#include "../master/master.c"
+#include "../master/datagram.c"
+#include "../master/frame_template.c"
+#include "../master/domain.c"
+#include "../master/fmmu_config.c"
+#include "../master/pdo_list.c"
+
+#include "test.h"
+
+/*****************************************************************************/
+
+#define FMMU_COUNT 4
+#define ENTRY_COUNT 512
+
+static ec_domain_t domain;
+static ec_slave_config_t configs[FMMU_COUNT];
+static ec_fmmu_config_t fmmus[FMMU_COUNT];
+static ec_pdo_t pdos[FMMU_COUNT];
+static ec_pdo_entry_t entries[ENTRY_COUNT];
+static unsigned int fmmu_count, entry_count;
+
+/*****************************************************************************/
+
+/** Initializes the master and an empty domain.
+ */
+static void init(void)
+{
+    test_master_init();
+    ec_domain_init(&domain, &test_master, 0);
+    fmmu_count = 0;
+    entry_count = 0;
+}
+
+/*****************************************************************************/
+
+/** Appends a PDO entry to a PDO.
+ */
+static void add_entry(ec_pdo_t *pdo, uint8_t bit_length)
+{
+    ec_pdo_entry_t *entry = &entries[entry_count++];
+
+    TEST_ASSERT(entry_count <= ENTRY_COUNT);
+    memset(entry, 0x00, sizeof(*entry));
+    entry->bit_length = bit_length;
+    list_add_tail(&entry->list, &pdo->entries);
+}
+
+/*****************************************************************************/
+
+/** Registers the FMMU of a new slave configuration with a single PDO.
+ *
+ * The PDO consists of an optional leading byte and \a count entries of
+ * \a bit_length bits.
+ */
+static ec_fmmu_config_t *add_fmmu(
+        ec_direction_t dir, /**< Direction. */
+        unsigned int leading_byte, /**< Non-zero for a leading 8 bit entry.
+                                    */
+        unsigned int count, /**< Number of further entries. */
+        uint8_t bit_length /**< Bit length of the further entries. */
+        )
+{
+    ec_slave_config_t *sc = &configs[fmmu_count];
+    ec_fmmu_config_t *fmmu = &fmmus[fmmu_count];
+    ec_pdo_t *pdo = &pdos[fmmu_count];
+    uint8_t sync_index = dir == EC_DIR_OUTPUT ? 2 : 3;
+    unsigned int i;
+
+    TEST_ASSERT(++fmmu_count <= FMMU_COUNT);
+    memset(sc, 0x00, sizeof(*sc));
+    INIT_LIST_HEAD(&sc->sync_configs[sync_index].pdos.list);
+    memset(pdo, 0x00, sizeof(*pdo));
+    INIT_LIST_HEAD(&pdo->entries);
+    list_add_tail(&pdo->list, &sc->sync_configs[sync_index].pdos.list);
+
+    if (leading_byte) {
+        add_entry(pdo, 8);
+    }
+    for (i = 0; i < count; i++) {
+        add_entry(pdo, bit_length);
+    }
+
+    ec_fmmu_config_init(fmmu, sc, &domain, sync_index, dir);
+    return fmmu;
+}
+
+/*****************************************************************************/
+
+/** Checks, that the FMMUs are listed by ascending domain offset and do not
+ * overlap.
+ */
+static void check_order(void)
+{
+    const ec_fmmu_config_t *fmmu;
+    uint32_t end = 0;
+
+    list_for_each_entry(fmmu, &domain.fmmu_configs, list) {
+        TEST_ASSERT(fmmu->logical_domain_offset >= end);
+        end = fmmu->logical_domain_offset + fmmu->data_size;
+    }
+    TEST_ASSERT(end <= domain.data_size);
+}
+
+/*****************************************************************************/
+
+/** The start offset is chosen, so that multi-byte entries are aligned.
+ */
+static void test_alignment(void)
+{
+    ec_fmmu_config_t *fmmu;
+
+    init();
+    fmmu = add_fmmu(EC_DIR_OUTPUT, 1, 1, 32);
+    TEST_ASSERT(fmmu->logical_domain_offset == 0);
+    TEST_ASSERT(domain.data_size == 5);
+
+    TEST_ASSERT(!ecrt_domain_optimize_layout(&domain));
+    TEST_ASSERT(!ec_domain_optimize_layout(&domain));
+
+    // the 32 bit entry follows the leading byte
+    TEST_ASSERT(fmmu->logical_domain_offset == 3);
+    TEST_ASSERT(domain.data_size == 8);
+    TEST_ASSERT(domain.remap_count == 1);
+    TEST_ASSERT(ecrt_domain_remap_offset(&domain, 0) == 3);
+    TEST_ASSERT(ecrt_domain_remap_offset(&domain, 1) == 4);
+    TEST_ASSERT(ecrt_domain_remap_offset(&domain, 4) == 7);
+    TEST_ASSERT(ecrt_domain_remap_offset(&domain, 5) == 5);
+    check_order();
+
+    // the pass is only done once
+    TEST_ASSERT(!ec_domain_optimize_layout(&domain));
+    TEST_ASSERT(fmmu->logical_domain_offset == 3);
+}
+
+/*****************************************************************************/
+
+/** Outputs and larger FMMUs are placed first, so that fewer datagrams are
+ * needed. Stored offsets are patched.
+ */
+static void test_packing(void)
+{
+    ec_fmmu_config_t *a, *b, *c, *d;
+    unsigned int offset_a = 5, offset_c = 1600 + 10;
+
+    init();
+    a = add_fmmu(EC_DIR_INPUT, 0, 100, 64);
+    b = add_fmmu(EC_DIR_OUTPUT, 0, 100, 64);
+    c = add_fmmu(EC_DIR_INPUT, 0, 75, 64);
+    d = add_fmmu(EC_DIR_OUTPUT, 0, 75, 64);
+    TEST_ASSERT(c->logical_domain_offset == 1600);
+    TEST_ASSERT(domain.data_size == 2800);
+    TEST_ASSERT(ec_domain_datagram_count(&domain) == 3);
+
+    domain.offset_refs = kmalloc(2 * sizeof(unsigned int *), GFP_KERNEL);
+    TEST_ASSERT(domain.offset_refs);
+    domain.offset_refs[0] = &offset_a;
+    domain.offset_refs[1] = &offset_c;
+    domain.offset_ref_count = 2;
+
+    TEST_ASSERT(!ecrt_domain_optimize_layout(&domain));
+    TEST_ASSERT(!ec_domain_optimize_layout(&domain));
+
+    TEST_ASSERT(b->logical_domain_offset == 0);
+    TEST_ASSERT(d->logical_domain_offset == 800);
+    TEST_ASSERT(a->logical_domain_offset == 1400);
+    TEST_ASSERT(c->logical_domain_offset == 2200);
+    TEST_ASSERT(domain.data_size == 2800);
+    TEST_ASSERT(ec_domain_datagram_count(&domain) == 2);
+    check_order();
+
+    TEST_ASSERT(list_first_entry(&domain.fmmu_configs, ec_fmmu_config_t,
+                list) == b);
+    TEST_ASSERT(list_last_entry(&domain.fmmu_configs, ec_fmmu_config_t,
+                list) == c);
+
+    // the remap table is sorted by the registration offsets
+    TEST_ASSERT(domain.remap_count == 4);
+    TEST_ASSERT(domain.remap[0].old_offset == 0);
+    TEST_ASSERT(domain.remap[3].old_offset == 2200);
+    TEST_ASSERT(ecrt_domain_remap_offset(&domain, 0) == 1400);
+    TEST_ASSERT(ecrt_domain_remap_offset(&domain, 799) == 2199);
+    TEST_ASSERT(ecrt_domain_remap_offset(&domain, 800) == 0);
+    TEST_ASSERT(ecrt_domain_remap_offset(&domain, 2799) == 1399);
+
+    TEST_ASSERT(offset_a == 1405);
+    TEST_ASSERT(offset_c == 2210);
+    TEST_ASSERT(!domain.offset_refs && !domain.offset_ref_count);
+}
+
+/*****************************************************************************/
+
+/** The layout is kept, if it is not requested, if it would exceed the
+ * external memory or if the domain has overlapping PDOs.
+ */
+static void test_keep(void)
+{
+    ec_fmmu_config_t *fmmu;
+
+    // not requested
+    init();
+    fmmu = add_fmmu(EC_DIR_OUTPUT, 1, 1, 32);
+    TEST_ASSERT(!ec_domain_optimize_layout(&domain));
+    TEST_ASSERT(fmmu->logical_domain_offset == 0);
+
+    // external memory too small
+    init();
+    fmmu = add_fmmu(EC_DIR_OUTPUT, 1, 1, 32);
+    domain.data_origin = EC_ORIG_EXTERNAL;
+    TEST_ASSERT(!ecrt_domain_optimize_layout(&domain));
+    TEST_ASSERT(!ec_domain_optimize_layout(&domain));
+    TEST_ASSERT(fmmu->logical_domain_offset == 0);
+    TEST_ASSERT(domain.data_size == 5);
+    TEST_ASSERT(!domain.remap_count);
+    TEST_ASSERT(ecrt_domain_remap_offset(&domain, 1) == 1);
+
+    // overlapping PDOs
+    init();
+    fmmu = add_fmmu(EC_DIR_OUTPUT, 1, 1, 32);
+    configs[0].allow_overlapping_pdos = 1;
+    TEST_ASSERT(!ecrt_domain_optimize_layout(&domain));
+    TEST_ASSERT(!ec_domain_optimize_layout(&domain));
+    TEST_ASSERT(fmmu->logical_domain_offset == 0);
+    TEST_ASSERT(!domain.remap_count);
+
+    // too late
+    init();
+    test_master.active = 1;
+    TEST_ASSERT(ecrt_domain_optimize_layout(&domain) == -EBUSY);
+}
+
+/*****************************************************************************/
+
+int main(void)
+{
+    test_alignment();
+    test_packing();
+    test_keep();
+    return 0;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,389 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Tests the first-fit-decreasing packing of datagrams into frames.
+*/
+
+/*****************************************************************************/
+
+#include "../master/master.c"
+#include "../master/datagram.c"
+#include "../master/frame_template.c"
+
+#include "test.h"
+
+/*****************************************************************************/
+
+#define DATAGRAM_COUNT 8
+
+/** Payload size of a datagram, that occupies \a size bytes of a frame.
+ */
+#define PAYLOAD(size) ((size) - EC_DATAGRAM_HEADER_SIZE \
+        - EC_DATAGRAM_FOOTER_SIZE)
+
+static struct list_head classes[EC_TRAFFIC_CLASS_COUNT];
+static ec_frame_bin_t frames[EC_TX_RING_SIZE];
+static ec_datagram_t datagrams[DATAGRAM_COUNT];
+static unsigned int datagram_count;
+
+#define DOMAIN_COUNT 2
+#define MAILBOX_COUNT 4
+
+static ec_domain_t domains[DOMAIN_COUNT];
+static ec_frame_template_t templates[DOMAIN_COUNT];
+static ec_datagram_t domain_datagrams[DOMAIN_COUNT];
+static ec_datagram_t mailbox_datagrams[MAILBOX_COUNT];
+
+/*****************************************************************************/
+
+/** Clears the class lists.
+ */
+static void init(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < EC_TRAFFIC_CLASS_COUNT; i++) {
+        INIT_LIST_HEAD(&classes[i]);
+    }
+    datagram_count = 0;
+}
+
+/*****************************************************************************/
+
+/** Schedules a datagram with a given payload size.
+ */
+static ec_datagram_t *add(ec_traffic_class_t traffic_class, size_t size)
+{
+    ec_datagram_t *datagram = &datagrams[datagram_count++];
+
+    TEST_ASSERT(datagram_count <= DATAGRAM_COUNT);
+    memset(datagram, 0x00, sizeof(*datagram));
+    datagram->traffic_class = traffic_class;
+    datagram->data_size = size;
+    list_add_tail(&datagram->sent, &classes[traffic_class]);
+    return datagram;
+}
+
+/*****************************************************************************/
+
+/** Returns the position of a datagram in a frame, or -1.
+ */
+static int position(unsigned int frame, const ec_datagram_t *datagram)
+{
+    const ec_datagram_t *d;
+    int pos = 0;
+
+    list_for_each_entry(d, &frames[frame].datagrams, sent) {
+        if (d == datagram) {
+            return pos;
+        }
+        pos++;
+    }
+
+    return -1;
+}
+
+/*****************************************************************************/
+
+/** Checks the frame sizes against the datagrams in the frames.
+ */
+static void check_sizes(unsigned int frame_count)
+{
+    const ec_datagram_t *d;
+    unsigned int i;
+    size_t size;
+
+    for (i = 0; i < frame_count; i++) {
+        size = EC_FRAME_HEADER_SIZE;
+        list_for_each_entry(d, &frames[i].datagrams, sent) {
+            size += EC_DATAGRAM_HEADER_SIZE + d->data_size
+                + EC_DATAGRAM_FOOTER_SIZE;
+        }
+        TEST_ASSERT(frames[i].size == size);
+        TEST_ASSERT(size <= ETH_DATA_LEN);
+    }
+}
+
+/*****************************************************************************/
+
+/** Larger datagrams are placed first, so that the smaller ones fill the
+ * gaps. Packing in queueing order would need three frames here.
+ */
+static void test_decreasing(void)
+{
+    ec_datagram_t *a, *b, *c, *d;
+    unsigned int count;
+
+    init();
+    a = add(EC_TRAFFIC_MAILBOX, PAYLOAD(498));
+    b = add(EC_TRAFFIC_MAILBOX, PAYLOAD(498));
+    c = add(EC_TRAFFIC_MAILBOX, PAYLOAD(1000));
+    d = add(EC_TRAFFIC_MAILBOX, PAYLOAD(998));
+
+    count = ec_master_pack_frames(classes, frames, 0, EC_TX_RING_SIZE);
+    TEST_ASSERT(count == 2);
+    check_sizes(count);
+    TEST_ASSERT(position(0, c) == 0 && position(0, a) == 1);
+    TEST_ASSERT(position(1, d) == 0 && position(1, b) == 1);
+    TEST_ASSERT(frames[0].size == ETH_DATA_LEN);
+}
+
+/*****************************************************************************/
+
+/** Datagrams of the same size keep their queueing order.
+ */
+static void test_stable(void)
+{
+    ec_datagram_t *a, *b, *c;
+
+    init();
+    a = add(EC_TRAFFIC_MAILBOX, 200);
+    b = add(EC_TRAFFIC_MAILBOX, 200);
+    c = add(EC_TRAFFIC_MAILBOX, 200);
+
+    TEST_ASSERT(ec_master_pack_frames(classes, frames, 0, EC_TX_RING_SIZE)
+            == 1);
+    TEST_ASSERT(position(0, a) == 0);
+    TEST_ASSERT(position(0, b) == 1);
+    TEST_ASSERT(position(0, c) == 2);
+}
+
+/*****************************************************************************/
+
+/** Cyclic data occupies the first frames, lower classes fill the gaps.
+ */
+static void test_classes(void)
+{
+    ec_datagram_t *mbox, *cyclic1, *cyclic2;
+    unsigned int count;
+
+    init();
+    mbox = add(EC_TRAFFIC_MAILBOX, 50);
+    cyclic1 = add(EC_TRAFFIC_CYCLIC, PAYLOAD(1400));
+    cyclic2 = add(EC_TRAFFIC_CYCLIC, PAYLOAD(1400));
+
+    count = ec_master_pack_frames(classes, frames, 0, EC_TX_RING_SIZE);
+    TEST_ASSERT(count == 2);
+    check_sizes(count);
+    TEST_ASSERT(position(0, cyclic1) == 0);
+    TEST_ASSERT(position(1, cyclic2) == 0);
+    TEST_ASSERT(position(0, mbox) == 1);
+}
+
+/*****************************************************************************/
+
+/** Distributed clock datagrams are not reordered, not even across frames.
+ */
+static void test_dc_order(void)
+{
+    ec_datagram_t *cyclic, *dc1, *dc2, *dc3;
+    unsigned int count;
+
+    init();
+    cyclic = add(EC_TRAFFIC_CYCLIC, PAYLOAD(1000));
+    dc1 = add(EC_TRAFFIC_DC, PAYLOAD(100));
+    dc2 = add(EC_TRAFFIC_DC, PAYLOAD(900));
+    dc3 = add(EC_TRAFFIC_DC, PAYLOAD(100));
+
+    count = ec_master_pack_frames(classes, frames, 0, EC_TX_RING_SIZE);
+    TEST_ASSERT(count == 2);
+    check_sizes(count);
+    TEST_ASSERT(position(0, cyclic) == 0);
+    TEST_ASSERT(position(0, dc1) == 1);
+    TEST_ASSERT(position(1, dc2) == 0);
+    TEST_ASSERT(position(1, dc3) == 1); // would fit into the first frame
+}
+
+/*****************************************************************************/
+
+/** Datagrams, that do not fit, stay in their class lists. Ordered classes
+ * stop at the first one.
+ */
+static void test_overflow(void)
+{
+    ec_datagram_t *big, *medium, *small, *dc1, *dc2, *dc3;
+    unsigned int count;
+
+    init();
+    big = add(EC_TRAFFIC_MAILBOX, PAYLOAD(1000));
+    medium = add(EC_TRAFFIC_MAILBOX, PAYLOAD(800));
+    small = add(EC_TRAFFIC_MAILBOX, PAYLOAD(300));
+    dc1 = add(EC_TRAFFIC_DC, PAYLOAD(1000));
+    dc2 = add(EC_TRAFFIC_DC, PAYLOAD(600));
+    dc3 = add(EC_TRAFFIC_DC, PAYLOAD(10));
+
+    count = ec_master_pack_frames(classes, frames, 0, 1);
+    TEST_ASSERT(count == 1);
+    check_sizes(count);
+
+    TEST_ASSERT(position(0, dc1) == 0);
+    TEST_ASSERT(position(0, small) == 1);
+    TEST_ASSERT(position(0, dc3) == -1); // would fit, but follows dc2
+
+    TEST_ASSERT(list_first_entry(&classes[EC_TRAFFIC_DC], ec_datagram_t,
+                sent) == dc2);
+    TEST_ASSERT(list_last_entry(&classes[EC_TRAFFIC_DC], ec_datagram_t,
+                sent) == dc3);
+    TEST_ASSERT(list_first_entry(&classes[EC_TRAFFIC_MAILBOX],
+                ec_datagram_t, sent) == big);
+    TEST_ASSERT(list_last_entry(&classes[EC_TRAFFIC_MAILBOX],
+                ec_datagram_t, sent) == medium);
+}
+
+/*****************************************************************************/
+
+/** A datagram, that exceeds a frame, is never packed.
+ */
+static void test_oversized(void)
+{
+    ec_datagram_t *huge, *small;
+
+    init();
+    huge = add(EC_TRAFFIC_EOE,
+            PAYLOAD(ETH_DATA_LEN - EC_FRAME_HEADER_SIZE + 1));
+    small = add(EC_TRAFFIC_EOE, 10);
+
+    TEST_ASSERT(ec_master_pack_frames(classes, frames, 0, EC_TX_RING_SIZE)
+            == 1);
+    TEST_ASSERT(position(0, small) == 0);
+    TEST_ASSERT(list_first_entry(&classes[EC_TRAFFIC_EOE], ec_datagram_t,
+                sent) == huge);
+    TEST_ASSERT(list_is_singular(&classes[EC_TRAFFIC_EOE]));
+}
+
+/*****************************************************************************/
+
+/** Queues the domain datagrams and some mailbox checks and sends them.
+ *
+ * \return Number of frames sent.
+ */
+static unsigned int send_templates(int active)
+{
+    unsigned int i;
+
+    test_master_init();
+    test_master.active = active;
+
+    for (i = 0; i < DOMAIN_COUNT; i++) {
+        ec_datagram_init(&domain_datagrams[i]);
+        TEST_ASSERT(!ec_datagram_lrw(&domain_datagrams[i], i * 100, 20));
+        domain_datagrams[i].traffic_class = EC_TRAFFIC_CYCLIC;
+
+        INIT_LIST_HEAD(&domains[i].frame_templates);
+        ec_frame_template_init(&templates[i], EC_DEVICE_MAIN);
+        TEST_ASSERT(!ec_frame_template_add(&templates[i],
+                    &domain_datagrams[i]));
+        list_add_tail(&templates[i].list, &domains[i].frame_templates);
+        list_add_tail(&domains[i].list, &test_master.domains);
+
+        ec_master_queue_datagram(&test_master, &domain_datagrams[i]);
+    }
+
+    for (i = 0; i < MAILBOX_COUNT; i++) {
+        ec_datagram_init(&mailbox_datagrams[i]);
+        TEST_ASSERT(!ec_datagram_fprd(&mailbox_datagrams[i], 0x1001 + i,
+                    0x080D, 1));
+        ec_master_queue_datagram(&test_master, &mailbox_datagrams[i]);
+    }
+
+    ec_master_send_datagrams(&test_master, EC_DEVICE_MAIN);
+
+    for (i = 0; i < DOMAIN_COUNT; i++) {
+        TEST_ASSERT(domain_datagrams[i].state == EC_DATAGRAM_SENT);
+    }
+    for (i = 0; i < MAILBOX_COUNT; i++) {
+        TEST_ASSERT(mailbox_datagrams[i].state == EC_DATAGRAM_SENT);
+    }
+
+    return test_frame_count;
+}
+
+/*****************************************************************************/
+
+/** Clears the datagrams of send_templates().
+ */
+static void clear_templates(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < DOMAIN_COUNT; i++) {
+        ec_datagram_clear(&domain_datagrams[i]);
+    }
+    for (i = 0; i < MAILBOX_COUNT; i++) {
+        ec_datagram_clear(&mailbox_datagrams[i]);
+    }
+}
+
+/*****************************************************************************/
+
+/** Templates of small domains share a frame with each other and with the
+ * mailbox checks, so that no more frames are sent than by the packer alone.
+ */
+static void test_templates(void)
+{
+    unsigned int i, packed, frame_count;
+
+    packed = send_templates(0);
+    clear_templates();
+    frame_count = send_templates(1);
+    TEST_ASSERT(frame_count == 1);
+    TEST_ASSERT(frame_count <= packed);
+
+    // every datagram of the frame is found on reception
+    test_frame_respond(&test_frames[0], 1);
+    ec_master_receive_datagrams(&test_master, &test_master.devices[EC_DEVICE_MAIN],
+            test_frames[0].data, test_frames[0].size);
+    TEST_ASSERT(test_master.stats.unmatched == 0);
+
+    for (i = 0; i < DOMAIN_COUNT; i++) {
+        TEST_ASSERT(domain_datagrams[i].state == EC_DATAGRAM_RECEIVED);
+    }
+    for (i = 0; i < MAILBOX_COUNT; i++) {
+        TEST_ASSERT(mailbox_datagrams[i].state == EC_DATAGRAM_RECEIVED);
+    }
+    clear_templates();
+}
+
+/*****************************************************************************/
+
+int main(void)
+{
+    test_decreasing();
+    test_stable();
+    test_classes();
+    test_dc_order();
+    test_overflow();
+    test_oversized();
+    test_templates();
+    return 0;
+}
+
+/*****************************************************************************/
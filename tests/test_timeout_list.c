@@ -0,0 +1,211 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Tests the expiry of sent datagrams via the timeout list.
+*/
+
+/*****************************************************************************/
+
+#include "../master/master.c"
+#include "../master/datagram.c"
+#include "../master/frame_template.c"
+
+#include "test.h"
+
+/*****************************************************************************/
+
+#define DATAGRAM_COUNT 3
+
+static ec_datagram_t datagrams[DATAGRAM_COUNT];
+
+/*****************************************************************************/
+
+/** Initializes the master and the datagrams and resets the clocks.
+ */
+static void init(void)
+{
+    test_master_init();
+    ktest_cycles = 0;
+    jiffies = 0;
+
+    test_datagrams_init(datagrams, DATAGRAM_COUNT);
+}
+
+/*****************************************************************************/
+
+/** Sends a single datagram.
+ */
+static void send(ec_datagram_t *datagram)
+{
+    ec_master_queue_datagram(&test_master, datagram);
+    ec_master_send_datagrams(&test_master, EC_DEVICE_MAIN);
+    TEST_ASSERT(datagram->state == EC_DATAGRAM_SENT);
+}
+
+/*****************************************************************************/
+
+/** Advances the clocks by a number of microseconds.
+ *
+ * cpu_khz is 1000 and HZ is 1000, so the timeout of EC_IO_TIMEOUT us
+ * corresponds to 1000 cycles or a single jiffy.
+ */
+static void advance(unsigned int us)
+{
+    ktest_cycles += us;
+    jiffies += us / 1000;
+}
+
+/*****************************************************************************/
+
+/** Only the datagrams, that are due, time out. The list stays in sending
+ * order.
+ */
+static void test_expiry(void)
+{
+    ec_datagram_t *a = &datagrams[0], *b = &datagrams[1];
+    uint8_t index_a;
+
+    init();
+
+    send(a);
+    index_a = a->index;
+    advance(1000);
+    send(b);
+    TEST_ASSERT(list_first_entry(&test_master.timeout_list, ec_datagram_t,
+                timeout) == a);
+    TEST_ASSERT(list_last_entry(&test_master.timeout_list, ec_datagram_t,
+                timeout) == b);
+
+    // a is exactly due, which is not yet a timeout
+    ecrt_master_receive(&test_master);
+    TEST_ASSERT(test_master.stats.timeouts == 0);
+    TEST_ASSERT(a->state == EC_DATAGRAM_SENT);
+
+    advance(1000);
+    ecrt_master_receive(&test_master);
+    TEST_ASSERT(test_master.stats.timeouts == 1);
+    TEST_ASSERT(a->state == EC_DATAGRAM_TIMED_OUT);
+    TEST_ASSERT(list_empty(&a->timeout));
+    TEST_ASSERT(list_empty(&a->queue));
+    TEST_ASSERT(!test_master.sent_datagrams[index_a]);
+    TEST_ASSERT(!test_bit(index_a, test_master.datagram_indices));
+
+    TEST_ASSERT(b->state == EC_DATAGRAM_SENT);
+    TEST_ASSERT(list_is_singular(&test_master.timeout_list));
+    TEST_ASSERT(test_master.sent_datagrams[b->index] == b);
+
+    advance(1000);
+    ecrt_master_receive(&test_master);
+    TEST_ASSERT(test_master.stats.timeouts == 2);
+    TEST_ASSERT(b->state == EC_DATAGRAM_TIMED_OUT);
+    TEST_ASSERT(list_empty(&test_master.timeout_list));
+}
+
+/*****************************************************************************/
+
+/** The search stops at the first datagram, that is not due, even if later
+ * ones would be.
+ */
+static void test_stop(void)
+{
+    ec_datagram_t *a = &datagrams[0], *b = &datagrams[1];
+
+    init();
+    advance(3000);
+
+    send(a);
+    send(b);
+
+    // let b be due, although it was sent after a
+#ifdef EC_HAVE_CYCLES
+    b->cycles_sent -= 2000;
+#endif
+    b->jiffies_sent -= 2;
+
+    ecrt_master_receive(&test_master);
+    TEST_ASSERT(test_master.stats.timeouts == 0);
+    TEST_ASSERT(b->state == EC_DATAGRAM_SENT);
+    TEST_ASSERT(list_last_entry(&test_master.timeout_list, ec_datagram_t,
+                timeout) == b);
+}
+
+/*****************************************************************************/
+
+/** Datagrams, that were re-queued or received since sending, are dropped
+ * from the list without timing out.
+ */
+static void test_drop(void)
+{
+    ec_datagram_t *a = &datagrams[0], *b = &datagrams[1],
+                  *c = &datagrams[2];
+    unsigned int f;
+
+    init();
+
+    send(a);
+    send(b);
+    send(c);
+    TEST_ASSERT(test_frame_count == 3);
+
+    // re-queue a, before it was received
+    ec_master_queue_datagram(&test_master, a);
+    TEST_ASSERT(a->state == EC_DATAGRAM_QUEUED);
+
+    // receive b
+    for (f = 0; f < test_frame_count; f++) {
+        test_frame_respond(&test_frames[f], 1);
+    }
+    ec_master_receive_datagrams(&test_master, &test_master.devices[EC_DEVICE_MAIN],
+            test_frames[1].data, test_frames[1].size);
+    TEST_ASSERT(b->state == EC_DATAGRAM_RECEIVED);
+
+    advance(2000);
+    ecrt_master_receive(&test_master);
+    TEST_ASSERT(test_master.stats.timeouts == 1);
+    TEST_ASSERT(a->state == EC_DATAGRAM_QUEUED);
+    TEST_ASSERT(b->state == EC_DATAGRAM_RECEIVED);
+    TEST_ASSERT(c->state == EC_DATAGRAM_TIMED_OUT);
+    TEST_ASSERT(list_empty(&test_master.timeout_list));
+}
+
+/*****************************************************************************/
+
+int main(void)
+{
+    ec_master_init_static();
+
+    test_expiry();
+    test_stop();
+    test_drop();
+    return 0;
+}
+
+/*****************************************************************************/
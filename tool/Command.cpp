@@ -62,27 +62,24 @@ class SlaveAliasParser:
     public NumberListParser
 {
     public:
-        SlaveAliasParser(ec_ioctl_master_t &master, MasterDevice &dev):
-            master(master), dev(dev) {}
+        SlaveAliasParser(const vector<ec_ioctl_slave_t> &slaves):
+            slaves(slaves) {}
 
     protected:
         int getMax() {
             unsigned int i;
 
             uint16_t maxAlias = 0;
-            for (i = 0; i < master.slave_count; i++) {
-                ec_ioctl_slave_t slave;
-                dev.getSlave(&slave, i);
-                if (slave.alias > maxAlias) {
-                    maxAlias = slave.alias;
+            for (i = 0; i < slaves.size(); i++) {
+                if (slaves[i].alias > maxAlias) {
+                    maxAlias = slaves[i].alias;
                 }
             }
             return maxAlias ? maxAlias : -1;
         };
 
     private:
-        ec_ioctl_master_t &master;
-        MasterDevice &dev;
+        const vector<ec_ioctl_slave_t> &slaves;
 };
 
 /*****************************************************************************/
@@ -358,26 +355,24 @@ unsigned int Command::getSingleMasterIndex() const
 
 Command::SlaveList Command::selectedSlaves(MasterDevice &m)
 {
-    ec_ioctl_master_t master;
+    vector<ec_ioctl_slave_t> slaves;
     unsigned int i;
-    ec_ioctl_slave_t slave;
     SlaveList list;
 
-    m.getMaster(&master);
+    m.getSlaves(slaves);
 
     if (aliases == "-") { // no alias given
-        PositionParser pp(master.slave_count);
+        PositionParser pp(slaves.size());
         NumberListParser::List posList = pp.parse(positions.c_str());
         NumberListParser::List::const_iterator pi;
 
         for (pi = posList.begin(); pi != posList.end(); pi++) {
-            if (*pi < master.slave_count) {
-                m.getSlave(&slave, *pi);
-                list.push_back(slave);
+            if (*pi < slaves.size()) {
+                list.push_back(slaves[*pi]);
             }
         }
     } else { // aliases given
-        SlaveAliasParser ap(master, m);
+        SlaveAliasParser ap(slaves);
         NumberListParser::List aliasList = ap.parse(aliases.c_str());
         NumberListParser::List::const_iterator ai;
 
@@ -387,8 +382,8 @@ Command::SlaveList Command::selectedSlaves(MasterDevice &m)
             uint16_t lastAlias = 0;
             vector<ec_ioctl_slave_t> aliasSlaves;
 
-            for (i = 0; i < master.slave_count; i++) {
-                m.getSlave(&slave, i);
+            for (i = 0; i < slaves.size(); i++) {
+                const ec_ioctl_slave_t &slave = slaves[i];
                 if (slave.alias) {
                     if (lastAlias && lastAlias == *ai && slave.alias != *ai) {
                         // ignore multiple ocurrences of the same alias to
@@ -103,6 +103,7 @@ void CommandCStruct::generateSlaveCStruct(
         const ec_ioctl_slave_t &slave
         )
 {
+    MasterDevice::SyncList syncList;
     ec_ioctl_slave_sync_t sync;
     ec_ioctl_slave_sync_pdo_t pdo;
     ec_ioctl_slave_sync_pdo_entry_t entry;
@@ -114,8 +115,10 @@ void CommandCStruct::generateSlaveCStruct(
 
     id << "slave_" << dec << slave.position << "_";
 
-    for (i = 0; i < slave.sync_count; i++) {
-        m.getSync(&sync, slave.position, i);
+    m.getSyncs(syncList, slave.position);
+
+    for (i = 0; i < syncList.size(); i++) {
+        sync = syncList[i].sync;
 
         syncs << "    {" << dec << sync.sync_index
             << ", " << (EC_READ_BIT(&sync.control_register, 2) ?
@@ -134,7 +137,7 @@ void CommandCStruct::generateSlaveCStruct(
         pdo_pos += sync.pdo_count;
 
         for (j = 0; j < sync.pdo_count; j++) {
-            m.getPdo(&pdo, slave.position, i, j);
+            pdo = syncList[i].pdos[j].pdo;
 
             pdos << "    {0x" << hex << setfill('0')
                 << setw(4) << pdo.index
@@ -153,7 +156,7 @@ void CommandCStruct::generateSlaveCStruct(
             entry_pos += pdo.entry_count;
 
             for (k = 0; k < pdo.entry_count; k++) {
-                m.getPdoEntry(&entry, slave.position, i, j, k);
+                entry = syncList[i].pdos[j].entries[k];
 
                 entries << "    {0x" << hex << setfill('0')
                     << setw(4) << entry.index
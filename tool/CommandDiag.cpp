@@ -134,7 +134,7 @@ void CommandDiag::CheckallSlaves(
         bool doIndent
         )
 {
-    ec_ioctl_master_t master;
+    vector<ec_ioctl_slave_t> allSlaves;
     unsigned int i, lastDevice;
     ec_ioctl_slave_t slave;
     uint16_t lastAlias, aliasIndex;
@@ -148,12 +148,12 @@ void CommandDiag::CheckallSlaves(
                  maxESCerrorsWidth = 0;
     string indent(doIndent ? "  " : "");
 
-    m.getMaster(&master);
+    m.getSlaves(allSlaves);
 
     lastAlias = 0;
     aliasIndex = 0;
-    for (i = 0; i < master.slave_count; i++) {
-        m.getSlave(&slave, i);
+    for (i = 0; i < allSlaves.size(); i++) {
+        slave = allSlaves[i];
 
         if (slave.alias) {
             lastAlias = slave.alias;
@@ -97,7 +97,6 @@ void CommandGraph::execute(const StringVector &args)
     SlaveVector slaves;
     typedef vector<CrcInfo> CrcInfoVector;
     CrcInfoVector crcInfos;
-    ec_ioctl_slave_t slave;
     SlaveVector::const_iterator si;
     map<int, string> portMedia;
     map<int, string>::const_iterator mi;
@@ -137,11 +136,7 @@ void CommandGraph::execute(const StringVector &args)
     m.open(MasterDevice::Read);
     m.getMaster(&master);
 
-    for (unsigned int i = 0; i < master.slave_count; i++) {
-        m.getSlave(&slave, i);
-        slaves.push_back(slave);
-
-    }
+    m.getSlaves(slaves);
 
     if (info == CRC) {
         uint8_t data[REG_SIZE];
@@ -36,6 +36,16 @@ using namespace std;
 
 #define MAX_TIME_STR_SIZE 50
 
+/** Traffic class names, indexed by ec_traffic_class_t.
+ */
+static const char *trafficClassNames[EC_TRAFFIC_CLASS_COUNT] = {
+    "Cyclic",
+    "DC",
+    "Master FSM",
+    "Slave FSM",
+    "EoE"
+};
+
 /*****************************************************************************/
 
 CommandMaster::CommandMaster():
@@ -256,6 +266,30 @@ void CommandMaster::execute(const StringVector &args)
         }
         cout << setprecision(0) << endl;
 
+        cout << "  Traffic classes:" << endl;
+        for (j = 0; j < EC_TRAFFIC_CLASS_COUNT; j++) {
+            cout << "    " << trafficClassNames[j] << ":" << endl
+                << "      Budget [byte/cycle]: ";
+            if (data.traffic_classes[j].budget) {
+                cout << data.traffic_classes[j].budget;
+            } else {
+                cout << "unlimited";
+            }
+            cout << endl
+                << "      Datagrams: "
+                << data.traffic_classes[j].datagrams << endl
+                << "      Bytes:     "
+                << data.traffic_classes[j].bytes << endl
+                << "      Deferred:  "
+                << data.traffic_classes[j].deferred << endl;
+        }
+
+        cout << "  Slave FSMs:" << endl
+            << "    Running:           " << data.fsm_exec_count
+            << " of " << data.ext_ring_size / 2 << endl
+            << "    Datagram ring:     " << data.ext_ring_size << endl
+            << "    Ring stalls:       " << data.ext_ring_stalls << endl;
+
         cout << "  Distributed clocks:" << endl
             << "    Reference clock:   ";
         if (data.ref_clock != 0xffff) {
@@ -155,6 +155,7 @@ void CommandPdos::listSlavePdos(
         bool showHeader
         )
 {
+    MasterDevice::SyncList syncList;
     ec_ioctl_slave_sync_t sync;
     ec_ioctl_slave_sync_pdo_t pdo;
     ec_ioctl_slave_sync_pdo_entry_t entry;
@@ -164,8 +165,10 @@ void CommandPdos::listSlavePdos(
         cout << "=== Master " << m.getIndex()
             << ", Slave " << slave.position << " ===" << endl;
 
-    for (i = 0; i < slave.sync_count; i++) {
-        m.getSync(&sync, slave.position, i);
+    m.getSyncs(syncList, slave.position);
+
+    for (i = 0; i < syncList.size(); i++) {
+        sync = syncList[i].sync;
 
         cout << "SM" << i << ":"
             << " PhysAddr 0x"
@@ -180,7 +183,7 @@ void CommandPdos::listSlavePdos(
             << endl;
 
         for (j = 0; j < sync.pdo_count; j++) {
-            m.getPdo(&pdo, slave.position, i, j);
+            pdo = syncList[i].pdos[j].pdo;
 
             cout << "  " << (sync.control_register & 0x04 ? "R" : "T")
                 << "xPDO 0x"
@@ -192,7 +195,7 @@ void CommandPdos::listSlavePdos(
                 continue;
 
             for (k = 0; k < pdo.entry_count; k++) {
-                m.getPdoEntry(&entry, slave.position, i, j, k);
+                entry = syncList[i].pdos[j].entries[k];
 
                 cout << "    PDO entry 0x"
                     << hex << setfill('0')
@@ -213,6 +216,7 @@ void CommandPdos::etherlabConfig(
         const ec_ioctl_slave_t &slave
         )
 {
+    MasterDevice::SyncList syncList;
     ec_ioctl_slave_sync_t sync;
     ec_ioctl_slave_sync_pdo_t pdo;
     ec_ioctl_slave_sync_pdo_entry_t entry;
@@ -236,22 +240,24 @@ void CommandPdos::etherlabConfig(
         << "rv.SlaveConfig.description = '" << slave.order << "';" << endl
         << "rv.SlaveConfig.sm = { ..." << endl;
 
+    m.getSyncs(syncList, slave.position);
+
     /* slave configuration */
-    for (i = 0; i < slave.sync_count; i++) {
-        m.getSync(&sync, slave.position, i);
+    for (i = 0; i < syncList.size(); i++) {
+        sync = syncList[i].sync;
 
         cout << "    {" << dec << i << ", "
             << (sync.control_register & 0x04 ? 0 : 1) << ", {" << endl;
 
         for (j = 0; j < sync.pdo_count; j++) {
-            m.getPdo(&pdo, slave.position, i, j);
+            pdo = syncList[i].pdos[j].pdo;
 
             cout << "        {hex2dec('" <<
                 hex << setfill('0') << setw(4) << pdo.index << "'), ["
                 << endl;
 
             for (k = 0; k < pdo.entry_count; k++) {
-                m.getPdoEntry(&entry, slave.position, i, j, k);
+                entry = syncList[i].pdos[j].entries[k];
 
                 cout << "            hex2dec('"
                     << hex << setfill('0') << setw(4) << entry.index
@@ -272,14 +278,14 @@ void CommandPdos::etherlabConfig(
     cout << "% Port configuration" << endl << endl;
 
     unsigned int input = 1, output = 1;
-    for (i = 0; i < slave.sync_count; i++) {
-        m.getSync(&sync, slave.position, i);
+    for (i = 0; i < syncList.size(); i++) {
+        sync = syncList[i].sync;
 
         for (j = 0; j < sync.pdo_count; j++) {
-            m.getPdo(&pdo, slave.position, i, j);
+            pdo = syncList[i].pdos[j].pdo;
 
             for (k = 0; k < pdo.entry_count; k++) {
-                m.getPdoEntry(&entry, slave.position, i, j, k);
+                entry = syncList[i].pdos[j].entries[k];
 
                 if (!entry.index) {
                     continue;
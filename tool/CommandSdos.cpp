@@ -139,6 +139,7 @@ void CommandSdos::listSlaveSdos(
         bool showHeader
         )
 {
+    MasterDevice::SdoList sdoList;
     ec_ioctl_slave_sdo_t sdo;
     ec_ioctl_slave_sdo_entry_t entry;
     unsigned int i, j;
@@ -148,8 +149,10 @@ void CommandSdos::listSlaveSdos(
         cout << "=== Master " << m.getIndex()
             << ", Slave " << slave.position << " ===" << endl;
 
-    for (i = 0; i < slave.sdo_count; i++) {
-        m.getSdo(&sdo, slave.position, i);
+    m.getSdos(sdoList, slave.position);
+
+    for (i = 0; i < sdoList.size(); i++) {
+        sdo = sdoList[i].sdo;
 
         cout << "SDO 0x"
             << hex << setfill('0')
@@ -159,13 +162,8 @@ void CommandSdos::listSlaveSdos(
         if (getVerbosity() == Quiet)
             continue;
 
-        for (j = 0; j <= sdo.max_subindex; j++) {
-            try {
-                m.getSdoEntry(&entry, slave.position, -i, j);
-            }
-            catch (MasterDeviceException &e) {
-                continue;
-            }
+        for (j = 0; j < sdoList[i].entries.size(); j++) {
+            entry = sdoList[i].entries[j];
 
             cout << "  0x" << hex << setfill('0')
                 << setw(4) << sdo.sdo_index << ":"
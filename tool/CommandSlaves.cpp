@@ -76,6 +76,12 @@ string CommandSlaves::helpString(const string &binaryBaseName) const
         << "If the --verbose option is given, a detailed (multi-line)" << endl
         << "description is output for each slave." << endl
         << endl
+        << "The information is read without blocking the master. It" << endl
+        << "is refreshed by the master thread: States, error flags" << endl
+        << "and links at once, all other values after a bus scan and" << endl
+        << "otherwise a few slaves per master thread cycle, so they" << endl
+        << "may lag behind on large buses." << endl
+        << endl
         << "Slave selection:" << endl
         << "  Slaves for this and other commands can be selected with" << endl
         << "  the --alias and --position parameters as follows:" << endl
@@ -143,7 +149,7 @@ void CommandSlaves::listSlaves(
         bool doIndent
         )
 {
-    ec_ioctl_master_t master;
+    vector<ec_ioctl_slave_t> allSlaves;
     unsigned int i, lastDevice;
     ec_ioctl_slave_t slave;
     uint16_t lastAlias, aliasIndex;
@@ -156,12 +162,12 @@ void CommandSlaves::listSlaves(
                  maxRelPosWidth = 0, maxStateWidth = 0;
     string indent(doIndent ? "  " : "");
 
-    m.getMaster(&master);
+    m.getSlaves(allSlaves);
 
     lastAlias = 0;
     aliasIndex = 0;
-    for (i = 0; i < master.slave_count; i++) {
-        m.getSlave(&slave, i);
+    for (i = 0; i < allSlaves.size(); i++) {
+        slave = allSlaves[i];
 
         if (slave.alias) {
             lastAlias = slave.alias;
@@ -106,6 +106,7 @@ void CommandXml::generateSlaveXml(
         unsigned int indent
         )
 {
+    MasterDevice::SyncList syncList;
     ec_ioctl_slave_sync_t sync;
     ec_ioctl_slave_sync_pdo_t pdo;
     string pdoType, in;
@@ -138,8 +139,10 @@ void CommandXml::generateSlaveXml(
             << "]]></Name>" << endl;
     }
 
-    for (i = 0; i < slave.sync_count; i++) {
-        m.getSync(&sync, slave.position, i);
+    m.getSyncs(syncList, slave.position);
+
+    for (i = 0; i < syncList.size(); i++) {
+        sync = syncList[i].sync;
 
         cout
             << in << "        <Sm Enable=\""
@@ -151,11 +154,11 @@ void CommandXml::generateSlaveXml(
             << "\" />" << endl;
     }
 
-    for (i = 0; i < slave.sync_count; i++) {
-        m.getSync(&sync, slave.position, i);
+    for (i = 0; i < syncList.size(); i++) {
+        sync = syncList[i].sync;
 
         for (j = 0; j < sync.pdo_count; j++) {
-            m.getPdo(&pdo, slave.position, i, j);
+            pdo = syncList[i].pdos[j].pdo;
             pdoType = (sync.control_register & 0x04 ? "R" : "T");
             pdoType += "xPdo"; // last 2 letters lowercase in XML!
 
@@ -168,7 +171,7 @@ void CommandXml::generateSlaveXml(
                 << in << "          <Name>" << pdo.name << "</Name>" << endl;
 
             for (k = 0; k < pdo.entry_count; k++) {
-                m.getPdoEntry(&entry, slave.position, i, j, k);
+                entry = syncList[i].pdos[j].entries[k];
 
                 cout
                     << in << "          <Entry>" << endl
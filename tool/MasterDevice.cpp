@@ -400,6 +400,207 @@ void MasterDevice::getSdoEntry(
 
 /****************************************************************************/
 
+/** Reads the next record of a snapshot buffer.
+ */
+void MasterDevice::readSnapshotRecord(
+        const vector<uint8_t> &buffer,
+        size_t &offset,
+        void *record,
+        size_t size
+        )
+{
+    if (offset + size > buffer.size()) {
+        throw MasterDeviceException("Truncated snapshot data.");
+    }
+
+    memcpy(record, &buffer[offset], size);
+    offset += size;
+}
+
+/****************************************************************************/
+
+/** Reads a string following a snapshot record.
+ */
+void MasterDevice::readSnapshotString(
+        const vector<uint8_t> &buffer,
+        size_t &offset,
+        void *target,
+        size_t size
+        )
+{
+    if (size >= EC_IOCTL_STRING_SIZE) {
+        throw MasterDeviceException("Invalid snapshot string size.");
+    }
+
+    readSnapshotRecord(buffer, offset, target, size);
+    ((char *) target)[size] = 0;
+}
+
+/****************************************************************************/
+
+void MasterDevice::getSnapshot(
+        ec_ioctl_snapshot_t *snapshot,
+        vector<uint8_t> &buffer
+        )
+{
+    buffer.resize(4096);
+
+    while (1) {
+        snapshot->buffer = &buffer[0];
+        snapshot->size = buffer.size();
+
+        if (ioctl(fd, EC_IOCTL_SNAPSHOT, snapshot)) {
+            stringstream err;
+            err << "Failed to get snapshot: " << strerror(errno);
+            throw MasterDeviceException(err);
+        }
+
+        if (snapshot->length <= buffer.size()) {
+            buffer.resize(snapshot->length);
+            return;
+        }
+
+        // the table grew in the meantime; retry with the reported size
+        buffer.resize(snapshot->length);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getSlaves(vector<ec_ioctl_slave_t> &slaves)
+{
+    ec_ioctl_snapshot_t snapshot;
+    vector<uint8_t> buffer;
+    size_t offset = 0;
+    unsigned int i;
+
+    snapshot.table = EC_IOCTL_SNAPSHOT_SLAVES;
+    snapshot.slave_position = 0;
+    getSnapshot(&snapshot, buffer);
+
+    slaves.resize(snapshot.count);
+    for (i = 0; i < snapshot.count; i++) {
+        readSnapshotRecord(buffer, offset, &slaves[i], sizeof(slaves[i]));
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getSyncs(
+        SyncList &syncs,
+        uint16_t slaveIndex
+        )
+{
+    ec_ioctl_snapshot_t snapshot;
+    ec_ioctl_snapshot_sync_t syncRec;
+    ec_ioctl_snapshot_pdo_t pdoRec;
+    ec_ioctl_snapshot_pdo_entry_t entryRec;
+    vector<uint8_t> buffer;
+    size_t offset = 0;
+    unsigned int i, j, k;
+
+    snapshot.table = EC_IOCTL_SNAPSHOT_PDOS;
+    snapshot.slave_position = slaveIndex;
+    getSnapshot(&snapshot, buffer);
+
+    syncs.resize(snapshot.count);
+    for (i = 0; i < snapshot.count; i++) {
+        ec_ioctl_slave_sync_t &sync = syncs[i].sync;
+
+        readSnapshotRecord(buffer, offset, &syncRec, sizeof(syncRec));
+        sync.slave_position = slaveIndex;
+        sync.sync_index = i;
+        sync.physical_start_address = syncRec.physical_start_address;
+        sync.default_size = syncRec.default_size;
+        sync.control_register = syncRec.control_register;
+        sync.enable = syncRec.enable;
+        sync.pdo_count = syncRec.pdo_count;
+
+        syncs[i].pdos.resize(syncRec.pdo_count);
+        for (j = 0; j < syncRec.pdo_count; j++) {
+            ec_ioctl_slave_sync_pdo_t &pdo = syncs[i].pdos[j].pdo;
+
+            readSnapshotRecord(buffer, offset, &pdoRec, sizeof(pdoRec));
+            pdo.slave_position = slaveIndex;
+            pdo.sync_index = i;
+            pdo.pdo_pos = j;
+            pdo.index = pdoRec.index;
+            pdo.entry_count = pdoRec.entry_count;
+            readSnapshotString(buffer, offset, pdo.name, pdoRec.name_size);
+
+            syncs[i].pdos[j].entries.resize(pdoRec.entry_count);
+            for (k = 0; k < pdoRec.entry_count; k++) {
+                ec_ioctl_slave_sync_pdo_entry_t &entry =
+                    syncs[i].pdos[j].entries[k];
+
+                readSnapshotRecord(buffer, offset,
+                        &entryRec, sizeof(entryRec));
+                entry.slave_position = slaveIndex;
+                entry.sync_index = i;
+                entry.pdo_pos = j;
+                entry.entry_pos = k;
+                entry.index = entryRec.index;
+                entry.subindex = entryRec.subindex;
+                entry.bit_length = entryRec.bit_length;
+                readSnapshotString(buffer, offset,
+                        entry.name, entryRec.name_size);
+            }
+        }
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getSdos(
+        SdoList &sdos,
+        uint16_t slaveIndex
+        )
+{
+    ec_ioctl_snapshot_t snapshot;
+    ec_ioctl_snapshot_sdo_t sdoRec;
+    ec_ioctl_snapshot_sdo_entry_t entryRec;
+    vector<uint8_t> buffer;
+    size_t offset = 0;
+    unsigned int i, j, k;
+
+    snapshot.table = EC_IOCTL_SNAPSHOT_DICT;
+    snapshot.slave_position = slaveIndex;
+    getSnapshot(&snapshot, buffer);
+
+    sdos.resize(snapshot.count);
+    for (i = 0; i < snapshot.count; i++) {
+        ec_ioctl_slave_sdo_t &sdo = sdos[i].sdo;
+
+        readSnapshotRecord(buffer, offset, &sdoRec, sizeof(sdoRec));
+        sdo.slave_position = slaveIndex;
+        sdo.sdo_position = i;
+        sdo.sdo_index = sdoRec.index;
+        sdo.max_subindex = sdoRec.max_subindex;
+        sdo.object_code = sdoRec.object_code;
+        readSnapshotString(buffer, offset, sdo.name, sdoRec.name_size);
+
+        sdos[i].entries.resize(sdoRec.entry_count);
+        for (j = 0; j < sdoRec.entry_count; j++) {
+            ec_ioctl_slave_sdo_entry_t &entry = sdos[i].entries[j];
+
+            readSnapshotRecord(buffer, offset, &entryRec, sizeof(entryRec));
+            entry.slave_position = slaveIndex;
+            entry.sdo_spec = -(int) i;
+            entry.sdo_entry_subindex = entryRec.subindex;
+            entry.data_type = entryRec.data_type;
+            entry.bit_length = entryRec.bit_length;
+            for (k = 0; k < EC_SDO_ENTRY_ACCESS_COUNT; k++) {
+                entry.read_access[k] = entryRec.read_access[k];
+                entry.write_access[k] = entryRec.write_access[k];
+            }
+            readSnapshotString(buffer, offset,
+                    entry.description, entryRec.description_size);
+        }
+    }
+}
+
+/****************************************************************************/
+
 void MasterDevice::readSii(
         ec_ioctl_slave_sii_t *data
         )
@@ -32,6 +32,7 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <vector>
 using namespace std;
 
 #include "ecrt.h"
@@ -114,6 +115,26 @@ class MasterDeviceEoeException:
 class MasterDevice
 {
     public:
+        /** PDO with its entries, as read by getSyncs(). */
+        struct Pdo {
+            ec_ioctl_slave_sync_pdo_t pdo;
+            vector<ec_ioctl_slave_sync_pdo_entry_t> entries;
+        };
+
+        /** Sync manager with its PDOs, as read by getSyncs(). */
+        struct Sync {
+            ec_ioctl_slave_sync_t sync;
+            vector<Pdo> pdos;
+        };
+        typedef vector<Sync> SyncList;
+
+        /** SDO with its entries, as read by getSdos(). */
+        struct Sdo {
+            ec_ioctl_slave_sdo_t sdo;
+            vector<ec_ioctl_slave_sdo_entry_t> entries;
+        };
+        typedef vector<Sdo> SdoList;
+
         MasterDevice(unsigned int = 0U);
         ~MasterDevice();
 
@@ -147,6 +168,9 @@ class MasterDevice
                 uint8_t, uint8_t);
         void getSdo(ec_ioctl_slave_sdo_t *, uint16_t, uint16_t);
         void getSdoEntry(ec_ioctl_slave_sdo_entry_t *, uint16_t, int, uint8_t);
+        void getSlaves(vector<ec_ioctl_slave_t> &);
+        void getSyncs(SyncList &, uint16_t);
+        void getSdos(SdoList &, uint16_t);
         void readSii(ec_ioctl_slave_sii_t *);
         void writeSii(ec_ioctl_slave_sii_t *);
         void readReg(ec_ioctl_slave_reg_t *);
@@ -177,6 +201,12 @@ class MasterDevice
         unsigned int index;
         unsigned int masterCount;
         int fd;
+
+        void getSnapshot(ec_ioctl_snapshot_t *, vector<uint8_t> &);
+        static void readSnapshotRecord(const vector<uint8_t> &, size_t &,
+                void *, size_t);
+        static void readSnapshotString(const vector<uint8_t> &, size_t &,
+                void *, size_t);
 };
 
 /****************************************************************************/